@@ -0,0 +1,306 @@
+/**
+ * @file als.c
+ * @brief Implementação do módulo de fatorização de matrizes por mínimos quadrados alternados
+ */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "als.h"
+#include "arena.h"
+#include "topk.h"
+#include "simkernel.h"
+
+// Pesos dos tipos de interação na confiança (índice = InteractionType; PAUSE não conta)
+static const float als_weights[4] = {
+    ALS_WEIGHT_PLAY, 0.0f, ALS_WEIGHT_COMPLETE, ALS_WEIGHT_FAVORITE
+};
+
+// Meia iteração: resolve as linhas de um lado com os fatores do outro lado fixos
+typedef struct {
+    AlsModel *model;
+    const float *fixed;         // Fatores fixos (stride floats por linha)
+    float *solved;              // Fatores a resolver
+    const int *offsets;         // Início das entradas de cada linha a resolver
+    const int *indices;         // Linha fixa de cada entrada
+    const float *values;        // Peso r de cada entrada
+    const double *gram;         // fixed^T * fixed (triângulo inferior, factors x factors)
+} AlsStep;
+
+// Reserva count linhas de stride floats a zeros, alinhadas a ALS_ALIGNMENT bytes
+static float *als_alloc_factors(int count, int stride, void **block) {
+    *block = calloc((size_t)count * stride * sizeof(float) + ALS_ALIGNMENT, 1);
+    if (*block == NULL) {
+        return NULL;
+    }
+    
+    uintptr_t address = (uintptr_t)*block;
+    address = (address + ALS_ALIGNMENT - 1) & ~(uintptr_t)(ALS_ALIGNMENT - 1);
+    return (float*)address;
+}
+
+// Liberta a matriz e os fatores, mantendo a configuração
+static void als_release(AlsModel *model) {
+    collab_matrix_free(&model->matrix);
+    free(model->user_block);
+    free(model->item_block);
+    model->user_block = NULL;
+    model->item_block = NULL;
+    model->user_factors = NULL;
+    model->item_factors = NULL;
+    model->iterations = 0;
+    model->manager = NULL;
+}
+
+// Resolve a * x = b (a simétrica definida positiva, triângulo inferior) por Cholesky; x fica em b
+static int als_cholesky_solve(double *a, double *b, int n) {
+    for (int j = 0; j < n; j++) {
+        double diagonal = a[j * n + j];
+        for (int k = 0; k < j; k++) {
+            diagonal -= a[j * n + k] * a[j * n + k];
+        }
+        if (diagonal <= 0.0) {
+            return 0;
+        }
+        a[j * n + j] = sqrt(diagonal);
+        
+        for (int i = j + 1; i < n; i++) {
+            double sum = a[i * n + j];
+            for (int k = 0; k < j; k++) {
+                sum -= a[i * n + k] * a[j * n + k];
+            }
+            a[i * n + j] = sum / a[j * n + j];
+        }
+    }
+    
+    // L * z = b e depois L^T * x = z
+    for (int i = 0; i < n; i++) {
+        double sum = b[i];
+        for (int k = 0; k < i; k++) {
+            sum -= a[i * n + k] * b[k];
+        }
+        b[i] = sum / a[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double sum = b[i];
+        for (int k = i + 1; k < n; k++) {
+            sum -= a[k * n + i] * b[k];
+        }
+        b[i] = sum / a[i * n + i];
+    }
+    return 1;
+}
+
+// Produto fixed^T * fixed de todas as linhas fixas (triângulo inferior)
+static void als_gram(const AlsModel *model, const float *fixed, int rows, double *gram) {
+    int n = model->factors;
+    
+    memset(gram, 0, (size_t)n * n * sizeof(double));
+    for (int r = 0; r < rows; r++) {
+        const float *y = fixed + (size_t)r * model->stride;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j <= i; j++) {
+                gram[i * n + j] += (double)y[i] * y[j];
+            }
+        }
+    }
+}
+
+// Resolve as equações normais das linhas [begin, end):
+// (G + lambda*I + sum (c - 1) y y^T) x = sum c y, com c = 1 + alpha * r
+static void als_solve_range(void *context, int begin, int end) {
+    AlsStep *step = (AlsStep*)context;
+    AlsModel *model = step->model;
+    int n = model->factors;
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    double *a = (double*)arena_alloc(scratch, (size_t)n * n * sizeof(double));
+    double *b = (double*)arena_alloc(scratch, n * sizeof(double));
+    
+    for (int row = begin; row < end; row++) {
+        float *x = step->solved + (size_t)row * model->stride;
+        
+        // Sem interações (ou sem memória): fatores a zero, preferência prevista 0
+        if (a == NULL || b == NULL || step->offsets[row] == step->offsets[row + 1]) {
+            memset(x, 0, model->stride * sizeof(float));
+            continue;
+        }
+        
+        memcpy(a, step->gram, (size_t)n * n * sizeof(double));
+        memset(b, 0, n * sizeof(double));
+        for (int i = 0; i < n; i++) {
+            a[i * n + i] += model->regularization;
+        }
+        
+        for (int e = step->offsets[row]; e < step->offsets[row + 1]; e++) {
+            const float *y = step->fixed + (size_t)step->indices[e] * model->stride;
+            double confidence = 1.0 + (double)model->alpha * step->values[e];
+            
+            for (int i = 0; i < n; i++) {
+                double scaled = (confidence - 1.0) * y[i];
+                for (int j = 0; j <= i; j++) {
+                    a[i * n + j] += scaled * y[j];
+                }
+                b[i] += confidence * y[i];
+            }
+        }
+        
+        if (als_cholesky_solve(a, b, n)) {
+            for (int i = 0; i < n; i++) {
+                x[i] = (float)b[i];
+            }
+        } else {
+            memset(x, 0, model->stride * sizeof(float));
+        }
+    }
+    
+    arena_reset_to(scratch, mark);
+}
+
+int als_init(AlsModel *model, int factors, float regularization, float alpha) {
+    if (model == NULL || factors <= 0 || factors > ALS_MAX_FACTORS ||
+        regularization <= 0.0f || alpha < 0.0f) {
+        return 0;
+    }
+    
+    memset(model, 0, sizeof(AlsModel));
+    model->factors = factors;
+    model->stride = (factors + 7) & ~7;
+    model->regularization = regularization;
+    model->alpha = alpha;
+    return 1;
+}
+
+void als_free(AlsModel *model) {
+    if (model == NULL) {
+        return;
+    }
+    
+    als_release(model);
+}
+
+int als_train(AlsModel *model, UserManager *manager, ContentCatalog *catalog, int iterations, ThreadPool *pool) {
+    if (model == NULL || manager == NULL || catalog == NULL || model->factors <= 0 || iterations <= 0) {
+        return 0;
+    }
+    
+    als_release(model);
+    if (!collab_matrix_build(&model->matrix, manager, catalog, als_weights, COLLAB_COMBINE_SUM)) {
+        return 0;
+    }
+    
+    CollabMatrix *matrix = &model->matrix;
+    model->user_factors = als_alloc_factors(matrix->row_count > 0 ? matrix->row_count : 1,
+                                            model->stride, &model->user_block);
+    model->item_factors = als_alloc_factors(matrix->item_slots, model->stride, &model->item_block);
+    double *gram = (double*)malloc((size_t)model->factors * model->factors * sizeof(double));
+    if (model->user_factors == NULL || model->item_factors == NULL || gram == NULL) {
+        free(gram);
+        als_release(model);
+        return 0;
+    }
+    
+    // Fatores iniciais pequenos e determinísticos para os conteúdos com interações
+    unsigned int seed = 12345u;
+    for (int id = 0; id < matrix->item_slots; id++) {
+        if (matrix->column_offsets[id] == matrix->column_offsets[id + 1]) {
+            continue;
+        }
+        float *y = model->item_factors + (size_t)id * model->stride;
+        for (int k = 0; k < model->factors; k++) {
+            seed = seed * 1103515245u + 12345u;
+            y[k] = 0.1f * (float)((seed >> 16) & 0x7fff) / 32768.0f;
+        }
+    }
+    
+    AlsStep users;
+    users.model = model;
+    users.fixed = model->item_factors;
+    users.solved = model->user_factors;
+    users.offsets = matrix->row_offsets;
+    users.indices = matrix->columns;
+    users.values = matrix->values;
+    users.gram = gram;
+    
+    AlsStep items;
+    items.model = model;
+    items.fixed = model->user_factors;
+    items.solved = model->item_factors;
+    items.offsets = matrix->column_offsets;
+    items.indices = matrix->column_rows;
+    items.values = matrix->column_values;
+    items.gram = gram;
+    
+    // Cada linha é resolvida de forma independente, pelo que os blocos correm em paralelo
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        als_gram(model, model->item_factors, matrix->item_slots, gram);
+        threadpool_parallel_for(pool, 0, matrix->row_count, 32, als_solve_range, &users);
+        
+        als_gram(model, model->user_factors, matrix->row_count, gram);
+        threadpool_parallel_for(pool, 0, matrix->item_slots, 32, als_solve_range, &items);
+    }
+    
+    free(gram);
+    model->iterations = iterations;
+    model->manager = manager;
+    return 1;
+}
+
+float als_predict(AlsModel *model, int user_id, int content_id) {
+    if (model == NULL || model->user_factors == NULL) {
+        return 0.0f;
+    }
+    
+    int row = collab_matrix_find_row(&model->matrix, user_id);
+    if (row < 0 || content_id <= 0 || content_id >= model->matrix.item_slots) {
+        return 0.0f;
+    }
+    
+    float score;
+    simkernel_dot_rows(model->user_factors + (size_t)row * model->stride,
+                       model->item_factors + (size_t)content_id * model->stride,
+                       model->factors, model->stride, 1, &score);
+    return score;
+}
+
+int als_recommend(AlsModel *model, int user_id, int *recommendations, int max_recommendations) {
+    if (model == NULL || recommendations == NULL || max_recommendations <= 0) {
+        return -1;
+    }
+    
+    CollabMatrix *matrix = &model->matrix;
+    int row = collab_matrix_find_row(matrix, user_id);
+    if (row < 0 || model->user_factors == NULL) {
+        return 0;
+    }
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    float *scores = (float*)arena_alloc(scratch, matrix->item_slots * sizeof(float));
+    TopK best;
+    if (scores == NULL || !topk_init(&best, max_recommendations)) {
+        arena_reset_to(scratch, mark);
+        return -1;
+    }
+    
+    // Produto interno do utilizador com todos os conteúdos, de uma vez
+    simkernel_dot_rows(model->user_factors + (size_t)row * model->stride, model->item_factors,
+                       model->factors, model->stride, matrix->item_slots, scores);
+    
+    // Os conteúdos do histórico ficam marcados com NAN para não serem recomendados
+    for (int e = matrix->row_offsets[row]; e < matrix->row_offsets[row + 1]; e++) {
+        scores[matrix->columns[e]] = NAN;
+    }
+    
+    for (int id = 1; id < matrix->item_slots; id++) {
+        if (matrix->column_offsets[id] != matrix->column_offsets[id + 1] && !isnan(scores[id])) {
+            topk_push(&best, id, scores[id]);
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
+    return recommendation_count;
+}
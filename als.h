@@ -0,0 +1,109 @@
+/**
+ * @file als.h
+ * @brief Módulo de fatorização de matrizes por mínimos quadrados alternados (ALS)
+ * 
+ * Treina fatores latentes de utilizadores e conteúdos a partir das
+ * interações (feedback implícito): cada par (utilizador, conteúdo) tem
+ * preferência 1 e confiança 1 + alpha * r, em que r soma os pesos das
+ * interações PLAY, COMPLETE e FAVORITE do par. Cada meia iteração resolve
+ * as equações normais de todos os utilizadores (ou de todos os conteúdos)
+ * em paralelo, com uma decomposição de Cholesky por linha. As
+ * recomendações percorrem os fatores dos conteúdos com o produto interno
+ * vetorizado de simkernel.
+ */
+
+#ifndef ALS_H
+#define ALS_H
+
+#include "content.h"
+#include "user.h"
+#include "threadpool.h"
+#include "collab.h"
+
+#define ALS_DEFAULT_FACTORS 32
+#define ALS_DEFAULT_ITERATIONS 10
+#define ALS_DEFAULT_REGULARIZATION 0.1f
+#define ALS_DEFAULT_ALPHA 10.0f
+#define ALS_MAX_FACTORS 256
+#define ALS_ALIGNMENT 32
+#define ALS_WEIGHT_PLAY 1.0f
+#define ALS_WEIGHT_COMPLETE 2.0f
+#define ALS_WEIGHT_FAVORITE 3.0f
+
+/**
+ * @brief Modelo de fatores latentes
+ * 
+ * Os fatores são guardados em linhas de stride floats (factors arredondado
+ * a múltiplos de 8, com o excesso a zero), alinhadas a ALS_ALIGNMENT bytes.
+ */
+typedef struct {
+    CollabMatrix matrix;        /**< Soma dos pesos r de cada par (utilizador, conteúdo) */
+    float *user_factors;        /**< Fatores de cada linha da matriz (row_count linhas) */
+    float *item_factors;        /**< Fatores de cada ID de conteúdo (item_slots linhas) */
+    void *user_block;           /**< Bloco alocado que contém user_factors */
+    void *item_block;           /**< Bloco alocado que contém item_factors */
+    int factors;                /**< Número de fatores latentes */
+    int stride;                 /**< Floats por linha de fatores */
+    float regularization;       /**< Regularização (lambda) */
+    float alpha;                /**< Escala da confiança */
+    int iterations;             /**< Iterações feitas no último treino */
+    UserManager *manager;       /**< Gerenciador a partir do qual o modelo foi treinado */
+} AlsModel;
+
+/**
+ * @brief Inicializa um modelo vazio
+ * 
+ * @param model Ponteiro para o modelo
+ * @param factors Número de fatores latentes (1 a ALS_MAX_FACTORS)
+ * @param regularization Regularização (lambda > 0)
+ * @param alpha Escala da confiança (>= 0)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int als_init(AlsModel *model, int factors, float regularization, float alpha);
+
+/**
+ * @brief Liberta a memória do modelo
+ * 
+ * @param model Ponteiro para o modelo
+ */
+void als_free(AlsModel *model);
+
+/**
+ * @brief Treina (ou treina de novo) o modelo com as interações atuais
+ * 
+ * O resultado é o mesmo com ou sem conjunto de threads.
+ * 
+ * @param model Ponteiro para o modelo
+ * @param manager Gerenciador de utilizadores (interações e agregados)
+ * @param catalog Catálogo de conteúdos
+ * @param iterations Número de iterações (cada uma resolve utilizadores e conteúdos)
+ * @param pool Conjunto de threads (NULL para treinar em série)
+ * @return int 1 se o treino foi bem-sucedido, 0 caso contrário
+ */
+int als_train(AlsModel *model, UserManager *manager, ContentCatalog *catalog, int iterations, ThreadPool *pool);
+
+/**
+ * @brief Calcula a preferência prevista de um utilizador por um conteúdo
+ * 
+ * @param model Ponteiro para o modelo
+ * @param user_id ID do utilizador
+ * @param content_id ID do conteúdo
+ * @return float Produto interno dos fatores (0 se algum não existir)
+ */
+float als_predict(AlsModel *model, int user_id, int content_id);
+
+/**
+ * @brief Recomenda os conteúdos com maior preferência prevista
+ * 
+ * Os conteúdos do histórico do utilizador e os conteúdos sem interações no
+ * treino não são recomendados.
+ * 
+ * @param model Ponteiro para o modelo
+ * @param user_id ID do utilizador
+ * @param recommendations Array para armazenar os IDs recomendados
+ * @param max_recommendations Número máximo de recomendações
+ * @return int Número de recomendações geradas, ou -1 em caso de erro
+ */
+int als_recommend(AlsModel *model, int user_id, int *recommendations, int max_recommendations);
+
+#endif /* ALS_H */
@@ -0,0 +1,200 @@
+/**
+ * @file arena.c
+ * @brief Implementação do módulo de alocação por arena
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+// Arena de rascunho de cada thread (sem blocos até ao primeiro pedido)
+static __thread Arena arena_thread_scratch;
+static __thread int arena_thread_scratch_ready = 0;
+
+// Bytes de alinhamento necessários para servir a partir de used
+static size_t arena_padding(ArenaBlock *block) {
+    uintptr_t address = (uintptr_t)(block->data + block->used);
+    return (ARENA_ALIGNMENT - (address & (ARENA_ALIGNMENT - 1))) & (ARENA_ALIGNMENT - 1);
+}
+
+// Verifica se o bloco ainda tem espaço para o pedido
+static int arena_fits(ArenaBlock *block, size_t size) {
+    size_t padding = arena_padding(block);
+    return block->used + padding <= block->capacity &&
+           size <= block->capacity - block->used - padding;
+}
+
+int arena_init(Arena *arena, size_t block_size) {
+    if (arena == NULL) {
+        return 0;
+    }
+    
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+    arena->allocations = 0;
+    arena->block_allocations = 0;
+    return 1;
+}
+
+void arena_free(Arena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    
+    ArenaBlock *block = arena->first;
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    
+    // Avançar pelos blocos mantidos depois de uma reposição antes de pedir mais
+    ArenaBlock *block = arena->current;
+    while (block != NULL && !arena_fits(block, size) && block->next != NULL) {
+        block = block->next;
+        block->used = 0;
+    }
+    
+    if (block == NULL || !arena_fits(block, size)) {
+        size_t capacity = arena->block_size;
+        if (size + ARENA_ALIGNMENT > capacity) {
+            capacity = size + ARENA_ALIGNMENT;
+        }
+        
+        ArenaBlock *fresh = (ArenaBlock*)malloc(sizeof(ArenaBlock) + capacity);
+        if (fresh == NULL) {
+            return NULL;
+        }
+        fresh->capacity = capacity;
+        fresh->used = 0;
+        arena->block_allocations++;
+        
+        // O novo bloco entra logo a seguir ao atual; os restantes continuam reutilizáveis
+        if (block == NULL) {
+            fresh->next = arena->first;
+            arena->first = fresh;
+        } else {
+            fresh->next = block->next;
+            block->next = fresh;
+        }
+        block = fresh;
+    }
+    
+    block->used += arena_padding(block);
+    void *memory = block->data + block->used;
+    block->used += size;
+    arena->current = block;
+    arena->allocations++;
+    return memory;
+}
+
+char* arena_strdup(Arena *arena, const char *str) {
+    if (str == NULL) {
+        return NULL;
+    }
+    
+    size_t length = strlen(str) + 1;
+    char *copy = (char*)arena_alloc(arena, length);
+    if (copy != NULL) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+char* arena_printf(Arena *arena, const char *format, ...) {
+    va_list args;
+    
+    if (arena == NULL) {
+        return NULL;
+    }
+    
+    // Formatar diretamente no espaço livre do bloco atual (uma só passagem no caso comum)
+    ArenaBlock *block = arena->current;
+    if (block != NULL && arena_fits(block, 1)) {
+        size_t padding = arena_padding(block);
+        size_t available = block->capacity - block->used - padding;
+        char *str = (char*)(block->data + block->used + padding);
+        
+        va_start(args, format);
+        int length = vsnprintf(str, available, format, args);
+        va_end(args);
+        
+        if (length >= 0 && (size_t)length < available) {
+            block->used += padding + (size_t)length + 1;
+            arena->allocations++;
+            return str;
+        }
+    }
+    
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    
+    if (length < 0) {
+        return NULL;
+    }
+    
+    char *str = (char*)arena_alloc(arena, (size_t)length + 1);
+    if (str != NULL) {
+        va_start(args, format);
+        vsnprintf(str, (size_t)length + 1, format, args);
+        va_end(args);
+    }
+    return str;
+}
+
+ArenaMark arena_mark(Arena *arena) {
+    ArenaMark mark;
+    mark.block = arena->current;
+    mark.used = arena->current != NULL ? arena->current->used : 0;
+    return mark;
+}
+
+void arena_reset_to(Arena *arena, ArenaMark mark) {
+    if (mark.block == NULL) {
+        arena_reset(arena);
+        return;
+    }
+    
+    // Os blocos seguintes são considerados vazios quando voltarem a ser usados
+    arena->current = mark.block;
+    mark.block->used = mark.used;
+}
+
+void arena_reset(Arena *arena) {
+    arena->current = arena->first;
+    if (arena->first != NULL) {
+        arena->first->used = 0;
+    }
+}
+
+Arena* arena_scratch(void) {
+    if (!arena_thread_scratch_ready) {
+        arena_init(&arena_thread_scratch, ARENA_SCRATCH_BLOCK_SIZE);
+        arena_thread_scratch_ready = 1;
+    }
+    return &arena_thread_scratch;
+}
+
+void arena_scratch_free(void) {
+    if (arena_thread_scratch_ready) {
+        arena_free(&arena_thread_scratch);
+        arena_thread_scratch_ready = 0;
+    }
+}
@@ -0,0 +1,132 @@
+/**
+ * @file arena.h
+ * @brief Módulo de alocação por arena (bump allocator)
+ * 
+ * Uma arena reserva blocos grandes com malloc e serve os pedidos avançando
+ * um ponteiro dentro do bloco atual. Não há libertação individual: a arena
+ * inteira (ou tudo o que foi alocado depois de uma marca) é reposta em O(1),
+ * mantendo os blocos para reutilização. Cada thread tem ainda uma arena de
+ * rascunho para os buffers temporários de um pedido (exportações, gravação
+ * de ficheiros, recomendações).
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_DEFAULT_BLOCK_SIZE 4096
+#define ARENA_SCRATCH_BLOCK_SIZE 65536
+
+/**
+ * @brief Bloco de memória de uma arena
+ */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;    /**< Bloco seguinte (reutilizado depois de uma reposição) */
+    size_t capacity;            /**< Bytes disponíveis em data */
+    size_t used;                /**< Bytes já servidos */
+    unsigned char data[];       /**< Memória servida pela arena */
+} ArenaBlock;
+
+/**
+ * @brief Estrutura que representa uma arena
+ */
+typedef struct {
+    ArenaBlock *first;          /**< Primeiro bloco da cadeia */
+    ArenaBlock *current;        /**< Bloco onde são servidos os pedidos */
+    size_t block_size;          /**< Tamanho mínimo de cada bloco */
+    size_t allocations;         /**< Pedidos servidos desde a inicialização */
+    size_t block_allocations;   /**< Chamadas a malloc feitas pela arena */
+} Arena;
+
+/**
+ * @brief Posição de uma arena, para repor tudo o que foi alocado depois dela
+ */
+typedef struct {
+    ArenaBlock *block;          /**< Bloco atual no momento da marca */
+    size_t used;                /**< Bytes usados nesse bloco */
+} ArenaMark;
+
+/**
+ * @brief Inicializa uma arena vazia (os blocos são criados no primeiro pedido)
+ * 
+ * @param arena Ponteiro para a arena
+ * @param block_size Tamanho mínimo de cada bloco (0 para ARENA_DEFAULT_BLOCK_SIZE)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int arena_init(Arena *arena, size_t block_size);
+
+/**
+ * @brief Liberta todos os blocos da arena
+ * 
+ * @param arena Ponteiro para a arena
+ */
+void arena_free(Arena *arena);
+
+/**
+ * @brief Reserva memória alinhada a ARENA_ALIGNMENT bytes
+ * 
+ * @param arena Ponteiro para a arena
+ * @param size Número de bytes
+ * @return void* Memória reservada, ou NULL em caso de erro
+ */
+void* arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copia uma string para a arena
+ * 
+ * @param arena Ponteiro para a arena
+ * @param str String a copiar
+ * @return char* Cópia da string, ou NULL em caso de erro
+ */
+char* arena_strdup(Arena *arena, const char *str);
+
+/**
+ * @brief Formata uma string (como sprintf) diretamente na arena
+ * 
+ * @param arena Ponteiro para a arena
+ * @param format Formato printf
+ * @return char* String formatada, ou NULL em caso de erro
+ */
+char* arena_printf(Arena *arena, const char *format, ...);
+
+/**
+ * @brief Obtém a posição atual da arena
+ * 
+ * @param arena Ponteiro para a arena
+ * @return ArenaMark Marca a passar a arena_reset_to
+ */
+ArenaMark arena_mark(Arena *arena);
+
+/**
+ * @brief Descarta, em O(1), tudo o que foi alocado depois da marca
+ * 
+ * @param arena Ponteiro para a arena
+ * @param mark Marca obtida com arena_mark
+ */
+void arena_reset_to(Arena *arena, ArenaMark mark);
+
+/**
+ * @brief Descarta, em O(1), tudo o que foi alocado na arena (os blocos são mantidos)
+ * 
+ * @param arena Ponteiro para a arena
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * @brief Obtém a arena de rascunho da thread atual
+ * 
+ * Quem usa a arena de rascunho deve guardar uma marca à entrada e repô-la
+ * à saída, para que os chamadores possam também usá-la.
+ * 
+ * @return Arena* Arena de rascunho da thread
+ */
+Arena* arena_scratch(void);
+
+/**
+ * @brief Liberta os blocos da arena de rascunho da thread atual
+ */
+void arena_scratch_free(void);
+
+#endif /* ARENA_H */
@@ -0,0 +1,1432 @@
+/**
+ * @file bench.c
+ * @brief Benchmarks de desempenho para os módulos do programa Streamflix
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <math.h>
+
+#include "content.h"
+#include "user.h"
+#include "threadpool.h"
+#include "arena.h"
+#include "topk.h"
+#include "neighbors.h"
+#include "simkernel.h"
+#include "collab.h"
+#include "als.h"
+#include "hnsw.h"
+#include "recommendation.h"
+
+#define BENCH_USERS 1000
+#define BENCH_CONTENTS 5000
+#define BENCH_INTERACTIONS 1000000
+#define BENCH_PARSE_ROUNDS 20
+#define BENCH_SORT_ROWS 10000000
+#define BENCH_COMPACT_ROWS 10000
+#define BENCH_READER_QUERIES 2000
+#define BENCH_VIEW_THREADS 32
+#define BENCH_VIEWS_PER_THREAD 1000000
+#define BENCH_POOL_ITEMS 50000000
+#define BENCH_EXPORT_ROWS 10000
+#define BENCH_EXPORT_REQUESTS 100
+#define BENCH_TOPK_TITLES 1000000
+#define BENCH_TOPK_ROUNDS 20
+#define BENCH_NEIGHBOR_TITLES 20000
+#define BENCH_NEIGHBOR_WATCHED 20
+#define BENCH_NEIGHBOR_ROUNDS 20
+#define BENCH_KERNEL_TITLES 100000
+#define BENCH_KERNEL_ROUNDS 20
+#define BENCH_COLLAB_USERS 2000
+#define BENCH_COLLAB_HISTORY 100
+#define BENCH_COLLAB_REQUESTS 1000
+#define BENCH_ALS_HISTORY 40
+#define BENCH_HNSW_COUNT 50000
+#define BENCH_HNSW_DIMENSION 32
+#define BENCH_HNSW_QUERIES 500
+#define BENCH_PERSONALIZED_HISTORY 30
+#define BENCH_PERSONALIZED_REQUESTS 200
+#define BENCH_CACHE_REQUESTS 2000
+#define BENCH_CACHE_HOT_USERS 100
+#define BENCH_CACHE_WRITE_EVERY 20
+#define BENCH_CACHE_CAPACITY 256
+#define BENCH_BATCH_MAX_THREADS 4
+#define BENCH_TABLE_REQUESTS 100000
+#define BENCH_TABLE_STALE_EVERY 10
+
+#define BENCH_TEXT_FILE "bench_interactions_text.csv"
+#define BENCH_NUMERIC_FILE "bench_interactions_numeric.csv"
+#define BENCH_CATALOG_FILE "bench_contents.csv"
+#define BENCH_BATCH_FILE "bench_recommendations.bin"
+
+// Protótipos das funções de benchmark
+void bench_interaction_type_parsing();
+void bench_interaction_loader();
+void bench_interaction_sort(int rows);
+void bench_catalog_readers();
+void bench_view_counters();
+void bench_threadpool_scaling();
+void bench_export_allocations();
+void bench_topk_selection();
+void bench_neighbor_lists();
+void bench_similarity_kernel();
+void bench_collaborative_filtering();
+void bench_als();
+void bench_hnsw();
+void bench_personalized();
+void bench_recommendation_cache();
+void bench_batch_recommendations();
+void bench_recommendation_table();
+
+/**
+ * @brief Função principal dos benchmarks
+ * 
+ * @param argc Número de argumentos
+ * @param argv Argumentos (opcional: número de interações a ordenar)
+ * @return int Código de saída
+ */
+int main(int argc, char *argv[]) {
+    int sort_rows = argc > 1 ? atoi(argv[1]) : BENCH_SORT_ROWS;
+    
+    printf("Iniciando benchmarks...\n\n");
+    
+    bench_interaction_type_parsing();
+    bench_interaction_loader();
+    bench_interaction_sort(sort_rows);
+    bench_catalog_readers();
+    bench_view_counters();
+    bench_threadpool_scaling();
+    bench_export_allocations();
+    bench_topk_selection();
+    bench_neighbor_lists();
+    bench_similarity_kernel();
+    bench_collaborative_filtering();
+    bench_als();
+    bench_hnsw();
+    bench_personalized();
+    bench_recommendation_cache();
+    bench_batch_recommendations();
+    bench_recommendation_table();
+    
+    printf("\nBenchmarks concluídos.\n");
+    return 0;
+}
+
+// Tempo decorrido em milissegundos desde o instante indicado
+static double bench_elapsed_ms(clock_t start) {
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+// Tempo de relógio (não de CPU) em milissegundos, para medir código com threads
+static double bench_wall_ms() {
+#ifdef _WIN32
+    return (double)clock() * 1000.0 / CLOCKS_PER_SEC;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+#endif
+}
+
+// Versão anterior do conversor (cópia + toupper + strcmp), usada como referência
+static InteractionType bench_type_from_string_reference(const char *str) {
+    char upper_str[MAX_INTERACTION_TYPE_LENGTH];
+    size_t len = strlen(str);
+    
+    if (len >= MAX_INTERACTION_TYPE_LENGTH) {
+        len = MAX_INTERACTION_TYPE_LENGTH - 1;
+    }
+    
+    for (size_t i = 0; i < len; i++) {
+        upper_str[i] = toupper(str[i]);
+    }
+    upper_str[len] = '\0';
+    
+    if (strcmp(upper_str, "PLAY") == 0) {
+        return INTERACTION_PLAY;
+    } else if (strcmp(upper_str, "PAUSE") == 0) {
+        return INTERACTION_PAUSE;
+    } else if (strcmp(upper_str, "COMPLETE") == 0) {
+        return INTERACTION_COMPLETE;
+    } else if (strcmp(upper_str, "FAVORITE") == 0) {
+        return INTERACTION_FAVORITE;
+    }
+    
+    return INTERACTION_PLAY;
+}
+
+// Gera um ficheiro de interações com tipos textuais ou numéricos
+static int bench_write_interactions(const char *filename, int numeric) {
+    static const char *names[] = {"PLAY", "pause", "Complete", "FAVORITE"};
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    fprintf(file, "ID_Utilizador,ID_Conteudo,Tipo,Timestamp\n");
+    srand(42);
+    for (int i = 0; i < BENCH_INTERACTIONS; i++) {
+        int type = rand() % 4;
+        if (numeric) {
+            fprintf(file, "%d,%d,%d,%ld\n", 1 + rand() % BENCH_USERS, 
+                    1 + rand() % BENCH_CONTENTS, type, 1600000000L + i);
+        } else {
+            fprintf(file, "%d,%d,%s,%ld\n", 1 + rand() % BENCH_USERS, 
+                    1 + rand() % BENCH_CONTENTS, names[type], 1600000000L + i);
+        }
+    }
+    
+    fclose(file);
+    return 1;
+}
+
+// Carrega um ficheiro de interações e retorna o tempo em milissegundos
+static double bench_load_interactions(const char *filename, int *loaded) {
+    UserManager manager;
+    char username[32];
+    
+    user_init_manager(&manager, BENCH_USERS, BENCH_INTERACTIONS);
+    for (int i = 0; i < BENCH_USERS; i++) {
+        sprintf(username, "user%d", i);
+        user_add(&manager, username);
+    }
+    
+    clock_t start = clock();
+    *loaded = user_load_interactions_from_csv(&manager, filename);
+    double elapsed = bench_elapsed_ms(start);
+    
+    user_free_manager(&manager);
+    return elapsed;
+}
+
+/**
+ * @brief Compara o conversor de tipos atual com a versão de referência
+ */
+void bench_interaction_type_parsing() {
+    static const char *names[] = {"PLAY", "pause", "Complete", "FAVORITE", "play", "COMPLETE", "Pause"};
+    const char **inputs = (const char**)malloc(BENCH_INTERACTIONS * sizeof(const char*));
+    // Chamadas indiretas para que nenhuma das versões seja expandida em linha
+    InteractionType (*volatile reference)(const char*) = bench_type_from_string_reference;
+    InteractionType (*volatile fast)(const char*) = user_interaction_type_from_string;
+    long sink = 0;
+    
+    if (inputs == NULL) {
+        return;
+    }
+    
+    srand(7);
+    for (int i = 0; i < BENCH_INTERACTIONS; i++) {
+        inputs[i] = names[rand() % 7];
+    }
+    
+    printf("Conversão de tipos de interação (%d x %d chamadas):\n", 
+           BENCH_PARSE_ROUNDS, BENCH_INTERACTIONS);
+    
+    clock_t start = clock();
+    for (int round = 0; round < BENCH_PARSE_ROUNDS; round++) {
+        for (int i = 0; i < BENCH_INTERACTIONS; i++) {
+            sink += reference(inputs[i]);
+        }
+    }
+    double reference_ms = bench_elapsed_ms(start);
+    
+    start = clock();
+    for (int round = 0; round < BENCH_PARSE_ROUNDS; round++) {
+        for (int i = 0; i < BENCH_INTERACTIONS; i++) {
+            sink -= fast(inputs[i]);
+        }
+    }
+    double fast_ms = bench_elapsed_ms(start);
+    
+    printf("  referência (cópia + strcmp): %8.1f ms\n", reference_ms);
+    printf("  dispersão perfeita:          %8.1f ms (%.1fx)\n", fast_ms, 
+           fast_ms > 0 ? reference_ms / fast_ms : 0.0);
+    
+    // Ambas as versões devem concordar nos tipos textuais
+    if (sink != 0) {
+        printf("  aviso: resultados divergentes\n");
+    }
+    free(inputs);
+}
+
+/**
+ * @brief Mede o carregamento de interações com coluna de tipo textual e numérica
+ */
+void bench_interaction_loader() {
+    int loaded = 0;
+    
+    printf("Carregamento de %d interações:\n", BENCH_INTERACTIONS);
+    
+    if (!bench_write_interactions(BENCH_TEXT_FILE, 0) || 
+        !bench_write_interactions(BENCH_NUMERIC_FILE, 1)) {
+        printf("  erro ao gerar ficheiros de teste\n");
+        return;
+    }
+    
+    double text_ms = bench_load_interactions(BENCH_TEXT_FILE, &loaded);
+    printf("  tipo textual:  %8.1f ms (%d linhas)\n", text_ms, loaded);
+    
+    double numeric_ms = bench_load_interactions(BENCH_NUMERIC_FILE, &loaded);
+    printf("  tipo numérico: %8.1f ms (%d linhas)\n", numeric_ms, loaded);
+    
+    remove(BENCH_TEXT_FILE);
+    remove(BENCH_NUMERIC_FILE);
+}
+
+/**
+ * @brief Mede a ordenação das interações por (utilizador, timestamp) com 1, 2 e 4 threads
+ * 
+ * Mede também uma varredura completa da compactação por retenção sobre o
+ * histórico já ordenado, em que as interações antigas não formam um prefixo.
+ * 
+ * @param rows Número de interações a ordenar
+ */
+void bench_interaction_sort(int rows) {
+    static const int thread_counts[] = {1, 2, 4};
+    
+    printf("Ordenação radix de %d interações:\n", rows);
+    
+    for (int k = 0; k < 3; k++) {
+        UserManager manager;
+        if (!user_init_manager(&manager, 1, rows)) {
+            printf("  erro de memória\n");
+            return;
+        }
+        
+        // Histórico sintético em ordem cronológica com utilizadores aleatórios
+        srand(42);
+        for (int i = 0; i < rows; i++) {
+            Interaction *interaction = &manager.interactions[i];
+            interaction->user_id = 1 + rand() % 1000000;
+            interaction->content_id = 1 + rand() % BENCH_CONTENTS;
+            interaction->type = (InteractionType)(rand() % 4);
+            interaction->timestamp = 1600000000L + i / 10;
+        }
+        manager.interaction_count = rows;
+        
+        double start = bench_wall_ms();
+        int sorted = user_sort_interactions(&manager, thread_counts[k]);
+        double elapsed = bench_wall_ms() - start;
+        
+        printf("  %d thread(s): %8.1f ms (%.1f ns por interação)%s\n", thread_counts[k], elapsed, 
+               rows > 0 ? elapsed * 1e6 / rows : 0.0, sorted ? "" : " (falhou)");
+        
+        // Uma varredura da retenção sobre o histórico ordenado: metade das interações é
+        // antiga e fica espalhada pelos blocos de cada utilizador, não num prefixo
+        if (k == 2 && sorted) {
+            user_set_retention(&manager, 1);
+            int steps = 0;
+            int compacted = 0;
+            double slowest = 0.0;
+            double sweep_start = bench_wall_ms();
+            do {
+                start = bench_wall_ms();
+                int step = user_compact_interactions(&manager, 1600000000L + rows / 20 + 86400, 
+                                                     BENCH_COMPACT_ROWS);
+                elapsed = bench_wall_ms() - start;
+                if (elapsed > slowest) {
+                    slowest = elapsed;
+                }
+                compacted += step > 0 ? step : 0;
+                steps++;
+            } while (manager.retention.cursor != 0 && steps <= rows / BENCH_COMPACT_ROWS + 1);
+            printf("  varredura em passos de %d interações: %d passos, %8.1f ms no total, "
+                   "passo mais lento %.1f ms (%d agregadas)\n", BENCH_COMPACT_ROWS, steps, 
+                   bench_wall_ms() - sweep_start, slowest, compacted);
+        }
+        user_free_manager(&manager);
+    }
+}
+
+// Argumentos de uma thread leitora do catálogo
+typedef struct {
+    ContentCatalog *catalog;
+    int queries;
+    long found;
+} BenchReader;
+
+// Executa pesquisas por categoria dentro de secções de leitura
+static void *bench_reader_run(void *arg) {
+    BenchReader *reader = (BenchReader*)arg;
+    int slot = content_reader_register(reader->catalog);
+    int results[16];
+    
+    for (int i = 0; i < reader->queries; i++) {
+        content_read_lock(reader->catalog, slot);
+        reader->found += content_search_by_category(reader->catalog, "Drama", results, 16);
+        reader->found += content_get_by_id(reader->catalog, 1 + i % BENCH_CONTENTS) != NULL;
+        content_read_unlock(reader->catalog, slot);
+    }
+    content_reader_unregister(reader->catalog, slot);
+    return NULL;
+}
+
+/**
+ * @brief Mede o débito de leitores concorrentes do catálogo enquanto um escritor edita
+ */
+void bench_catalog_readers() {
+    static const int reader_counts[] = {1, 2, 4, 8};
+    
+    printf("Leitores concorrentes do catálogo (%d pesquisas por thread):\n", BENCH_READER_QUERIES);
+    
+    for (int k = 0; k < 4; k++) {
+        ContentCatalog catalog;
+        BenchReader readers[8];
+        pthread_t threads[8];
+        char title[32];
+        int threads_count = reader_counts[k];
+        
+        content_init_catalog(&catalog, BENCH_CONTENTS);
+        for (int i = 0; i < BENCH_CONTENTS; i++) {
+            sprintf(title, "Titulo %d", i);
+            content_add(&catalog, title, i % 2 ? "Drama" : "Ação", 90, 12);
+        }
+        
+        double start = bench_wall_ms();
+        for (int t = 0; t < threads_count; t++) {
+            readers[t].catalog = &catalog;
+            readers[t].queries = BENCH_READER_QUERIES;
+            readers[t].found = 0;
+            pthread_create(&threads[t], NULL, bench_reader_run, &readers[t]);
+        }
+        
+        // Escritor: edições e adições esporádicas enquanto os leitores trabalham
+        for (int i = 0; i < 50; i++) {
+            content_edit(&catalog, 1 + i, "Editado", NULL, 0, -1);
+            content_add(&catalog, "Novo", "Drama", 60, 0);
+        }
+        
+        for (int t = 0; t < threads_count; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        double elapsed = bench_wall_ms() - start;
+        
+        printf("  %d leitor(es): %8.1f ms (%.0f pesquisas/s)\n", threads_count, elapsed, 
+               elapsed > 0 ? threads_count * BENCH_READER_QUERIES * 1000.0 / elapsed : 0.0);
+        content_free_catalog(&catalog);
+    }
+}
+
+// Argumentos de uma thread que incrementa as visualizações do mesmo título
+typedef struct {
+    ContentCatalog *catalog;
+    Content *content;
+    int sharded;
+} BenchViewWriter;
+
+// Incrementa as visualizações num contador partilhado ou na fatia da thread
+static void *bench_view_writer_run(void *arg) {
+    BenchViewWriter *writer = (BenchViewWriter*)arg;
+    
+    for (int i = 0; i < BENCH_VIEWS_PER_THREAD; i++) {
+        if (writer->sharded) {
+            content_add_views(writer->catalog, writer->content->id, 1);
+        } else {
+            __atomic_fetch_add(&writer->content->views, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Compara um contador atómico partilhado com as fatias por thread num título muito visto
+ */
+void bench_view_counters() {
+    pthread_t threads[BENCH_VIEW_THREADS];
+    BenchViewWriter writers[BENCH_VIEW_THREADS];
+    
+    printf("Visualizações de um título por %d threads (%d cada):\n", 
+           BENCH_VIEW_THREADS, BENCH_VIEWS_PER_THREAD);
+    
+    for (int sharded = 0; sharded <= 1; sharded++) {
+        ContentCatalog catalog;
+        content_init_catalog(&catalog, 1);
+        int id = content_add(&catalog, "Popular", "Ação", 90, 12);
+        const Content *content = content_get_by_id(&catalog, id);
+        
+        double start = bench_wall_ms();
+        for (int t = 0; t < BENCH_VIEW_THREADS; t++) {
+            writers[t].catalog = &catalog;
+            writers[t].content = (Content*)content; // O termo de comparação soma no próprio Content.views
+            writers[t].sharded = sharded;
+            pthread_create(&threads[t], NULL, bench_view_writer_run, &writers[t]);
+        }
+        for (int t = 0; t < BENCH_VIEW_THREADS; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        double elapsed = bench_wall_ms() - start;
+        
+        printf("  %-26s %8.1f ms (total %d)\n", 
+               sharded ? "fatias por thread:" : "atómico partilhado:", elapsed, 
+               content_get_views(&catalog, content));
+        content_free_catalog(&catalog);
+    }
+}
+
+// Acumula uma dispersão de cada índice do bloco (trabalho de CPU sem memória partilhada)
+static void bench_pool_map(void *context, int begin, int end, void *partial) {
+    unsigned long long sum = 0;
+    (void)context;
+    for (int i = begin; i < end; i++) {
+        unsigned int x = (unsigned int)i * 2654435761u;
+        x ^= x >> 15;
+        sum += x * 2246822519u;
+    }
+    *(unsigned long long*)partial += sum;
+}
+
+static void bench_pool_combine(void *context, void *into, const void *from) {
+    (void)context;
+    *(unsigned long long*)into += *(const unsigned long long*)from;
+}
+
+/**
+ * @brief Mede a redução paralela do conjunto de threads com 1, 2, 4 e 8 trabalhadoras
+ */
+void bench_threadpool_scaling() {
+    static const int worker_counts[] = {1, 2, 4, 8};
+    unsigned long long identity = 0, expected = 0, result = 0;
+    
+    printf("Redução paralela de %d elementos:\n", BENCH_POOL_ITEMS);
+    
+    double start = bench_wall_ms();
+    threadpool_parallel_reduce(NULL, 0, BENCH_POOL_ITEMS, 65536, bench_pool_map, 
+                               bench_pool_combine, NULL, &expected, &identity, sizeof(expected));
+    double serial_ms = bench_wall_ms() - start;
+    printf("  em série:          %8.1f ms\n", serial_ms);
+    
+    for (int k = 0; k < 4; k++) {
+        ThreadPool pool;
+        if (!threadpool_init(&pool, worker_counts[k])) {
+            printf("  erro ao criar as threads\n");
+            return;
+        }
+        
+        start = bench_wall_ms();
+        threadpool_parallel_reduce(&pool, 0, BENCH_POOL_ITEMS, 65536, bench_pool_map, 
+                                   bench_pool_combine, NULL, &result, &identity, sizeof(result));
+        double elapsed = bench_wall_ms() - start;
+        
+        printf("  %d trabalhadora(s): %8.1f ms (%.2fx)%s\n", worker_counts[k], elapsed, 
+               elapsed > 0 ? serial_ms / elapsed : 0.0, 
+               result == expected ? "" : " (resultado divergente)");
+        threadpool_free(&pool);
+    }
+}
+
+// Chamadas a malloc feitas pela versão anterior da tabela de exportação
+static size_t bench_malloc_calls = 0;
+
+static void *bench_counted_malloc(size_t size) {
+    bench_malloc_calls++;
+    return malloc(size);
+}
+
+/**
+ * @brief Compara as alocações da tabela de exportação de relatórios com malloc por célula e com arena
+ */
+void bench_export_allocations() {
+    char title[32];
+    long sink = 0;
+    
+    printf("Tabela de exportação (%d pedidos de %d linhas):\n", 
+           BENCH_EXPORT_REQUESTS, BENCH_EXPORT_ROWS);
+    
+    // Versão anterior: um malloc por linha e por célula, libertados no fim do pedido
+    double start = bench_wall_ms();
+    for (int request = 0; request < BENCH_EXPORT_REQUESTS; request++) {
+        char ***data = (char***)bench_counted_malloc(BENCH_EXPORT_ROWS * sizeof(char**));
+        for (int i = 0; i < BENCH_EXPORT_ROWS; i++) {
+            data[i] = (char**)bench_counted_malloc(3 * sizeof(char*));
+            data[i][0] = (char*)bench_counted_malloc(20);
+            sprintf(data[i][0], "%d", i);
+            sprintf(title, "Titulo %d", i);
+            data[i][1] = (char*)bench_counted_malloc(MAX_TITLE_LENGTH);
+            strcpy(data[i][1], title);
+            data[i][2] = (char*)bench_counted_malloc(20);
+            sprintf(data[i][2], "%d", i * 3);
+        }
+        sink += data[BENCH_EXPORT_ROWS - 1][1][0];
+        for (int i = 0; i < BENCH_EXPORT_ROWS; i++) {
+            for (int j = 0; j < 3; j++) {
+                free(data[i][j]);
+            }
+            free(data[i]);
+        }
+        free(data);
+    }
+    double malloc_ms = bench_wall_ms() - start;
+    
+    // Arena de rascunho reposta em O(1) no fim de cada pedido
+    Arena arena;
+    arena_init(&arena, ARENA_SCRATCH_BLOCK_SIZE);
+    start = bench_wall_ms();
+    for (int request = 0; request < BENCH_EXPORT_REQUESTS; request++) {
+        char ***data = (char***)arena_alloc(&arena, BENCH_EXPORT_ROWS * sizeof(char**));
+        for (int i = 0; i < BENCH_EXPORT_ROWS; i++) {
+            data[i] = (char**)arena_alloc(&arena, 3 * sizeof(char*));
+            data[i][0] = arena_printf(&arena, "%d", i);
+            sprintf(title, "Titulo %d", i);
+            data[i][1] = arena_strdup(&arena, title);
+            data[i][2] = arena_printf(&arena, "%d", i * 3);
+        }
+        sink -= data[BENCH_EXPORT_ROWS - 1][1][0];
+        arena_reset(&arena);
+    }
+    double arena_ms = bench_wall_ms() - start;
+    
+    printf("  malloc por célula: %8.1f ms (%zu chamadas a malloc)\n", malloc_ms, bench_malloc_calls);
+    printf("  arena de rascunho: %8.1f ms (%zu chamadas a malloc, %zu pedidos servidos)\n", 
+           arena_ms, arena.block_allocations, arena.allocations);
+    if (sink != 0) {
+        printf("  aviso: resultados divergentes\n");
+    }
+    arena_free(&arena);
+}
+
+// Score de um título na versão anterior (copiar todos os candidatos e ordenar)
+typedef struct {
+    int content_id;
+    float score;
+} BenchScore;
+
+// Ordem decrescente de score; em empate, pela posição no catálogo (como a seleção)
+static int bench_compare_scores(const void *a, const void *b) {
+    const BenchScore *score_a = (const BenchScore*)a;
+    const BenchScore *score_b = (const BenchScore*)b;
+    
+    if (score_b->score > score_a->score) return 1;
+    if (score_b->score < score_a->score) return -1;
+    return score_a->content_id - score_b->content_id;
+}
+
+/**
+ * @brief Compara qsort de todo o catálogo com a seleção top-K num catálogo de 1M títulos
+ */
+void bench_topk_selection() {
+    ContentCatalog catalog;
+    int reference[MAX_RECOMMENDATIONS], selected[MAX_RECOMMENDATIONS];
+    
+    printf("Recomendação por popularidade em %d títulos (%d pedidos):\n", 
+           BENCH_TOPK_TITLES, BENCH_TOPK_ROUNDS);
+    
+    if (!content_init_catalog(&catalog, BENCH_TOPK_TITLES)) {
+        printf("  erro de memória\n");
+        return;
+    }
+    
+    // Catálogo gerado em CSV (content_add procura o próximo ID em O(n) por título)
+    FILE *file = fopen(BENCH_CATALOG_FILE, "w");
+    if (file == NULL) {
+        content_free_catalog(&catalog);
+        return;
+    }
+    fprintf(file, "ID,Titulo,Categoria,Duracao,Classificacao,Visualizacoes\n");
+    srand(11);
+    for (int i = 0; i < BENCH_TOPK_TITLES; i++) {
+        fprintf(file, "%d,Titulo %d,Drama,90,12,%d\n", i + 1, i, rand() % 5000);
+    }
+    fclose(file);
+    content_load_from_csv(&catalog, BENCH_CATALOG_FILE);
+    remove(BENCH_CATALOG_FILE);
+    
+    int content_count;
+    const Content *items = content_snapshot(&catalog, &content_count);
+    BenchScore *scores = (BenchScore*)malloc(content_count * sizeof(BenchScore));
+    if (scores == NULL) {
+        content_free_catalog(&catalog);
+        return;
+    }
+    
+    double start = bench_wall_ms();
+    for (int round = 0; round < BENCH_TOPK_ROUNDS; round++) {
+        for (int i = 0; i < content_count; i++) {
+            scores[i].content_id = items[i].id;
+            scores[i].score = (float)content_get_views(&catalog, &items[i]);
+        }
+        qsort(scores, content_count, sizeof(BenchScore), bench_compare_scores);
+        for (int i = 0; i < MAX_RECOMMENDATIONS; i++) {
+            reference[i] = scores[i].content_id;
+        }
+    }
+    double sort_ms = bench_wall_ms() - start;
+    
+    start = bench_wall_ms();
+    int count = 0;
+    for (int round = 0; round < BENCH_TOPK_ROUNDS; round++) {
+        count = recommendation_by_popularity(&catalog, selected, MAX_RECOMMENDATIONS);
+    }
+    double topk_ms = bench_wall_ms() - start;
+    
+    int same = count == MAX_RECOMMENDATIONS && 
+               memcmp(reference, selected, sizeof(reference)) == 0;
+    printf("  qsort de todos:  %8.1f ms\n", sort_ms);
+    printf("  heap top-%d:     %8.1f ms (%.1fx)%s\n", MAX_RECOMMENDATIONS, topk_ms, 
+           topk_ms > 0 ? sort_ms / topk_ms : 0.0, same ? "" : " (resultado divergente)");
+    
+    free(scores);
+    content_free_catalog(&catalog);
+}
+
+/**
+ * @brief Compara a recomendação por similaridade com varrimento do catálogo
+ * e com a junção das listas de vizinhos pré-calculadas
+ */
+void bench_neighbor_lists() {
+    static const char *categories[] = {"Drama", "Comédia", "Ação", "Terror", "Documentário", "Animação"};
+    ContentCatalog catalog;
+    UserManager manager;
+    NeighborTable table;
+    ThreadPool pool;
+    int scan[MAX_RECOMMENDATIONS], merged[MAX_RECOMMENDATIONS];
+    
+    printf("Recomendação por similaridade em %d títulos (%d assistidos, %d pedidos):\n", 
+           BENCH_NEIGHBOR_TITLES, BENCH_NEIGHBOR_WATCHED, BENCH_NEIGHBOR_ROUNDS);
+    
+    if (!content_init_catalog(&catalog, BENCH_NEIGHBOR_TITLES)) {
+        printf("  erro de memória\n");
+        return;
+    }
+    
+    FILE *file = fopen(BENCH_CATALOG_FILE, "w");
+    if (file == NULL) {
+        content_free_catalog(&catalog);
+        return;
+    }
+    fprintf(file, "ID,Titulo,Categoria,Duracao,Classificacao,Visualizacoes\n");
+    srand(13);
+    for (int i = 0; i < BENCH_NEIGHBOR_TITLES; i++) {
+        fprintf(file, "%d,Titulo %d,%s,%d,%d,0\n", i + 1, i, categories[rand() % 6], 
+                20 + rand() % 160, (rand() % 4) * 6);
+    }
+    fclose(file);
+    content_load_from_csv(&catalog, BENCH_CATALOG_FILE);
+    remove(BENCH_CATALOG_FILE);
+    
+    user_init_manager(&manager, 4, BENCH_NEIGHBOR_WATCHED);
+    int user = user_add(&manager, "bench");
+    for (int i = 0; i < BENCH_NEIGHBOR_WATCHED; i++) {
+        user_register_interaction(&manager, user, 1 + rand() % BENCH_NEIGHBOR_TITLES, INTERACTION_COMPLETE);
+    }
+    
+    double start = bench_wall_ms();
+    for (int round = 0; round < BENCH_NEIGHBOR_ROUNDS; round++) {
+        recommendation_by_content_similarity(&manager, &catalog, user, scan, MAX_RECOMMENDATIONS);
+    }
+    double scan_ms = bench_wall_ms() - start;
+    
+    int pool_ready = threadpool_init(&pool, THREADPOOL_DEFAULT_WORKERS);
+    start = bench_wall_ms();
+    int built = neighbors_init(&table, NEIGHBORS_DEFAULT_COUNT) && 
+                neighbors_build(&table, &catalog, pool_ready ? &pool : NULL);
+    double build_ms = bench_wall_ms() - start;
+    
+    if (built) {
+        recommendation_set_neighbors(&table);
+        start = bench_wall_ms();
+        int count = 0;
+        for (int round = 0; round < BENCH_NEIGHBOR_ROUNDS; round++) {
+            count = recommendation_by_content_similarity(&manager, &catalog, user, merged, MAX_RECOMMENDATIONS);
+        }
+        double merge_ms = bench_wall_ms() - start;
+        recommendation_set_neighbors(NULL);
+        
+        // Quantas das recomendações exatas a junção das listas também devolve
+        int overlap = 0;
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j < MAX_RECOMMENDATIONS; j++) {
+                if (merged[i] == scan[j]) {
+                    overlap++;
+                    break;
+                }
+            }
+        }
+        
+        printf("  construção das listas (N=%d): %8.1f ms\n", NEIGHBORS_DEFAULT_COUNT, build_ms);
+        printf("  varrimento do catálogo:       %8.1f ms\n", scan_ms);
+        printf("  junção das listas:            %8.1f ms (%.1fx, %d/%d em comum)\n", merge_ms, 
+               merge_ms > 0 ? scan_ms / merge_ms : 0.0, overlap, MAX_RECOMMENDATIONS);
+    } else {
+        printf("  erro ao construir as listas\n");
+    }
+    
+    neighbors_free(&table);
+    if (pool_ready) {
+        threadpool_free(&pool);
+    }
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+}
+
+/**
+ * @brief Compara a pontuação do catálogo par a par com a versão vetorizada em cada nível
+ */
+void bench_similarity_kernel() {
+    static const char *names[] = {"Drama", "Comédia", "Ação", "Terror", "Documentário", "Animação"};
+    
+    printf("Pontuação de %d títulos contra %d assistidos (por pedido):\n", 
+           BENCH_KERNEL_TITLES, BENCH_NEIGHBOR_WATCHED);
+    
+    Content *items = (Content*)malloc(BENCH_KERNEL_TITLES * sizeof(Content));
+    int *categories = (int*)malloc(BENCH_KERNEL_TITLES * sizeof(int));
+    int *age_ratings = (int*)malloc(BENCH_KERNEL_TITLES * sizeof(int));
+    int *durations = (int*)malloc(BENCH_KERNEL_TITLES * sizeof(int));
+    float *reference = (float*)malloc(BENCH_KERNEL_TITLES * sizeof(float));
+    float *scores = (float*)malloc(BENCH_KERNEL_TITLES * sizeof(float));
+    if (items == NULL || categories == NULL || age_ratings == NULL || durations == NULL ||
+        reference == NULL || scores == NULL) {
+        printf("  erro de memória\n");
+        free(items); free(categories); free(age_ratings); free(durations); free(reference); free(scores);
+        return;
+    }
+    
+    srand(17);
+    for (int i = 0; i < BENCH_KERNEL_TITLES; i++) {
+        categories[i] = rand() % 6;
+        age_ratings[i] = (rand() % 4) * 6;
+        durations[i] = 20 + rand() % 160;
+        items[i].id = i + 1;
+        strcpy(items[i].category, names[categories[i]]);
+        items[i].age_rating = age_ratings[i];
+        items[i].duration = durations[i];
+    }
+    
+    int watched[BENCH_NEIGHBOR_WATCHED];
+    for (int j = 0; j < BENCH_NEIGHBOR_WATCHED; j++) {
+        watched[j] = rand() % BENCH_KERNEL_TITLES;
+    }
+    
+    // Referência: o ciclo de recommendation_by_content_similarity sem tabela
+    double start = bench_wall_ms();
+    for (int round = 0; round < BENCH_KERNEL_ROUNDS; round++) {
+        for (int i = 0; i < BENCH_KERNEL_TITLES; i++) {
+            float total = 0.0f;
+            for (int j = 0; j < BENCH_NEIGHBOR_WATCHED; j++) {
+                total += recommendation_calculate_similarity(&items[watched[j]], &items[i]);
+            }
+            reference[i] = total;
+        }
+    }
+    double pairs_ms = bench_wall_ms() - start;
+    printf("  par a par (strcmp): %10.1f us\n", pairs_ms * 1000.0 / BENCH_KERNEL_ROUNDS);
+    
+    SimKernelLevel supported = simkernel_supported();
+    for (int level = SIMKERNEL_SCALAR; level <= (int)supported; level++) {
+        simkernel_set_level((SimKernelLevel)level);
+        
+        start = bench_wall_ms();
+        for (int round = 0; round < BENCH_KERNEL_ROUNDS; round++) {
+            memset(scores, 0, BENCH_KERNEL_TITLES * sizeof(float));
+            for (int j = 0; j < BENCH_NEIGHBOR_WATCHED; j++) {
+                int w = watched[j];
+                simkernel_accumulate(categories[w], age_ratings[w], durations[w], categories, 
+                                     age_ratings, durations, BENCH_KERNEL_TITLES, scores);
+            }
+        }
+        double kernel_ms = bench_wall_ms() - start;
+        
+        int same = 1;
+        for (int i = 0; i < BENCH_KERNEL_TITLES; i++) {
+            if (scores[i] - reference[i] > 1e-5f || reference[i] - scores[i] > 1e-5f) {
+                same = 0;
+                break;
+            }
+        }
+        printf("  %-8s (arrays):  %10.1f us (%.1fx)%s\n", simkernel_level_name((SimKernelLevel)level),
+               kernel_ms * 1000.0 / BENCH_KERNEL_ROUNDS, kernel_ms > 0 ? pairs_ms / kernel_ms : 0.0,
+               same ? "" : " (resultado divergente)");
+    }
+    simkernel_set_level(supported);
+    
+    free(items);
+    free(categories);
+    free(age_ratings);
+    free(durations);
+    free(reference);
+    free(scores);
+}
+
+/**
+ * @brief Mede a construção do modelo colaborativo (em série e em paralelo) e o custo por pedido
+ */
+void bench_collaborative_filtering() {
+    ContentCatalog catalog;
+    UserManager manager;
+    CollabModel model;
+    ThreadPool pool;
+    char username[MAX_USERNAME_LENGTH];
+    int recommendations[MAX_RECOMMENDATIONS];
+    
+    printf("Filtragem colaborativa (%d utilizadores x %d interações, %d títulos):\n", 
+           BENCH_COLLAB_USERS, BENCH_COLLAB_HISTORY, BENCH_CONTENTS);
+    
+    if (!content_init_catalog(&catalog, BENCH_CONTENTS) || 
+        !user_init_manager(&manager, BENCH_COLLAB_USERS, BENCH_COLLAB_USERS * BENCH_COLLAB_HISTORY)) {
+        printf("  erro de memória\n");
+        return;
+    }
+    for (int i = 0; i < BENCH_CONTENTS; i++) {
+        content_add(&catalog, "Titulo", "Drama", 90, 12);
+    }
+    
+    // Cada utilizador vê sobretudo títulos de um de 50 grupos, com algum ruído
+    user_set_mock_clock(&manager, 1700000000, 1);
+    srand(23);
+    for (int u = 1; u <= BENCH_COLLAB_USERS; u++) {
+        snprintf(username, sizeof(username), "bench%d", u);
+        user_add(&manager, username);
+        int group = rand() % 50;
+        for (int k = 0; k < BENCH_COLLAB_HISTORY; k++) {
+            int item = rand() % 4 == 0 ? 1 + rand() % BENCH_CONTENTS : 
+                       1 + group * (BENCH_CONTENTS / 50) + rand() % (BENCH_CONTENTS / 50);
+            user_register_interaction(&manager, u, item, (InteractionType)(rand() % 4));
+        }
+    }
+    
+    collab_init(&model, COLLAB_DEFAULT_NEIGHBORS);
+    double start = bench_wall_ms();
+    collab_build(&model, &manager, &catalog, NULL);
+    double serial_ms = bench_wall_ms() - start;
+    
+    double parallel_ms = 0.0;
+    if (threadpool_init(&pool, THREADPOOL_DEFAULT_WORKERS)) {
+        start = bench_wall_ms();
+        collab_build(&model, &manager, &catalog, &pool);
+        parallel_ms = bench_wall_ms() - start;
+        threadpool_free(&pool);
+    }
+    
+    start = bench_wall_ms();
+    int total = 0;
+    for (int i = 0; i < BENCH_COLLAB_REQUESTS; i++) {
+        total += collab_recommend(&model, 1 + i % BENCH_COLLAB_USERS, recommendations, MAX_RECOMMENDATIONS);
+    }
+    double request_ms = bench_wall_ms() - start;
+    
+    printf("  matriz: %d entradas\n", model.matrix.entry_count);
+    printf("  construção em série:     %8.1f ms\n", serial_ms);
+    printf("  construção (%d threads): %8.1f ms\n", THREADPOOL_DEFAULT_WORKERS, parallel_ms);
+    printf("  recomendação:            %8.1f us por pedido (%d recomendações)\n", 
+           request_ms * 1000.0 / BENCH_COLLAB_REQUESTS, total);
+    
+    collab_free(&model);
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+}
+
+/**
+ * @brief Mede o treino ALS (em série e em paralelo), a qualidade (recall@10) e o custo por pedido
+ */
+void bench_als() {
+    ContentCatalog catalog;
+    UserManager manager;
+    AlsModel model;
+    ThreadPool pool;
+    char username[MAX_USERNAME_LENGTH];
+    int recommendations[MAX_RECOMMENDATIONS];
+    int *held_out = (int*)malloc((BENCH_COLLAB_USERS + 1) * sizeof(int));
+    
+    printf("Fatorização ALS (%d utilizadores x %d interações, %d títulos, %d fatores):\n", 
+           BENCH_COLLAB_USERS, BENCH_ALS_HISTORY, BENCH_CONTENTS, ALS_DEFAULT_FACTORS);
+    
+    if (held_out == NULL || !content_init_catalog(&catalog, BENCH_CONTENTS) || 
+        !user_init_manager(&manager, BENCH_COLLAB_USERS, BENCH_COLLAB_USERS * BENCH_ALS_HISTORY)) {
+        printf("  erro de memória\n");
+        free(held_out);
+        return;
+    }
+    for (int i = 0; i < BENCH_CONTENTS; i++) {
+        content_add(&catalog, "Titulo", "Drama", 90, 12);
+    }
+    
+    // Grupos como em bench_collaborative_filtering; um título do grupo fica de fora por utilizador
+    int group_size = BENCH_CONTENTS / 50;
+    user_set_mock_clock(&manager, 1700000000, 1);
+    srand(29);
+    for (int u = 1; u <= BENCH_COLLAB_USERS; u++) {
+        snprintf(username, sizeof(username), "bench%d", u);
+        user_add(&manager, username);
+        int group = rand() % 50;
+        held_out[u] = 1 + group * group_size + rand() % group_size;
+        for (int k = 0; k < BENCH_ALS_HISTORY; k++) {
+            int item = rand() % 4 == 0 ? 1 + rand() % BENCH_CONTENTS : 
+                       1 + group * group_size + rand() % group_size;
+            if (item != held_out[u]) {
+                user_register_interaction(&manager, u, item, (InteractionType)(rand() % 4));
+            }
+        }
+    }
+    
+    als_init(&model, ALS_DEFAULT_FACTORS, ALS_DEFAULT_REGULARIZATION, ALS_DEFAULT_ALPHA);
+    double start = bench_wall_ms();
+    als_train(&model, &manager, &catalog, ALS_DEFAULT_ITERATIONS, NULL);
+    double serial_ms = bench_wall_ms() - start;
+    
+    double parallel_ms = 0.0;
+    if (threadpool_init(&pool, THREADPOOL_DEFAULT_WORKERS)) {
+        start = bench_wall_ms();
+        als_train(&model, &manager, &catalog, ALS_DEFAULT_ITERATIONS, &pool);
+        parallel_ms = bench_wall_ms() - start;
+        threadpool_free(&pool);
+    }
+    
+    // Recall@10: o título retirado aparece nas 10 primeiras recomendações?
+    CollabMatrix *matrix = &model.matrix;
+    int als_hits = 0, popular_hits = 0;
+    for (int u = 1; u <= BENCH_COLLAB_USERS; u++) {
+        int count = als_recommend(&model, u, recommendations, 10);
+        for (int i = 0; i < count; i++) {
+            als_hits += recommendations[i] == held_out[u];
+        }
+        
+        // Referência: os 10 títulos com mais utilizadores que o utilizador ainda não viu
+        int row = collab_matrix_find_row(matrix, u);
+        TopK popular;
+        if (row < 0 || !topk_init(&popular, 10)) {
+            continue;
+        }
+        int seen = matrix->row_offsets[row];
+        for (int id = 1; id < matrix->item_slots; id++) {
+            while (seen < matrix->row_offsets[row + 1] && matrix->columns[seen] < id) {
+                seen++;
+            }
+            if (seen < matrix->row_offsets[row + 1] && matrix->columns[seen] == id) {
+                continue;
+            }
+            topk_push(&popular, id, (float)(matrix->column_offsets[id + 1] - matrix->column_offsets[id]));
+        }
+        count = topk_extract(&popular, recommendations, 10);
+        for (int i = 0; i < count; i++) {
+            popular_hits += recommendations[i] == held_out[u];
+        }
+        topk_free(&popular);
+    }
+    
+    // Varrimento dos fatores de todos os títulos por pedido, escalar e vetorizado
+    SimKernelLevel level_in_use = simkernel_level();
+    double request_ms[2];
+    for (int pass = 0; pass < 2; pass++) {
+        simkernel_set_level(pass == 0 ? SIMKERNEL_SCALAR : simkernel_supported());
+        start = bench_wall_ms();
+        for (int i = 0; i < BENCH_COLLAB_REQUESTS; i++) {
+            als_recommend(&model, 1 + i % BENCH_COLLAB_USERS, recommendations, MAX_RECOMMENDATIONS);
+        }
+        request_ms[pass] = bench_wall_ms() - start;
+    }
+    simkernel_set_level(level_in_use);
+    
+    printf("  matriz: %d entradas\n", matrix->entry_count);
+    printf("  treino em série (%d iterações):     %8.1f ms\n", ALS_DEFAULT_ITERATIONS, serial_ms);
+    printf("  treino (%d threads):                %8.1f ms\n", THREADPOOL_DEFAULT_WORKERS, parallel_ms);
+    printf("  recall@10 ALS:                      %8.3f\n", (double)als_hits / BENCH_COLLAB_USERS);
+    printf("  recall@10 popularidade:             %8.3f\n", (double)popular_hits / BENCH_COLLAB_USERS);
+    for (int pass = 0; pass < 2; pass++) {
+        printf("  recomendação (%-7s):             %8.1f us por pedido\n", 
+               simkernel_level_name(pass == 0 ? SIMKERNEL_SCALAR : simkernel_supported()), 
+               request_ms[pass] * 1000.0 / BENCH_COLLAB_REQUESTS);
+    }
+    
+    als_free(&model);
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+    free(held_out);
+}
+
+/**
+ * @brief Compara o índice HNSW com a pesquisa exata (recall@10 e latência para vários ef)
+ */
+void bench_hnsw() {
+    HnswIndex index;
+    TopK exact;
+    int *ids = (int*)malloc(BENCH_HNSW_COUNT * sizeof(int));
+    float *vectors = (float*)malloc((size_t)BENCH_HNSW_COUNT * BENCH_HNSW_DIMENSION * sizeof(float));
+    float *normalized = (float*)malloc((size_t)BENCH_HNSW_COUNT * BENCH_HNSW_DIMENSION * sizeof(float));
+    float *scores = (float*)malloc(BENCH_HNSW_COUNT * sizeof(float));
+    int *truth = (int*)malloc(BENCH_HNSW_QUERIES * 10 * sizeof(int));
+    float queries[BENCH_HNSW_QUERIES][BENCH_HNSW_DIMENSION];
+    int found[10];
+    
+    printf("Índice HNSW (%d vetores de %d dimensões, %d pesquisas de 10):\n", 
+           BENCH_HNSW_COUNT, BENCH_HNSW_DIMENSION, BENCH_HNSW_QUERIES);
+    
+    if (ids == NULL || vectors == NULL || normalized == NULL || scores == NULL || truth == NULL ||
+        !hnsw_init(&index, BENCH_HNSW_DIMENSION, HNSW_DEFAULT_M, HNSW_DEFAULT_EF_CONSTRUCTION)) {
+        printf("  erro de memória\n");
+        free(ids);
+        free(vectors);
+        free(normalized);
+        free(scores);
+        free(truth);
+        return;
+    }
+    
+    // Vetores agrupados à volta de 200 centros, como fatores latentes de conteúdos
+    srand(37);
+    float centers[200][BENCH_HNSW_DIMENSION];
+    for (int c = 0; c < 200; c++) {
+        for (int k = 0; k < BENCH_HNSW_DIMENSION; k++) {
+            centers[c][k] = (float)rand() / RAND_MAX - 0.5f;
+        }
+    }
+    for (int i = 0; i < BENCH_HNSW_COUNT; i++) {
+        ids[i] = i + 1;
+        int center = rand() % 200;
+        float norm = 0.0f;
+        for (int k = 0; k < BENCH_HNSW_DIMENSION; k++) {
+            float value = centers[center][k] + 0.3f * ((float)rand() / RAND_MAX - 0.5f);
+            vectors[(size_t)i * BENCH_HNSW_DIMENSION + k] = value;
+            norm += value * value;
+        }
+        for (int k = 0; k < BENCH_HNSW_DIMENSION; k++) {
+            normalized[(size_t)i * BENCH_HNSW_DIMENSION + k] = 
+                vectors[(size_t)i * BENCH_HNSW_DIMENSION + k] / sqrtf(norm);
+        }
+    }
+    
+    // As pesquisas são pontos novos dos mesmos grupos (não estão no índice)
+    for (int q = 0; q < BENCH_HNSW_QUERIES; q++) {
+        int center = rand() % 200;
+        float norm = 0.0f;
+        for (int k = 0; k < BENCH_HNSW_DIMENSION; k++) {
+            queries[q][k] = centers[center][k] + 0.3f * ((float)rand() / RAND_MAX - 0.5f);
+            norm += queries[q][k] * queries[q][k];
+        }
+        for (int k = 0; k < BENCH_HNSW_DIMENSION; k++) {
+            queries[q][k] /= sqrtf(norm);
+        }
+    }
+    
+    double start = bench_wall_ms();
+    hnsw_build(&index, vectors, BENCH_HNSW_DIMENSION, ids, BENCH_HNSW_COUNT);
+    double build_ms = bench_wall_ms() - start;
+    
+    // Referência exata: produto interno com todos os vetores normalizados e seleção dos 10 melhores
+    start = bench_wall_ms();
+    for (int q = 0; q < BENCH_HNSW_QUERIES; q++) {
+        simkernel_dot_rows(queries[q], normalized, BENCH_HNSW_DIMENSION, BENCH_HNSW_DIMENSION, 
+                           BENCH_HNSW_COUNT, scores);
+        topk_init(&exact, 10);
+        for (int i = 0; i < BENCH_HNSW_COUNT; i++) {
+            topk_push(&exact, ids[i], scores[i]);
+        }
+        topk_extract(&exact, truth + q * 10, 10);
+        topk_free(&exact);
+    }
+    double exact_ms = bench_wall_ms() - start;
+    
+    printf("  construção:              %8.1f ms\n", build_ms);
+    printf("  pesquisa exata:          %8.1f us por pesquisa\n", exact_ms * 1000.0 / BENCH_HNSW_QUERIES);
+    
+    static const int efs[] = {10, 16, 32, 64, 128, 256};
+    for (int e = 0; e < (int)(sizeof(efs) / sizeof(efs[0])); e++) {
+        int hits = 0;
+        start = bench_wall_ms();
+        for (int q = 0; q < BENCH_HNSW_QUERIES; q++) {
+            int count = hnsw_search(&index, queries[q], 10, efs[e], found, NULL);
+            for (int i = 0; i < count; i++) {
+                for (int j = 0; j < 10; j++) {
+                    hits += found[i] == truth[q * 10 + j];
+                }
+            }
+        }
+        double search_ms = bench_wall_ms() - start;
+        printf("  HNSW ef=%-4d             %8.1f us por pesquisa, recall@10 %.3f\n", efs[e], 
+               search_ms * 1000.0 / BENCH_HNSW_QUERIES, (double)hits / (BENCH_HNSW_QUERIES * 10));
+    }
+    
+    // Abrir o índice gravado evita a construção
+    if (hnsw_save(&index, "bench_hnsw.bin")) {
+        HnswIndex mapped;
+        hnsw_init(&mapped, BENCH_HNSW_DIMENSION, HNSW_DEFAULT_M, HNSW_DEFAULT_EF_CONSTRUCTION);
+        start = bench_wall_ms();
+        int opened = hnsw_open_mapped(&mapped, "bench_hnsw.bin");
+        double open_ms = bench_wall_ms() - start;
+        if (opened) {
+            printf("  abertura mapeada:        %8.3f ms\n", open_ms);
+        }
+        hnsw_free(&mapped);
+        remove("bench_hnsw.bin");
+    }
+    
+    hnsw_free(&index);
+    free(ids);
+    free(vectors);
+    free(normalized);
+    free(scores);
+    free(truth);
+}
+
+// Catálogo de BENCH_NEIGHBOR_TITLES títulos e BENCH_COLLAB_USERS utilizadores com histórico ordenado
+static int bench_personalized_data(ContentCatalog *catalog, UserManager *manager) {
+    static const char *categories[] = {"Drama", "Comédia", "Ação", "Terror", "Documentário", "Animação"};
+    char username[MAX_USERNAME_LENGTH];
+    
+    if (!content_init_catalog(catalog, BENCH_NEIGHBOR_TITLES)) {
+        return 0;
+    }
+    if (!user_init_manager(manager, BENCH_COLLAB_USERS, BENCH_COLLAB_USERS * BENCH_PERSONALIZED_HISTORY)) {
+        content_free_catalog(catalog);
+        return 0;
+    }
+    
+    FILE *file = fopen(BENCH_CATALOG_FILE, "w");
+    if (file == NULL) {
+        content_free_catalog(catalog);
+        user_free_manager(manager);
+        return 0;
+    }
+    fprintf(file, "ID,Titulo,Categoria,Duracao,Classificacao,Visualizacoes\n");
+    srand(43);
+    for (int i = 0; i < BENCH_NEIGHBOR_TITLES; i++) {
+        fprintf(file, "%d,Titulo %d,%s,%d,%d,%d\n", i + 1, i, categories[rand() % 6], 
+                20 + rand() % 160, (rand() % 4) * 6, rand() % 1000);
+    }
+    fclose(file);
+    content_load_from_csv(catalog, BENCH_CATALOG_FILE);
+    remove(BENCH_CATALOG_FILE);
+    
+    user_set_mock_clock(manager, 1700000000, 1);
+    for (int u = 1; u <= BENCH_COLLAB_USERS; u++) {
+        snprintf(username, sizeof(username), "bench%d", u);
+        user_add(manager, username);
+        for (int k = 0; k < BENCH_PERSONALIZED_HISTORY; k++) {
+            user_register_interaction(manager, u, 1 + rand() % BENCH_NEIGHBOR_TITLES, 
+                                      (InteractionType)(rand() % 4));
+        }
+    }
+    user_sort_interactions(manager, 1);
+    return 1;
+}
+
+/**
+ * @brief Compara a recomendação personalizada numa só passagem com a combinação das fontes em separado
+ */
+void bench_personalized() {
+    ContentCatalog catalog;
+    UserManager manager;
+    int fused[MAX_RECOMMENDATIONS], reference[MAX_RECOMMENDATIONS];
+    
+    printf("Recomendação personalizada (%d títulos, %d utilizadores x %d interações, %d pedidos):\n", 
+           BENCH_NEIGHBOR_TITLES, BENCH_COLLAB_USERS, BENCH_PERSONALIZED_HISTORY, BENCH_PERSONALIZED_REQUESTS);
+    
+    if (!bench_personalized_data(&catalog, &manager)) {
+        printf("  erro de memória\n");
+        return;
+    }
+    
+    double start = bench_wall_ms();
+    for (int i = 0; i < BENCH_PERSONALIZED_REQUESTS; i++) {
+        recommendation_personalized_reference(&manager, &catalog, 1 + i * 7 % BENCH_COLLAB_USERS, 
+                                              reference, MAX_RECOMMENDATIONS);
+    }
+    double reference_ms = bench_wall_ms() - start;
+    
+    start = bench_wall_ms();
+    for (int i = 0; i < BENCH_PERSONALIZED_REQUESTS; i++) {
+        recommendation_personalized(&manager, &catalog, 1 + i * 7 % BENCH_COLLAB_USERS, 
+                                    fused, MAX_RECOMMENDATIONS);
+    }
+    double fused_ms = bench_wall_ms() - start;
+    
+    int same = 0;
+    for (int i = 0; i < BENCH_PERSONALIZED_REQUESTS; i++) {
+        int user = 1 + i * 7 % BENCH_COLLAB_USERS;
+        int reference_count = recommendation_personalized_reference(&manager, &catalog, user, 
+                                                                    reference, MAX_RECOMMENDATIONS);
+        int fused_count = recommendation_personalized(&manager, &catalog, user, fused, MAX_RECOMMENDATIONS);
+        same += fused_count == reference_count && memcmp(fused, reference, fused_count * sizeof(int)) == 0;
+    }
+    
+    printf("  fontes em separado: %8.1f us por pedido\n", reference_ms * 1000.0 / BENCH_PERSONALIZED_REQUESTS);
+    printf("  uma passagem:       %8.1f us por pedido (%.1fx)\n", fused_ms * 1000.0 / BENCH_PERSONALIZED_REQUESTS,
+           fused_ms > 0 ? reference_ms / fused_ms : 0.0);
+    printf("  listas iguais:      %d/%d\n", same, BENCH_PERSONALIZED_REQUESTS);
+    
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+}
+
+// Utilizador do pedido i da sequência do benchmark da cache (a maioria repete um grupo pequeno)
+static int bench_cache_user(unsigned int *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    unsigned int draw = (*seed >> 16) & 0x7fff;
+    if (draw % 10 != 0) {
+        return 1 + (int)(draw / 10) % BENCH_CACHE_HOT_USERS;
+    }
+    return 1 + (int)(draw / 10) % BENCH_COLLAB_USERS;
+}
+
+/**
+ * @brief Mede a cache de recomendações numa sequência de pedidos repetidos com novas interações
+ */
+void bench_recommendation_cache() {
+    ContentCatalog catalog;
+    UserManager manager;
+    RecommendationCache cache;
+    RecommendationCacheStats stats;
+    int recommendations[MAX_RECOMMENDATIONS];
+    
+    printf("Cache de recomendações (%d pedidos, 90%% de %d utilizadores, uma interação a cada %d pedidos):\n", 
+           BENCH_CACHE_REQUESTS, BENCH_CACHE_HOT_USERS, BENCH_CACHE_WRITE_EVERY);
+    
+    if (!bench_personalized_data(&catalog, &manager)) {
+        printf("  erro de memória\n");
+        return;
+    }
+    if (!recommendation_cache_init(&cache, &manager, &catalog, BENCH_CACHE_CAPACITY)) {
+        printf("  erro de memória\n");
+        user_free_manager(&manager);
+        content_free_catalog(&catalog);
+        return;
+    }
+    
+    double elapsed[2];
+    for (int cached = 0; cached < 2; cached++) {
+        unsigned int seed = 7u;
+        double start = bench_wall_ms();
+        for (int i = 0; i < BENCH_CACHE_REQUESTS; i++) {
+            int user = bench_cache_user(&seed);
+            if (i % BENCH_CACHE_WRITE_EVERY == 0) {
+                user_register_interaction(&manager, user, 1 + i % BENCH_NEIGHBOR_TITLES, INTERACTION_COMPLETE);
+            }
+            if (cached) {
+                recommendation_cached(&cache, RECOMMENDATION_METHOD_PERSONALIZED, user, 
+                                      recommendations, MAX_RECOMMENDATIONS);
+            } else {
+                recommendation_personalized(&manager, &catalog, user, recommendations, MAX_RECOMMENDATIONS);
+            }
+        }
+        elapsed[cached] = bench_wall_ms() - start;
+    }
+    recommendation_cache_get_stats(&cache, &stats);
+    
+    printf("  sem cache:  %8.1f us por pedido\n", elapsed[0] * 1000.0 / BENCH_CACHE_REQUESTS);
+    printf("  com cache:  %8.1f us por pedido (%.1fx)\n", elapsed[1] * 1000.0 / BENCH_CACHE_REQUESTS,
+           elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0);
+    printf("  acertos: %ld, falhas: %ld, invalidações: %ld, despejos: %ld\n", 
+           stats.hits, stats.misses, stats.invalidations, stats.evictions);
+    
+    recommendation_cache_free(&cache);
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+}
+
+/**
+ * @brief Compara o lote de recomendações de todos os utilizadores com um pedido por utilizador
+ */
+void bench_batch_recommendations() {
+    ContentCatalog catalog;
+    UserManager manager;
+    ThreadPool pool;
+    int recommendations[MAX_RECOMMENDATIONS];
+    
+    printf("Recomendações em lote (%d títulos, %d utilizadores):\n", BENCH_NEIGHBOR_TITLES, BENCH_COLLAB_USERS);
+    
+    if (!bench_personalized_data(&catalog, &manager)) {
+        printf("  erro de memória\n");
+        return;
+    }
+    
+    // Referência: a tarefa noturna chamava recommendation_personalized para cada utilizador
+    double start = bench_wall_ms();
+    for (int i = 0; i < manager.count; i++) {
+        recommendation_personalized(&manager, &catalog, manager.users[i].id, recommendations, MAX_RECOMMENDATIONS);
+    }
+    double single_ms = bench_wall_ms() - start;
+    printf("  um pedido por utilizador: %8.1f ms\n", single_ms);
+    
+    for (int threads = 1; threads <= BENCH_BATCH_MAX_THREADS; threads *= 2) {
+        int pool_ready = threads > 1 && threadpool_init(&pool, threads);
+        start = bench_wall_ms();
+        int written = recommendation_batch_all(&manager, &catalog, MAX_RECOMMENDATIONS, BENCH_BATCH_FILE, 
+                                               RECOMMENDATION_BATCH_BINARY, pool_ready ? &pool : NULL);
+        double batch_ms = bench_wall_ms() - start;
+        if (pool_ready) {
+            threadpool_free(&pool);
+        }
+        printf("  lote, %d thread(s):       %8.1f ms (%.1fx, %d utilizadores)\n", threads, batch_ms,
+               batch_ms > 0 ? single_ms / batch_ms : 0.0, written);
+    }
+    remove(BENCH_BATCH_FILE);
+    
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+}
+
+/**
+ * @brief Compara a recomendação personalizada lida da tabela pré-calculada com o cálculo
+ */
+void bench_recommendation_table() {
+    ContentCatalog catalog;
+    UserManager manager;
+    RecommendationTable table;
+    int recommendations[MAX_RECOMMENDATIONS];
+    
+    printf("Tabela de recomendações pré-calculadas (%d títulos, %d utilizadores):\n", 
+           BENCH_NEIGHBOR_TITLES, BENCH_COLLAB_USERS);
+    
+    if (!bench_personalized_data(&catalog, &manager)) {
+        printf("  erro de memória\n");
+        return;
+    }
+    
+    double start = bench_wall_ms();
+    int written = recommendation_batch_all(&manager, &catalog, MAX_RECOMMENDATIONS, BENCH_BATCH_FILE, 
+                                           RECOMMENDATION_BATCH_BINARY, NULL);
+    double batch_ms = bench_wall_ms() - start;
+    start = bench_wall_ms();
+    int opened = written > 0 && recommendation_table_open(&table, BENCH_BATCH_FILE, &manager, &catalog);
+    double open_ms = bench_wall_ms() - start;
+    if (!opened) {
+        printf("  erro ao gerar ou abrir a tabela\n");
+        remove(BENCH_BATCH_FILE);
+        user_free_manager(&manager);
+        content_free_catalog(&catalog);
+        return;
+    }
+    
+    start = bench_wall_ms();
+    for (int i = 0; i < BENCH_PERSONALIZED_REQUESTS; i++) {
+        recommendation_personalized(&manager, &catalog, 1 + i * 7 % BENCH_COLLAB_USERS, 
+                                    recommendations, MAX_RECOMMENDATIONS);
+    }
+    double live_us = (bench_wall_ms() - start) * 1000.0 / BENCH_PERSONALIZED_REQUESTS;
+    
+    // Pedidos servidos pela tabela, com uma parte dos utilizadores desatualizada pelas novas interações
+    recommendation_set_table(&table);
+    start = bench_wall_ms();
+    for (int i = 0; i < BENCH_TABLE_REQUESTS; i++) {
+        recommendation_personalized(&manager, &catalog, 1 + i * 7 % BENCH_COLLAB_USERS, 
+                                    recommendations, MAX_RECOMMENDATIONS);
+    }
+    double table_us = (bench_wall_ms() - start) * 1000.0 / BENCH_TABLE_REQUESTS;
+    
+    for (int u = 1; u <= BENCH_COLLAB_USERS; u += BENCH_TABLE_STALE_EVERY) {
+        user_register_interaction(&manager, u, 1 + u % BENCH_NEIGHBOR_TITLES, INTERACTION_COMPLETE);
+    }
+    start = bench_wall_ms();
+    for (int i = 0; i < BENCH_PERSONALIZED_REQUESTS; i++) {
+        recommendation_personalized(&manager, &catalog, 1 + i % BENCH_COLLAB_USERS, 
+                                    recommendations, MAX_RECOMMENDATIONS);
+    }
+    double mixed_us = (bench_wall_ms() - start) * 1000.0 / BENCH_PERSONALIZED_REQUESTS;
+    recommendation_set_table(NULL);
+    
+    printf("  geração em lote:   %8.1f ms (%d utilizadores)\n", batch_ms, written);
+    printf("  abertura mapeada:  %8.3f ms\n", open_ms);
+    printf("  cálculo:           %8.2f us por pedido\n", live_us);
+    printf("  tabela:            %8.2f us por pedido (%.0fx)\n", table_us, table_us > 0 ? live_us / table_us : 0.0);
+    printf("  tabela, 1 em %d desatualizado: %8.2f us por pedido\n", BENCH_TABLE_STALE_EVERY, mixed_us);
+    
+    recommendation_table_free(&table);
+    remove(BENCH_BATCH_FILE);
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+}
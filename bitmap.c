@@ -0,0 +1,218 @@
+/**
+ * @file bitmap.c
+ * @brief Implementação do módulo de conjuntos de inteiros comprimidos
+ */
+
+#include "bitmap.h"
+
+// Busca binária do contentor com a chave indicada (devolve -(posição de inserção) - 1 se não existir)
+static int bitmap_find_container(const Bitmap *bitmap, uint16_t key) {
+    int low = 0;
+    int high = bitmap->count - 1;
+    
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        uint16_t mid_key = bitmap->containers[mid].key;
+        
+        if (mid_key < key) {
+            low = mid + 1;
+        } else if (mid_key > key) {
+            high = mid - 1;
+        } else {
+            return mid;
+        }
+    }
+    
+    return -(low + 1);
+}
+
+// Busca binária num contentor array: primeira posição com valor >= low_bits
+static int bitmap_array_lower_bound(const BitmapContainer *container, uint16_t low_bits) {
+    int low = 0;
+    int high = container->cardinality;
+    
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (container->data.array[mid] < low_bits) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
+
+// Converte um contentor array cheio num mapa de bits
+static int bitmap_container_to_bitset(BitmapContainer *container) {
+    uint64_t *bits = (uint64_t*)calloc(BITMAP_WORDS, sizeof(uint64_t));
+    if (bits == NULL) {
+        return 0;
+    }
+    
+    for (int i = 0; i < container->cardinality; i++) {
+        uint16_t low_bits = container->data.array[i];
+        bits[low_bits >> 6] |= (uint64_t)1 << (low_bits & 63);
+    }
+    
+    free(container->data.array);
+    container->data.bits = bits;
+    container->is_bitset = 1;
+    container->capacity = 0;
+    return 1;
+}
+
+void bitmap_init(Bitmap *bitmap) {
+    if (bitmap == NULL) {
+        return;
+    }
+    
+    bitmap->containers = NULL;
+    bitmap->count = 0;
+    bitmap->capacity = 0;
+}
+
+void bitmap_free(Bitmap *bitmap) {
+    if (bitmap == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < bitmap->count; i++) {
+        if (bitmap->containers[i].is_bitset) {
+            free(bitmap->containers[i].data.bits);
+        } else {
+            free(bitmap->containers[i].data.array);
+        }
+    }
+    
+    free(bitmap->containers);
+    bitmap->containers = NULL;
+    bitmap->count = 0;
+    bitmap->capacity = 0;
+}
+
+int bitmap_add(Bitmap *bitmap, uint32_t value) {
+    if (bitmap == NULL) {
+        return 0;
+    }
+    
+    uint16_t key = (uint16_t)(value >> 16);
+    uint16_t low_bits = (uint16_t)(value & 0xFFFF);
+    int index = bitmap_find_container(bitmap, key);
+    
+    if (index < 0) {
+        // Criar um novo contentor na posição correta
+        index = -index - 1;
+        
+        if (bitmap->count >= bitmap->capacity) {
+            int new_capacity = bitmap->capacity > 0 ? bitmap->capacity * 2 : 1;
+            BitmapContainer *new_containers = (BitmapContainer*)realloc(bitmap->containers, 
+                                              new_capacity * sizeof(BitmapContainer));
+            
+            if (new_containers == NULL) {
+                return 0;
+            }
+            
+            bitmap->containers = new_containers;
+            bitmap->capacity = new_capacity;
+        }
+        
+        memmove(&bitmap->containers[index + 1], &bitmap->containers[index], 
+                (bitmap->count - index) * sizeof(BitmapContainer));
+        
+        BitmapContainer *container = &bitmap->containers[index];
+        container->key = key;
+        container->is_bitset = 0;
+        container->cardinality = 0;
+        container->capacity = 0;
+        container->data.array = NULL;
+        bitmap->count++;
+    }
+    
+    BitmapContainer *container = &bitmap->containers[index];
+    
+    if (container->is_bitset) {
+        uint64_t mask = (uint64_t)1 << (low_bits & 63);
+        if ((container->data.bits[low_bits >> 6] & mask) == 0) {
+            container->data.bits[low_bits >> 6] |= mask;
+            container->cardinality++;
+        }
+        return 1;
+    }
+    
+    int position = bitmap_array_lower_bound(container, low_bits);
+    if (position < container->cardinality && container->data.array[position] == low_bits) {
+        return 1; // Já pertence ao conjunto
+    }
+    
+    if (container->cardinality >= BITMAP_ARRAY_MAX) {
+        // Contentor denso: passar a mapa de bits
+        if (!bitmap_container_to_bitset(container)) {
+            return 0;
+        }
+        container->data.bits[low_bits >> 6] |= (uint64_t)1 << (low_bits & 63);
+        container->cardinality++;
+        return 1;
+    }
+    
+    if (container->cardinality >= container->capacity) {
+        int new_capacity = container->capacity > 0 ? container->capacity * 2 : 4;
+        uint16_t *new_array = (uint16_t*)realloc(container->data.array, 
+                                                 new_capacity * sizeof(uint16_t));
+        
+        if (new_array == NULL) {
+            return 0;
+        }
+        
+        container->data.array = new_array;
+        container->capacity = new_capacity;
+    }
+    
+    memmove(&container->data.array[position + 1], &container->data.array[position], 
+            (container->cardinality - position) * sizeof(uint16_t));
+    container->data.array[position] = low_bits;
+    container->cardinality++;
+    return 1;
+}
+
+int bitmap_contains(const Bitmap *bitmap, uint32_t value) {
+    if (bitmap == NULL || bitmap->count == 0) {
+        return 0;
+    }
+    
+    uint16_t key = (uint16_t)(value >> 16);
+    uint16_t low_bits = (uint16_t)(value & 0xFFFF);
+    int index;
+    
+    // Caso comum: todos os IDs cabem no primeiro contentor
+    if (bitmap->containers[0].key == key) {
+        index = 0;
+    } else {
+        index = bitmap_find_container(bitmap, key);
+        if (index < 0) {
+            return 0;
+        }
+    }
+    
+    const BitmapContainer *container = &bitmap->containers[index];
+    
+    if (container->is_bitset) {
+        return (container->data.bits[low_bits >> 6] >> (low_bits & 63)) & 1;
+    }
+    
+    int position = bitmap_array_lower_bound(container, low_bits);
+    return position < container->cardinality && container->data.array[position] == low_bits;
+}
+
+int bitmap_cardinality(const Bitmap *bitmap) {
+    if (bitmap == NULL) {
+        return 0;
+    }
+    
+    int total = 0;
+    for (int i = 0; i < bitmap->count; i++) {
+        total += bitmap->containers[i].cardinality;
+    }
+    
+    return total;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file bitmap.h
+ * @brief Módulo de conjuntos de inteiros comprimidos (estilo Roaring)
+ * 
+ * Este módulo implementa um conjunto de inteiros não negativos dividido em
+ * contentores de 65536 valores. Cada contentor guarda os 16 bits baixos dos
+ * seus valores num array ordenado enquanto tem poucos elementos e passa a um
+ * mapa de bits de 8 KB quando fica denso.
+ */
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BITMAP_ARRAY_MAX 4096
+#define BITMAP_WORDS 1024
+
+/**
+ * @brief Estrutura que representa um contentor de 65536 valores
+ */
+typedef struct {
+    uint16_t key;           /**< 16 bits altos dos valores do contentor */
+    uint16_t is_bitset;     /**< 1 se o contentor usa mapa de bits, 0 se usa array */
+    int cardinality;        /**< Número de valores no contentor */
+    int capacity;           /**< Capacidade do array (apenas contentores array) */
+    union {
+        uint16_t *array;    /**< 16 bits baixos dos valores, ordenados */
+        uint64_t *bits;     /**< Mapa de bits com BITMAP_WORDS palavras */
+    } data;                 /**< Armazenamento do contentor */
+} BitmapContainer;
+
+/**
+ * @brief Estrutura que representa um conjunto comprimido de inteiros
+ */
+typedef struct {
+    BitmapContainer *containers; /**< Contentores ordenados por chave */
+    int count;              /**< Número atual de contentores */
+    int capacity;           /**< Capacidade máxima do array de contentores */
+} Bitmap;
+
+/**
+ * @brief Inicializa um conjunto vazio
+ * 
+ * @param bitmap Ponteiro para o conjunto a ser inicializado
+ */
+void bitmap_init(Bitmap *bitmap);
+
+/**
+ * @brief Liberta a memória alocada para o conjunto
+ * 
+ * @param bitmap Ponteiro para o conjunto a ser libertado
+ */
+void bitmap_free(Bitmap *bitmap);
+
+/**
+ * @brief Adiciona um valor ao conjunto
+ * 
+ * @param bitmap Ponteiro para o conjunto
+ * @param value Valor a ser adicionado
+ * @return int 1 se a operação foi bem-sucedida, 0 em caso de erro de memória
+ */
+int bitmap_add(Bitmap *bitmap, uint32_t value);
+
+/**
+ * @brief Verifica se um valor pertence ao conjunto
+ * 
+ * @param bitmap Ponteiro para o conjunto
+ * @param value Valor a ser verificado
+ * @return int 1 se o valor pertence ao conjunto, 0 caso contrário
+ */
+int bitmap_contains(const Bitmap *bitmap, uint32_t value);
+
+/**
+ * @brief Obtém o número de valores no conjunto
+ * 
+ * @param bitmap Ponteiro para o conjunto
+ * @return int Número de valores
+ */
+int bitmap_cardinality(const Bitmap *bitmap);
+
+#endif /* BITMAP_H */
@@ -0,0 +1,435 @@
+/**
+ * @file collab.c
+ * @brief Implementação do módulo de filtragem colaborativa item-item
+ */
+
+#include <math.h>
+
+#include "collab.h"
+#include "arena.h"
+#include "topk.h"
+
+// Entrada da matriz antes da ordenação (uma por interação ou agregado)
+typedef struct {
+    int user_id;
+    int content_id;
+    float weight;
+} CollabTriplet;
+
+// Pesos dos tipos de interação no modelo item-item (índice = InteractionType)
+static const float collab_weights[4] = {
+    COLLAB_WEIGHT_PLAY, COLLAB_WEIGHT_PAUSE, COLLAB_WEIGHT_COMPLETE, COLLAB_WEIGHT_FAVORITE
+};
+
+// Ordena as entradas por (utilizador, conteúdo)
+static int collab_compare_triplets(const void *a, const void *b) {
+    const CollabTriplet *triplet_a = (const CollabTriplet*)a;
+    const CollabTriplet *triplet_b = (const CollabTriplet*)b;
+    
+    if (triplet_a->user_id != triplet_b->user_id) {
+        return triplet_a->user_id < triplet_b->user_id ? -1 : 1;
+    }
+    if (triplet_a->content_id != triplet_b->content_id) {
+        return triplet_a->content_id < triplet_b->content_id ? -1 : 1;
+    }
+    return 0;
+}
+
+// Ordena IDs por ordem crescente
+static int collab_compare_ids(const void *a, const void *b) {
+    int id_a = *(const int*)a;
+    int id_b = *(const int*)b;
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+// Liberta a matriz e as listas de vizinhos, mantendo neighbor_count
+static void collab_release(CollabModel *model) {
+    collab_matrix_free(&model->matrix);
+    free(model->norms);
+    free(model->neighbors);
+    free(model->neighbor_counts);
+    
+    int neighbor_count = model->neighbor_count;
+    memset(model, 0, sizeof(CollabModel));
+    model->neighbor_count = neighbor_count;
+}
+
+// Acrescenta uma entrada com o peso do tipo (vezes count, se as interações se somam)
+static void collab_add_triplet(CollabTriplet *triplets, size_t *triplet_count, int user_id, int content_id,
+                               float weight, int count, CollabCombine combine) {
+    if (weight <= 0.0f || count <= 0) {
+        return;
+    }
+    
+    triplets[*triplet_count].user_id = user_id;
+    triplets[*triplet_count].content_id = content_id;
+    triplets[*triplet_count].weight = combine == COLLAB_COMBINE_SUM ? weight * count : weight;
+    (*triplet_count)++;
+}
+
+// Calcula os vizinhos dos conteúdos [begin, end): coluna × matriz, podada aos N melhores
+static void collab_similarity_range(void *context, int begin, int end) {
+    CollabModel *model = (CollabModel*)context;
+    CollabMatrix *matrix = &model->matrix;
+    
+    // Acumulador denso por ID e lista dos IDs tocados, na arena de rascunho da thread
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    float *dots = (float*)arena_alloc(scratch, matrix->item_slots * sizeof(float));
+    int *touched = (int*)arena_alloc(scratch, matrix->item_slots * sizeof(int));
+    if (dots == NULL || touched == NULL) {
+        for (int item = begin; item < end; item++) {
+            model->neighbor_counts[item] = 0;
+        }
+        arena_reset_to(scratch, mark);
+        return;
+    }
+    memset(dots, 0, matrix->item_slots * sizeof(float));
+    
+    for (int item = begin; item < end; item++) {
+        NeighborEntry *list = &model->neighbors[(size_t)item * model->neighbor_count];
+        int count = 0;
+        int touched_count = 0;
+        
+        // Produto interno com todas as colunas que partilham utilizadores com esta
+        for (int k = matrix->column_offsets[item]; k < matrix->column_offsets[item + 1]; k++) {
+            int row = matrix->column_rows[k];
+            float weight = matrix->column_values[k];
+            
+            for (int e = matrix->row_offsets[row]; e < matrix->row_offsets[row + 1]; e++) {
+                int other = matrix->columns[e];
+                if (other == item) {
+                    continue;
+                }
+                // Os pesos são positivos: um acumulador a zero ainda não foi tocado
+                if (dots[other] == 0.0f) {
+                    touched[touched_count++] = other;
+                }
+                dots[other] += weight * matrix->values[e];
+            }
+        }
+        
+        for (int t = 0; t < touched_count; t++) {
+            int other = touched[t];
+            float score = dots[other] / (model->norms[item] * model->norms[other]);
+            neighbors_insert(list, &count, model->neighbor_count, other, score);
+            dots[other] = 0.0f;
+        }
+        
+        model->neighbor_counts[item] = count;
+    }
+    
+    arena_reset_to(scratch, mark);
+}
+
+int collab_init(CollabModel *model, int neighbor_count) {
+    if (model == NULL || neighbor_count <= 0) {
+        return 0;
+    }
+    
+    memset(model, 0, sizeof(CollabModel));
+    model->neighbor_count = neighbor_count;
+    return 1;
+}
+
+void collab_free(CollabModel *model) {
+    if (model == NULL) {
+        return;
+    }
+    
+    collab_release(model);
+}
+
+// Corpo de collab_matrix_build, com a época do catálogo já fixada
+static int collab_matrix_build_pinned(CollabMatrix *matrix, UserManager *manager, ContentCatalog *catalog,
+                                      const float weights[4], CollabCombine combine) {
+    if (matrix == NULL || manager == NULL || catalog == NULL || weights == NULL) {
+        return 0;
+    }
+    
+    // Conteúdos presentes no catálogo, por ID
+    int content_count;
+    const Content *items = content_snapshot(catalog, &content_count);
+    int item_slots = 1;
+    for (int i = 0; i < content_count; i++) {
+        if (items[i].id >= item_slots) {
+            item_slots = items[i].id + 1;
+        }
+    }
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    char *present = (char*)arena_alloc(scratch, item_slots);
+    if (present == NULL) {
+        return 0;
+    }
+    memset(present, 0, item_slots);
+    for (int i = 0; i < content_count; i++) {
+        if (items[i].id > 0) {
+            present[items[i].id] = 1;
+        }
+    }
+    
+    // Uma entrada por interação e por tipo de cada agregado
+    InteractionRetention *retention = &manager->retention;
+    size_t capacity = (size_t)manager->interaction_count + 4 * (size_t)retention->count;
+    CollabTriplet *triplets = (CollabTriplet*)malloc((capacity > 0 ? capacity : 1) * sizeof(CollabTriplet));
+    if (triplets == NULL) {
+        arena_reset_to(scratch, mark);
+        return 0;
+    }
+    
+    size_t triplet_count = 0;
+    for (int i = 0; i < manager->interaction_count; i++) {
+        const Interaction *interaction = &manager->interactions[i];
+        if (interaction->content_id > 0 && interaction->content_id < item_slots &&
+            present[interaction->content_id] && (int)interaction->type >= 0 && interaction->type < 4) {
+            collab_add_triplet(triplets, &triplet_count, interaction->user_id, interaction->content_id,
+                               weights[interaction->type], 1, combine);
+        }
+    }
+    for (int i = 0; i < retention->count; i++) {
+        const InteractionAggregate *aggregate = &retention->aggregates[i];
+        if (aggregate->content_id <= 0 || aggregate->content_id >= item_slots ||
+            !present[aggregate->content_id]) {
+            continue;
+        }
+        for (int type = 0; type < 4; type++) {
+            collab_add_triplet(triplets, &triplet_count, aggregate->user_id, aggregate->content_id,
+                               weights[type], aggregate->counts[type], combine);
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    qsort(triplets, triplet_count, sizeof(CollabTriplet), collab_compare_triplets);
+    
+    // Dimensões: pares (utilizador, conteúdo) distintos e utilizadores distintos
+    int entry_count = 0;
+    int row_count = 0;
+    for (size_t i = 0; i < triplet_count; i++) {
+        if (i == 0 || triplets[i].user_id != triplets[i - 1].user_id) {
+            row_count++;
+            entry_count++;
+        } else if (triplets[i].content_id != triplets[i - 1].content_id) {
+            entry_count++;
+        }
+    }
+    
+    CollabMatrix built;
+    memset(&built, 0, sizeof(CollabMatrix));
+    built.row_users = (int*)malloc((row_count + 1) * sizeof(int));
+    built.row_offsets = (int*)malloc((row_count + 1) * sizeof(int));
+    built.columns = (int*)malloc((entry_count + 1) * sizeof(int));
+    built.values = (float*)malloc((entry_count + 1) * sizeof(float));
+    built.column_offsets = (int*)calloc(item_slots + 1, sizeof(int));
+    built.column_rows = (int*)malloc((entry_count + 1) * sizeof(int));
+    built.column_values = (float*)malloc((entry_count + 1) * sizeof(float));
+    if (built.row_users == NULL || built.row_offsets == NULL || built.columns == NULL ||
+        built.values == NULL || built.column_offsets == NULL || built.column_rows == NULL ||
+        built.column_values == NULL) {
+        free(triplets);
+        collab_matrix_free(&built);
+        return 0;
+    }
+    
+    // CSR: repetições do mesmo par combinadas pelo maior peso ou pela soma
+    int entry = -1;
+    int row = -1;
+    for (size_t i = 0; i < triplet_count; i++) {
+        if (i == 0 || triplets[i].user_id != triplets[i - 1].user_id) {
+            row++;
+            built.row_users[row] = triplets[i].user_id;
+            built.row_offsets[row] = entry + 1;
+        }
+        if (i == 0 || triplets[i].user_id != triplets[i - 1].user_id ||
+            triplets[i].content_id != triplets[i - 1].content_id) {
+            entry++;
+            built.columns[entry] = triplets[i].content_id;
+            built.values[entry] = triplets[i].weight;
+        } else if (combine == COLLAB_COMBINE_SUM) {
+            built.values[entry] += triplets[i].weight;
+        } else if (triplets[i].weight > built.values[entry]) {
+            built.values[entry] = triplets[i].weight;
+        }
+    }
+    built.row_offsets[row_count] = entry_count;
+    built.row_count = row_count;
+    built.entry_count = entry_count;
+    built.item_slots = item_slots;
+    free(triplets);
+    
+    // CSC: contagem por coluna, somas prefixas e distribuição pela ordem das linhas
+    for (int e = 0; e < entry_count; e++) {
+        built.column_offsets[built.columns[e] + 1]++;
+    }
+    for (int id = 0; id < item_slots; id++) {
+        built.column_offsets[id + 1] += built.column_offsets[id];
+    }
+    
+    mark = arena_mark(scratch);
+    int *fill = (int*)arena_alloc(scratch, item_slots * sizeof(int));
+    if (fill == NULL) {
+        collab_matrix_free(&built);
+        return 0;
+    }
+    memcpy(fill, built.column_offsets, item_slots * sizeof(int));
+    for (int r = 0; r < row_count; r++) {
+        for (int e = built.row_offsets[r]; e < built.row_offsets[r + 1]; e++) {
+            int position = fill[built.columns[e]]++;
+            built.column_rows[position] = r;
+            built.column_values[position] = built.values[e];
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    collab_matrix_free(matrix);
+    *matrix = built;
+    return 1;
+}
+
+int collab_matrix_build(CollabMatrix *matrix, UserManager *manager, ContentCatalog *catalog,
+                        const float weights[4], CollabCombine combine) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(catalog)) {
+        return 0;
+    }
+    int result = collab_matrix_build_pinned(matrix, manager, catalog, weights, combine);
+    content_read_end(catalog);
+    return result;
+}
+
+void collab_matrix_free(CollabMatrix *matrix) {
+    if (matrix == NULL) {
+        return;
+    }
+    
+    free(matrix->row_users);
+    free(matrix->row_offsets);
+    free(matrix->columns);
+    free(matrix->values);
+    free(matrix->column_offsets);
+    free(matrix->column_rows);
+    free(matrix->column_values);
+    memset(matrix, 0, sizeof(CollabMatrix));
+}
+
+int collab_matrix_find_row(const CollabMatrix *matrix, int user_id) {
+    if (matrix == NULL) {
+        return -1;
+    }
+    
+    // Pesquisa binária em row_users
+    int low = 0;
+    int high = matrix->row_count - 1;
+    while (low <= high) {
+        int middle = low + (high - low) / 2;
+        if (matrix->row_users[middle] == user_id) {
+            return middle;
+        }
+        if (matrix->row_users[middle] < user_id) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return -1;
+}
+
+int collab_build(CollabModel *model, UserManager *manager, ContentCatalog *catalog, ThreadPool *pool) {
+    if (model == NULL || manager == NULL || catalog == NULL || model->neighbor_count <= 0) {
+        return 0;
+    }
+    
+    collab_release(model);
+    if (!collab_matrix_build(&model->matrix, manager, catalog, collab_weights, COLLAB_COMBINE_MAX)) {
+        return 0;
+    }
+    
+    CollabMatrix *matrix = &model->matrix;
+    int item_slots = matrix->item_slots;
+    model->norms = (float*)calloc(item_slots, sizeof(float));
+    model->neighbors = (NeighborEntry*)malloc((size_t)item_slots * model->neighbor_count * sizeof(NeighborEntry));
+    model->neighbor_counts = (int*)calloc(item_slots, sizeof(int));
+    if (model->norms == NULL || model->neighbors == NULL || model->neighbor_counts == NULL) {
+        collab_release(model);
+        return 0;
+    }
+    
+    for (int id = 0; id < item_slots; id++) {
+        float sum = 0.0f;
+        for (int k = matrix->column_offsets[id]; k < matrix->column_offsets[id + 1]; k++) {
+            sum += matrix->column_values[k] * matrix->column_values[k];
+        }
+        model->norms[id] = sqrtf(sum);
+    }
+    
+    // Cada conteúdo tem a sua lista, pelo que os blocos de IDs correm em paralelo
+    threadpool_parallel_for(pool, 0, item_slots, 64, collab_similarity_range, model);
+    
+    model->manager = manager;
+    return 1;
+}
+
+const NeighborEntry* collab_get_neighbors(CollabModel *model, int content_id, int *count) {
+    *count = 0;
+    if (model == NULL || content_id <= 0 || content_id >= model->matrix.item_slots ||
+        model->neighbor_counts[content_id] == 0) {
+        return NULL;
+    }
+    
+    *count = model->neighbor_counts[content_id];
+    return &model->neighbors[(size_t)content_id * model->neighbor_count];
+}
+
+int collab_recommend(CollabModel *model, int user_id, int *recommendations, int max_recommendations) {
+    if (model == NULL || recommendations == NULL || max_recommendations <= 0) {
+        return -1;
+    }
+    
+    CollabMatrix *matrix = &model->matrix;
+    int row = collab_matrix_find_row(matrix, user_id);
+    if (row < 0) {
+        return 0;
+    }
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    float *scores = (float*)arena_alloc(scratch, matrix->item_slots * sizeof(float));
+    int *candidates = (int*)arena_alloc(scratch, matrix->item_slots * sizeof(int));
+    TopK best;
+    if (scores == NULL || candidates == NULL || !topk_init(&best, max_recommendations)) {
+        arena_reset_to(scratch, mark);
+        return -1;
+    }
+    memset(scores, 0, matrix->item_slots * sizeof(float));
+    
+    // Peso da interação × similaridade, somado sobre o histórico
+    int candidate_count = 0;
+    for (int e = matrix->row_offsets[row]; e < matrix->row_offsets[row + 1]; e++) {
+        int count;
+        const NeighborEntry *list = collab_get_neighbors(model, matrix->columns[e], &count);
+        
+        for (int j = 0; j < count; j++) {
+            if (scores[list[j].id] == 0.0f) {
+                candidates[candidate_count++] = list[j].id;
+            }
+            scores[list[j].id] += matrix->values[e] * list[j].score;
+        }
+    }
+    for (int e = matrix->row_offsets[row]; e < matrix->row_offsets[row + 1]; e++) {
+        scores[matrix->columns[e]] = -1.0f;
+    }
+    
+    // Oferecer por ordem de ID para que os empates se resolvam como na ordem do catálogo
+    qsort(candidates, candidate_count, sizeof(int), collab_compare_ids);
+    for (int i = 0; i < candidate_count; i++) {
+        if (scores[candidates[i]] > 0.0f) {
+            topk_push(&best, candidates[i], scores[candidates[i]]);
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
+    return recommendation_count;
+}
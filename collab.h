@@ -0,0 +1,155 @@
+/**
+ * @file collab.h
+ * @brief Módulo de filtragem colaborativa item-item
+ * 
+ * Constrói a matriz esparsa utilizador × conteúdo a partir das interações
+ * (e dos agregados das interações antigas), guardada em CSR (linhas por
+ * utilizador) e em CSC (colunas por conteúdo). A similaridade de cosseno
+ * entre conteúdos vistos pelos mesmos utilizadores é calculada com um
+ * produto esparso × esparso em paralelo e podada aos N vizinhos mais
+ * próximos de cada conteúdo. As recomendações pontuam o histórico do
+ * utilizador contra esses vizinhos.
+ */
+
+#ifndef COLLAB_H
+#define COLLAB_H
+
+#include "content.h"
+#include "user.h"
+#include "threadpool.h"
+#include "neighbors.h"
+
+#define COLLAB_DEFAULT_NEIGHBORS 20
+#define COLLAB_WEIGHT_PLAY 1.0f
+#define COLLAB_WEIGHT_PAUSE 0.5f
+#define COLLAB_WEIGHT_COMPLETE 2.0f
+#define COLLAB_WEIGHT_FAVORITE 3.0f
+
+/**
+ * @brief Forma de combinar as várias interações de um par (utilizador, conteúdo)
+ */
+typedef enum {
+    COLLAB_COMBINE_MAX,         /**< Fica o maior dos pesos dos tipos registados */
+    COLLAB_COMBINE_SUM          /**< Soma o peso de cada interação (confiança por contagem) */
+} CollabCombine;
+
+/**
+ * @brief Matriz esparsa utilizador × conteúdo, em CSR e em CSC
+ */
+typedef struct {
+    int *row_users;             /**< ID do utilizador de cada linha, por ordem crescente */
+    int *row_offsets;           /**< Início de cada linha em columns/values (row_count + 1 posições) */
+    int *columns;               /**< ID do conteúdo de cada entrada, crescente dentro da linha */
+    float *values;              /**< Peso de cada entrada */
+    int row_count;              /**< Número de utilizadores com interações */
+    int *column_offsets;        /**< Início de cada coluna em column_rows/column_values (item_slots + 1 posições) */
+    int *column_rows;           /**< Linha (utilizador) de cada entrada da coluna */
+    float *column_values;       /**< Peso de cada entrada da coluna */
+    int item_slots;             /**< IDs de conteúdo suportados (0 a item_slots - 1) */
+    int entry_count;            /**< Número de entradas não nulas da matriz */
+} CollabMatrix;
+
+/**
+ * @brief Modelo de filtragem colaborativa
+ * 
+ * O peso de cada par (utilizador, conteúdo) é o maior dos pesos
+ * COLLAB_WEIGHT_* dos tipos de interação registados para o par.
+ */
+typedef struct {
+    CollabMatrix matrix;        /**< Matriz utilizador × conteúdo */
+    float *norms;               /**< Norma de cada coluna (por ID de conteúdo) */
+    NeighborEntry *neighbors;   /**< Vizinhos de cada conteúdo, neighbor_count por ID */
+    int *neighbor_counts;       /**< Número de vizinhos de cada ID */
+    int neighbor_count;         /**< Vizinhos guardados por conteúdo (N) */
+    UserManager *manager;       /**< Gerenciador a partir do qual o modelo foi construído */
+} CollabModel;
+
+/**
+ * @brief Constrói a matriz a partir das interações e dos agregados das interações antigas
+ * 
+ * Apenas os conteúdos presentes no catálogo e os tipos com peso positivo
+ * entram na matriz. Uma matriz anterior (ou a zeros) é substituída só se a
+ * construção for bem-sucedida.
+ * 
+ * @param matrix Ponteiro para a matriz (a zeros ou com uma matriz anterior)
+ * @param manager Gerenciador de utilizadores
+ * @param catalog Catálogo de conteúdos
+ * @param weights Peso de cada tipo de interação (índice = InteractionType)
+ * @param combine Forma de combinar as interações de um mesmo par
+ * @return int 1 se a construção foi bem-sucedida, 0 caso contrário
+ */
+int collab_matrix_build(CollabMatrix *matrix, UserManager *manager, ContentCatalog *catalog,
+                        const float weights[4], CollabCombine combine);
+
+/**
+ * @brief Liberta a memória da matriz (que fica a zeros)
+ * 
+ * @param matrix Ponteiro para a matriz
+ */
+void collab_matrix_free(CollabMatrix *matrix);
+
+/**
+ * @brief Procura a linha de um utilizador
+ * 
+ * @param matrix Ponteiro para a matriz
+ * @param user_id ID do utilizador
+ * @return int Índice da linha, ou -1 se o utilizador não tiver interações na matriz
+ */
+int collab_matrix_find_row(const CollabMatrix *matrix, int user_id);
+
+/**
+ * @brief Inicializa um modelo vazio
+ * 
+ * @param model Ponteiro para o modelo
+ * @param neighbor_count Vizinhos a guardar por conteúdo (> 0)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int collab_init(CollabModel *model, int neighbor_count);
+
+/**
+ * @brief Liberta a memória do modelo
+ * 
+ * @param model Ponteiro para o modelo
+ */
+void collab_free(CollabModel *model);
+
+/**
+ * @brief Constrói (ou reconstrói) o modelo a partir das interações atuais
+ * 
+ * Apenas os conteúdos presentes no catálogo entram na matriz. As interações
+ * registadas depois da construção só contam depois de uma nova construção.
+ * 
+ * @param model Ponteiro para o modelo
+ * @param manager Gerenciador de utilizadores (interações e agregados)
+ * @param catalog Catálogo de conteúdos
+ * @param pool Conjunto de threads para o produto esparso (NULL para calcular em série)
+ * @return int 1 se a construção foi bem-sucedida, 0 caso contrário
+ */
+int collab_build(CollabModel *model, UserManager *manager, ContentCatalog *catalog, ThreadPool *pool);
+
+/**
+ * @brief Obtém os vizinhos colaborativos de um conteúdo
+ * 
+ * @param model Ponteiro para o modelo
+ * @param content_id ID do conteúdo
+ * @param count Recebe o número de vizinhos
+ * @return const NeighborEntry* Vizinhos por similaridade decrescente, ou NULL se não houver
+ */
+const NeighborEntry* collab_get_neighbors(CollabModel *model, int content_id, int *count);
+
+/**
+ * @brief Recomenda conteúdos a partir dos vizinhos dos conteúdos com que o utilizador interagiu
+ * 
+ * O score de cada candidato é a soma, sobre o histórico do utilizador, do
+ * peso da interação vezes a similaridade com o candidato. Os conteúdos do
+ * histórico não são recomendados.
+ * 
+ * @param model Ponteiro para o modelo
+ * @param user_id ID do utilizador
+ * @param recommendations Array para armazenar os IDs recomendados
+ * @param max_recommendations Número máximo de recomendações
+ * @return int Número de recomendações geradas, ou -1 em caso de erro
+ */
+int collab_recommend(CollabModel *model, int user_id, int *recommendations, int max_recommendations);
+
+#endif /* COLLAB_H */
@@ -7,18 +7,253 @@
 #include "csvutil.h"
 #include <ctype.h>
 
+// Próximo índice de thread a atribuir e índice da thread atual (-1 = ainda sem fatia)
+static int content_next_thread = 0;
+static __thread int content_thread_slab = -1;
+
+// Secção de leitura da thread atual num catálogo (ver content_read_begin)
+typedef struct {
+    ContentCatalog *catalog;    // Catálogo (NULL = posição livre)
+    unsigned long instance;     // Identificador do catálogo no registo
+    int reader;                 // Identificador de leitor obtido com content_reader_register (-1 = fixação partilhada)
+    int depth;                  // Secções abertas (só a mais externa fixa a época)
+} ContentThreadReader;
+
+static unsigned long content_next_instance = 0;
+static __thread ContentThreadReader content_thread_readers[CONTENT_THREAD_CATALOGS];
+static __thread int content_thread_watched = 0;
+
+// Catálogos vivos: a saída de uma thread só devolve posições de leitor de catálogos que ainda existem
+static pthread_mutex_t content_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static ContentCatalog **content_registry = NULL;
+static int content_registry_count = 0;
+static int content_registry_capacity = 0;
+
+// Chave cujo destrutor devolve as posições de leitor de uma thread que termina
+static pthread_once_t content_thread_once = PTHREAD_ONCE_INIT;
+static pthread_key_t content_thread_key;
+
+// Obtém a fatia de contadores de visualizações da thread atual
+static int content_current_slab(void) {
+    if (content_thread_slab < 0) {
+        content_thread_slab = __atomic_fetch_add(&content_next_thread, 1, __ATOMIC_RELAXED) 
+                              % CONTENT_VIEW_SLABS;
+    }
+    return content_thread_slab;
+}
+
+// Obtém o contador de um ID numa fatia, alocando o diretório e a página se pedido
+static int *content_view_counter(ContentViewSlab *slab, int id, int create) {
+    int page = id / CONTENT_VIEW_PAGE_SIZE;
+    if (id <= 0 || page >= CONTENT_VIEW_MAX_PAGES) {
+        return NULL;
+    }
+    
+    int **pages = __atomic_load_n(&slab->pages, __ATOMIC_ACQUIRE);
+    if (pages == NULL) {
+        if (!create) {
+            return NULL;
+        }
+        // Mais threads do que fatias podem partilhar uma fatia: publicar com CAS
+        int **fresh = (int**)calloc(CONTENT_VIEW_MAX_PAGES, sizeof(int*));
+        if (fresh == NULL) {
+            return NULL;
+        }
+        if (!__atomic_compare_exchange_n(&slab->pages, &pages, fresh, 0, 
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(fresh);
+        } else {
+            pages = fresh;
+        }
+    }
+    
+    int *counters = __atomic_load_n(&pages[page], __ATOMIC_ACQUIRE);
+    if (counters == NULL) {
+        if (!create) {
+            return NULL;
+        }
+        int *fresh = (int*)calloc(CONTENT_VIEW_PAGE_SIZE, sizeof(int));
+        if (fresh == NULL) {
+            return NULL;
+        }
+        if (!__atomic_compare_exchange_n(&pages[page], &counters, fresh, 0, 
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(fresh);
+        } else {
+            counters = fresh;
+        }
+    }
+    
+    return &counters[id % CONTENT_VIEW_PAGE_SIZE];
+}
+
+// Posição de um ID na lista de visualizações sem fatia (-1 se não estiver), com o mutex obtido
+static int content_overflow_find(ContentCatalog *catalog, int id) {
+    for (int i = 0; i < catalog->view_overflow_count; i++) {
+        if (catalog->view_overflow[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Soma as visualizações pendentes de um ID em todas as fatias (com take, zera-as)
+static int content_pending_views(ContentCatalog *catalog, int id, int take) {
+    int pending = 0;
+    
+    // IDs sem fatia: caminho raro, pela lista partilhada
+    if (id / CONTENT_VIEW_PAGE_SIZE >= CONTENT_VIEW_MAX_PAGES) {
+        pthread_mutex_lock(&catalog->view_overflow_lock);
+        int position = content_overflow_find(catalog, id);
+        if (position != -1) {
+            pending = catalog->view_overflow[position].views;
+            if (take) {
+                catalog->view_overflow[position] = 
+                    catalog->view_overflow[--catalog->view_overflow_count];
+            }
+        }
+        pthread_mutex_unlock(&catalog->view_overflow_lock);
+        return pending;
+    }
+    
+    int slabs = __atomic_load_n(&content_next_thread, __ATOMIC_RELAXED);
+    if (slabs > CONTENT_VIEW_SLABS) {
+        slabs = CONTENT_VIEW_SLABS;
+    }
+    
+    for (int i = 0; i < slabs; i++) {
+        int *counter = content_view_counter(&catalog->view_slabs[i], id, 0);
+        if (counter != NULL) {
+            pending += take ? __atomic_exchange_n(counter, 0, __ATOMIC_RELAXED) 
+                            : __atomic_load_n(counter, __ATOMIC_RELAXED);
+        }
+    }
+    return pending;
+}
+
+// Cria uma nova versão do array com a capacidade indicada, copiando os conteúdos atuais
+static ContentTable *content_table_clone(ContentCatalog *catalog, int capacity) {
+    ContentTable *table = (ContentTable*)malloc(sizeof(ContentTable) + capacity * sizeof(Content));
+    if (table == NULL) {
+        return NULL;
+    }
+    
+    table->count = catalog->count;
+    table->capacity = capacity;
+    if (catalog->count > 0) {
+        memcpy(table->items, catalog->items, catalog->count * sizeof(Content));
+    }
+    return table;
+}
+
+// Publica uma nova versão para os leitores e retira a anterior
+static int content_publish(ContentCatalog *catalog, ContentTable *table) {
+    if (catalog->retired_count >= catalog->retired_capacity) {
+        int new_capacity = catalog->retired_capacity > 0 ? catalog->retired_capacity * 2 : 8;
+        ContentRetired *new_retired = (ContentRetired*)realloc(catalog->retired, 
+                                      new_capacity * sizeof(ContentRetired));
+        if (new_retired == NULL) {
+            free(table);
+            return 0;
+        }
+        catalog->retired = new_retired;
+        catalog->retired_capacity = new_capacity;
+    }
+    
+    ContentTable *old = catalog->table;
+    __atomic_store_n(&catalog->table, table, __ATOMIC_SEQ_CST);
+    
+    catalog->items = table->items;
+    catalog->count = table->count;
+    catalog->capacity = table->capacity;
+    
+    // Leitores com época até à atual podem ainda estar a ler a versão antiga
+    catalog->retired[catalog->retired_count].table = old;
+    catalog->retired[catalog->retired_count].epoch = catalog->epoch;
+    catalog->retired_count++;
+    __atomic_add_fetch(&catalog->epoch, 1, __ATOMIC_SEQ_CST);
+    
+    content_reclaim(catalog);
+    return 1;
+}
+
+// Torna visível aos leitores um conteúdo já escrito na posição count da versão atual
+static void content_publish_append(ContentCatalog *catalog) {
+    catalog->count++;
+    __atomic_store_n(&catalog->table->count, catalog->count, __ATOMIC_RELEASE);
+}
+
+// Garante espaço para mais um conteúdo, publicando uma versão maior se necessário
+static int content_reserve_one(ContentCatalog *catalog) {
+    if (catalog->count < catalog->capacity) {
+        return 1;
+    }
+    
+    ContentTable *table = content_table_clone(catalog, catalog->capacity * 2);
+    if (table == NULL) {
+        return 0;
+    }
+    return content_publish(catalog, table);
+}
+
+// Comunica uma alteração já publicada aos observadores do catálogo
+static void content_notify(ContentCatalog *catalog, int id, ContentChange change) {
+    for (int i = 0; i < catalog->listener_count; i++) {
+        catalog->change_listeners[i](catalog->change_contexts[i], id, change);
+    }
+}
+
 int content_init_catalog(ContentCatalog *catalog, int initial_capacity) {
     if (catalog == NULL || initial_capacity <= 0) {
         return 0;
     }
     
-    catalog->items = (Content*)malloc(initial_capacity * sizeof(Content));
-    if (catalog->items == NULL) {
+    catalog->table = (ContentTable*)malloc(sizeof(ContentTable) + initial_capacity * sizeof(Content));
+    catalog->readers = (ContentReaderSlot*)calloc(CONTENT_MAX_READERS, sizeof(ContentReaderSlot));
+    catalog->view_slabs = (ContentViewSlab*)calloc(CONTENT_VIEW_SLABS, sizeof(ContentViewSlab));
+    if (catalog->table == NULL || catalog->readers == NULL || catalog->view_slabs == NULL) {
+        free(catalog->table);
+        free(catalog->readers);
+        free(catalog->view_slabs);
         return 0;
     }
     
+    catalog->table->count = 0;
+    catalog->table->capacity = initial_capacity;
+    catalog->items = catalog->table->items;
     catalog->count = 0;
     catalog->capacity = initial_capacity;
+    catalog->epoch = 1;
+    catalog->views_generation = 1;
+    catalog->view_overflow = NULL;
+    catalog->view_overflow_count = 0;
+    catalog->view_overflow_capacity = 0;
+    pthread_mutex_init(&catalog->view_overflow_lock, NULL);
+    catalog->reader_count = 0;
+    catalog->retired = NULL;
+    catalog->retired_count = 0;
+    catalog->retired_capacity = 0;
+    catalog->listener_count = 0;
+    catalog->shared_readers = 0;
+    catalog->instance = __atomic_add_fetch(&content_next_instance, 1, __ATOMIC_RELAXED);
+    
+    pthread_mutex_lock(&content_registry_lock);
+    if (content_registry_count == content_registry_capacity) {
+        int capacity = content_registry_capacity > 0 ? content_registry_capacity * 2 : 8;
+        ContentCatalog **grown = (ContentCatalog**)realloc(content_registry, capacity * sizeof(ContentCatalog*));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&content_registry_lock);
+            pthread_mutex_destroy(&catalog->view_overflow_lock);
+            free(catalog->table);
+            free(catalog->readers);
+            free(catalog->view_slabs);
+            return 0;
+        }
+        content_registry = grown;
+        content_registry_capacity = capacity;
+    }
+    content_registry[content_registry_count++] = catalog;
+    pthread_mutex_unlock(&content_registry_lock);
     return 1;
 }
 
@@ -27,12 +262,279 @@ void content_free_catalog(ContentCatalog *catalog) {
         return;
     }
     
-    free(catalog->items);
+    // A partir daqui as threads que terminam já não tocam nas posições de leitor
+    pthread_mutex_lock(&content_registry_lock);
+    for (int i = 0; i < content_registry_count; i++) {
+        if (content_registry[i] == catalog) {
+            content_registry[i] = content_registry[--content_registry_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&content_registry_lock);
+    
+    for (int i = 0; i < catalog->retired_count; i++) {
+        free(catalog->retired[i].table);
+    }
+    
+    for (int i = 0; i < CONTENT_VIEW_SLABS; i++) {
+        int **pages = catalog->view_slabs[i].pages;
+        if (pages != NULL) {
+            for (int j = 0; j < CONTENT_VIEW_MAX_PAGES; j++) {
+                free(pages[j]);
+            }
+            free(pages);
+        }
+    }
+    
+    free(catalog->table);
+    free(catalog->readers);
+    free(catalog->retired);
+    free(catalog->view_slabs);
+    free(catalog->view_overflow);
+    pthread_mutex_destroy(&catalog->view_overflow_lock);
+    catalog->view_slabs = NULL;
+    catalog->view_overflow = NULL;
+    catalog->view_overflow_count = 0;
+    catalog->view_overflow_capacity = 0;
+    catalog->table = NULL;
+    catalog->readers = NULL;
+    catalog->retired = NULL;
+    catalog->retired_count = 0;
+    catalog->retired_capacity = 0;
+    catalog->reader_count = 0;
     catalog->items = NULL;
     catalog->count = 0;
     catalog->capacity = 0;
 }
 
+int content_add_change_listener(ContentCatalog *catalog, ContentChangeFunc listener, void *context) {
+    if (catalog == NULL || listener == NULL) {
+        return 0;
+    }
+    
+    for (int i = 0; i < catalog->listener_count; i++) {
+        if (catalog->change_contexts[i] == context) {
+            catalog->change_listeners[i] = listener;
+            return 1;
+        }
+    }
+    if (catalog->listener_count >= CONTENT_MAX_LISTENERS) {
+        return 0;
+    }
+    
+    catalog->change_listeners[catalog->listener_count] = listener;
+    catalog->change_contexts[catalog->listener_count] = context;
+    catalog->listener_count++;
+    return 1;
+}
+
+void content_remove_change_listener(ContentCatalog *catalog, void *context) {
+    if (catalog == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < catalog->listener_count; i++) {
+        if (catalog->change_contexts[i] == context) {
+            // Mantém a ordem de registo dos restantes
+            for (int j = i + 1; j < catalog->listener_count; j++) {
+                catalog->change_listeners[j - 1] = catalog->change_listeners[j];
+                catalog->change_contexts[j - 1] = catalog->change_contexts[j];
+            }
+            catalog->listener_count--;
+            return;
+        }
+    }
+}
+
+int content_reader_register(ContentCatalog *catalog) {
+    if (catalog == NULL) {
+        return -1;
+    }
+    
+    for (int i = 0; i < CONTENT_MAX_READERS; i++) {
+        int expected = 0;
+        if (__atomic_load_n(&catalog->readers[i].used, __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&catalog->readers[i].used, &expected, 1, 0, 
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            // content_reclaim percorre as posições até ao limite superior já usado
+            int count = __atomic_load_n(&catalog->reader_count, __ATOMIC_SEQ_CST);
+            while (count < i + 1 && 
+                   !__atomic_compare_exchange_n(&catalog->reader_count, &count, i + 1, 0, 
+                                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            }
+            return i;
+        }
+    }
+    return -1;
+}
+
+void content_reader_unregister(ContentCatalog *catalog, int reader) {
+    if (catalog == NULL || reader < 0 || reader >= CONTENT_MAX_READERS) {
+        return;
+    }
+    
+    __atomic_store_n(&catalog->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&catalog->readers[reader].used, 0, __ATOMIC_RELEASE);
+}
+
+void content_read_lock(ContentCatalog *catalog, int reader) {
+    unsigned long epoch = __atomic_load_n(&catalog->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&catalog->readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+}
+
+void content_read_unlock(ContentCatalog *catalog, int reader) {
+    __atomic_store_n(&catalog->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+// Procura a secção da thread atual num catálogo
+static ContentThreadReader *content_thread_reader(ContentCatalog *catalog) {
+    for (int i = 0; i < CONTENT_THREAD_CATALOGS; i++) {
+        ContentThreadReader *entry = &content_thread_readers[i];
+        if (entry->catalog == catalog && entry->instance == catalog->instance) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Fecha as secções e devolve a posição de leitor de uma entrada, se o catálogo ainda existir
+static void content_thread_release(ContentThreadReader *entry) {
+    if (entry->catalog == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&content_registry_lock);
+    for (int i = 0; i < content_registry_count; i++) {
+        ContentCatalog *catalog = content_registry[i];
+        if (catalog == entry->catalog && catalog->instance == entry->instance) {
+            if (entry->reader >= 0) {
+                content_reader_unregister(catalog, entry->reader);
+            } else if (entry->depth > 0) {
+                __atomic_sub_fetch(&catalog->shared_readers, 1, __ATOMIC_SEQ_CST);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&content_registry_lock);
+    
+    entry->catalog = NULL;
+    entry->reader = -1;
+    entry->depth = 0;
+}
+
+// Destrutor da chave: devolve as posições de leitor da thread que termina
+static void content_thread_exit(void *value) {
+    ContentThreadReader *entries = (ContentThreadReader*)value;
+    for (int i = 0; i < CONTENT_THREAD_CATALOGS; i++) {
+        content_thread_release(&entries[i]);
+    }
+}
+
+static void content_thread_key_create(void) {
+    pthread_key_create(&content_thread_key, content_thread_exit);
+}
+
+int content_read_begin(ContentCatalog *catalog) {
+    if (catalog == NULL) {
+        return 0;
+    }
+    
+    ContentThreadReader *entry = content_thread_reader(catalog);
+    if (entry == NULL) {
+        // Primeira leitura desta thread neste catálogo: reutilizar uma entrada sem secção aberta,
+        // devolvendo a posição de leitor do catálogo que ela tinha
+        for (int i = 0; i < CONTENT_THREAD_CATALOGS && entry == NULL; i++) {
+            if (content_thread_readers[i].depth == 0) {
+                entry = &content_thread_readers[i];
+            }
+        }
+        if (entry == NULL) {
+            return 0;
+        }
+        content_thread_release(entry);
+        
+        if (!content_thread_watched) {
+            pthread_once(&content_thread_once, content_thread_key_create);
+            pthread_setspecific(content_thread_key, content_thread_readers);
+            content_thread_watched = 1;
+        }
+        entry->catalog = catalog;
+        entry->instance = catalog->instance;
+        entry->reader = -1;
+    }
+    
+    if (entry->depth++ == 0) {
+        // Sem posição própria (todas ocupadas da última vez): tentar de novo antes de partilhar
+        if (entry->reader < 0) {
+            entry->reader = content_reader_register(catalog);
+        }
+        if (entry->reader >= 0) {
+            content_read_lock(catalog, entry->reader);
+        } else {
+            __atomic_add_fetch(&catalog->shared_readers, 1, __ATOMIC_SEQ_CST);
+        }
+    }
+    return 1;
+}
+
+void content_read_end(ContentCatalog *catalog) {
+    if (catalog == NULL) {
+        return;
+    }
+    
+    ContentThreadReader *entry = content_thread_reader(catalog);
+    if (entry != NULL && entry->depth > 0 && --entry->depth == 0) {
+        if (entry->reader >= 0) {
+            content_read_unlock(catalog, entry->reader);
+        } else {
+            __atomic_sub_fetch(&catalog->shared_readers, 1, __ATOMIC_SEQ_CST);
+        }
+    }
+}
+
+const Content* content_snapshot(ContentCatalog *catalog, int *count) {
+    ContentTable *table = __atomic_load_n(&catalog->table, __ATOMIC_SEQ_CST);
+    *count = __atomic_load_n(&table->count, __ATOMIC_ACQUIRE);
+    return table->items;
+}
+
+int content_reclaim(ContentCatalog *catalog) {
+    if (catalog == NULL) {
+        return 0;
+    }
+    
+    // Uma secção sem posição própria pode estar a ler qualquer versão
+    if (__atomic_load_n(&catalog->shared_readers, __ATOMIC_SEQ_CST) > 0) {
+        return 0;
+    }
+    
+    // Menor época fixada por um leitor ativo
+    unsigned long oldest = (unsigned long)-1;
+    int readers = __atomic_load_n(&catalog->reader_count, __ATOMIC_SEQ_CST);
+    if (readers > CONTENT_MAX_READERS) {
+        readers = CONTENT_MAX_READERS;
+    }
+    for (int i = 0; i < readers; i++) {
+        unsigned long epoch = __atomic_load_n(&catalog->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    
+    // Libertar as versões retiradas antes da época mais antiga ainda em uso
+    int freed = 0, kept = 0;
+    for (int i = 0; i < catalog->retired_count; i++) {
+        if (catalog->retired[i].epoch < oldest) {
+            free(catalog->retired[i].table);
+            freed++;
+        } else {
+            catalog->retired[kept++] = catalog->retired[i];
+        }
+    }
+    catalog->retired_count = kept;
+    return freed;
+}
+
 int content_load_from_csv(ContentCatalog *catalog, const char *filename) {
     if (catalog == NULL || filename == NULL) {
         return -1;
@@ -56,17 +558,9 @@ int content_load_from_csv(ContentCatalog *catalog, const char *filename) {
         
         if (field_count >= 5) {  // ID, título, categoria, duração, classificação, visualizações
             // Verificar se precisamos aumentar a capacidade do catálogo
-            if (catalog->count >= catalog->capacity) {
-                int new_capacity = catalog->capacity * 2;
-                Content *new_items = (Content*)realloc(catalog->items, new_capacity * sizeof(Content));
-                
-                if (new_items == NULL) {
-                    fclose(file);
-                    return -1;
-                }
-                
-                catalog->items = new_items;
-                catalog->capacity = new_capacity;
+            if (!content_reserve_one(catalog)) {
+                fclose(file);
+                return -1;
             }
             
             Content *content = &catalog->items[catalog->count];
@@ -82,7 +576,7 @@ int content_load_from_csv(ContentCatalog *catalog, const char *filename) {
             content->age_rating = atoi(fields[4]);
             content->views = field_count > 5 ? atoi(fields[5]) : 0;
             
-            catalog->count++;
+            content_publish_append(catalog);
             loaded_count++;
         }
     }
@@ -112,7 +606,7 @@ int content_save_to_csv(ContentCatalog *catalog, const char *filename) {
         sprintf(id_str, "%d", content->id);
         sprintf(duration_str, "%d", content->duration);
         sprintf(age_rating_str, "%d", content->age_rating);
-        sprintf(views_str, "%d", content->views);
+        sprintf(views_str, "%d", content_get_views(catalog, content));
         
         char *fields[6] = {
             id_str,
@@ -138,16 +632,8 @@ int content_add(ContentCatalog *catalog, const char *title, const char *category
     }
     
     // Verificar se precisamos aumentar a capacidade do catálogo
-    if (catalog->count >= catalog->capacity) {
-        int new_capacity = catalog->capacity * 2;
-        Content *new_items = (Content*)realloc(catalog->items, new_capacity * sizeof(Content));
-        
-        if (new_items == NULL) {
-            return -1;
-        }
-        
-        catalog->items = new_items;
-        catalog->capacity = new_capacity;
+    if (!content_reserve_one(catalog)) {
+        return -1;
     }
     
     // Encontrar o próximo ID disponível
@@ -171,8 +657,10 @@ int content_add(ContentCatalog *catalog, const char *title, const char *category
     content->duration = duration;
     content->age_rating = age_rating;
     content->views = 0;
+    content_pending_views(catalog, next_id, 1);  // Descartar contagens de um ID reutilizado
     
-    catalog->count++;
+    content_publish_append(catalog);
+    content_notify(catalog, next_id, CONTENT_CHANGE_ADD);
     return next_id;
 }
 
@@ -194,12 +682,21 @@ int content_remove(ContentCatalog *catalog, int id) {
         return 0; // ID não encontrado
     }
     
-    // Mover os conteúdos seguintes uma posição para trás
-    for (int i = index; i < catalog->count - 1; i++) {
-        catalog->items[i] = catalog->items[i + 1];
+    // Publicar uma nova versão sem o conteúdo (os leitores podem estar na atual)
+    ContentTable *table = content_table_clone(catalog, catalog->capacity);
+    if (table == NULL) {
+        return 0;
     }
     
-    catalog->count--;
+    memmove(&table->items[index], &table->items[index + 1], 
+            (catalog->count - index - 1) * sizeof(Content));
+    table->count--;
+    content_pending_views(catalog, id, 1);
+    
+    if (!content_publish(catalog, table)) {
+        return 0;
+    }
+    content_notify(catalog, id, CONTENT_CHANGE_REMOVE);
     return 1;
 }
 
@@ -210,18 +707,25 @@ int content_edit(ContentCatalog *catalog, int id, const char *title,
     }
     
     // Buscar o conteúdo com o ID especificado
-    Content *content = NULL;
+    int index = -1;
     for (int i = 0; i < catalog->count; i++) {
         if (catalog->items[i].id == id) {
-            content = &catalog->items[i];
+            index = i;
             break;
         }
     }
     
-    if (content == NULL) {
+    if (index == -1) {
         return 0; // ID não encontrado
     }
     
+    // Editar uma cópia para que os leitores nunca vejam um registo a meio da escrita
+    ContentTable *table = content_table_clone(catalog, catalog->capacity);
+    if (table == NULL) {
+        return 0;
+    }
+    Content *content = &table->items[index];
+    
     // Atualizar os campos especificados
     if (title != NULL) {
         strncpy(content->title, title, MAX_TITLE_LENGTH - 1);
@@ -241,6 +745,10 @@ int content_edit(ContentCatalog *catalog, int id, const char *title,
         content->age_rating = age_rating;
     }
     
+    if (!content_publish(catalog, table)) {
+        return 0;
+    }
+    content_notify(catalog, id, CONTENT_CHANGE_EDIT);
     return 1;
 }
 
@@ -250,14 +758,21 @@ int content_search_by_title(ContentCatalog *catalog, const char *title,
         return 0;
     }
     
+    // A versão lida não pode ser libertada por uma alteração concorrente até ao fim da pesquisa
+    if (!content_read_begin(catalog)) {
+        return 0;
+    }
+    
     int found_count = 0;
+    int content_count;
+    const Content *items = content_snapshot(catalog, &content_count);
     
-    for (int i = 0; i < catalog->count && found_count < max_results; i++) {
+    for (int i = 0; i < content_count && found_count < max_results; i++) {
         // Busca por substring, ignorando maiúsculas/minúsculas
         char title_lower[MAX_TITLE_LENGTH];
         char search_lower[MAX_TITLE_LENGTH];
         
-        strncpy(title_lower, catalog->items[i].title, MAX_TITLE_LENGTH - 1);
+        strncpy(title_lower, items[i].title, MAX_TITLE_LENGTH - 1);
         title_lower[MAX_TITLE_LENGTH - 1] = '\0';
         
         strncpy(search_lower, title, MAX_TITLE_LENGTH - 1);
@@ -273,10 +788,11 @@ int content_search_by_title(ContentCatalog *catalog, const char *title,
         }
         
         if (strstr(title_lower, search_lower) != NULL) {
-            results[found_count++] = catalog->items[i].id;
+            results[found_count++] = items[i].id;
         }
     }
     
+    content_read_end(catalog);
     return found_count;
 }
 
@@ -286,14 +802,21 @@ int content_search_by_category(ContentCatalog *catalog, const char *category,
         return 0;
     }
     
+    // A versão lida não pode ser libertada por uma alteração concorrente até ao fim da pesquisa
+    if (!content_read_begin(catalog)) {
+        return 0;
+    }
+    
     int found_count = 0;
+    int content_count;
+    const Content *items = content_snapshot(catalog, &content_count);
     
-    for (int i = 0; i < catalog->count && found_count < max_results; i++) {
+    for (int i = 0; i < content_count && found_count < max_results; i++) {
         // Busca exata, ignorando maiúsculas/minúsculas
         char category_lower[MAX_CATEGORY_LENGTH];
         char search_lower[MAX_CATEGORY_LENGTH];
         
-        strncpy(category_lower, catalog->items[i].category, MAX_CATEGORY_LENGTH - 1);
+        strncpy(category_lower, items[i].category, MAX_CATEGORY_LENGTH - 1);
         category_lower[MAX_CATEGORY_LENGTH - 1] = '\0';
         
         strncpy(search_lower, category, MAX_CATEGORY_LENGTH - 1);
@@ -309,10 +832,11 @@ int content_search_by_category(ContentCatalog *catalog, const char *category,
         }
         
         if (strcmp(category_lower, search_lower) == 0) {
-            results[found_count++] = catalog->items[i].id;
+            results[found_count++] = items[i].id;
         }
     }
     
+    content_read_end(catalog);
     return found_count;
 }
 
@@ -322,14 +846,22 @@ int content_search_by_age_rating(ContentCatalog *catalog, int age_rating,
         return 0;
     }
     
+    // A versão lida não pode ser libertada por uma alteração concorrente até ao fim da pesquisa
+    if (!content_read_begin(catalog)) {
+        return 0;
+    }
+    
     int found_count = 0;
+    int content_count;
+    const Content *items = content_snapshot(catalog, &content_count);
     
-    for (int i = 0; i < catalog->count && found_count < max_results; i++) {
-        if (catalog->items[i].age_rating == age_rating) {
-            results[found_count++] = catalog->items[i].id;
+    for (int i = 0; i < content_count && found_count < max_results; i++) {
+        if (items[i].age_rating == age_rating) {
+            results[found_count++] = items[i].id;
         }
     }
     
+    content_read_end(catalog);
     return found_count;
 }
 
@@ -338,23 +870,114 @@ int content_increment_views(ContentCatalog *catalog, int id) {
         return 0;
     }
     
-    Content *content = content_get_by_id(catalog, id);
-    if (content == NULL) {
+    // A procura percorre a versão publicada: fixá-la durante a verificação
+    if (!content_read_begin(catalog)) {
         return 0;
     }
+    int exists = content_get_by_id(catalog, id) != NULL;
+    content_read_end(catalog);
+    
+    return exists ? content_add_views(catalog, id, 1) : 0;
+}
+
+int content_add_views(ContentCatalog *catalog, int id, int delta) {
+    if (catalog == NULL || id <= 0) {
+        return 0;
+    }
+    
+    ContentViewSlab *slab = &catalog->view_slabs[content_current_slab()];
+    int *counter = content_view_counter(slab, id, 1);
+    if (counter == NULL) {
+        if (id / CONTENT_VIEW_PAGE_SIZE < CONTENT_VIEW_MAX_PAGES) {
+            return 0;
+        }
+        
+        // ID fora do intervalo das fatias: fica pendente até o escritor o consolidar
+        // (somar na versão publicada perder-se-ia se o escritor a estivesse a copiar)
+        pthread_mutex_lock(&catalog->view_overflow_lock);
+        int position = content_overflow_find(catalog, id);
+        if (position == -1) {
+            if (catalog->view_overflow_count == catalog->view_overflow_capacity) {
+                int capacity = catalog->view_overflow_capacity == 0 ? 8 : catalog->view_overflow_capacity * 2;
+                ContentViewOverflow *grown = (ContentViewOverflow*)realloc(catalog->view_overflow, 
+                                                                           capacity * sizeof(ContentViewOverflow));
+                if (grown == NULL) {
+                    pthread_mutex_unlock(&catalog->view_overflow_lock);
+                    return 0;
+                }
+                catalog->view_overflow = grown;
+                catalog->view_overflow_capacity = capacity;
+            }
+            position = catalog->view_overflow_count++;
+            catalog->view_overflow[position].id = id;
+            catalog->view_overflow[position].views = 0;
+        }
+        catalog->view_overflow[position].views += delta;
+        __atomic_add_fetch(&catalog->views_generation, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&catalog->view_overflow_lock);
+        return 1;
+    }
     
-    content->views++;
+    // Fatia da thread: sem disputa de linha de cache com as outras threads
+    __atomic_fetch_add(counter, delta, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&slab->generation, 1, __ATOMIC_RELEASE);
     return 1;
 }
 
-Content* content_get_by_id(ContentCatalog *catalog, int id) {
+int content_get_views(ContentCatalog *catalog, const Content *content) {
+    if (catalog == NULL || content == NULL) {
+        return 0;
+    }
+    
+    return __atomic_load_n(&content->views, __ATOMIC_RELAXED) + 
+           content_pending_views(catalog, content->id, 0);
+}
+
+int content_fold_views(ContentCatalog *catalog) {
+    if (catalog == NULL) {
+        return 0;
+    }
+    
+    int folded = 0;
+    for (int i = 0; i < catalog->count; i++) {
+        Content *content = &catalog->items[i];
+        int pending = content_pending_views(catalog, content->id, 1);
+        if (pending != 0) {
+            __atomic_fetch_add(&content->views, pending, __ATOMIC_RELAXED);
+            folded += pending;
+        }
+    }
+    
+    if (folded != 0) {
+        __atomic_add_fetch(&catalog->views_generation, 1, __ATOMIC_SEQ_CST);
+    }
+    return folded;
+}
+
+unsigned long content_views_generation(ContentCatalog *catalog) {
+    if (catalog == NULL) {
+        return 0;
+    }
+    
+    // Cada fatia só avança: a soma muda sempre que alguma muda
+    unsigned long generation = __atomic_load_n(&catalog->views_generation, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < CONTENT_VIEW_SLABS; i++) {
+        generation += __atomic_load_n(&catalog->view_slabs[i].generation, __ATOMIC_ACQUIRE);
+    }
+    return generation;
+}
+
+const Content* content_get_by_id(ContentCatalog *catalog, int id) {
     if (catalog == NULL || id <= 0) {
         return NULL;
     }
     
-    for (int i = 0; i < catalog->count; i++) {
-        if (catalog->items[i].id == id) {
-            return &catalog->items[i];
+    int content_count;
+    const Content *items = content_snapshot(catalog, &content_count);
+    
+    for (int i = 0; i < content_count; i++) {
+        if (items[i].id == id) {
+            return &items[i];
         }
     }
     
@@ -13,10 +13,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #define MAX_TITLE_LENGTH 100
 #define MAX_CATEGORY_LENGTH 50
 #define MAX_FIELD_COUNT 10
+#define CONTENT_MAX_READERS 64
+#define CONTENT_VIEW_SLABS 64
+#define CONTENT_VIEW_PAGE_SIZE 1024
+#define CONTENT_VIEW_MAX_PAGES 4096
+#define CONTENT_MAX_LISTENERS 8
+#define CONTENT_THREAD_CATALOGS 4
 
 /**
  * @brief Estrutura que representa um conteúdo no catálogo
@@ -27,16 +34,105 @@ typedef struct {
     char category[MAX_CATEGORY_LENGTH]; /**< Categoria do conteúdo */
     int duration;                      /**< Duração em minutos */
     int age_rating;                    /**< Classificação etária */
-    int views;                         /**< Número de visualizações */
+    int views;                         /**< Visualizações consolidadas (usar content_get_views) */
 } Content;
 
+/**
+ * @brief Versão publicada do array de conteúdos, lida pelos leitores concorrentes
+ */
+typedef struct {
+    int count;             /**< Número de conteúdos visíveis nesta versão */
+    int capacity;          /**< Capacidade do array desta versão */
+    Content items[];       /**< Conteúdos */
+} ContentTable;
+
+/**
+ * @brief Versão substituída que aguarda que os leitores a abandonem
+ */
+typedef struct {
+    ContentTable *table;   /**< Versão substituída */
+    unsigned long epoch;   /**< Época em que foi substituída */
+} ContentRetired;
+
+/**
+ * @brief Época fixada por um leitor (0 = fora de uma secção de leitura)
+ */
+typedef struct {
+    unsigned long epoch;   /**< Época fixada */
+    int used;              /**< 1 se a posição pertence a um leitor registado */
+    char padding[64 - sizeof(unsigned long) - sizeof(int)]; /**< Uma linha de cache por leitor */
+} ContentReaderSlot;
+
+/**
+ * @brief Contadores de visualizações ainda não consolidados de um grupo de threads
+ * 
+ * Indexados por ID de conteúdo, em páginas de CONTENT_VIEW_PAGE_SIZE
+ * contadores alocadas à medida que são usadas.
+ */
+typedef struct {
+    int **pages;           /**< Diretório de páginas (NULL até ao primeiro uso) */
+    unsigned long generation; /**< Incrementos feitos nesta fatia (ver content_views_generation) */
+    char padding[64 - sizeof(int**) - sizeof(unsigned long)]; /**< Uma linha de cache por fatia */
+} ContentViewSlab;
+
+/**
+ * @brief Visualizações pendentes de um ID fora do intervalo das fatias
+ */
+typedef struct {
+    int id;                /**< ID do conteúdo */
+    int views;             /**< Visualizações ainda não consolidadas */
+} ContentViewOverflow;
+
+/**
+ * @brief Tipo de alteração de um conteúdo comunicada ao observador do catálogo
+ */
+typedef enum {
+    CONTENT_CHANGE_ADD,    /**< Conteúdo adicionado */
+    CONTENT_CHANGE_EDIT,   /**< Conteúdo editado */
+    CONTENT_CHANGE_REMOVE  /**< Conteúdo removido */
+} ContentChange;
+
+/**
+ * @brief Função chamada depois de cada alteração publicada no catálogo
+ * 
+ * @param context Dados registados com content_add_change_listener
+ * @param id ID do conteúdo alterado
+ * @param change Tipo de alteração
+ */
+typedef void (*ContentChangeFunc)(void *context, int id, ContentChange change);
+
 /**
  * @brief Estrutura que gerencia a coleção de conteúdos
+ * 
+ * Suporta um escritor e vários leitores concorrentes: o escritor publica
+ * uma nova versão do array (ContentTable) em vez de o alterar no lugar, e
+ * os leitores fixam uma época com content_read_lock (ou content_read_begin),
+ * sem bloqueios. As versões antigas são libertadas quando nenhum leitor as
+ * pode estar a usar. Os campos items/count/capacity refletem a versão atual
+ * para o escritor.
  */
 typedef struct {
-    Content *items;        /**< Array dinâmico de conteúdos */
+    Content *items;        /**< Array dinâmico de conteúdos (versão atual) */
     int count;             /**< Número atual de conteúdos */
     int capacity;          /**< Capacidade máxima do array */
+    ContentTable *table;   /**< Versão publicada para os leitores */
+    unsigned long epoch;   /**< Época global, avançada a cada publicação */
+    ContentReaderSlot *readers; /**< Épocas fixadas pelos leitores registados */
+    int reader_count;      /**< Limite superior das posições de leitor já usadas */
+    int shared_readers;    /**< Secções de leitura sem posição própria (impedem qualquer libertação) */
+    ContentRetired *retired; /**< Versões substituídas ainda não libertadas */
+    int retired_count;     /**< Número de versões substituídas */
+    int retired_capacity;  /**< Capacidade do array de versões substituídas */
+    ContentViewSlab *view_slabs; /**< Visualizações pendentes, uma fatia por thread (CONTENT_VIEW_SLABS) */
+    unsigned long views_generation; /**< Geração das visualizações consolidadas (somada às das fatias) */
+    ContentViewOverflow *view_overflow; /**< Visualizações pendentes dos IDs sem fatia, até à consolidação */
+    int view_overflow_count; /**< Número de IDs com visualizações pendentes sem fatia */
+    int view_overflow_capacity; /**< Capacidade do array view_overflow */
+    pthread_mutex_t view_overflow_lock; /**< Protege view_overflow (caminho raro) */
+    ContentChangeFunc change_listeners[CONTENT_MAX_LISTENERS]; /**< Observadores das alterações, por ordem de registo */
+    void *change_contexts[CONTENT_MAX_LISTENERS]; /**< Dados passados a cada observador */
+    int listener_count;    /**< Número de observadores registados */
+    unsigned long instance; /**< Identificador único do catálogo (distingue catálogos no mesmo endereço) */
 } ContentCatalog;
 
 /**
@@ -55,6 +151,113 @@ int content_init_catalog(ContentCatalog *catalog, int initial_capacity);
  */
 void content_free_catalog(ContentCatalog *catalog);
 
+/**
+ * @brief Regista um observador chamado depois de content_add, content_edit e content_remove
+ * 
+ * Os observadores são chamados pela ordem de registo. Se já houver um
+ * observador com o mesmo contexto, a sua função é substituída. O
+ * carregamento em massa (content_load_from_csv) não notifica os
+ * observadores; quem depende deles deve reconstruir o seu estado depois
+ * de carregar.
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param listener Função a chamar
+ * @param context Dados passados à função (identificam o observador)
+ * @return int 1 se o registo foi bem-sucedido, 0 se já houver CONTENT_MAX_LISTENERS observadores
+ */
+int content_add_change_listener(ContentCatalog *catalog, ContentChangeFunc listener, void *context);
+
+/**
+ * @brief Remove o observador registado com um contexto
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param context Contexto com que o observador foi registado
+ */
+void content_remove_change_listener(ContentCatalog *catalog, void *context);
+
+/**
+ * @brief Regista uma thread leitora do catálogo
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @return int Identificador do leitor, ou -1 se as CONTENT_MAX_READERS posições estiverem ocupadas
+ */
+int content_reader_register(ContentCatalog *catalog);
+
+/**
+ * @brief Devolve a posição de um leitor registado com content_reader_register
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param reader Identificador do leitor (fora de uma secção de leitura)
+ */
+void content_reader_unregister(ContentCatalog *catalog, int reader);
+
+/**
+ * @brief Inicia uma secção de leitura, fixando a época atual
+ * 
+ * Enquanto a secção estiver aberta, os ponteiros obtidos com
+ * content_snapshot ou content_get_by_id continuam válidos, mesmo que o
+ * escritor publique novas versões do catálogo.
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param reader Identificador devolvido por content_reader_register
+ */
+void content_read_lock(ContentCatalog *catalog, int reader);
+
+/**
+ * @brief Termina uma secção de leitura
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param reader Identificador devolvido por content_reader_register
+ */
+void content_read_unlock(ContentCatalog *catalog, int reader);
+
+/**
+ * @brief Inicia uma secção de leitura na thread atual
+ * 
+ * Regista a thread como leitora do catálogo na primeira utilização e fixa
+ * a época atual. As secções podem ser aninhadas: só a mais externa fixa e
+ * liberta a época, por isso um recomendador pode chamar outro. Os
+ * recomendadores, relatórios, sessões, pesquisas e construções de modelos
+ * abrem uma secção enquanto leem o catálogo; as threads do conjunto que
+ * trabalham para eles ficam cobertas pela secção de quem as espera.
+ * 
+ * A posição de leitor é devolvida quando a thread termina ou quando a
+ * thread passa a ler mais de CONTENT_THREAD_CATALOGS catálogos. Sem
+ * posições livres, a secção entra na fixação partilhada do catálogo, que
+ * impede a libertação de qualquer versão enquanto estiver aberta.
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @return int 1 se a época ficou fixada, 0 se catalog for NULL ou a thread já tiver
+ *         secções abertas em CONTENT_THREAD_CATALOGS outros catálogos
+ */
+int content_read_begin(ContentCatalog *catalog);
+
+/**
+ * @brief Termina uma secção aberta com content_read_begin na thread atual
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ */
+void content_read_end(ContentCatalog *catalog);
+
+/**
+ * @brief Obtém uma vista consistente dos conteúdos publicados
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param count Ponteiro para armazenar o número de conteúdos
+ * @return const Content* Array de conteúdos (válido até ao fim da secção de leitura)
+ */
+const Content* content_snapshot(ContentCatalog *catalog, int *count);
+
+/**
+ * @brief Liberta as versões substituídas que já nenhum leitor pode estar a usar
+ * 
+ * Chamada automaticamente pelo escritor a cada publicação.
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @return int Número de versões libertadas
+ */
+int content_reclaim(ContentCatalog *catalog);
+
 /**
  * @brief Carrega conteúdos de um arquivo CSV para o catálogo
  * 
@@ -148,19 +351,78 @@ int content_search_by_age_rating(ContentCatalog *catalog, int age_rating,
 /**
  * @brief Incrementa o contador de visualizações de um conteúdo
  * 
+ * O incremento vai para a fatia de contadores da thread atual, sem
+ * partilhar linhas de cache com outras threads; content_get_views soma as
+ * fatias e content_fold_views consolida-as em Content.views.
+ * 
  * @param catalog Ponteiro para o catálogo
  * @param id ID do conteúdo
  * @return int 1 se a operação foi bem-sucedida, 0 caso contrário
  */
 int content_increment_views(ContentCatalog *catalog, int id);
 
+/**
+ * @brief Soma visualizações a um conteúdo cujo ID já foi validado pelo chamador
+ * 
+ * Os IDs acima do intervalo das fatias ficam pendentes numa lista
+ * partilhada (protegida por um mutex) até content_fold_views, que só o
+ * escritor chama: nunca se altera a versão publicada do catálogo.
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param id ID do conteúdo
+ * @param delta Número de visualizações a somar
+ * @return int 1 se a operação foi bem-sucedida, 0 caso contrário
+ */
+int content_add_views(ContentCatalog *catalog, int id, int delta);
+
+/**
+ * @brief Obtém o total de visualizações de um conteúdo (consolidadas e pendentes)
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @param content Ponteiro para o conteúdo
+ * @return int Número de visualizações
+ */
+int content_get_views(ContentCatalog *catalog, const Content *content);
+
+/**
+ * @brief Consolida as visualizações pendentes de todas as threads em Content.views
+ * 
+ * Operação do escritor; pode ser chamada periodicamente. Avança a geração
+ * das visualizações (content_views_generation) quando consolida alguma.
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @return int Número de visualizações consolidadas
+ */
+int content_fold_views(ContentCatalog *catalog);
+
+/**
+ * @brief Obtém a geração das visualizações consolidadas
+ * 
+ * Muda sempre que o valor de content_get_views de algum conteúdo pode ter
+ * mudado: a cada visualização registada numa fatia, a cada consolidação e
+ * a cada visualização de um ID fora das fatias. Soma a geração do
+ * catálogo com a de cada fatia, que só é escrita pelas threads dessa
+ * fatia, para que quem guarda resultados que dependem da popularidade
+ * saiba quando os recalcular sem disputar uma linha de cache por
+ * visualização.
+ * 
+ * @param catalog Ponteiro para o catálogo de conteúdos
+ * @return unsigned long Geração atual
+ */
+unsigned long content_views_generation(ContentCatalog *catalog);
+
 /**
  * @brief Obtém um conteúdo pelo ID
  * 
+ * O conteúdo pertence à versão publicada do catálogo, que a próxima
+ * alteração substitui: o ponteiro só é válido dentro de uma secção de
+ * leitura (content_read_begin) ou, para o escritor, até à sua próxima
+ * alteração. As alterações passam por content_edit.
+ * 
  * @param catalog Ponteiro para o catálogo
  * @param id ID do conteúdo
- * @return Content* Ponteiro para o conteúdo ou NULL se não encontrado
+ * @return const Content* Ponteiro para o conteúdo ou NULL se não encontrado
  */
-Content* content_get_by_id(ContentCatalog *catalog, int id);
+const Content* content_get_by_id(ContentCatalog *catalog, int id);
 
 #endif /* CONTENT_H */
\ No newline at end of file
@@ -0,0 +1,836 @@
+/**
+ * @file hnsw.c
+ * @brief Implementação do módulo de índice aproximado de vizinhos mais próximos (HNSW)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "hnsw.h"
+#include "arena.h"
+#include "simkernel.h"
+#include "mapfile.h"
+
+#define HNSW_MAX_ID (CONTENT_VIEW_MAX_PAGES * CONTENT_VIEW_PAGE_SIZE)
+#define HNSW_FILE_MAGIC "SFHNSW1"
+
+// Cabeçalho do ficheiro gravado por hnsw_save (64 bytes), seguido dos arrays do índice
+typedef struct {
+    char magic[8];
+    int dimension;
+    int m;
+    int m0;
+    int ef_construction;
+    int count;
+    int deleted_count;
+    int upper_count;
+    int id_slots;
+    int entry_point;
+    int max_level;
+    unsigned int seed;
+    int reserved[3];
+} HnswFileHeader;
+
+// Nó candidato e a sua distância ao vetor pesquisado
+typedef struct {
+    float distance;
+    int node;
+} HnswCandidate;
+
+// Conjunto dos nós já visitados numa pesquisa (dispersão aberta na arena de rascunho)
+typedef struct {
+    int *slots;
+    int mask;
+    int used;
+    Arena *arena;
+} HnswVisited;
+
+// Distância de cosseno entre dois vetores normalizados
+static float hnsw_distance(const HnswIndex *index, const float *a, const float *b) {
+    float dot;
+    simkernel_dot_rows(a, b, index->dimension, index->dimension, 1, &dot);
+    return 1.0f - dot;
+}
+
+static const float *hnsw_vector(const HnswIndex *index, int node) {
+    return index->vectors + (size_t)node * index->dimension;
+}
+
+// Lista de ligações de um nó num nível (o primeiro inteiro é o número de ligações)
+static int *hnsw_links(const HnswIndex *index, int node, int level) {
+    if (level == 0) {
+        return index->links0 + (size_t)node * (index->m0 + 1);
+    }
+    return index->upper_links + index->upper_offsets[node] + (size_t)(level - 1) * (index->m + 1);
+}
+
+// Copia um vetor normalizado (ou a zeros, se a norma for nula)
+static void hnsw_normalize(const float *vector, int dimension, float *normalized) {
+    double norm = 0.0;
+    for (int k = 0; k < dimension; k++) {
+        norm += (double)vector[k] * vector[k];
+    }
+    
+    float scale = norm > 0.0 ? (float)(1.0 / sqrt(norm)) : 0.0f;
+    for (int k = 0; k < dimension; k++) {
+        normalized[k] = vector[k] * scale;
+    }
+}
+
+// Nível aleatório com distribuição geométrica de razão 1/m
+static int hnsw_random_level(HnswIndex *index) {
+    index->seed = index->seed * 1103515245u + 12345u;
+    double uniform = (double)((index->seed >> 8) + 1) / 16777217.0;
+    int level = (int)(-log(uniform) / log((double)index->m));
+    return level < HNSW_MAX_LEVEL ? level : HNSW_MAX_LEVEL;
+}
+
+// Heap máximo por distância (os candidatos a expandir usam a distância negada)
+static void hnsw_heap_push(HnswCandidate *heap, int *size, float distance, int node) {
+    int i = (*size)++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap[parent].distance >= distance) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i].distance = distance;
+    heap[i].node = node;
+}
+
+static HnswCandidate hnsw_heap_pop(HnswCandidate *heap, int *size) {
+    HnswCandidate top = heap[0];
+    HnswCandidate last = heap[--(*size)];
+    int i = 0;
+    
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= *size) {
+            break;
+        }
+        if (child + 1 < *size && heap[child + 1].distance > heap[child].distance) {
+            child++;
+        }
+        if (last.distance >= heap[child].distance) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (*size > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+static int hnsw_visited_init(HnswVisited *visited, Arena *arena, int expected) {
+    int slots = 64;
+    while (slots < expected * 2) {
+        slots *= 2;
+    }
+    
+    visited->slots = (int*)arena_alloc(arena, slots * sizeof(int));
+    if (visited->slots == NULL) {
+        return 0;
+    }
+    memset(visited->slots, 0xff, slots * sizeof(int));
+    visited->mask = slots - 1;
+    visited->used = 0;
+    visited->arena = arena;
+    return 1;
+}
+
+// Marca um nó como visitado; devolve 1 se ainda não tinha sido, 0 se já tinha (ou sem memória)
+static int hnsw_visit(HnswVisited *visited, int node) {
+    if (2 * (visited->used + 1) > visited->mask + 1) {
+        int old_mask = visited->mask;
+        int *old_slots = visited->slots;
+        if (!hnsw_visited_init(visited, visited->arena, (old_mask + 1) * 2)) {
+            visited->slots = old_slots;
+            visited->mask = old_mask;
+            return 0;
+        }
+        for (int i = 0; i <= old_mask; i++) {
+            if (old_slots[i] >= 0) {
+                hnsw_visit(visited, old_slots[i]);
+            }
+        }
+    }
+    
+    unsigned int slot = ((unsigned)node * 2654435761u) & (unsigned)visited->mask;
+    while (visited->slots[slot] >= 0) {
+        if (visited->slots[slot] == node) {
+            return 0;
+        }
+        slot = (slot + 1) & (unsigned)visited->mask;
+    }
+    visited->slots[slot] = node;
+    visited->used++;
+    return 1;
+}
+
+// Desce gulosamente no nível até não haver ligação mais próxima
+static int hnsw_greedy(const HnswIndex *index, const float *query, int entry, int level) {
+    float best = hnsw_distance(index, query, hnsw_vector(index, entry));
+    int changed = 1;
+    
+    while (changed) {
+        changed = 0;
+        const int *links = hnsw_links(index, entry, level);
+        for (int i = 1; i <= links[0]; i++) {
+            float distance = hnsw_distance(index, query, hnsw_vector(index, links[i]));
+            if (distance < best) {
+                best = distance;
+                entry = links[i];
+                changed = 1;
+            }
+        }
+    }
+    return entry;
+}
+
+// Pesquisa em largura limitada a ef resultados num nível; results recebe os nós por
+// distância crescente (pelo menos ef + 1 posições). Com skip_deleted, os nós removidos
+// servem de passagem mas não entram nos resultados.
+static int hnsw_search_layer(const HnswIndex *index, const float *query, int entry, int ef, int level,
+                             int skip_deleted, HnswCandidate *results, Arena *scratch) {
+    HnswVisited visited;
+    int candidate_capacity = 4 * ef + 16;
+    HnswCandidate *candidates = (HnswCandidate*)arena_alloc(scratch, candidate_capacity * sizeof(HnswCandidate));
+    if (candidates == NULL || !hnsw_visited_init(&visited, scratch, 8 * ef)) {
+        return 0;
+    }
+    
+    int candidate_count = 0, result_count = 0;
+    float distance = hnsw_distance(index, query, hnsw_vector(index, entry));
+    float bound = distance;
+    hnsw_visit(&visited, entry);
+    hnsw_heap_push(candidates, &candidate_count, -distance, entry);
+    if (!skip_deleted || !index->deleted[entry]) {
+        hnsw_heap_push(results, &result_count, distance, entry);
+    } else {
+        bound = INFINITY;
+    }
+    
+    while (candidate_count > 0) {
+        HnswCandidate current = hnsw_heap_pop(candidates, &candidate_count);
+        if (-current.distance > bound && result_count == ef) {
+            break;
+        }
+        
+        const int *links = hnsw_links(index, current.node, level);
+        for (int i = 1; i <= links[0]; i++) {
+            int neighbor = links[i];
+            if (!hnsw_visit(&visited, neighbor)) {
+                continue;
+            }
+            
+            distance = hnsw_distance(index, query, hnsw_vector(index, neighbor));
+            if (result_count < ef || distance < bound) {
+                if (candidate_count == candidate_capacity) {
+                    HnswCandidate *grown = (HnswCandidate*)arena_alloc(scratch,
+                                                                       2 * candidate_capacity * sizeof(HnswCandidate));
+                    if (grown == NULL) {
+                        continue;
+                    }
+                    memcpy(grown, candidates, candidate_count * sizeof(HnswCandidate));
+                    candidates = grown;
+                    candidate_capacity *= 2;
+                }
+                hnsw_heap_push(candidates, &candidate_count, -distance, neighbor);
+                
+                if (!skip_deleted || !index->deleted[neighbor]) {
+                    hnsw_heap_push(results, &result_count, distance, neighbor);
+                    if (result_count > ef) {
+                        hnsw_heap_pop(results, &result_count);
+                    }
+                }
+                if (result_count > 0) {
+                    bound = results[0].distance;
+                }
+            }
+        }
+    }
+    
+    // Esvaziar o heap máximo do fim para o início deixa os resultados por distância crescente
+    int count = result_count;
+    while (result_count > 0) {
+        HnswCandidate top = hnsw_heap_pop(results, &result_count);
+        results[result_count] = top;
+    }
+    return count;
+}
+
+// Heurística de seleção: um candidato (por distância crescente) só fica se estiver mais
+// perto do nó de origem do que de todos os já escolhidos, o que mantém ligações em várias direções
+static int hnsw_select(const HnswIndex *index, const HnswCandidate *candidates, int count, int max, int *selected) {
+    int selected_count = 0;
+    
+    for (int i = 0; i < count && selected_count < max; i++) {
+        const float *vector = hnsw_vector(index, candidates[i].node);
+        int keep = 1;
+        for (int j = 0; j < selected_count && keep; j++) {
+            if (hnsw_distance(index, vector, hnsw_vector(index, selected[j])) < candidates[i].distance) {
+                keep = 0;
+            }
+        }
+        if (keep) {
+            selected[selected_count++] = candidates[i].node;
+        }
+    }
+    return selected_count;
+}
+
+static int hnsw_compare_candidates(const void *a, const void *b) {
+    const HnswCandidate *first = (const HnswCandidate*)a;
+    const HnswCandidate *second = (const HnswCandidate*)b;
+    if (first->distance != second->distance) {
+        return first->distance < second->distance ? -1 : 1;
+    }
+    return first->node - second->node;
+}
+
+// Acrescenta node às ligações de neighbor; se a lista estiver cheia, volta a selecioná-la
+static void hnsw_connect(HnswIndex *index, int neighbor, int node, int level) {
+    int *links = hnsw_links(index, neighbor, level);
+    int cap = level == 0 ? index->m0 : index->m;
+    
+    if (links[0] < cap) {
+        links[++links[0]] = node;
+        return;
+    }
+    
+    HnswCandidate candidates[2 * HNSW_MAX_M + 1];
+    const float *origin = hnsw_vector(index, neighbor);
+    for (int i = 0; i < links[0]; i++) {
+        candidates[i].node = links[i + 1];
+        candidates[i].distance = hnsw_distance(index, origin, hnsw_vector(index, links[i + 1]));
+    }
+    candidates[cap].node = node;
+    candidates[cap].distance = hnsw_distance(index, origin, hnsw_vector(index, node));
+    qsort(candidates, cap + 1, sizeof(HnswCandidate), hnsw_compare_candidates);
+    links[0] = hnsw_select(index, candidates, cap + 1, cap, links + 1);
+}
+
+// Copia para o heap um índice aberto com mapeamento em memória
+static int hnsw_unmap(HnswIndex *index);
+
+// Garante espaço para mais um nó e para o ID dado
+static int hnsw_reserve(HnswIndex *index, int id, int level) {
+    if (index->mapping != NULL && !hnsw_unmap(index)) {
+        return 0;
+    }
+    
+    if (index->count == index->capacity) {
+        int capacity = index->capacity > 0 ? index->capacity * 2 : 64;
+        float *vectors = (float*)realloc(index->vectors, (size_t)capacity * index->dimension * sizeof(float));
+        if (vectors != NULL) {
+            index->vectors = vectors;
+        }
+        int *ids = (int*)realloc(index->ids, capacity * sizeof(int));
+        if (ids != NULL) {
+            index->ids = ids;
+        }
+        int *levels = (int*)realloc(index->levels, capacity * sizeof(int));
+        if (levels != NULL) {
+            index->levels = levels;
+        }
+        unsigned char *deleted = (unsigned char*)realloc(index->deleted, capacity);
+        if (deleted != NULL) {
+            index->deleted = deleted;
+        }
+        int *links0 = (int*)realloc(index->links0, (size_t)capacity * (index->m0 + 1) * sizeof(int));
+        if (links0 != NULL) {
+            index->links0 = links0;
+        }
+        int *upper_offsets = (int*)realloc(index->upper_offsets, capacity * sizeof(int));
+        if (upper_offsets != NULL) {
+            index->upper_offsets = upper_offsets;
+        }
+        if (vectors == NULL || ids == NULL || levels == NULL || deleted == NULL ||
+            links0 == NULL || upper_offsets == NULL) {
+            return 0;
+        }
+        index->capacity = capacity;
+    }
+    
+    int needed = index->upper_count + level * (index->m + 1);
+    if (needed > index->upper_capacity) {
+        int capacity = index->upper_capacity > 0 ? index->upper_capacity : 256;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        int *upper_links = (int*)realloc(index->upper_links, capacity * sizeof(int));
+        if (upper_links == NULL) {
+            return 0;
+        }
+        index->upper_links = upper_links;
+        index->upper_capacity = capacity;
+    }
+    
+    if (id >= index->id_slots) {
+        int slots = index->id_slots > 0 ? index->id_slots : 64;
+        while (slots <= id) {
+            slots *= 2;
+        }
+        int *node_of_id = (int*)realloc(index->node_of_id, slots * sizeof(int));
+        if (node_of_id == NULL) {
+            return 0;
+        }
+        for (int i = index->id_slots; i < slots; i++) {
+            node_of_id[i] = -1;
+        }
+        index->node_of_id = node_of_id;
+        index->id_slots = slots;
+    }
+    return 1;
+}
+
+static int hnsw_insert_locked(HnswIndex *index, int id, const float *vector) {
+    int level = hnsw_random_level(index);
+    if (!hnsw_reserve(index, id, level)) {
+        return 0;
+    }
+    
+    int node = index->count;
+    float *normalized = index->vectors + (size_t)node * index->dimension;
+    hnsw_normalize(vector, index->dimension, normalized);
+    index->ids[node] = id;
+    index->levels[node] = level;
+    index->deleted[node] = 0;
+    index->links0[(size_t)node * (index->m0 + 1)] = 0;
+    index->upper_offsets[node] = level > 0 ? index->upper_count : -1;
+    for (int l = 0; l < level; l++) {
+        index->upper_links[index->upper_count + l * (index->m + 1)] = 0;
+    }
+    index->upper_count += level * (index->m + 1);
+    index->count++;
+    
+    // Um ID reinserido substitui o nó anterior
+    int previous = index->node_of_id[id];
+    if (previous >= 0 && !index->deleted[previous]) {
+        index->deleted[previous] = 1;
+        index->deleted_count++;
+    }
+    index->node_of_id[id] = node;
+    
+    if (index->entry_point < 0) {
+        index->entry_point = node;
+        index->max_level = level;
+        return 1;
+    }
+    
+    int entry = index->entry_point;
+    for (int l = index->max_level; l > level; l--) {
+        entry = hnsw_greedy(index, normalized, entry, l);
+    }
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    HnswCandidate *results = (HnswCandidate*)arena_alloc(scratch, (index->ef_construction + 1) * sizeof(HnswCandidate));
+    int selected[HNSW_MAX_M];
+    
+    for (int l = level < index->max_level ? level : index->max_level; l >= 0 && results != NULL; l--) {
+        int found = hnsw_search_layer(index, normalized, entry, index->ef_construction, l, 0, results, scratch);
+        if (found == 0) {
+            continue;
+        }
+        
+        int selected_count = hnsw_select(index, results, found, index->m, selected);
+        int *links = hnsw_links(index, node, l);
+        links[0] = selected_count;
+        memcpy(links + 1, selected, selected_count * sizeof(int));
+        for (int i = 0; i < selected_count; i++) {
+            hnsw_connect(index, selected[i], node, l);
+        }
+        entry = results[0].node;
+    }
+    arena_reset_to(scratch, mark);
+    
+    if (level > index->max_level) {
+        index->entry_point = node;
+        index->max_level = level;
+    }
+    return 1;
+}
+
+// Liberta os arrays do índice (ou o mapeamento), deixando-o vazio
+static void hnsw_release(HnswIndex *index);
+
+static void hnsw_reset(HnswIndex *index) {
+    hnsw_release(index);
+    index->count = 0;
+    index->capacity = 0;
+    index->deleted_count = 0;
+    index->upper_count = 0;
+    index->upper_capacity = 0;
+    index->id_slots = 0;
+    index->entry_point = -1;
+    index->max_level = 0;
+    index->seed = 42u;
+}
+
+static void hnsw_release(HnswIndex *index) {
+    if (index->mapping != NULL) {
+        mapfile_close(index->mapping, index->mapping_size);
+    } else {
+        free(index->vectors);
+        free(index->ids);
+        free(index->levels);
+        free(index->deleted);
+        free(index->links0);
+        free(index->upper_offsets);
+        free(index->upper_links);
+        free(index->node_of_id);
+    }
+    
+    index->mapping = NULL;
+    index->mapping_size = 0;
+    index->vectors = NULL;
+    index->ids = NULL;
+    index->levels = NULL;
+    index->deleted = NULL;
+    index->links0 = NULL;
+    index->upper_offsets = NULL;
+    index->upper_links = NULL;
+    index->node_of_id = NULL;
+}
+
+// Cópia no heap de size bytes (com pelo menos 1 byte reservado)
+static void *hnsw_copy(const void *source, size_t size) {
+    void *copy = malloc(size > 0 ? size : 1);
+    if (copy != NULL && size > 0) {
+        memcpy(copy, source, size);
+    }
+    return copy;
+}
+
+static int hnsw_unmap(HnswIndex *index) {
+    HnswIndex copy = *index;
+    size_t count = (size_t)index->count;
+    
+    copy.vectors = (float*)hnsw_copy(index->vectors, count * index->dimension * sizeof(float));
+    copy.ids = (int*)hnsw_copy(index->ids, count * sizeof(int));
+    copy.levels = (int*)hnsw_copy(index->levels, count * sizeof(int));
+    copy.deleted = (unsigned char*)hnsw_copy(index->deleted, count);
+    copy.links0 = (int*)hnsw_copy(index->links0, count * (index->m0 + 1) * sizeof(int));
+    copy.upper_offsets = (int*)hnsw_copy(index->upper_offsets, count * sizeof(int));
+    copy.upper_links = (int*)hnsw_copy(index->upper_links, (size_t)index->upper_count * sizeof(int));
+    copy.node_of_id = (int*)hnsw_copy(index->node_of_id, (size_t)index->id_slots * sizeof(int));
+    copy.mapping = NULL;
+    if (copy.vectors == NULL || copy.ids == NULL || copy.levels == NULL || copy.deleted == NULL ||
+        copy.links0 == NULL || copy.upper_offsets == NULL || copy.upper_links == NULL || copy.node_of_id == NULL) {
+        hnsw_release(&copy);
+        return 0;
+    }
+    
+    mapfile_close(index->mapping, index->mapping_size);
+    index->mapping = NULL;
+    index->mapping_size = 0;
+    index->vectors = copy.vectors;
+    index->ids = copy.ids;
+    index->levels = copy.levels;
+    index->deleted = copy.deleted;
+    index->links0 = copy.links0;
+    index->upper_offsets = copy.upper_offsets;
+    index->upper_links = copy.upper_links;
+    index->node_of_id = copy.node_of_id;
+    index->capacity = index->count;
+    index->upper_capacity = index->upper_count;
+    return 1;
+}
+
+// Observador do catálogo
+static void hnsw_on_change(void *context, int id, ContentChange change) {
+    HnswIndex *index = (HnswIndex*)context;
+    
+    if (change == CONTENT_CHANGE_REMOVE) {
+        hnsw_remove(index, id);
+        return;
+    }
+    
+    const Content *content = content_get_by_id(index->catalog, id);
+    if (content != NULL) {
+        float vector[HNSW_MAX_DIMENSION];
+        index->embed(index->embed_context, content, vector);
+        hnsw_insert(index, id, vector);
+    }
+}
+
+int hnsw_init(HnswIndex *index, int dimension, int m, int ef_construction) {
+    if (index == NULL || dimension <= 0 || dimension > HNSW_MAX_DIMENSION ||
+        m < 2 || m > HNSW_MAX_M || ef_construction < m) {
+        return 0;
+    }
+    
+    memset(index, 0, sizeof(HnswIndex));
+    index->dimension = dimension;
+    index->m = m;
+    index->m0 = 2 * m;
+    index->ef_construction = ef_construction;
+    index->entry_point = -1;
+    index->seed = 42u;
+    if (pthread_rwlock_init(&index->lock, NULL) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
+void hnsw_free(HnswIndex *index) {
+    if (index == NULL) {
+        return;
+    }
+    
+    if (index->catalog != NULL) {
+        content_remove_change_listener(index->catalog, index);
+        index->catalog = NULL;
+    }
+    hnsw_reset(index);
+    pthread_rwlock_destroy(&index->lock);
+}
+
+int hnsw_build(HnswIndex *index, const float *vectors, int stride, const int *ids, int count) {
+    if (index == NULL || vectors == NULL || ids == NULL || count < 0 || stride < index->dimension) {
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (ids[i] <= 0 || ids[i] >= HNSW_MAX_ID) {
+            return 0;
+        }
+    }
+    
+    pthread_rwlock_wrlock(&index->lock);
+    hnsw_reset(index);
+    int success = 1;
+    for (int i = 0; i < count && success; i++) {
+        success = hnsw_insert_locked(index, ids[i], vectors + (size_t)i * stride);
+    }
+    pthread_rwlock_unlock(&index->lock);
+    return success;
+}
+
+int hnsw_insert(HnswIndex *index, int id, const float *vector) {
+    if (index == NULL || vector == NULL || id <= 0 || id >= HNSW_MAX_ID) {
+        return 0;
+    }
+    
+    pthread_rwlock_wrlock(&index->lock);
+    int success = hnsw_insert_locked(index, id, vector);
+    pthread_rwlock_unlock(&index->lock);
+    return success;
+}
+
+int hnsw_remove(HnswIndex *index, int id) {
+    if (index == NULL || id <= 0) {
+        return 0;
+    }
+    
+    pthread_rwlock_wrlock(&index->lock);
+    int node = id < index->id_slots ? index->node_of_id[id] : -1;
+    int removed = node >= 0 && !index->deleted[node];
+    if (removed && (index->mapping == NULL || hnsw_unmap(index))) {
+        index->deleted[node] = 1;
+        index->deleted_count++;
+        index->node_of_id[id] = -1;
+    } else {
+        removed = 0;
+    }
+    pthread_rwlock_unlock(&index->lock);
+    return removed;
+}
+
+int hnsw_search(HnswIndex *index, const float *query, int k, int ef, int *ids, float *scores) {
+    if (index == NULL || query == NULL || ids == NULL || k <= 0) {
+        return -1;
+    }
+    if (ef < k) {
+        ef = k;
+    }
+    
+    pthread_rwlock_rdlock(&index->lock);
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    float *normalized = (float*)arena_alloc(scratch, index->dimension * sizeof(float));
+    HnswCandidate *results = (HnswCandidate*)arena_alloc(scratch, (ef + 1) * sizeof(HnswCandidate));
+    if (normalized == NULL || results == NULL) {
+        pthread_rwlock_unlock(&index->lock);
+        arena_reset_to(scratch, mark);
+        return -1;
+    }
+    hnsw_normalize(query, index->dimension, normalized);
+    
+    int found = 0;
+    if (index->entry_point >= 0) {
+        int entry = index->entry_point;
+        for (int l = index->max_level; l > 0; l--) {
+            entry = hnsw_greedy(index, normalized, entry, l);
+        }
+        found = hnsw_search_layer(index, normalized, entry, ef, 0, 1, results, scratch);
+    }
+    
+    int count = found < k ? found : k;
+    for (int i = 0; i < count; i++) {
+        ids[i] = index->ids[results[i].node];
+        if (scores != NULL) {
+            scores[i] = 1.0f - results[i].distance;
+        }
+    }
+    pthread_rwlock_unlock(&index->lock);
+    
+    arena_reset_to(scratch, mark);
+    return count;
+}
+
+int hnsw_attach(HnswIndex *index, ContentCatalog *catalog, HnswEmbedFunc embed, void *context) {
+    if (index == NULL || catalog == NULL || embed == NULL) {
+        return 0;
+    }
+    
+    if (index->catalog != NULL && index->catalog != catalog) {
+        content_remove_change_listener(index->catalog, index);
+    }
+    index->catalog = catalog;
+    index->embed = embed;
+    index->embed_context = context;
+    if (!content_add_change_listener(catalog, hnsw_on_change, index)) {
+        index->catalog = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+void hnsw_embed_metadata(void *context, const Content *content, float *vector) {
+    (void)context;
+    int buckets = HNSW_METADATA_DIMENSION - 2;
+    
+    // Dispersão FNV-1a do nome da categoria
+    unsigned int hash = 2166136261u;
+    for (const char *c = content->category; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    
+    memset(vector, 0, HNSW_METADATA_DIMENSION * sizeof(float));
+    vector[hash % buckets] = 1.0f;
+    vector[buckets] = content->age_rating / 18.0f;
+    vector[buckets + 1] = content->duration / 180.0f;
+}
+
+int hnsw_save(HnswIndex *index, const char *filename) {
+    if (index == NULL || filename == NULL) {
+        return 0;
+    }
+    
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    pthread_rwlock_rdlock(&index->lock);
+    HnswFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HNSW_FILE_MAGIC, sizeof(header.magic));
+    header.dimension = index->dimension;
+    header.m = index->m;
+    header.m0 = index->m0;
+    header.ef_construction = index->ef_construction;
+    header.count = index->count;
+    header.deleted_count = index->deleted_count;
+    header.upper_count = index->upper_count;
+    header.id_slots = index->id_slots;
+    header.entry_point = index->entry_point;
+    header.max_level = index->max_level;
+    header.seed = index->seed;
+    
+    size_t count = (size_t)index->count;
+    int success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(index->vectors, sizeof(float), count * index->dimension, file) == count * index->dimension &&
+        fwrite(index->ids, sizeof(int), count, file) == count &&
+        fwrite(index->levels, sizeof(int), count, file) == count &&
+        fwrite(index->links0, sizeof(int), count * (index->m0 + 1), file) == count * (index->m0 + 1) &&
+        fwrite(index->upper_offsets, sizeof(int), count, file) == count &&
+        fwrite(index->upper_links, sizeof(int), index->upper_count, file) == (size_t)index->upper_count &&
+        fwrite(index->node_of_id, sizeof(int), index->id_slots, file) == (size_t)index->id_slots &&
+        fwrite(index->deleted, 1, count, file) == count;
+    pthread_rwlock_unlock(&index->lock);
+    
+    if (fclose(file) != 0) {
+        success = 0;
+    }
+    return success;
+}
+
+int hnsw_open_mapped(HnswIndex *index, const char *filename) {
+    if (index == NULL || filename == NULL) {
+        return 0;
+    }
+    
+    size_t size = 0;
+    char *address = (char*)mapfile_open(filename, &size);
+    if (address == NULL) {
+        return 0;
+    }
+    
+    // O ficheiro tem de vir de hnsw_save: valida-se o cabeçalho e o tamanho de cada array
+    HnswFileHeader header;
+    size_t expected = 0;
+    if (size >= sizeof(header)) {
+        memcpy(&header, address, sizeof(header));
+        if (memcmp(header.magic, HNSW_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.dimension > 0 && header.dimension <= HNSW_MAX_DIMENSION &&
+            header.m >= 2 && header.m <= HNSW_MAX_M && header.m0 == 2 * header.m &&
+            header.count >= 0 && header.upper_count >= 0 && header.id_slots >= 0 &&
+            header.entry_point >= -1 && header.entry_point < header.count &&
+            header.max_level >= 0 && header.max_level <= HNSW_MAX_LEVEL) {
+            size_t count = (size_t)header.count;
+            expected = sizeof(header) + count * header.dimension * sizeof(float) +
+                       count * (3 + header.m0 + 1) * sizeof(int) +
+                       ((size_t)header.upper_count + header.id_slots) * sizeof(int) + count;
+        }
+    }
+    if (expected == 0 || expected != size) {
+        mapfile_close(address, size);
+        return 0;
+    }
+    
+    pthread_rwlock_wrlock(&index->lock);
+    hnsw_reset(index);
+    size_t count = (size_t)header.count;
+    char *cursor = address + sizeof(header);
+    index->dimension = header.dimension;
+    index->m = header.m;
+    index->m0 = header.m0;
+    index->ef_construction = header.ef_construction;
+    index->vectors = (float*)cursor;
+    cursor += count * header.dimension * sizeof(float);
+    index->ids = (int*)cursor;
+    cursor += count * sizeof(int);
+    index->levels = (int*)cursor;
+    cursor += count * sizeof(int);
+    index->links0 = (int*)cursor;
+    cursor += count * (header.m0 + 1) * sizeof(int);
+    index->upper_offsets = (int*)cursor;
+    cursor += count * sizeof(int);
+    index->upper_links = (int*)cursor;
+    cursor += (size_t)header.upper_count * sizeof(int);
+    index->node_of_id = (int*)cursor;
+    cursor += (size_t)header.id_slots * sizeof(int);
+    index->deleted = (unsigned char*)cursor;
+    
+    index->count = header.count;
+    index->capacity = header.count;
+    index->deleted_count = header.deleted_count;
+    index->upper_count = header.upper_count;
+    index->upper_capacity = header.upper_count;
+    index->id_slots = header.id_slots;
+    index->entry_point = header.entry_point;
+    index->max_level = header.max_level;
+    index->seed = header.seed;
+    index->mapping = address;
+    index->mapping_size = size;
+    pthread_rwlock_unlock(&index->lock);
+    return 1;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file hnsw.h
+ * @brief Módulo de índice aproximado de vizinhos mais próximos (HNSW)
+ * 
+ * Guarda vetores densos de conteúdos (fatores ALS, metadados, ...) num
+ * grafo hierárquico navegável (Hierarchical Navigable Small World): cada
+ * nó tem um nível aleatório e ligações aos vizinhos mais próximos em cada
+ * nível até ao seu, e uma pesquisa desce do nível de topo ao nível 0
+ * visitando apenas uma pequena parte dos nós. A semelhança é o cosseno
+ * (os vetores são normalizados na inserção). O índice pode observar o
+ * catálogo, inserindo os conteúdos adicionados ou editados e marcando os
+ * removidos, e pode ser gravado num ficheiro e aberto com mapeamento em
+ * memória, sem o reconstruir.
+ */
+
+#ifndef HNSW_H
+#define HNSW_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "content.h"
+
+#define HNSW_DEFAULT_M 16
+#define HNSW_DEFAULT_EF_CONSTRUCTION 100
+#define HNSW_DEFAULT_EF_SEARCH 64
+#define HNSW_MAX_M 64
+#define HNSW_MAX_LEVEL 16
+#define HNSW_MAX_DIMENSION 256
+#define HNSW_METADATA_DIMENSION 16
+
+/**
+ * @brief Função que calcula o vetor de um conteúdo
+ * 
+ * @param context Dados registados com hnsw_attach
+ * @param content Conteúdo
+ * @param vector Recebe dimension floats
+ */
+typedef void (*HnswEmbedFunc)(void *context, const Content *content, float *vector);
+
+/**
+ * @brief Índice HNSW
+ * 
+ * Os nós são numerados pela ordem de inserção. A lista de ligações de um
+ * nó num nível começa pelo número de ligações, seguido dos nós ligados:
+ * links0 guarda o nível 0 (m0 + 1 inteiros por nó) e upper_links os níveis
+ * acima (m + 1 inteiros por nível, a partir de upper_offsets[nó]).
+ */
+typedef struct {
+    int dimension;              /**< Dimensão dos vetores */
+    int m;                      /**< Ligações por nó nos níveis acima de 0 */
+    int m0;                     /**< Ligações por nó no nível 0 (2 * m) */
+    int ef_construction;        /**< Candidatos examinados em cada inserção */
+    int count;                  /**< Número de nós (incluindo os marcados como removidos) */
+    int capacity;               /**< Nós reservados */
+    int deleted_count;          /**< Nós marcados como removidos */
+    float *vectors;             /**< Vetor normalizado de cada nó (dimension floats) */
+    int *ids;                   /**< ID do conteúdo de cada nó */
+    int *levels;                /**< Nível de topo de cada nó */
+    unsigned char *deleted;     /**< 1 se o nó foi removido (continua a servir de passagem) */
+    int *links0;                /**< Ligações no nível 0 */
+    int *upper_offsets;         /**< Início das ligações dos níveis acima de 0 (-1 se não houver) */
+    int *upper_links;           /**< Ligações dos níveis acima de 0 */
+    int upper_count;            /**< Inteiros usados em upper_links */
+    int upper_capacity;         /**< Inteiros reservados em upper_links */
+    int *node_of_id;            /**< Nó atual de cada ID de conteúdo (-1 se não houver) */
+    int id_slots;               /**< IDs suportados por node_of_id (0 a id_slots - 1) */
+    int entry_point;            /**< Nó de entrada das pesquisas (-1 se vazio) */
+    int max_level;              /**< Nível do nó de entrada */
+    unsigned int seed;          /**< Estado do gerador dos níveis */
+    void *mapping;              /**< Ficheiro mapeado em memória (NULL se os arrays estão no heap) */
+    size_t mapping_size;        /**< Tamanho do mapeamento */
+    ContentCatalog *catalog;    /**< Catálogo observado (NULL se nenhum) */
+    HnswEmbedFunc embed;        /**< Vetor dos conteúdos do catálogo observado */
+    void *embed_context;        /**< Dados passados a embed */
+    pthread_rwlock_t lock;      /**< Inserções e remoções exclusivas das pesquisas */
+} HnswIndex;
+
+/**
+ * @brief Inicializa um índice vazio
+ * 
+ * @param index Ponteiro para o índice
+ * @param dimension Dimensão dos vetores (1 a HNSW_MAX_DIMENSION)
+ * @param m Ligações por nó (2 a HNSW_MAX_M); o nível 0 usa 2 * m
+ * @param ef_construction Candidatos examinados em cada inserção (>= m)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int hnsw_init(HnswIndex *index, int dimension, int m, int ef_construction);
+
+/**
+ * @brief Liberta a memória (ou o mapeamento) do índice e deixa de observar o catálogo
+ * 
+ * @param index Ponteiro para o índice
+ */
+void hnsw_free(HnswIndex *index);
+
+/**
+ * @brief Constrói o índice a partir de uma matriz de vetores, substituindo os nós atuais
+ * 
+ * @param index Ponteiro para o índice
+ * @param vectors Primeira linha da matriz (dimension floats por linha)
+ * @param stride Distância, em floats, entre linhas consecutivas (>= dimension)
+ * @param ids ID do conteúdo de cada linha
+ * @param count Número de linhas
+ * @return int 1 se a construção foi bem-sucedida, 0 caso contrário
+ */
+int hnsw_build(HnswIndex *index, const float *vectors, int stride, const int *ids, int count);
+
+/**
+ * @brief Insere (ou substitui) o vetor de um conteúdo
+ * 
+ * Se o ID já estiver no índice, o nó anterior é marcado como removido.
+ * 
+ * @param index Ponteiro para o índice
+ * @param id ID do conteúdo (> 0)
+ * @param vector Vetor de dimension floats
+ * @return int 1 se a inserção foi bem-sucedida, 0 caso contrário
+ */
+int hnsw_insert(HnswIndex *index, int id, const float *vector);
+
+/**
+ * @brief Marca o nó de um conteúdo como removido
+ * 
+ * O nó deixa de aparecer nos resultados mas continua no grafo como passagem.
+ * 
+ * @param index Ponteiro para o índice
+ * @param id ID do conteúdo
+ * @return int 1 se o conteúdo estava no índice, 0 caso contrário
+ */
+int hnsw_remove(HnswIndex *index, int id);
+
+/**
+ * @brief Procura os conteúdos mais semelhantes a um vetor
+ * 
+ * Pode ser chamada por várias threads em simultâneo.
+ * 
+ * @param index Ponteiro para o índice
+ * @param query Vetor de dimension floats (não precisa de estar normalizado)
+ * @param k Número de resultados pretendidos
+ * @param ef Candidatos examinados no nível 0 (maior = mais exato e mais lento; é pelo menos k)
+ * @param ids Recebe os IDs, por semelhança decrescente
+ * @param scores Recebe o cosseno de cada resultado (pode ser NULL)
+ * @return int Número de resultados, ou -1 em caso de erro
+ */
+int hnsw_search(HnswIndex *index, const float *query, int k, int ef, int *ids, float *scores);
+
+/**
+ * @brief Passa a manter o índice atualizado com as alterações do catálogo
+ * 
+ * Os conteúdos adicionados ou editados são inseridos com o vetor dado por
+ * embed e os removidos são marcados. Os conteúdos já existentes não são
+ * inseridos (ver hnsw_build).
+ * 
+ * @param index Ponteiro para o índice
+ * @param catalog Catálogo a observar
+ * @param embed Função que calcula o vetor de um conteúdo
+ * @param context Dados passados a embed
+ * @return int 1 se o registo foi bem-sucedido, 0 caso contrário
+ */
+int hnsw_attach(HnswIndex *index, ContentCatalog *catalog, HnswEmbedFunc embed, void *context);
+
+/**
+ * @brief Vetor de metadados de um conteúdo (HNSW_METADATA_DIMENSION floats)
+ * 
+ * A categoria ocupa uma de HNSW_METADATA_DIMENSION - 2 posições (por
+ * dispersão do nome) e as duas últimas são a classificação etária e a
+ * duração normalizadas.
+ * 
+ * @param context Não usado
+ * @param content Conteúdo
+ * @param vector Recebe HNSW_METADATA_DIMENSION floats
+ */
+void hnsw_embed_metadata(void *context, const Content *content, float *vector);
+
+/**
+ * @brief Grava o índice num ficheiro binário
+ * 
+ * @param index Ponteiro para o índice
+ * @param filename Nome do ficheiro
+ * @return int 1 se a gravação foi bem-sucedida, 0 caso contrário
+ */
+int hnsw_save(HnswIndex *index, const char *filename);
+
+/**
+ * @brief Abre um índice gravado com hnsw_save, mapeando o ficheiro em memória
+ * 
+ * O índice é usado diretamente a partir do mapeamento; a primeira inserção
+ * ou remoção copia-o para o heap. O índice anterior é libertado só se a
+ * abertura for bem-sucedida.
+ * 
+ * @param index Ponteiro para um índice inicializado
+ * @param filename Nome do ficheiro
+ * @return int 1 se a abertura foi bem-sucedida, 0 caso contrário
+ */
+int hnsw_open_mapped(HnswIndex *index, const char *filename);
+
+#endif /* HNSW_H */
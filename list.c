@@ -5,6 +5,7 @@
 
 #include "list.h"
 #include "csvutil.h"
+#include "arena.h"
 
 int list_init_manager(ListManager *manager, int initial_capacity) {
     if (manager == NULL || initial_capacity <= 0) {
@@ -105,13 +106,18 @@ int list_save_to_csv(ListManager *manager, const char *filename) {
     // Escrever cabeçalho
     fprintf(file, "ID,ID_Utilizador,Nome,Conteudos\n");
     
+    Arena *scratch = arena_scratch();
+    
     // Escrever dados
     for (int i = 0; i < manager->count; i++) {
         CustomList *list = &manager->lists[i];
         
         // Calcular o número de campos total (ID + user_id + nome + conteúdos)
         int field_count = 3 + list->count;
-        char **fields = (char**)malloc(field_count * sizeof(char*));
+        
+        // Campos da linha na arena de rascunho, descartados no fim da linha
+        ArenaMark mark = arena_mark(scratch);
+        char **fields = (char**)arena_alloc(scratch, field_count * sizeof(char*));
         
         if (fields == NULL) {
             fclose(file);
@@ -127,37 +133,17 @@ int list_save_to_csv(ListManager *manager, const char *filename) {
         fields[2] = list->name;
         
         // Adicionar os IDs dos conteúdos
-        char **content_strs = (char**)malloc(list->count * sizeof(char*));
-        if (content_strs == NULL) {
-            free(fields);
-            fclose(file);
-            return 0;
-        }
-        
         for (int j = 0; j < list->count; j++) {
-            content_strs[j] = (char*)malloc(20 * sizeof(char));
-            if (content_strs[j] == NULL) {
-                for (int k = 0; k < j; k++) {
-                    free(content_strs[k]);
-                }
-                free(content_strs);
-                free(fields);
+            fields[3 + j] = arena_printf(scratch, "%d", list->content_ids[j]);
+            if (fields[3 + j] == NULL) {
+                arena_reset_to(scratch, mark);
                 fclose(file);
                 return 0;
             }
-            
-            sprintf(content_strs[j], "%d", list->content_ids[j]);
-            fields[3 + j] = content_strs[j];
         }
         
         csv_write_line(file, fields, field_count);
-        
-        // Liberar memória
-        for (int j = 0; j < list->count; j++) {
-            free(content_strs[j]);
-        }
-        free(content_strs);
-        free(fields);
+        arena_reset_to(scratch, mark);
     }
     
     fclose(file);
@@ -17,12 +17,42 @@
 #include "list.h"
 #include "recommendation.h"
 #include "report.h"
+#include "threadpool.h"
+#include "arena.h"
 
 // Arquivo padrão de dados
 #define CONTENT_FILE "contents.csv"
 #define USER_FILE "users.csv"
 #define INTERACTION_FILE "interactions.csv"
 #define LIST_FILE "lists.csv"
+#define AGGREGATE_FILE "interaction_aggregates.csv"
+
+// Opção de arranque que ativa a retenção das interações em bruto (--retencao-dias=N; por omissão
+// guarda-se todo o histórico). As interações mais antigas passam a agregados, que só os relatórios
+// somam; os recomendadores veem apenas o histórico em bruto que fica
+#define RETENTION_DAYS_OPTION "--retencao-dias="
+#define RETENTION_ROWS_PER_TICK 10000
+
+// Listas de vizinhos recalculadas a cada ciclo do menu, depois de alterações ao catálogo
+#define NEIGHBOR_REPAIRS_PER_TICK 64
+
+// Janela (segundos) para descartar eventos repetidos na ingestão
+#define INGEST_DEDUP_WINDOW 1
+
+// Opção de arranque para ordenar as interações por utilizador (--ordenar-interacoes[=threads])
+#define SORT_INTERACTIONS_OPTION "--ordenar-interacoes"
+#define SORT_INTERACTIONS_DEFAULT_THREADS 4
+
+// Opção de arranque para o número de threads de trabalho (--threads=N, 1 = em série)
+#define THREADS_OPTION "--threads="
+
+// Opção de arranque que grava as recomendações de todos os utilizadores e sai sem abrir o menu
+// (--recomendacoes-lote=FICHEIRO; em CSV se o nome terminar em .csv, senão em binário)
+#define BATCH_RECOMMENDATIONS_OPTION "--recomendacoes-lote="
+
+// Opção de arranque que serve as recomendações personalizadas a partir de um ficheiro binário
+// gerado pelo modo em lote (--recomendacoes-tabela=FICHEIRO)
+#define RECOMMENDATION_TABLE_OPTION "--recomendacoes-tabela="
 
 // Capacidades iniciais dos gerenciadores
 #define INITIAL_CONTENT_CAPACITY 100
@@ -51,9 +81,38 @@ void save_data(ContentCatalog *content_catalog, UserManager *user_manager, ListM
 /**
  * @brief Função principal do programa
  * 
+ * @param argc Número de argumentos
+ * @param argv Argumentos da linha de comandos
  * @return int Código de saída
  */
-int main() {
+int main(int argc, char *argv[]) {
+    // Processar opções de arranque
+    int sort_threads = 0;
+    int worker_threads = THREADPOOL_DEFAULT_WORKERS;
+    const char *batch_file = NULL;
+    const char *table_file = NULL;
+    int retention_days = 0;
+    size_t option_length = strlen(SORT_INTERACTIONS_OPTION);
+    
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], THREADS_OPTION, strlen(THREADS_OPTION)) == 0) {
+            worker_threads = atoi(argv[i] + strlen(THREADS_OPTION));
+        } else if (strncmp(argv[i], BATCH_RECOMMENDATIONS_OPTION, strlen(BATCH_RECOMMENDATIONS_OPTION)) == 0) {
+            batch_file = argv[i] + strlen(BATCH_RECOMMENDATIONS_OPTION);
+        } else if (strncmp(argv[i], RECOMMENDATION_TABLE_OPTION, strlen(RECOMMENDATION_TABLE_OPTION)) == 0) {
+            table_file = argv[i] + strlen(RECOMMENDATION_TABLE_OPTION);
+        } else if (strncmp(argv[i], RETENTION_DAYS_OPTION, strlen(RETENTION_DAYS_OPTION)) == 0) {
+            retention_days = atoi(argv[i] + strlen(RETENTION_DAYS_OPTION));
+        } else if (strncmp(argv[i], SORT_INTERACTIONS_OPTION, option_length) == 0) {
+            sort_threads = SORT_INTERACTIONS_DEFAULT_THREADS;
+            if (argv[i][option_length] == '=') {
+                sort_threads = atoi(argv[i] + option_length + 1);
+            }
+        } else {
+            printf("Opcao desconhecida: %s\n", argv[i]);
+        }
+    }
+    
     // Inicializar seed para geração de números aleatórios
     srand((unsigned int)time(NULL));
     
@@ -81,6 +140,15 @@ int main() {
         return 1;
     }
     
+    // Conjunto de threads partilhado por carregamento, relatórios e recomendações
+    ThreadPool thread_pool;
+    int pool_ready = worker_threads > 1 && threadpool_init(&thread_pool, worker_threads);
+    if (pool_ready) {
+        threadpool_set_default(&thread_pool);
+    } else if (worker_threads > 1) {
+        printf("Aviso: Nao foi possivel criar as threads de trabalho. A executar em serie.\n");
+    }
+    
     // Carregar dados dos arquivos CSV
     printf("Carregando dados...\n");
     
@@ -91,6 +159,16 @@ int main() {
         printf("Aviso: Nao foi possivel carregar o arquivo de conteudos. Um novo sera criado.\n");
     }
     
+    // Listas de conteúdos semelhantes, mantidas em dia a cada alteração do catálogo
+    NeighborTable neighbor_table;
+    int neighbors_ready = neighbors_init(&neighbor_table, NEIGHBORS_DEFAULT_COUNT) && 
+                          neighbors_build(&neighbor_table, &content_catalog, threadpool_get_default());
+    if (neighbors_ready) {
+        recommendation_set_neighbors(&neighbor_table);
+    } else {
+        printf("Aviso: Nao foi possivel pre-calcular os conteudos semelhantes.\n");
+    }
+    
     int user_count = user_load_from_csv(&user_manager, USER_FILE);
     if (user_count >= 0) {
         printf("%d utilizadores carregados.\n", user_count);
@@ -98,6 +176,14 @@ int main() {
         printf("Aviso: Nao foi possivel carregar o arquivo de utilizadores. Um novo sera criado.\n");
     }
     
+    user_set_retention(&user_manager, retention_days);
+    user_set_dedup_window(&user_manager, INGEST_DEDUP_WINDOW);
+    
+    int aggregate_count = user_load_aggregates_from_csv(&user_manager, AGGREGATE_FILE);
+    if (aggregate_count > 0) {
+        printf("%d agregados de interacoes antigas carregados.\n", aggregate_count);
+    }
+    
     int interaction_count = user_load_interactions_from_csv(&user_manager, INTERACTION_FILE);
     if (interaction_count >= 0) {
         printf("%d interacoes carregadas.\n", interaction_count);
@@ -105,6 +191,35 @@ int main() {
         printf("Aviso: Nao foi possivel carregar o arquivo de interacoes. Um novo sera criado.\n");
     }
     
+    if (sort_threads > 0) {
+        if (user_sort_interactions(&user_manager, sort_threads)) {
+            printf("Interacoes ordenadas por utilizador.\n");
+        } else {
+            printf("Aviso: Nao foi possivel ordenar as interacoes.\n");
+        }
+    }
+    
+    // Vizinhos colaborativos a partir das interações carregadas
+    CollabModel collab_model;
+    int collab_ready = collab_init(&collab_model, COLLAB_DEFAULT_NEIGHBORS) && 
+                       collab_build(&collab_model, &user_manager, &content_catalog, threadpool_get_default());
+    if (collab_ready) {
+        recommendation_set_collab(&collab_model);
+    } else {
+        printf("Aviso: Nao foi possivel construir o modelo de filtragem colaborativa.\n");
+    }
+    
+    // Recomendações pré-calculadas; os utilizadores fora da tabela ou com novas interações são calculados
+    RecommendationTable recommendation_table;
+    int table_ready = table_file != NULL && 
+                      recommendation_table_open(&recommendation_table, table_file, &user_manager, &content_catalog);
+    if (table_ready) {
+        recommendation_set_table(&recommendation_table);
+        printf("Recomendacoes pre-calculadas de %d utilizadores abertas.\n", recommendation_table.user_count);
+    } else if (table_file != NULL) {
+        printf("Aviso: Nao foi possivel abrir as recomendacoes pre-calculadas em %s.\n", table_file);
+    }
+    
     int list_count = list_load_from_csv(&list_manager, LIST_FILE);
     if (list_count >= 0) {
         printf("%d listas carregadas.\n", list_count);
@@ -112,13 +227,43 @@ int main() {
         printf("Aviso: Nao foi possivel carregar o arquivo de listas. Um novo sera criado.\n");
     }
     
-    pause_screen();
+    // Modo em lote: gravar as recomendações de todos os utilizadores e sair
+    int running = 1;
+    int exit_code = 0;
+    if (batch_file != NULL && batch_file[0] != '\0') {
+        size_t name_length = strlen(batch_file);
+        RecommendationBatchFormat format = name_length >= 4 && strcmp(batch_file + name_length - 4, ".csv") == 0 ?
+                                           RECOMMENDATION_BATCH_CSV : RECOMMENDATION_BATCH_BINARY;
+        time_t start = time(NULL);
+        int written = recommendation_batch_all(&user_manager, &content_catalog, MAX_RECOMMENDATIONS, 
+                                               batch_file, format, threadpool_get_default());
+        if (written >= 0) {
+            printf("Recomendacoes de %d utilizadores gravadas em %s (%ld s).\n", 
+                   written, batch_file, (long)(time(NULL) - start));
+        } else {
+            printf("Erro ao gravar as recomendacoes em %s.\n", batch_file);
+            exit_code = 1;
+        }
+        running = 0;
+    } else {
+        pause_screen();
+    }
     
     // Loop principal do programa
     int option;
-    int running = 1;
     
     while (running) {
+        // Compactar uma fatia limitada das interações antigas a cada ciclo (se a retenção estiver ativa)
+        user_compact_interactions(&user_manager, time(NULL), RETENTION_ROWS_PER_TICK);
+        
+        // Consolidar as visualizações pendentes de cada thread em Content.views
+        content_fold_views(&content_catalog);
+        
+        // Recalcular fora do observador do catálogo as listas de vizinhos que ficaram marcadas
+        if (neighbors_ready) {
+            neighbors_repair(&neighbor_table, threadpool_get_default(), NEIGHBOR_REPAIRS_PER_TICK);
+        }
+        
         clear_screen();
         show_main_menu();
         option = get_user_choice();
@@ -134,6 +279,12 @@ int main() {
                 list_management_menu(&list_manager, &user_manager, &content_catalog);
                 break;
             case 4:
+                // Incluir as interações registadas desde a última construção
+                if (collab_ready) {
+                    collab_ready = collab_build(&collab_model, &user_manager, &content_catalog, 
+                                                threadpool_get_default());
+                    recommendation_set_collab(collab_ready ? &collab_model : NULL);
+                }
                 recommendation_menu(&user_manager, &content_catalog);
                 break;
             case 5:
@@ -156,11 +307,23 @@ int main() {
     }
     
     // Liberar memória
+    recommendation_set_table(NULL);
+    if (table_ready) {
+        recommendation_table_free(&recommendation_table);
+    }
+    recommendation_set_neighbors(NULL);
+    neighbors_free(&neighbor_table);
+    recommendation_set_collab(NULL);
+    collab_free(&collab_model);
     content_free_catalog(&content_catalog);
     user_free_manager(&user_manager);
     list_free_manager(&list_manager);
+    if (pool_ready) {
+        threadpool_free(&thread_pool);
+    }
+    arena_scratch_free();
     
-    return 0;
+    return exit_code;
 }
 
 void show_main_menu() {
@@ -211,7 +374,8 @@ void content_management_menu(ContentCatalog *catalog) {
                     Content *content = &catalog->items[i];
                     printf("[ID: %d] %s\n", content->id, content->title);
                     printf("  Categoria: %s | Duracao: %d min | Classificacao: %d | Visualizacoes: %d\n", 
-                           content->category, content->duration, content->age_rating, content->views);
+                           content->category, content->duration, content->age_rating, 
+                           content_get_views(catalog, content));
                     printf("----------------------------------------\n");
                 }
                 
@@ -266,7 +430,7 @@ void content_management_menu(ContentCatalog *catalog) {
                 scanf("%d", &id);
                 getchar(); // Consumir quebra de linha
                 
-                Content *content = content_get_by_id(catalog, id);
+                const Content *content = content_get_by_id(catalog, id);
                 if (content == NULL) {
                     printf("Conteudo nao encontrado.\n");
                     pause_screen();
@@ -323,7 +487,7 @@ void content_management_menu(ContentCatalog *catalog) {
                 scanf("%d", &id);
                 getchar(); // Consumir quebra de linha
                 
-                Content *content = content_get_by_id(catalog, id);
+                const Content *content = content_get_by_id(catalog, id);
                 if (content == NULL) {
                     printf("Conteudo nao encontrado.\n");
                     pause_screen();
@@ -368,7 +532,7 @@ void content_management_menu(ContentCatalog *catalog) {
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < count; i++) {
-                    Content *content = content_get_by_id(catalog, results[i]);
+                    const Content *content = content_get_by_id(catalog, results[i]);
                     printf("[ID: %d] %s\n", content->id, content->title);
                     printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
                            content->category, content->duration, content->age_rating);
@@ -396,7 +560,7 @@ void content_management_menu(ContentCatalog *catalog) {
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < count; i++) {
-                    Content *content = content_get_by_id(catalog, results[i]);
+                    const Content *content = content_get_by_id(catalog, results[i]);
                     printf("[ID: %d] %s\n", content->id, content->title);
                     printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
                            content->category, content->duration, content->age_rating);
@@ -424,7 +588,7 @@ void content_management_menu(ContentCatalog *catalog) {
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < count; i++) {
-                    Content *content = content_get_by_id(catalog, results[i]);
+                    const Content *content = content_get_by_id(catalog, results[i]);
                     printf("[ID: %d] %s\n", content->id, content->title);
                     printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
                            content->category, content->duration, content->age_rating);
@@ -595,15 +759,13 @@ void user_management_menu(UserManager *user_manager, ContentCatalog *content_cat
                         break;
                 }
                 
-                int result = user_register_interaction(user_manager, user_id, content_id, type);
+                int result = user_ingest_interaction(user_manager, content_catalog, 
+                                                     user_id, content_id, type);
                 
-                if (result) {
+                if (result == 2) {
+                    printf("Interacao repetida ignorada.\n");
+                } else if (result) {
                     printf("Interacao registrada com sucesso!\n");
-                    
-                    // Incrementar visualizações se for do tipo PLAY ou COMPLETE
-                    if (type == INTERACTION_PLAY || type == INTERACTION_COMPLETE) {
-                        content_increment_views(content_catalog, content_id);
-                    }
                 } else {
                     printf("Erro ao registrar a interacao.\n");
                 }
@@ -629,11 +791,14 @@ void user_management_menu(UserManager *user_manager, ContentCatalog *content_cat
                     break;
                 }
                 
-                printf("Favoritos de %s (%d):\n", user->username, user->favorite_count);
+                int favorite_count;
+                const int *favorites = user_get_favorites(user, &favorite_count);
+                
+                printf("Favoritos de %s (%d):\n", user->username, favorite_count);
                 printf("----------------------------------------\n");
                 
-                for (int i = 0; i < user->favorite_count; i++) {
-                    Content *content = content_get_by_id(content_catalog, user->favorite_contents[i]);
+                for (int i = 0; i < favorite_count; i++) {
+                    const Content *content = content_get_by_id(content_catalog, favorites[i]);
                     if (content != NULL) {
                         printf("[%d] %s\n", content->id, content->title);
                         printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
@@ -703,9 +868,12 @@ void user_management_menu(UserManager *user_manager, ContentCatalog *content_cat
                     break;
                 }
                 
+                int favorite_count;
+                const int *favorites = user_get_favorites(user, &favorite_count);
+                
                 printf("Favoritos atuais:\n");
-                for (int i = 0; i < user->favorite_count; i++) {
-                    Content *content = content_get_by_id(content_catalog, user->favorite_contents[i]);
+                for (int i = 0; i < favorite_count; i++) {
+                    const Content *content = content_get_by_id(content_catalog, favorites[i]);
                     if (content != NULL) {
                         printf("[%d] %s\n", content->id, content->title);
                     }
@@ -986,7 +1154,7 @@ void list_management_menu(ListManager *list_manager, UserManager *user_manager,
                 
                 printf("Conteudos da lista '%s':\n", list->name);
                 for (int i = 0; i < list->count; i++) {
-                    Content *content = content_get_by_id(content_catalog, list->content_ids[i]);
+                    const Content *content = content_get_by_id(content_catalog, list->content_ids[i]);
                     if (content != NULL) {
                         printf("[%d] %s\n", content->id, content->title);
                     }
@@ -1033,7 +1201,7 @@ void list_management_menu(ListManager *list_manager, UserManager *user_manager,
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < list->count; i++) {
-                    Content *content = content_get_by_id(content_catalog, list->content_ids[i]);
+                    const Content *content = content_get_by_id(content_catalog, list->content_ids[i]);
                     if (content != NULL) {
                         printf("[ID: %d] %s\n", content->id, content->title);
                         printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
@@ -1102,7 +1270,7 @@ void recommendation_menu(UserManager *user_manager, ContentCatalog *content_cata
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < count; i++) {
-                    Content *content = content_get_by_id(content_catalog, recommendations[i]);
+                    const Content *content = content_get_by_id(content_catalog, recommendations[i]);
                     if (content != NULL) {
                         printf("[ID: %d] %s\n", content->id, content->title);
                         printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
@@ -1140,7 +1308,7 @@ void recommendation_menu(UserManager *user_manager, ContentCatalog *content_cata
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < count; i++) {
-                    Content *content = content_get_by_id(content_catalog, recommendations[i]);
+                    const Content *content = content_get_by_id(content_catalog, recommendations[i]);
                     if (content != NULL) {
                         printf("[ID: %d] %s\n", content->id, content->title);
                         printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
@@ -1166,11 +1334,12 @@ void recommendation_menu(UserManager *user_manager, ContentCatalog *content_cata
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < count; i++) {
-                    Content *content = content_get_by_id(content_catalog, recommendations[i]);
+                    const Content *content = content_get_by_id(content_catalog, recommendations[i]);
                     if (content != NULL) {
                         printf("[ID: %d] %s\n", content->id, content->title);
                         printf("  Categoria: %s | Duracao: %d min | Classificacao: %d | Visualizacoes: %d\n", 
-                               content->category, content->duration, content->age_rating, content->views);
+                               content->category, content->duration, content->age_rating, 
+                               content_get_views(content_catalog, content));
                         printf("----------------------------------------\n");
                     }
                 }
@@ -1204,7 +1373,7 @@ void recommendation_menu(UserManager *user_manager, ContentCatalog *content_cata
                 printf("----------------------------------------\n");
                 
                 for (int i = 0; i < count; i++) {
-                    Content *content = content_get_by_id(content_catalog, recommendations[i]);
+                    const Content *content = content_get_by_id(content_catalog, recommendations[i]);
                     if (content != NULL) {
                         printf("[ID: %d] %s\n", content->id, content->title);
                         printf("  Categoria: %s | Duracao: %d min | Classificacao: %d\n", 
@@ -1363,6 +1532,10 @@ void report_menu(UserManager *user_manager, ContentCatalog *content_catalog, Lis
                 
                 int result = 0;
                 
+                // Tabela de exportação na arena de rascunho, descartada de uma vez no fim
+                Arena *scratch = arena_scratch();
+                ArenaMark mark = arena_mark(scratch);
+                
                 switch (report_type) {
                     case 1: {
                         // Conteúdos mais assistidos
@@ -1372,30 +1545,20 @@ void report_menu(UserManager *user_manager, ContentCatalog *content_catalog, Lis
                         // Preparar os dados para exportação
                         char *headers[3] = {"ID", "Título", "Visualizações"};
                         
-                        char ***data = (char***)malloc(count * sizeof(char**));
-                        for (int i = 0; i < count; i++) {
-                            data[i] = (char**)malloc(3 * sizeof(char*));
-                            
-                            data[i][0] = (char*)malloc(20 * sizeof(char));
-                            sprintf(data[i][0], "%d", results[i].content_id);
-                            
-                            data[i][1] = (char*)malloc(MAX_TITLE_LENGTH * sizeof(char));
-                            strcpy(data[i][1], results[i].title);
+                        char ***data = (char***)arena_alloc(scratch, count * sizeof(char**));
+                        for (int i = 0; data != NULL && i < count; i++) {
+                            data[i] = (char**)arena_alloc(scratch, 3 * sizeof(char*));
+                            if (data[i] == NULL) {
+                                data = NULL;
+                                break;
+                            }
                             
-                            data[i][2] = (char*)malloc(20 * sizeof(char));
-                            sprintf(data[i][2], "%d", results[i].count);
+                            data[i][0] = arena_printf(scratch, "%d", results[i].content_id);
+                            data[i][1] = arena_strdup(scratch, results[i].title);
+                            data[i][2] = arena_printf(scratch, "%d", results[i].count);
                         }
                         
-                        result = report_export_to_csv(filename, headers, 3, data, count);
-                        
-                        // Liberar memória
-                        for (int i = 0; i < count; i++) {
-                            for (int j = 0; j < 3; j++) {
-                                free(data[i][j]);
-                            }
-                            free(data[i]);
-                        }
-                        free(data);
+                        result = data != NULL && report_export_to_csv(filename, headers, 3, data, count);
                         
                         break;
                     }
@@ -1407,27 +1570,19 @@ void report_menu(UserManager *user_manager, ContentCatalog *content_catalog, Lis
                         // Preparar os dados para exportação
                         char *headers[2] = {"Categoria", "Visualizações"};
                         
-                        char ***data = (char***)malloc(count * sizeof(char**));
-                        for (int i = 0; i < count; i++) {
-                            data[i] = (char**)malloc(2 * sizeof(char*));
-                            
-                            data[i][0] = (char*)malloc(MAX_CATEGORY_LENGTH * sizeof(char));
-                            strcpy(data[i][0], results[i].category);
+                        char ***data = (char***)arena_alloc(scratch, count * sizeof(char**));
+                        for (int i = 0; data != NULL && i < count; i++) {
+                            data[i] = (char**)arena_alloc(scratch, 2 * sizeof(char*));
+                            if (data[i] == NULL) {
+                                data = NULL;
+                                break;
+                            }
                             
-                            data[i][1] = (char*)malloc(20 * sizeof(char));
-                            sprintf(data[i][1], "%d", results[i].count);
+                            data[i][0] = arena_strdup(scratch, results[i].category);
+                            data[i][1] = arena_printf(scratch, "%d", results[i].count);
                         }
                         
-                        result = report_export_to_csv(filename, headers, 2, data, count);
-                        
-                        // Libertar memória
-                        for (int i = 0; i < count; i++) {
-                            for (int j = 0; j < 2; j++) {
-                                free(data[i][j]);
-                            }
-                            free(data[i]);
-                        }
-                        free(data);
+                        result = data != NULL && report_export_to_csv(filename, headers, 2, data, count);
                         
                         break;
                     }
@@ -1439,30 +1594,20 @@ void report_menu(UserManager *user_manager, ContentCatalog *content_catalog, Lis
                         // Preparar os dados para exportação
                         char *headers[3] = {"ID", "Nome de Utilizador", "Interacoes"};
                         
-                        char ***data = (char***)malloc(count * sizeof(char**));
-                        for (int i = 0; i < count; i++) {
-                            data[i] = (char**)malloc(3 * sizeof(char*));
-                            
-                            data[i][0] = (char*)malloc(20 * sizeof(char));
-                            sprintf(data[i][0], "%d", results[i].user_id);
-                            
-                            data[i][1] = (char*)malloc(MAX_USERNAME_LENGTH * sizeof(char));
-                            strcpy(data[i][1], results[i].username);
+                        char ***data = (char***)arena_alloc(scratch, count * sizeof(char**));
+                        for (int i = 0; data != NULL && i < count; i++) {
+                            data[i] = (char**)arena_alloc(scratch, 3 * sizeof(char*));
+                            if (data[i] == NULL) {
+                                data = NULL;
+                                break;
+                            }
                             
-                            data[i][2] = (char*)malloc(20 * sizeof(char));
-                            sprintf(data[i][2], "%d", results[i].count);
+                            data[i][0] = arena_printf(scratch, "%d", results[i].user_id);
+                            data[i][1] = arena_strdup(scratch, results[i].username);
+                            data[i][2] = arena_printf(scratch, "%d", results[i].count);
                         }
                         
-                        result = report_export_to_csv(filename, headers, 3, data, count);
-                        
-                        // Libertar memória
-                        for (int i = 0; i < count; i++) {
-                            for (int j = 0; j < 3; j++) {
-                                free(data[i][j]);
-                            }
-                            free(data[i]);
-                        }
-                        free(data);
+                        result = data != NULL && report_export_to_csv(filename, headers, 3, data, count);
                         
                         break;
                     }
@@ -1472,6 +1617,8 @@ void report_menu(UserManager *user_manager, ContentCatalog *content_catalog, Lis
                         break;
                 }
                 
+                arena_reset_to(scratch, mark);
+                
                 if (result) {
                     printf("Relatorio exportado com sucesso para '%s'!\n", filename);
                 } else {
@@ -1518,6 +1665,13 @@ void save_data(ContentCatalog *content_catalog, UserManager *user_manager, ListM
         printf("Erro ao salvar as interacoes.\n");
     }
     
+    int aggregate_result = user_save_aggregates_to_csv(user_manager, AGGREGATE_FILE);
+    if (aggregate_result) {
+        printf("Agregados de interacoes salvos com sucesso em '%s'.\n", AGGREGATE_FILE);
+    } else {
+        printf("Erro ao salvar os agregados de interacoes.\n");
+    }
+    
     int list_result = list_save_to_csv(list_manager, LIST_FILE);
     if (list_result) {
         printf("Listas salvas com sucesso em '%s'.\n", LIST_FILE);
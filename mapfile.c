@@ -0,0 +1,74 @@
+/**
+ * @file mapfile.c
+ * @brief Implementação do módulo de mapeamento de ficheiros em memória
+ */
+
+#include "mapfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+
+void *mapfile_open(const char *filename, size_t *size) {
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    
+    LARGE_INTEGER file_size;
+    void *address = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)file_size.QuadPart;
+    }
+    CloseHandle(file);
+    return address;
+}
+
+void mapfile_close(void *address, size_t size) {
+    (void)size;
+    if (address != NULL) {
+        UnmapViewOfFile(address);
+    }
+}
+
+#else
+
+void *mapfile_open(const char *filename, size_t *size) {
+    int file = open(filename, O_RDONLY);
+    if (file < 0) {
+        return NULL;
+    }
+    
+    struct stat info;
+    void *address = NULL;
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+        address = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (address == MAP_FAILED) {
+            address = NULL;
+        }
+        *size = (size_t)info.st_size;
+    }
+    close(file);
+    return address;
+}
+
+void mapfile_close(void *address, size_t size) {
+    if (address != NULL) {
+        munmap(address, size);
+    }
+}
+
+#endif
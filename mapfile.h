@@ -0,0 +1,30 @@
+/**
+ * @file mapfile.h
+ * @brief Módulo de mapeamento de ficheiros em memória só de leitura
+ * 
+ * Esconde a diferença entre mmap (POSIX) e CreateFileMapping/MapViewOfFile
+ * (_WIN32), para que os índices gravados em disco (HNSW, tabela de
+ * recomendações) possam ser abertos sem copiar o ficheiro para o heap.
+ */
+
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <stddef.h>
+
+/**
+ * @brief Mapeia um ficheiro inteiro em memória, só de leitura
+ * @param filename Caminho do ficheiro
+ * @param size Recebe o tamanho do ficheiro em bytes
+ * @return Endereço do mapeamento, ou NULL se o ficheiro não existir, estiver vazio ou não puder ser mapeado
+ */
+void *mapfile_open(const char *filename, size_t *size);
+
+/**
+ * @brief Liberta um mapeamento obtido com mapfile_open
+ * @param address Endereço devolvido por mapfile_open
+ * @param size Tamanho devolvido por mapfile_open
+ */
+void mapfile_close(void *address, size_t size);
+
+#endif /* MAPFILE_H */
@@ -0,0 +1,690 @@
+/**
+ * @file neighbors.c
+ * @brief Implementação do módulo de listas pré-calculadas de conteúdos semelhantes
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "neighbors.h"
+#include "arena.h"
+#include "topk.h"
+#include "simkernel.h"
+
+// Conteúdos com atributos compactados para a construção em blocos
+typedef struct {
+    NeighborTable *table;
+    const int *ids;             // ID de cada conteúdo
+    const int *categories;      // Categoria interna de cada conteúdo
+    const int *age_ratings;     // Classificação etária de cada conteúdo
+    const int *durations;       // Duração de cada conteúdo
+    int count;                  // Número de conteúdos
+} NeighborBuild;
+
+// Conteúdo alterado cujas ocorrências nas listas dos outros conteúdos são corrigidas
+typedef struct {
+    NeighborTable *table;
+    int id;                     // Conteúdo alterado
+    int present;                // 0 se o conteúdo foi removido
+} NeighborRefresh;
+
+// Listas marcadas para recálculo, calculadas fora do bloqueio sobre uma cópia dos atributos
+typedef struct {
+    const int *ids;             // IDs das listas a recalcular
+    const int *categories;      // Cópia das categorias por ID
+    const int *age_ratings;     // Cópia das classificações etárias por ID
+    const int *durations;       // Cópia das durações por ID
+    int slot_capacity;          // Tamanho das cópias
+    int neighbor_count;         // Vizinhos por lista
+    NeighborEntry *lists;       // Listas calculadas (neighbor_count por ID a recalcular)
+    int *counts;                // Número de vizinhos de cada lista calculada
+} NeighborRepair;
+
+// Similaridade entre dois IDs presentes na tabela
+static float neighbors_slot_similarity(NeighborTable *table, int a, int b) {
+    return simkernel_similarity(table->categories[a], table->age_ratings[a], table->durations[a],
+                                table->categories[b], table->age_ratings[b], table->durations[b]);
+}
+
+void neighbors_insert(NeighborEntry *list, int *count, int capacity, int id, float score) {
+    int n = *count;
+    
+    // Caso comum: a lista está cheia e o candidato não bate o último
+    if (n == capacity && (score < list[n - 1].score ||
+                          (score == list[n - 1].score && id > list[n - 1].id))) {
+        return;
+    }
+    
+    int position = n;
+    while (position > 0 && (score > list[position - 1].score ||
+                            (score == list[position - 1].score && id < list[position - 1].id))) {
+        position--;
+    }
+    
+    if (n == capacity) {
+        n--;
+    }
+    for (int i = n; i > position; i--) {
+        list[i] = list[i - 1];
+    }
+    list[position].id = id;
+    list[position].score = score;
+    *count = n + 1;
+}
+
+// Obtém (ou regista) o índice interno de uma categoria
+static int neighbors_category(NeighborTable *table, const char *name) {
+    for (int i = 0; i < table->category_count; i++) {
+        if (strcmp(table->category_names[i], name) == 0) {
+            return i;
+        }
+    }
+    
+    if (table->category_count >= table->category_capacity) {
+        int new_capacity = table->category_capacity > 0 ? table->category_capacity * 2 : 16;
+        char (*names)[MAX_CATEGORY_LENGTH] = (char (*)[MAX_CATEGORY_LENGTH])realloc(
+            table->category_names, new_capacity * sizeof(*names));
+        if (names == NULL) {
+            return -1;
+        }
+        table->category_names = names;
+        table->category_capacity = new_capacity;
+    }
+    
+    strncpy(table->category_names[table->category_count], name, MAX_CATEGORY_LENGTH - 1);
+    table->category_names[table->category_count][MAX_CATEGORY_LENGTH - 1] = '\0';
+    return table->category_count++;
+}
+
+// Aumenta um array de atributos por ID para new_capacity posições
+static int neighbors_grow(int **array, int new_capacity) {
+    int *grown = (int*)realloc(*array, new_capacity * sizeof(int));
+    if (grown == NULL) {
+        return 0;
+    }
+    *array = grown;
+    return 1;
+}
+
+// Garante espaço para os IDs até id (inclusive); os novos IDs ficam sem conteúdo
+static int neighbors_reserve(NeighborTable *table, int id) {
+    if (id < table->slot_capacity) {
+        return 1;
+    }
+    
+    int new_capacity = table->slot_capacity > 0 ? table->slot_capacity : 64;
+    while (new_capacity <= id) {
+        new_capacity *= 2;
+    }
+    
+    NeighborEntry *entries = (NeighborEntry*)realloc(table->entries, 
+                             (size_t)new_capacity * table->neighbor_count * sizeof(NeighborEntry));
+    if (entries == NULL) {
+        return 0;
+    }
+    table->entries = entries;
+    
+    if (!neighbors_grow(&table->counts, new_capacity) || 
+        !neighbors_grow(&table->categories, new_capacity) || 
+        !neighbors_grow(&table->age_ratings, new_capacity) || 
+        !neighbors_grow(&table->durations, new_capacity) || 
+        !neighbors_grow(&table->dirty, new_capacity) || 
+        !neighbors_grow(&table->dirty_ids, new_capacity)) {
+        return 0;
+    }
+    
+    for (int i = table->slot_capacity; i < new_capacity; i++) {
+        table->counts[i] = 0;
+        table->categories[i] = -1;
+        table->age_ratings[i] = 0;
+        table->durations[i] = 0;
+        table->dirty[i] = 0;
+    }
+    table->slot_capacity = new_capacity;
+    return 1;
+}
+
+// Calcula de raiz a lista de um ID comparando-o com todos os outros; devolve o número de vizinhos
+static int neighbors_scan(const int *categories, const int *age_ratings, const int *durations,
+                          int slot_capacity, int neighbor_count, int id, NeighborEntry *list) {
+    float scores[NEIGHBORS_BLOCK_COLUMNS];
+    int count = 0;
+    
+    if (categories[id] < 0) {
+        return 0;
+    }
+    
+    for (int begin = 1; begin < slot_capacity; begin += NEIGHBORS_BLOCK_COLUMNS) {
+        int length = slot_capacity - begin < NEIGHBORS_BLOCK_COLUMNS ?
+                     slot_capacity - begin : NEIGHBORS_BLOCK_COLUMNS;
+        
+        memset(scores, 0, length * sizeof(float));
+        simkernel_accumulate(categories[id], age_ratings[id], durations[id],
+                             &categories[begin], &age_ratings[begin],
+                             &durations[begin], length, scores);
+        
+        for (int i = 0; i < length; i++) {
+            int other = begin + i;
+            if (other != id && categories[other] >= 0) {
+                neighbors_insert(list, &count, neighbor_count, other, scores[i]);
+            }
+        }
+    }
+    
+    return count;
+}
+
+// Recalcula de raiz a lista de um ID da tabela
+static void neighbors_recompute(NeighborTable *table, int id) {
+    table->counts[id] = neighbors_scan(table->categories, table->age_ratings, table->durations,
+                                       table->slot_capacity, table->neighbor_count, id,
+                                       &table->entries[(size_t)id * table->neighbor_count]);
+}
+
+// Marca a lista de um ID para ser recalculada por neighbors_repair
+static void neighbors_mark_dirty(NeighborTable *table, int id) {
+    if (!table->dirty[id]) {
+        table->dirty[id] = 1;
+        table->dirty_ids[table->dirty_count++] = id;
+    }
+}
+
+// Calcula as listas [begin, end) de um reparo
+static void neighbors_repair_range(void *context, int begin, int end) {
+    NeighborRepair *repair = (NeighborRepair*)context;
+    
+    for (int i = begin; i < end; i++) {
+        repair->counts[i] = neighbors_scan(repair->categories, repair->age_ratings, repair->durations,
+                                           repair->slot_capacity, repair->neighbor_count, repair->ids[i],
+                                           &repair->lists[(size_t)i * repair->neighbor_count]);
+    }
+}
+
+// Calcula as listas dos blocos de linhas [first, last)
+static void neighbors_build_rows(void *context, int first, int last) {
+    NeighborBuild *build = (NeighborBuild*)context;
+    NeighborTable *table = build->table;
+    int begin = first * NEIGHBORS_BLOCK_ROWS;
+    int end = last * NEIGHBORS_BLOCK_ROWS < build->count ? last * NEIGHBORS_BLOCK_ROWS : build->count;
+    float scores[NEIGHBORS_BLOCK_COLUMNS];
+    
+    for (int row = begin; row < end; row++) {
+        table->counts[build->ids[row]] = 0;
+    }
+    
+    // Cada bloco de candidatos é percorrido por todas as linhas enquanto está em cache
+    for (int column_begin = 0; column_begin < build->count; column_begin += NEIGHBORS_BLOCK_COLUMNS) {
+        int column_end = column_begin + NEIGHBORS_BLOCK_COLUMNS < build->count ?
+                         column_begin + NEIGHBORS_BLOCK_COLUMNS : build->count;
+        
+        int length = column_end - column_begin;
+        
+        for (int row = begin; row < end; row++) {
+            int id = build->ids[row];
+            NeighborEntry *list = &table->entries[(size_t)id * table->neighbor_count];
+            int *count = &table->counts[id];
+            
+            // O bloco inteiro é pontuado de uma vez pela versão vetorizada
+            memset(scores, 0, length * sizeof(float));
+            simkernel_accumulate(build->categories[row], build->age_ratings[row], build->durations[row],
+                                 &build->categories[column_begin], &build->age_ratings[column_begin],
+                                 &build->durations[column_begin], length, scores);
+            
+            for (int column = column_begin; column < column_end; column++) {
+                if (column != row) {
+                    neighbors_insert(list, count, table->neighbor_count, build->ids[column],
+                                     scores[column - column_begin]);
+                }
+            }
+        }
+    }
+}
+
+// Corrige as listas dos IDs [begin, end) depois de um conteúdo ter mudado
+static void neighbors_refresh_range(void *context, int begin, int end) {
+    NeighborRefresh *refresh = (NeighborRefresh*)context;
+    NeighborTable *table = refresh->table;
+    int id = refresh->id;
+    int capacity = table->neighbor_count;
+    
+    for (int other = begin; other < end; other++) {
+        if (other == id || table->categories[other] < 0) {
+            continue;
+        }
+        
+        NeighborEntry *list = &table->entries[(size_t)other * capacity];
+        int *count = &table->counts[other];
+        
+        int position = -1;
+        for (int i = 0; i < *count; i++) {
+            if (list[i].id == id) {
+                position = i;
+                break;
+            }
+        }
+        
+        if (position < 0) {
+            // Ainda não era vizinho: entra se bater o último da lista
+            if (refresh->present) {
+                neighbors_insert(list, count, capacity, id,
+                                 neighbors_slot_similarity(table, other, id));
+            }
+            continue;
+        }
+        
+        int was_full = *count == capacity;
+        float old_score = list[position].score;
+        for (int i = position; i < *count - 1; i++) {
+            list[i] = list[i + 1];
+        }
+        (*count)--;
+        
+        float score = refresh->present ? neighbors_slot_similarity(table, other, id) : 0.0f;
+        if (refresh->present && (!was_full || score >= old_score)) {
+            // Continua entre os melhores: os restantes vizinhos não mudam
+            neighbors_insert(list, count, capacity, id, score);
+        } else if (was_full) {
+            // Saiu ou desceu numa lista cheia: o substituto pode ser qualquer outro conteúdo.
+            // A lista fica com os melhores que restam até neighbors_repair a recalcular,
+            // em vez de uma varredura do catálogo por lista com o bloqueio detido
+            neighbors_mark_dirty(table, other);
+        }
+    }
+}
+
+// Ordena vizinhos por ID crescente
+static int neighbors_compare_ids(const void *a, const void *b) {
+    const NeighborEntry *entry_a = (const NeighborEntry*)a;
+    const NeighborEntry *entry_b = (const NeighborEntry*)b;
+    return (entry_a->id > entry_b->id) - (entry_a->id < entry_b->id);
+}
+
+// Observador do catálogo
+static void neighbors_on_change(void *context, int id, ContentChange change) {
+    (void)change;
+    neighbors_refresh((NeighborTable*)context, id);
+}
+
+int neighbors_init(NeighborTable *table, int neighbor_count) {
+    if (table == NULL || neighbor_count <= 0) {
+        return 0;
+    }
+    
+    memset(table, 0, sizeof(NeighborTable));
+    table->neighbor_count = neighbor_count;
+    if (pthread_rwlock_init(&table->lock, NULL) != 0) {
+        return 0;
+    }
+    return 1;
+}
+
+void neighbors_free(NeighborTable *table) {
+    if (table == NULL) {
+        return;
+    }
+    
+    if (table->catalog != NULL) {
+        content_remove_change_listener(table->catalog, table);
+    }
+    
+    free(table->entries);
+    free(table->counts);
+    free(table->categories);
+    free(table->age_ratings);
+    free(table->durations);
+    free(table->dirty);
+    free(table->dirty_ids);
+    free(table->category_names);
+    pthread_rwlock_destroy(&table->lock);
+    memset(table, 0, sizeof(NeighborTable));
+}
+
+// Corpo de neighbors_build, com a época do catálogo já fixada
+static int neighbors_build_pinned(NeighborTable *table, ContentCatalog *catalog, ThreadPool *pool) {
+    if (table == NULL || catalog == NULL) {
+        return 0;
+    }
+    
+    int content_count;
+    const Content *items = content_snapshot(catalog, &content_count);
+    
+    // Atributos compactados dos conteúdos, na arena de rascunho
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    int *ids = (int*)arena_alloc(scratch, (content_count + 1) * sizeof(int));
+    int *categories = (int*)arena_alloc(scratch, (content_count + 1) * sizeof(int));
+    int *age_ratings = (int*)arena_alloc(scratch, (content_count + 1) * sizeof(int));
+    int *durations = (int*)arena_alloc(scratch, (content_count + 1) * sizeof(int));
+    if (ids == NULL || categories == NULL || age_ratings == NULL || durations == NULL) {
+        arena_reset_to(scratch, mark);
+        return 0;
+    }
+    
+    pthread_rwlock_wrlock(&table->lock);
+    
+    for (int i = 0; i < table->slot_capacity; i++) {
+        table->counts[i] = 0;
+        table->categories[i] = -1;
+        table->dirty[i] = 0;
+    }
+    table->dirty_count = 0;
+    
+    int count = 0;
+    for (int i = 0; i < content_count; i++) {
+        const Content *content = &items[i];
+        if (content->id <= 0 || content->id >= NEIGHBORS_MAX_ID) {
+            continue;
+        }
+        
+        int category = neighbors_category(table, content->category);
+        if (category < 0 || !neighbors_reserve(table, content->id)) {
+            pthread_rwlock_unlock(&table->lock);
+            arena_reset_to(scratch, mark);
+            return 0;
+        }
+        
+        table->categories[content->id] = category;
+        table->age_ratings[content->id] = content->age_rating;
+        table->durations[content->id] = content->duration;
+        
+        ids[count] = content->id;
+        categories[count] = category;
+        age_ratings[count] = content->age_rating;
+        durations[count] = content->duration;
+        count++;
+    }
+    
+    NeighborBuild build;
+    build.table = table;
+    build.ids = ids;
+    build.categories = categories;
+    build.age_ratings = age_ratings;
+    build.durations = durations;
+    build.count = count;
+    
+    int row_blocks = (count + NEIGHBORS_BLOCK_ROWS - 1) / NEIGHBORS_BLOCK_ROWS;
+    threadpool_parallel_for(pool, 0, row_blocks, 1, neighbors_build_rows, &build);
+    
+    table->catalog = catalog;
+    table->recomputed = 0;
+    __atomic_add_fetch(&table->version, 1, __ATOMIC_SEQ_CST);
+    pthread_rwlock_unlock(&table->lock);
+    arena_reset_to(scratch, mark);
+    
+    content_add_change_listener(catalog, neighbors_on_change, table);
+    return 1;
+}
+
+int neighbors_build(NeighborTable *table, ContentCatalog *catalog, ThreadPool *pool) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(catalog)) {
+        return 0;
+    }
+    int result = neighbors_build_pinned(table, catalog, pool);
+    content_read_end(catalog);
+    return result;
+}
+
+int neighbors_refresh(NeighborTable *table, int id) {
+    if (table == NULL || table->catalog == NULL || id <= 0 || id >= NEIGHBORS_MAX_ID) {
+        return 0;
+    }
+    
+    pthread_rwlock_wrlock(&table->lock);
+    
+    if (!neighbors_reserve(table, id)) {
+        pthread_rwlock_unlock(&table->lock);
+        return 0;
+    }
+    
+    // Atributos atuais do conteúdo (ou ausência, se foi removido)
+    const Content *content = content_get_by_id(table->catalog, id);
+    int category = content != NULL ? neighbors_category(table, content->category) : -1;
+    if (content != NULL && category < 0) {
+        pthread_rwlock_unlock(&table->lock);
+        return 0;
+    }
+    
+    table->categories[id] = category;
+    table->counts[id] = 0;
+    if (content != NULL) {
+        table->age_ratings[id] = content->age_rating;
+        table->durations[id] = content->duration;
+        neighbors_recompute(table, id);
+    }
+    
+    NeighborRefresh refresh;
+    refresh.table = table;
+    refresh.id = id;
+    refresh.present = content != NULL;
+    
+    // Em série: o bloqueio de escrita está detido e quem espera num conjunto de
+    // threads pode executar tarefas de leitura que bloqueariam nele
+    neighbors_refresh_range(&refresh, 1, table->slot_capacity);
+    
+    __atomic_add_fetch(&table->version, 1, __ATOMIC_SEQ_CST);
+    pthread_rwlock_unlock(&table->lock);
+    return 1;
+}
+
+int neighbors_repair(NeighborTable *table, ThreadPool *pool, int max_lists) {
+    if (table == NULL) {
+        return -1;
+    }
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    
+    // Copiar os atributos e as listas a recalcular: o cálculo corre sem bloqueio
+    pthread_rwlock_rdlock(&table->lock);
+    
+    int batch = table->dirty_count;
+    if (max_lists > 0 && batch > max_lists) {
+        batch = max_lists;
+    }
+    if (batch == 0) {
+        pthread_rwlock_unlock(&table->lock);
+        return 0;
+    }
+    
+    unsigned long version = __atomic_load_n(&table->version, __ATOMIC_SEQ_CST);
+    int slot_capacity = table->slot_capacity;
+    size_t attribute_size = (size_t)slot_capacity * sizeof(int);
+    int *ids = (int*)arena_alloc(scratch, batch * sizeof(int));
+    int *categories = (int*)arena_alloc(scratch, attribute_size);
+    int *age_ratings = (int*)arena_alloc(scratch, attribute_size);
+    int *durations = (int*)arena_alloc(scratch, attribute_size);
+    NeighborEntry *lists = (NeighborEntry*)arena_alloc(scratch, 
+                           (size_t)batch * table->neighbor_count * sizeof(NeighborEntry));
+    int *counts = (int*)arena_alloc(scratch, batch * sizeof(int));
+    if (ids == NULL || categories == NULL || age_ratings == NULL || durations == NULL || 
+        lists == NULL || counts == NULL) {
+        pthread_rwlock_unlock(&table->lock);
+        arena_reset_to(scratch, mark);
+        return -1;
+    }
+    
+    // As últimas marcadas saem primeiro, para a instalação só encurtar a lista
+    memcpy(ids, &table->dirty_ids[table->dirty_count - batch], batch * sizeof(int));
+    memcpy(categories, table->categories, attribute_size);
+    memcpy(age_ratings, table->age_ratings, attribute_size);
+    memcpy(durations, table->durations, attribute_size);
+    
+    pthread_rwlock_unlock(&table->lock);
+    
+    NeighborRepair repair;
+    repair.ids = ids;
+    repair.categories = categories;
+    repair.age_ratings = age_ratings;
+    repair.durations = durations;
+    repair.slot_capacity = slot_capacity;
+    repair.neighbor_count = table->neighbor_count;
+    repair.lists = lists;
+    repair.counts = counts;
+    threadpool_parallel_for(pool, 0, batch, 1, neighbors_repair_range, &repair);
+    
+    // Instalar só se a tabela não mudou entretanto; senão as listas ficam para a próxima chamada
+    pthread_rwlock_wrlock(&table->lock);
+    
+    int repaired = 0;
+    if (__atomic_load_n(&table->version, __ATOMIC_SEQ_CST) == version) {
+        for (int i = 0; i < batch; i++) {
+            int id = ids[i];
+            memcpy(&table->entries[(size_t)id * table->neighbor_count], 
+                   &lists[(size_t)i * table->neighbor_count], 
+                   counts[i] * sizeof(NeighborEntry));
+            table->counts[id] = counts[i];
+            table->dirty[id] = 0;
+        }
+        table->dirty_count -= batch;
+        repaired = batch;
+        __atomic_add_fetch(&table->recomputed, batch, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&table->version, 1, __ATOMIC_SEQ_CST);
+    }
+    
+    pthread_rwlock_unlock(&table->lock);
+    arena_reset_to(scratch, mark);
+    return repaired;
+}
+
+unsigned long neighbors_version(NeighborTable *table) {
+    if (table == NULL) {
+        return 0;
+    }
+    
+    return __atomic_load_n(&table->version, __ATOMIC_SEQ_CST);
+}
+
+const NeighborEntry* neighbors_get(NeighborTable *table, int id, int *count) {
+    *count = 0;
+    if (table == NULL || id <= 0 || id >= table->slot_capacity || table->categories[id] < 0) {
+        return NULL;
+    }
+    
+    *count = table->counts[id];
+    return &table->entries[(size_t)id * table->neighbor_count];
+}
+
+int neighbors_recommend(NeighborTable *table, const int *watched_ids, int watched_count,
+                        int *recommendations, int max_recommendations) {
+    if (table == NULL || watched_ids == NULL || watched_count <= 0 ||
+        recommendations == NULL || max_recommendations <= 0) {
+        return -1;
+    }
+    
+    // Tabela de dispersão dos candidatos (os assistidos entram marcados como excluídos)
+    int slot_count = 1;
+    while (slot_count < 2 * watched_count * (table->neighbor_count + 1)) {
+        slot_count *= 2;
+    }
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    int *slot_ids = (int*)arena_alloc(scratch, slot_count * sizeof(int));
+    float *slot_scores = (float*)arena_alloc(scratch, slot_count * sizeof(float));
+    NeighborEntry *candidates = (NeighborEntry*)arena_alloc(scratch, slot_count * sizeof(NeighborEntry));
+    TopK best;
+    if (slot_ids == NULL || slot_scores == NULL || candidates == NULL ||
+        !topk_init(&best, max_recommendations)) {
+        arena_reset_to(scratch, mark);
+        return -1;
+    }
+    memset(slot_ids, 0, slot_count * sizeof(int));
+    
+    for (int i = 0; i < watched_count; i++) {
+        unsigned int slot = ((unsigned int)watched_ids[i] * 2654435761u) & (slot_count - 1);
+        while (slot_ids[slot] != 0 && slot_ids[slot] != watched_ids[i]) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slot_ids[slot] = watched_ids[i];
+        slot_scores[slot] = -1.0f;
+    }
+    
+    pthread_rwlock_rdlock(&table->lock);
+    
+    int candidate_count = 0;
+    for (int i = 0; i < watched_count; i++) {
+        int count;
+        const NeighborEntry *list = neighbors_get(table, watched_ids[i], &count);
+        
+        for (int j = 0; j < count; j++) {
+            unsigned int slot = ((unsigned int)list[j].id * 2654435761u) & (slot_count - 1);
+            while (slot_ids[slot] != 0 && slot_ids[slot] != list[j].id) {
+                slot = (slot + 1) & (slot_count - 1);
+            }
+            
+            if (slot_ids[slot] == 0) {
+                slot_ids[slot] = list[j].id;
+                slot_scores[slot] = list[j].score;
+                candidates[candidate_count++].id = (int)slot;
+            } else if (slot_scores[slot] >= 0.0f) {
+                slot_scores[slot] += list[j].score;
+            }
+        }
+    }
+    
+    pthread_rwlock_unlock(&table->lock);
+    
+    // Oferecer por ordem de ID para que os empates se resolvam como na ordem do catálogo
+    for (int i = 0; i < candidate_count; i++) {
+        int slot = candidates[i].id;
+        candidates[i].id = slot_ids[slot];
+        candidates[i].score = slot_scores[slot] / watched_count;
+    }
+    qsort(candidates, candidate_count, sizeof(NeighborEntry), neighbors_compare_ids);
+    for (int i = 0; i < candidate_count; i++) {
+        topk_push(&best, candidates[i].id, candidates[i].score);
+    }
+    
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
+    arena_reset_to(scratch, mark);
+    return recommendation_count;
+}
+
+float* neighbors_score(NeighborTable *table, const int *watched_ids, int watched_count,
+                       Arena *arena, int *slot_count) {
+    if (slot_count != NULL) {
+        *slot_count = 0;
+    }
+    if (table == NULL || watched_ids == NULL || watched_count <= 0 || 
+        arena == NULL || slot_count == NULL) {
+        return NULL;
+    }
+    
+    pthread_rwlock_rdlock(&table->lock);
+    
+    int capacity = table->slot_capacity;
+    float *scores = (float*)arena_alloc(arena, (capacity > 0 ? capacity : 1) * sizeof(float));
+    if (scores == NULL) {
+        pthread_rwlock_unlock(&table->lock);
+        return NULL;
+    }
+    memset(scores, 0, capacity * sizeof(float));
+    
+    // Cada bloco de IDs é pontuado contra todos os assistidos enquanto está em cache
+    for (int begin = 0; begin < capacity; begin += NEIGHBORS_BLOCK_COLUMNS) {
+        int length = capacity - begin < NEIGHBORS_BLOCK_COLUMNS ? capacity - begin : NEIGHBORS_BLOCK_COLUMNS;
+        
+        for (int i = 0; i < watched_count; i++) {
+            int id = watched_ids[i];
+            if (id > 0 && id < capacity && table->categories[id] >= 0) {
+                simkernel_accumulate(table->categories[id], table->age_ratings[id], table->durations[id],
+                                     &table->categories[begin], &table->age_ratings[begin],
+                                     &table->durations[begin], length, &scores[begin]);
+            }
+        }
+    }
+    
+    for (int id = 0; id < capacity; id++) {
+        scores[id] = table->categories[id] >= 0 ? scores[id] / watched_count : -1.0f;
+    }
+    for (int i = 0; i < watched_count; i++) {
+        if (watched_ids[i] > 0 && watched_ids[i] < capacity) {
+            scores[watched_ids[i]] = -1.0f;
+        }
+    }
+    
+    pthread_rwlock_unlock(&table->lock);
+    *slot_count = capacity;
+    return scores;
+}
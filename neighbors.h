@@ -0,0 +1,196 @@
+/**
+ * @file neighbors.h
+ * @brief Módulo de listas pré-calculadas de conteúdos semelhantes (item-item)
+ * 
+ * Para cada conteúdo do catálogo guarda os N conteúdos mais semelhantes
+ * (segundo recommendation_calculate_similarity), calculados de uma vez em
+ * blocos e em paralelo. Depois de construída, a tabela observa o catálogo e
+ * corrige apenas as listas afetadas quando um conteúdo é adicionado,
+ * editado ou removido; as listas que precisam de ser recalculadas de raiz
+ * ficam marcadas para neighbors_repair. As recomendações por similaridade
+ * juntam as listas dos conteúdos assistidos em vez de compararem todos os
+ * pares.
+ */
+
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+
+#include <pthread.h>
+
+#include "content.h"
+#include "threadpool.h"
+#include "arena.h"
+
+#define NEIGHBORS_DEFAULT_COUNT 20
+#define NEIGHBORS_BLOCK_ROWS 64
+#define NEIGHBORS_BLOCK_COLUMNS 2048
+#define NEIGHBORS_MAX_ID (CONTENT_VIEW_MAX_PAGES * CONTENT_VIEW_PAGE_SIZE)
+
+/**
+ * @brief Vizinho de um conteúdo
+ */
+typedef struct {
+    int id;                     /**< ID do conteúdo vizinho */
+    float score;                /**< Similaridade com o conteúdo */
+} NeighborEntry;
+
+/**
+ * @brief Tabela de vizinhos, indexada por ID de conteúdo
+ * 
+ * A lista do conteúdo id ocupa entries[id * neighbor_count] em diante e está
+ * ordenada por similaridade decrescente (em empate, por ID crescente).
+ */
+typedef struct {
+    NeighborEntry *entries;     /**< Listas de vizinhos, neighbor_count por ID */
+    int *counts;                /**< Número de vizinhos de cada ID */
+    int *categories;            /**< Categoria (índice em category_names) de cada ID, -1 se não existir */
+    int *age_ratings;           /**< Classificação etária de cada ID */
+    int *durations;             /**< Duração de cada ID */
+    int slot_capacity;          /**< IDs suportados (0 a slot_capacity - 1) */
+    int neighbor_count;         /**< Vizinhos guardados por conteúdo (N) */
+    char (*category_names)[MAX_CATEGORY_LENGTH]; /**< Categorias distintas */
+    int category_count;         /**< Número de categorias distintas */
+    int category_capacity;      /**< Capacidade do array de categorias */
+    ContentCatalog *catalog;    /**< Catálogo observado (NULL antes de neighbors_build) */
+    int *dirty;                 /**< 1 se a lista do ID espera por neighbors_repair */
+    int *dirty_ids;             /**< IDs das listas marcadas, pela ordem de marcação */
+    int dirty_count;            /**< Número de listas marcadas */
+    pthread_rwlock_t lock;      /**< Escritas (construção, atualização) exclusivas das leituras */
+    unsigned long version;      /**< Avança a cada alteração das listas */
+    long recomputed;            /**< Listas recalculadas por neighbors_repair desde a construção */
+} NeighborTable;
+
+/**
+ * @brief Insere um vizinho numa lista ordenada, limitada a capacity
+ * 
+ * A lista fica por score decrescente (em empate, por ID crescente); com a
+ * lista cheia, o candidato só entra se bater o último, que é descartado.
+ * Partilhada pelas listas de vizinhos e pelo modelo colaborativo.
+ * 
+ * @param list Lista de vizinhos (capacity posições)
+ * @param count Número de vizinhos na lista (atualizado)
+ * @param capacity Capacidade da lista (> 0)
+ * @param id ID do candidato
+ * @param score Score do candidato
+ */
+void neighbors_insert(NeighborEntry *list, int *count, int capacity, int id, float score);
+
+/**
+ * @brief Inicializa uma tabela vazia
+ * 
+ * @param table Ponteiro para a tabela
+ * @param neighbor_count Vizinhos a guardar por conteúdo (> 0)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int neighbors_init(NeighborTable *table, int neighbor_count);
+
+/**
+ * @brief Deixa de observar o catálogo e liberta a memória da tabela
+ * 
+ * @param table Ponteiro para a tabela
+ */
+void neighbors_free(NeighborTable *table);
+
+/**
+ * @brief Calcula as listas de todos os conteúdos e passa a observar o catálogo
+ * 
+ * As linhas são processadas em blocos de NEIGHBORS_BLOCK_ROWS conteúdos contra
+ * blocos de NEIGHBORS_BLOCK_COLUMNS candidatos, para que os atributos dos
+ * candidatos fiquem em cache, e os blocos de linhas correm em paralelo.
+ * 
+ * @param table Ponteiro para a tabela
+ * @param catalog Catálogo de conteúdos
+ * @param pool Conjunto de threads (NULL para calcular em série)
+ * @return int 1 se a construção foi bem-sucedida, 0 caso contrário
+ */
+int neighbors_build(NeighborTable *table, ContentCatalog *catalog, ThreadPool *pool);
+
+/**
+ * @brief Atualiza as listas depois de um conteúdo ter sido adicionado, editado ou removido
+ * 
+ * Chamada automaticamente pelo catálogo observado; recalcula a lista do
+ * conteúdo e corrige as listas em que ele entra ou de onde sai. Uma lista
+ * cheia de onde o conteúdo sai (ou onde desce) precisaria de uma varredura
+ * do catálogo para encontrar o substituto: em vez disso fica com os
+ * vizinhos que restam e é marcada para neighbors_repair, para que o custo
+ * com o bloqueio de escrita detido não cresça com o número de listas
+ * afetadas.
+ * 
+ * @param table Ponteiro para a tabela
+ * @param id ID do conteúdo alterado
+ * @return int 1 se a atualização foi bem-sucedida, 0 caso contrário
+ */
+int neighbors_refresh(NeighborTable *table, int id);
+
+/**
+ * @brief Recalcula de raiz até max_lists listas marcadas por neighbors_refresh
+ * 
+ * Copia os atributos com o bloqueio de leitura, calcula as listas em
+ * paralelo sem bloqueio e instala-as com o bloqueio de escrita, só o tempo
+ * de as copiar. Se a tabela mudou durante o cálculo, as listas continuam
+ * marcadas e ficam para a chamada seguinte. Pode ser chamada
+ * periodicamente por qualquer thread.
+ * 
+ * @param table Ponteiro para a tabela
+ * @param pool Conjunto de threads (NULL para calcular em série)
+ * @param max_lists Número máximo de listas a recalcular (0 para todas)
+ * @return int Número de listas recalculadas, ou -1 em caso de erro
+ */
+int neighbors_repair(NeighborTable *table, ThreadPool *pool, int max_lists);
+
+/**
+ * @brief Obtém a versão das listas, que avança a cada alteração
+ * 
+ * @param table Ponteiro para a tabela
+ * @return unsigned long Versão atual
+ */
+unsigned long neighbors_version(NeighborTable *table);
+
+/**
+ * @brief Obtém a lista de vizinhos de um conteúdo
+ * 
+ * Para uso pela thread que altera o catálogo (ou sem escritores concorrentes).
+ * 
+ * @param table Ponteiro para a tabela
+ * @param id ID do conteúdo
+ * @param count Recebe o número de vizinhos
+ * @return const NeighborEntry* Lista de vizinhos, ou NULL se o ID não existir
+ */
+const NeighborEntry* neighbors_get(NeighborTable *table, int id, int *count);
+
+/**
+ * @brief Recomenda conteúdos juntando as listas de vizinhos dos conteúdos assistidos
+ * 
+ * O score de cada candidato é a soma das similaridades com os conteúdos
+ * assistidos de cujas listas faz parte, dividida por watched_count.
+ * 
+ * @param table Ponteiro para a tabela
+ * @param watched_ids IDs dos conteúdos assistidos (excluídos das recomendações)
+ * @param watched_count Número de conteúdos assistidos
+ * @param recommendations Array para armazenar os IDs recomendados
+ * @param max_recommendations Número máximo de recomendações
+ * @return int Número de recomendações geradas, ou -1 em caso de erro
+ */
+int neighbors_recommend(NeighborTable *table, const int *watched_ids, int watched_count,
+                        int *recommendations, int max_recommendations);
+
+/**
+ * @brief Calcula o score exato de todos os conteúdos da tabela para um conjunto de assistidos
+ * 
+ * Percorre os atributos por ID da tabela em blocos com simkernel_accumulate,
+ * sem passar pelas listas de vizinhos. O score de cada ID é a soma das
+ * similaridades com os assistidos presentes na tabela, dividida por
+ * watched_count (o mesmo valor de recommendation_by_content_similarity sem
+ * tabela); IDs sem conteúdo e os próprios assistidos ficam com -1.
+ * 
+ * @param table Ponteiro para a tabela
+ * @param watched_ids IDs dos conteúdos assistidos
+ * @param watched_count Número de conteúdos assistidos
+ * @param arena Arena onde é reservado o array de scores
+ * @param slot_count Recebe o tamanho do array (IDs 0 a slot_count - 1)
+ * @return float* Scores indexados por ID, ou NULL em caso de erro
+ */
+float* neighbors_score(NeighborTable *table, const int *watched_ids, int watched_count,
+                       Arena *arena, int *slot_count);
+
+#endif /* NEIGHBORS_H */
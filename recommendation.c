@@ -4,29 +4,116 @@
  */
 
 #include "recommendation.h"
+#include "threadpool.h"
+#include "arena.h"
+#include "topk.h"
+#include "simkernel.h"
+#include "mapfile.h"
 #include <math.h>
+#include <stdint.h>
+#include <time.h>
 
-// Estrutura auxiliar para ordenação de conteúdos por score
+// Estrutura auxiliar para acumular o score de um conteúdo
 typedef struct {
     int content_id;
     float score;
 } ContentScore;
 
-// Função de comparação para ordenação de scores (ordem decrescente)
-static int compare_scores(const void *a, const void *b) {
-    const ContentScore *score_a = (const ContentScore *)a;
-    const ContentScore *score_b = (const ContentScore *)b;
+// Tabela de vizinhos pré-calculada (NULL = comparar o catálogo todo)
+static NeighborTable *recommendation_neighbors = NULL;
+
+// Modelo de filtragem colaborativa (NULL = fonte desativada)
+static CollabModel *recommendation_collab = NULL;
+
+// Recomendações pré-calculadas consultadas antes do cálculo personalizado (NULL = calcular sempre)
+static RecommendationTable *recommendation_table = NULL;
+
+// Avançada sempre que a tabela de vizinhos, o modelo colaborativo ou a tabela pré-calculada mudam
+// (invalida as caches)
+static unsigned long recommendation_config_generation = 1;
+
+// Dados partilhados pelo cálculo paralelo de similaridade
+typedef struct {
+    const Content *items;       // Conteúdos candidatos
+    const Content **watched;    // Conteúdos assistidos encontrados no catálogo
+    int found_count;            // Número de conteúdos assistidos encontrados
+    const int *watched_ids;     // IDs assistidos (para excluir candidatos)
+    int watched_count;          // Número de IDs assistidos (divisor da média)
+    float *scores;              // Score de cada candidato (-1 se já assistido)
+} SimilarityJob;
+
+// Calcula o score médio dos candidatos [begin, end)
+static void recommendation_similarity_range(void *context, int begin, int end) {
+    SimilarityJob *job = (SimilarityJob*)context;
     
-    if (score_b->score > score_a->score) return 1;
-    if (score_b->score < score_a->score) return -1;
-    return 0;
+    for (int i = begin; i < end; i++) {
+        const Content *candidate = &job->items[i];
+        
+        // Verificar se o utilizador já assistiu este conteúdo
+        int already_watched = 0;
+        for (int j = 0; j < job->watched_count; j++) {
+            if (job->watched_ids[j] == candidate->id) {
+                already_watched = 1;
+                break;
+            }
+        }
+        
+        if (already_watched) {
+            job->scores[i] = -1.0f;
+            continue;
+        }
+        
+        float total_similarity = 0.0f;
+        for (int j = 0; j < job->found_count; j++) {
+            total_similarity += recommendation_calculate_similarity(job->watched[j], candidate);
+        }
+        
+        // Calcular score médio
+        job->scores[i] = total_similarity / job->watched_count;
+    }
 }
 
-int recommendation_by_content_similarity(UserManager *user_manager, 
-                                       ContentCatalog *content_catalog,
-                                       int user_id, 
-                                       int *recommendations, 
-                                       int max_recommendations) {
+// Seleciona pelo score exato calculado sobre a tabela de vizinhos (-1 se a tabela não cobre o catálogo)
+static int recommendation_similarity_from_table(NeighborTable *neighbors, ContentCatalog *content_catalog,
+                                                const int *watched_ids, int watched_count,
+                                                int *recommendations, int max_recommendations) {
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    int slot_count;
+    float *scores = neighbors_score(neighbors, watched_ids, watched_count, scratch, &slot_count);
+    
+    TopK best;
+    if (scores == NULL || !topk_init(&best, max_recommendations)) {
+        arena_reset_to(scratch, mark);
+        return -1;
+    }
+    
+    // Pela ordem do catálogo, para o mesmo desempate do cálculo sem tabela
+    int content_count;
+    const Content *items = content_snapshot(content_catalog, &content_count);
+    for (int i = 0; i < content_count; i++) {
+        if (items[i].id <= 0 || items[i].id >= slot_count) {
+            topk_free(&best);
+            arena_reset_to(scratch, mark);
+            return -1;
+        }
+        if (scores[items[i].id] >= 0.0f) {
+            topk_push(&best, items[i].id, scores[items[i].id]);
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
+    return recommendation_count;
+}
+
+// Corpo de recommendation_by_content_similarity, com a época do catálogo já fixada pelo chamador
+static int recommendation_by_content_similarity_pinned(UserManager *user_manager, 
+                                                     ContentCatalog *content_catalog,
+                                                     int user_id, 
+                                                     int *recommendations, 
+                                                     int max_recommendations) {
     if (user_manager == NULL || content_catalog == NULL || 
         user_id <= 0 || recommendations == NULL || max_recommendations <= 0) {
         return 0;
@@ -62,58 +149,98 @@ int recommendation_by_content_similarity(UserManager *user_manager,
         return recommendation_by_popularity(content_catalog, recommendations, max_recommendations);
     }
     
-    // Calcular similaridade de todos os conteúdos não assistidos com os assistidos
-    ContentScore scores[1000]; // Assumindo no máximo 1000 conteúdos
-    int score_count = 0;
-    
-    for (int i = 0; i < content_catalog->count && score_count < 1000; i++) {
-        Content *candidate = &content_catalog->items[i];
-        
-        // Verificar se o utilizador já assistiu este conteúdo
-        int already_watched = 0;
-        for (int j = 0; j < watched_count; j++) {
-            if (watched_ids[j] == candidate->id) {
-                already_watched = 1;
-                break;
-            }
+    // Juntar as listas de vizinhos pré-calculadas dos conteúdos assistidos
+    NeighborTable *neighbors = recommendation_neighbors;
+    if (neighbors != NULL && neighbors->catalog == content_catalog) {
+        int count = neighbors_recommend(neighbors, watched_ids, watched_count, 
+                                        recommendations, max_recommendations);
+        if (count == max_recommendations) {
+            return count;
         }
         
-        if (!already_watched) {
-            float total_similarity = 0.0f;
-            
-            for (int j = 0; j < watched_count; j++) {
-                Content *watched = content_get_by_id(content_catalog, watched_ids[j]);
-                if (watched != NULL) {
-                    total_similarity += recommendation_calculate_similarity(watched, candidate);
-                }
-            }
-            
-            // Calcular score médio
-            float avg_similarity = watched_count > 0 ? total_similarity / watched_count : 0;
-            
-            scores[score_count].content_id = candidate->id;
-            scores[score_count].score = avg_similarity;
-            score_count++;
+        // As listas não chegam: calcular o score exato de todo o catálogo com a versão vetorizada
+        count = recommendation_similarity_from_table(neighbors, content_catalog, watched_ids, watched_count,
+                                                     recommendations, max_recommendations);
+        if (count >= 0) {
+            return count;
+        }
+    }
+    
+    // Calcular similaridade de todos os conteúdos não assistidos com os assistidos
+    int content_count;
+    const Content *items = content_snapshot(content_catalog, &content_count);
+    if (content_count == 0) {
+        return 0;
+    }
+    
+    const Content *watched[100];
+    int found_count = 0;
+    for (int j = 0; j < watched_count; j++) {
+        const Content *content = content_get_by_id(content_catalog, watched_ids[j]);
+        if (content != NULL) {
+            watched[found_count++] = content;
         }
     }
     
-    // Ordenar os scores em ordem decrescente
-    qsort(scores, score_count, sizeof(ContentScore), compare_scores);
+    SimilarityJob job;
+    job.items = items;
+    job.watched = watched;
+    job.found_count = found_count;
+    job.watched_ids = watched_ids;
+    job.watched_count = watched_count;
     
-    // Copiar as recomendações para o array de resultado
-    int recommendation_count = 0;
-    for (int i = 0; i < score_count && recommendation_count < max_recommendations; i++) {
-        recommendations[recommendation_count++] = scores[i].content_id;
+    // Scores temporários na arena de rascunho, descartados no fim do pedido
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    job.scores = (float*)arena_alloc(scratch, content_count * sizeof(float));
+    if (job.scores == NULL) {
+        arena_reset_to(scratch, mark);
+        return 0;
     }
     
+    // Cada candidato tem a sua posição, pelo que os blocos correm em paralelo
+    threadpool_parallel_for(threadpool_get_default(), 0, content_count, 256, 
+                            recommendation_similarity_range, &job);
+    
+    // Selecionar os melhores pela ordem do catálogo (desempate estável)
+    TopK best;
+    if (!topk_init(&best, max_recommendations)) {
+        arena_reset_to(scratch, mark);
+        return 0;
+    }
+    for (int i = 0; i < content_count; i++) {
+        if (job.scores[i] >= 0.0f) {
+            topk_push(&best, items[i].id, job.scores[i]);
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
     return recommendation_count;
 }
 
-int recommendation_by_category(UserManager *user_manager, 
-                              ContentCatalog *content_catalog,
-                              int user_id, 
-                              int *recommendations, 
-                              int max_recommendations) {
+int recommendation_by_content_similarity(UserManager *user_manager, 
+                                       ContentCatalog *content_catalog,
+                                       int user_id, 
+                                       int *recommendations, 
+                                       int max_recommendations) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(content_catalog)) {
+        return 0;
+    }
+    int count = recommendation_by_content_similarity_pinned(user_manager, content_catalog, user_id, 
+                                                            recommendations, max_recommendations);
+    content_read_end(content_catalog);
+    return count;
+}
+
+// Corpo de recommendation_by_category, com a época do catálogo já fixada pelo chamador
+static int recommendation_by_category_pinned(UserManager *user_manager, 
+                                            ContentCatalog *content_catalog,
+                                            int user_id, 
+                                            int *recommendations, 
+                                            int max_recommendations) {
     if (user_manager == NULL || content_catalog == NULL || 
         user_id <= 0 || recommendations == NULL || max_recommendations <= 0) {
         return 0;
@@ -131,7 +258,7 @@ int recommendation_by_category(UserManager *user_manager,
             (interaction->type == INTERACTION_PLAY || 
              interaction->type == INTERACTION_COMPLETE)) {
             
-            Content *content = content_get_by_id(content_catalog, interaction->content_id);
+            const Content *content = content_get_by_id(content_catalog, interaction->content_id);
             if (content != NULL) {
                 // Verificar se a categoria já está na lista
                 int category_index = -1;
@@ -177,15 +304,24 @@ int recommendation_by_category(UserManager *user_manager,
         }
     }
     
-    // Criar uma lista dos conteúdos não assistidos nas categorias populares
-    ContentScore scores[1000]; // Assumindo no máximo 1000 conteúdos
-    int score_count = 0;
+    // Selecionar os melhores conteúdos não assistidos nas categorias populares
+    TopK best;
+    if (!topk_init(&best, max_recommendations)) {
+        return 0;
+    }
+    
+    // Conjunto de conteúdos assistidos, resolvido uma única vez (catálogo AND-NOT assistidos)
+    User *user = user_get_by_id(user_manager, user_id);
+    const Bitmap *watched = user != NULL ? user->watched : NULL;
+    
+    int content_count;
+    const Content *items = content_snapshot(content_catalog, &content_count);
     
-    for (int i = 0; i < content_catalog->count && score_count < 1000; i++) {
-        Content *content = &content_catalog->items[i];
+    for (int i = 0; i < content_count; i++) {
+        const Content *content = &items[i];
         
         // Verificar se o utilizador já assistiu este conteúdo
-        if (!recommendation_has_watched(user_manager, user_id, content->id)) {
+        if (content->id <= 0 || !bitmap_contains(watched, (uint32_t)content->id)) {
             // Encontrar a posição da categoria deste conteúdo na lista de categorias populares
             int category_index = -1;
             for (int j = 0; j < category_count; j++) {
@@ -196,67 +332,99 @@ int recommendation_by_category(UserManager *user_manager,
             }
             
             if (category_index >= 0) {
-                scores[score_count].content_id = content->id;
-                
                 // O score é a posição inversa na lista (mais popular = maior score)
-                scores[score_count].score = (float)(category_count - category_index) +
-                                           // Adicionar uma fração da contagem normalizada
-                                           (float)category_counts[category_index] / 
-                                           (category_counts[0] > 0 ? category_counts[0] : 1);
+                float score = (float)(category_count - category_index) +
+                              // Adicionar uma fração da contagem normalizada
+                              (float)category_counts[category_index] / 
+                              (category_counts[0] > 0 ? category_counts[0] : 1);
                 
-                score_count++;
+                topk_push(&best, content->id, score);
             }
         }
     }
     
-    // Ordenar os scores em ordem decrescente
-    qsort(scores, score_count, sizeof(ContentScore), compare_scores);
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
+    return recommendation_count;
+}
+
+int recommendation_by_category(UserManager *user_manager, 
+                              ContentCatalog *content_catalog,
+                              int user_id, 
+                              int *recommendations, 
+                              int max_recommendations) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(content_catalog)) {
+        return 0;
+    }
+    int count = recommendation_by_category_pinned(user_manager, content_catalog, user_id, 
+                                                  recommendations, max_recommendations);
+    content_read_end(content_catalog);
+    return count;
+}
+
+// Corpo de recommendation_by_popularity, com a época do catálogo já fixada pelo chamador
+static int recommendation_by_popularity_pinned(ContentCatalog *content_catalog, 
+                                              int *recommendations, 
+                                              int max_recommendations) {
+    if (content_catalog == NULL || recommendations == NULL || max_recommendations <= 0) {
+        return 0;
+    }
+    
+    // Selecionar os conteúdos com mais visualizações
+    TopK best;
+    if (!topk_init(&best, max_recommendations)) {
+        return 0;
+    }
     
-    // Copiar as recomendações para o array de resultado
-    int recommendation_count = 0;
-    for (int i = 0; i < score_count && recommendation_count < max_recommendations; i++) {
-        recommendations[recommendation_count++] = scores[i].content_id;
+    int content_count;
+    const Content *items = content_snapshot(content_catalog, &content_count);
+    
+    for (int i = 0; i < content_count; i++) {
+        const Content *content = &items[i];
+        topk_push(&best, content->id, (float)content_get_views(content_catalog, content));
     }
     
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
     return recommendation_count;
 }
 
 int recommendation_by_popularity(ContentCatalog *content_catalog, 
                                 int *recommendations, 
                                 int max_recommendations) {
-    if (content_catalog == NULL || recommendations == NULL || max_recommendations <= 0) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(content_catalog)) {
         return 0;
     }
-    
-    // Criar array de scores com base nas visualizações
-    ContentScore scores[1000]; // Assumindo no máximo 1000 conteúdos
-    int score_count = 0;
-    
-    for (int i = 0; i < content_catalog->count && score_count < 1000; i++) {
-        Content *content = &content_catalog->items[i];
-        
-        scores[score_count].content_id = content->id;
-        scores[score_count].score = (float)content->views;
-        score_count++;
+    int count = recommendation_by_popularity_pinned(content_catalog, recommendations, max_recommendations);
+    content_read_end(content_catalog);
+    return count;
+}
+
+int recommendation_by_collaborative(UserManager *user_manager, 
+                                    int user_id, 
+                                    int *recommendations, 
+                                    int max_recommendations) {
+    if (user_manager == NULL || user_id <= 0 || recommendations == NULL || max_recommendations <= 0) {
+        return 0;
     }
     
-    // Ordenar os scores em ordem decrescente
-    qsort(scores, score_count, sizeof(ContentScore), compare_scores);
-    
-    // Copiar as recomendações para o array de resultado
-    int recommendation_count = 0;
-    for (int i = 0; i < score_count && recommendation_count < max_recommendations; i++) {
-        recommendations[recommendation_count++] = scores[i].content_id;
+    CollabModel *model = recommendation_collab;
+    if (model == NULL || model->manager != user_manager) {
+        return 0;
     }
     
-    return recommendation_count;
+    int count = collab_recommend(model, user_id, recommendations, max_recommendations);
+    return count > 0 ? count : 0;
 }
 
-int recommendation_personalized(UserManager *user_manager, 
-                              ContentCatalog *content_catalog,
-                              int user_id, 
-                              int *recommendations, 
-                              int max_recommendations) {
+// Corpo de recommendation_personalized_reference, com a época do catálogo já fixada pelo chamador
+static int recommendation_personalized_reference_pinned(UserManager *user_manager, 
+                                                      ContentCatalog *content_catalog,
+                                                      int user_id, 
+                                                      int *recommendations, 
+                                                      int max_recommendations) {
     if (user_manager == NULL || content_catalog == NULL || 
         user_id <= 0 || recommendations == NULL || max_recommendations <= 0) {
         return 0;
@@ -266,6 +434,7 @@ int recommendation_personalized(UserManager *user_manager,
     int similarity_recs[MAX_RECOMMENDATIONS];
     int category_recs[MAX_RECOMMENDATIONS];
     int popularity_recs[MAX_RECOMMENDATIONS];
+    int collaborative_recs[MAX_RECOMMENDATIONS];
     
     int similarity_count = recommendation_by_content_similarity(
         user_manager, content_catalog, user_id, similarity_recs, MAX_RECOMMENDATIONS);
@@ -276,8 +445,11 @@ int recommendation_personalized(UserManager *user_manager,
     int popularity_count = recommendation_by_popularity(
         content_catalog, popularity_recs, MAX_RECOMMENDATIONS);
     
+    int collaborative_count = recommendation_by_collaborative(
+        user_manager, user_id, collaborative_recs, MAX_RECOMMENDATIONS);
+    
     // Combinar as recomendações com pesos
-    ContentScore combined_scores[3 * MAX_RECOMMENDATIONS];
+    ContentScore combined_scores[4 * MAX_RECOMMENDATIONS];
     int combined_count = 0;
     
     // Adicionar recomendações por similaridade (peso alto)
@@ -287,6 +459,26 @@ int recommendation_personalized(UserManager *user_manager,
         combined_count++;
     }
     
+    // Adicionar recomendações por filtragem colaborativa (peso entre similaridade e categoria)
+    for (int i = 0; i < collaborative_count; i++) {
+        // Verificar se já foi adicionado
+        int exists = 0;
+        for (int j = 0; j < combined_count; j++) {
+            if (combined_scores[j].content_id == collaborative_recs[i]) {
+                exists = 1;
+                // Se já existe, aumentar o score
+                combined_scores[j].score += 2.5f * (float)(collaborative_count - i) / collaborative_count;
+                break;
+            }
+        }
+        
+        if (!exists) {
+            combined_scores[combined_count].content_id = collaborative_recs[i];
+            combined_scores[combined_count].score = 2.5f * (float)(collaborative_count - i) / collaborative_count;
+            combined_count++;
+        }
+    }
+    
     // Adicionar recomendações por categoria (peso médio)
     for (int i = 0; i < category_count; i++) {
         // Verificar se já foi adicionado
@@ -327,37 +519,816 @@ int recommendation_personalized(UserManager *user_manager,
         }
     }
     
-    // Ordenar os scores combinados em ordem decrescente
-    qsort(combined_scores, combined_count, sizeof(ContentScore), compare_scores);
+    // Selecionar os melhores scores combinados
+    TopK best;
+    if (!topk_init(&best, max_recommendations)) {
+        return 0;
+    }
+    for (int i = 0; i < combined_count; i++) {
+        topk_push(&best, combined_scores[i].content_id, combined_scores[i].score);
+    }
     
-    // Copiar as recomendações para o array de resultado
-    int recommendation_count = 0;
-    for (int i = 0; i < combined_count && recommendation_count < max_recommendations; i++) {
-        recommendations[recommendation_count++] = combined_scores[i].content_id;
+    int recommendation_count = topk_extract(&best, recommendations, max_recommendations);
+    topk_free(&best);
+    return recommendation_count;
+}
+
+int recommendation_personalized_reference(UserManager *user_manager, 
+                                        ContentCatalog *content_catalog,
+                                        int user_id, 
+                                        int *recommendations, 
+                                        int max_recommendations) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(content_catalog)) {
+        return 0;
+    }
+    int count = recommendation_personalized_reference_pinned(user_manager, content_catalog, user_id, 
+                                                             recommendations, max_recommendations);
+    content_read_end(content_catalog);
+    return count;
+}
+
+// Conteúdo do histórico do utilizador, na tabela de dispersão por ID do pedido personalizado
+typedef struct {
+    int id;                     // ID do conteúdo (0 = posição vazia)
+    int item;                   // Primeira posição no catálogo (-1 se não estiver no catálogo)
+    int excluded;               // 1 se está entre os assistidos que a similaridade exclui
+} HistoryEntry;
+
+// Categorias do catálogo convertidas em inteiros (iguais se e só se os nomes forem iguais)
+typedef struct {
+    const char **names;         // Nome de cada categoria interna
+    int *slots;                 // Tabela de dispersão: categoria interna + 1 (0 = vazia)
+    int mask;                   // Posições da tabela - 1
+    int count;                  // Número de categorias internas
+    Arena *arena;               // Arena de onde vêm as tabelas
+} CategoryInterner;
+
+// Procura um ID na tabela do histórico; com insert, acrescenta-o se faltar
+static HistoryEntry* recommendation_history_slot(HistoryEntry *table, int mask, int id, int insert) {
+    unsigned int slot = ((unsigned)id * 2654435761u) & (unsigned)mask;
+    while (table[slot].id != 0) {
+        if (table[slot].id == id) {
+            return &table[slot];
+        }
+        slot = (slot + 1) & (unsigned)mask;
+    }
+    
+    if (!insert) {
+        return NULL;
+    }
+    table[slot].id = id;
+    table[slot].item = -1;
+    table[slot].excluded = 0;
+    return &table[slot];
+}
+
+static unsigned int recommendation_category_hash(const char *name) {
+    unsigned int hash = 2166136261u;
+    for (const char *c = name; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    return hash;
+}
+
+static int recommendation_interner_init(CategoryInterner *interner, Arena *arena, int max_categories) {
+    interner->names = (const char**)arena_alloc(arena, (max_categories > 0 ? max_categories : 1) * sizeof(char*));
+    interner->slots = (int*)arena_alloc(arena, 64 * sizeof(int));
+    if (interner->names == NULL || interner->slots == NULL) {
+        return 0;
+    }
+    memset(interner->slots, 0, 64 * sizeof(int));
+    interner->mask = 63;
+    interner->count = 0;
+    interner->arena = arena;
+    return 1;
+}
+
+// Categoria interna de um nome, criada na primeira ocorrência (-1 sem memória)
+static int recommendation_intern(CategoryInterner *interner, const char *name) {
+    unsigned int slot = recommendation_category_hash(name) & (unsigned)interner->mask;
+    while (interner->slots[slot] != 0) {
+        int category = interner->slots[slot] - 1;
+        if (strcmp(interner->names[category], name) == 0) {
+            return category;
+        }
+        slot = (slot + 1) & (unsigned)interner->mask;
+    }
+    
+    // Manter a tabela com ocupação até metade
+    if (2 * (interner->count + 1) > interner->mask + 1) {
+        int size = 2 * (interner->mask + 1);
+        int *slots = (int*)arena_alloc(interner->arena, size * sizeof(int));
+        if (slots == NULL) {
+            return -1;
+        }
+        memset(slots, 0, size * sizeof(int));
+        for (int category = 0; category < interner->count; category++) {
+            unsigned int other = recommendation_category_hash(interner->names[category]) & (unsigned)(size - 1);
+            while (slots[other] != 0) {
+                other = (other + 1) & (unsigned)(size - 1);
+            }
+            slots[other] = category + 1;
+        }
+        interner->slots = slots;
+        interner->mask = size - 1;
+        slot = recommendation_category_hash(name) & (unsigned)interner->mask;
+        while (interner->slots[slot] != 0) {
+            slot = (slot + 1) & (unsigned)interner->mask;
+        }
+    }
+    
+    interner->names[interner->count] = name;
+    interner->slots[slot] = interner->count + 1;
+    return interner->count++;
+}
+
+// Soma à lista combinada o score pela posição de cada recomendação de uma fonte;
+// slots é uma tabela de dispersão (mask + 1 posições) com a posição + 1 de cada ID já combinado
+static void recommendation_merge_source(ContentScore *combined, int *combined_count, int *slots, int mask,
+                                        const int *source, int count, float weight) {
+    for (int i = 0; i < count; i++) {
+        float score = weight * (float)(count - i) / count;
+        unsigned int slot = ((unsigned)source[i] * 2654435761u) & (unsigned)mask;
+        while (slots[slot] != 0 && combined[slots[slot] - 1].content_id != source[i]) {
+            slot = (slot + 1) & (unsigned)mask;
+        }
+        
+        if (slots[slot] != 0) {
+            combined[slots[slot] - 1].score += score;
+        } else {
+            combined[*combined_count].content_id = source[i];
+            combined[*combined_count].score = score;
+            slots[slot] = ++(*combined_count);
+        }
+    }
+}
+
+// Dados do catálogo partilhados pelos pedidos personalizados (só leitura depois de construídos)
+typedef struct {
+    const Content *items;       // Conteúdos do catálogo
+    int content_count;          // Número de conteúdos
+    int *categories;            // Categoria interna de cada conteúdo
+    int *age_ratings;           // Classificação etária de cada conteúdo
+    int *durations;             // Duração de cada conteúdo
+    int category_total;         // Número de categorias internas
+    int *id_slots;              // Tabela de dispersão ID -> primeira posição no catálogo + 1 (0 = vazia)
+    int id_mask;                // Posições da tabela - 1
+    int popularity[MAX_RECOMMENDATIONS]; // Lista de recommendation_by_popularity
+    int popularity_count;       // Número de IDs na lista de popularidade
+} PersonalizedCatalog;
+
+// Primeira posição de um ID no catálogo partilhado (-1 se não estiver no catálogo)
+static int recommendation_catalog_position(const PersonalizedCatalog *shared, int id) {
+    unsigned int slot = ((unsigned)id * 2654435761u) & (unsigned)shared->id_mask;
+    while (shared->id_slots[slot] != 0) {
+        int position = shared->id_slots[slot] - 1;
+        if (shared->items[position].id == id) {
+            return position;
+        }
+        slot = (slot + 1) & (unsigned)shared->id_mask;
+    }
+    return -1;
+}
+
+// Uma passagem pelo catálogo: colunas para o cálculo vetorizado, categorias internas,
+// posição de cada ID e lista de popularidade
+static int recommendation_catalog_prepare(PersonalizedCatalog *shared, ContentCatalog *content_catalog, 
+                                          Arena *arena) {
+    int content_count;
+    const Content *items = content_snapshot(content_catalog, &content_count);
+    
+    shared->id_mask = 63;
+    while (shared->id_mask + 1 < 2 * (content_count + 1)) {
+        shared->id_mask = 2 * shared->id_mask + 1;
+    }
+    shared->items = items;
+    shared->content_count = content_count;
+    shared->categories = (int*)arena_alloc(arena, (content_count + 1) * sizeof(int));
+    shared->age_ratings = (int*)arena_alloc(arena, (content_count + 1) * sizeof(int));
+    shared->durations = (int*)arena_alloc(arena, (content_count + 1) * sizeof(int));
+    shared->id_slots = (int*)arena_alloc(arena, (shared->id_mask + 1) * sizeof(int));
+    CategoryInterner interner;
+    TopK popular;
+    if (shared->categories == NULL || shared->age_ratings == NULL || shared->durations == NULL ||
+        shared->id_slots == NULL || !recommendation_interner_init(&interner, arena, content_count) ||
+        !topk_init(&popular, MAX_RECOMMENDATIONS)) {
+        return 0;
+    }
+    memset(shared->id_slots, 0, (shared->id_mask + 1) * sizeof(int));
+    
+    for (int i = 0; i < content_count; i++) {
+        const Content *content = &items[i];
+        shared->categories[i] = recommendation_intern(&interner, content->category);
+        shared->age_ratings[i] = content->age_rating;
+        shared->durations[i] = content->duration;
+        topk_push(&popular, content->id, (float)content_get_views(content_catalog, content));
+        
+        unsigned int slot = ((unsigned)content->id * 2654435761u) & (unsigned)shared->id_mask;
+        while (shared->id_slots[slot] != 0 && items[shared->id_slots[slot] - 1].id != content->id) {
+            slot = (slot + 1) & (unsigned)shared->id_mask;
+        }
+        if (shared->id_slots[slot] == 0) {
+            shared->id_slots[slot] = i + 1;
+        }
+    }
+    
+    shared->category_total = interner.count;
+    shared->popularity_count = topk_extract(&popular, shared->popularity, MAX_RECOMMENDATIONS);
+    topk_free(&popular);
+    return 1;
+}
+
+// Recomendações personalizadas de um utilizador sobre os dados partilhados do catálogo, com o
+// score combinado de cada uma em scores (pode ser NULL); os buffers temporários vêm da arena da thread atual
+static int recommendation_personalized_user(UserManager *user_manager, const PersonalizedCatalog *shared,
+                                            int user_id, int *recommendations, float *scores, 
+                                            int max_recommendations) {
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    
+    // Uma passagem pelo histórico: o bloco do utilizador no prefixo ordenado e depois as
+    // interações registadas após a ordenação, pela mesma ordem que uma passagem pelo array todo
+    int watched_ids[100];
+    int watched_count = 0;
+    int played_capacity = 64, played_count = 0;
+    int *played = (int*)arena_alloc(scratch, played_capacity * sizeof(int));
+    int block_count;
+    const Interaction *block = user_get_interactions(user_manager, user_id, &block_count);
+    int tail_start = user_manager->order.count;
+    
+    for (int part = 0; part < 2 && played != NULL; part++) {
+        const Interaction *interactions = part == 0 ? block : user_manager->interactions + tail_start;
+        int count = part == 0 ? block_count : user_manager->interaction_count - tail_start;
+        
+        for (int i = 0; i < count; i++) {
+            const Interaction *interaction = &interactions[i];
+            if (interaction->user_id != user_id || 
+                (interaction->type != INTERACTION_PLAY && interaction->type != INTERACTION_COMPLETE)) {
+                continue;
+            }
+            
+            // Assistidos da similaridade: os primeiros 100 IDs distintos com COMPLETE
+            if (interaction->type == INTERACTION_COMPLETE && watched_count < 100) {
+                int exists = 0;
+                for (int j = 0; j < watched_count && !exists; j++) {
+                    exists = watched_ids[j] == interaction->content_id;
+                }
+                if (!exists) {
+                    watched_ids[watched_count++] = interaction->content_id;
+                }
+            }
+            
+            // Conteúdos com PLAY ou COMPLETE, para as categorias
+            if (played_count == played_capacity) {
+                int *grown = (int*)arena_alloc(scratch, 2 * played_capacity * sizeof(int));
+                if (grown == NULL) {
+                    played = NULL;
+                    break;
+                }
+                memcpy(grown, played, played_count * sizeof(int));
+                played = grown;
+                played_capacity *= 2;
+            }
+            played[played_count++] = interaction->content_id;
+        }
+    }
+    
+    int history_mask = 63;
+    while (history_mask + 1 < 2 * (played_count + 1)) {
+        history_mask = 2 * history_mask + 1;
     }
+    HistoryEntry *history = (HistoryEntry*)arena_alloc(scratch, (history_mask + 1) * sizeof(HistoryEntry));
     
+    int content_count = shared->content_count;
+    const int *categories = shared->categories;
+    float *similarity = (float*)arena_alloc(scratch, (content_count + 1) * sizeof(float));
+    int *category_rank = (int*)arena_alloc(scratch, (shared->category_total + 1) * sizeof(int));
+    TopK similar, by_category;
+    if (played == NULL || history == NULL || similarity == NULL || category_rank == NULL) {
+        arena_reset_to(scratch, mark);
+        return 0;
+    }
+    
+    memset(history, 0, (history_mask + 1) * sizeof(HistoryEntry));
+    for (int i = 0; i < played_count; i++) {
+        if (played[i] > 0) {
+            HistoryEntry *entry = recommendation_history_slot(history, history_mask, played[i], 1);
+            if (entry->item < 0) {
+                entry->item = recommendation_catalog_position(shared, played[i]);
+            }
+        }
+    }
+    for (int j = 0; j < watched_count; j++) {
+        if (watched_ids[j] > 0) {
+            recommendation_history_slot(history, history_mask, watched_ids[j], 0)->excluded = 1;
+        }
+    }
+    
+    // Similaridade: soma, pela ordem dos assistidos, da similaridade com cada candidato
+    memset(similarity, 0, (content_count + 1) * sizeof(float));
+    for (int j = 0; j < watched_count; j++) {
+        HistoryEntry *entry = watched_ids[j] > 0 ? 
+                              recommendation_history_slot(history, history_mask, watched_ids[j], 0) : NULL;
+        if (entry != NULL && entry->item >= 0) {
+            simkernel_accumulate(categories[entry->item], shared->age_ratings[entry->item], 
+                                 shared->durations[entry->item], categories, shared->age_ratings, 
+                                 shared->durations, content_count, similarity);
+        }
+    }
+    
+    // Categorias assistidas por ordem de aparecimento, ordenadas por frequência como em
+    // recommendation_by_category
+    int category_ids[100];
+    int category_counts[100] = {0};
+    int category_count = 0;
+    for (int i = 0; i < played_count; i++) {
+        HistoryEntry *entry = played[i] > 0 ? 
+                              recommendation_history_slot(history, history_mask, played[i], 0) : NULL;
+        if (entry == NULL || entry->item < 0) {
+            continue;
+        }
+        
+        int category_index = -1;
+        for (int j = 0; j < category_count && category_index < 0; j++) {
+            if (category_ids[j] == categories[entry->item]) {
+                category_index = j;
+            }
+        }
+        if (category_index >= 0) {
+            category_counts[category_index]++;
+        } else if (category_count < 100) {
+            category_ids[category_count] = categories[entry->item];
+            category_counts[category_count] = 1;
+            category_count++;
+        }
+    }
+    for (int i = 0; i < category_count - 1; i++) {
+        for (int j = i + 1; j < category_count; j++) {
+            if (category_counts[j] > category_counts[i]) {
+                int temp_count = category_counts[i];
+                category_counts[i] = category_counts[j];
+                category_counts[j] = temp_count;
+                int temp_id = category_ids[i];
+                category_ids[i] = category_ids[j];
+                category_ids[j] = temp_id;
+            }
+        }
+    }
+    if (!topk_init(&similar, MAX_RECOMMENDATIONS)) {
+        arena_reset_to(scratch, mark);
+        return 0;
+    }
+    if (!topk_init(&by_category, MAX_RECOMMENDATIONS)) {
+        topk_free(&similar);
+        arena_reset_to(scratch, mark);
+        return 0;
+    }
+    for (int category = 0; category < shared->category_total; category++) {
+        category_rank[category] = -1;
+    }
+    for (int j = 0; j < category_count; j++) {
+        category_rank[category_ids[j]] = j;
+    }
+    
+    // Scores de similaridade e de categoria de cada candidato, pela ordem do catálogo
+    User *user = user_get_by_id(user_manager, user_id);
+    const Bitmap *watched = user != NULL ? user->watched : NULL;
+    for (int i = 0; i < content_count; i++) {
+        int id = shared->items[i].id;
+        
+        if (watched_count > 0) {
+            HistoryEntry *entry = id > 0 ? recommendation_history_slot(history, history_mask, id, 0) : NULL;
+            float score = similarity[i] / watched_count;
+            if ((entry == NULL || !entry->excluded) && score >= 0.0f) {
+                topk_push(&similar, id, score);
+            }
+        }
+        
+        int category_index = categories[i] >= 0 ? category_rank[categories[i]] : -1;
+        if (category_index >= 0 && (id <= 0 || !bitmap_contains(watched, (uint32_t)id))) {
+            float score = (float)(category_count - category_index) +
+                          (float)category_counts[category_index] / 
+                          (category_counts[0] > 0 ? category_counts[0] : 1);
+            topk_push(&by_category, id, score);
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    // Sem histórico, a similaridade e a categoria devolvem a lista de popularidade
+    int similarity_recs[MAX_RECOMMENDATIONS];
+    int category_recs[MAX_RECOMMENDATIONS];
+    int collaborative_recs[MAX_RECOMMENDATIONS];
+    
+    int similarity_count = topk_extract(&similar, similarity_recs, MAX_RECOMMENDATIONS);
+    int category_count_recs = topk_extract(&by_category, category_recs, MAX_RECOMMENDATIONS);
+    topk_free(&similar);
+    topk_free(&by_category);
+    if (watched_count == 0) {
+        memcpy(similarity_recs, shared->popularity, shared->popularity_count * sizeof(int));
+        similarity_count = shared->popularity_count;
+    }
+    if (category_count == 0) {
+        memcpy(category_recs, shared->popularity, shared->popularity_count * sizeof(int));
+        category_count_recs = shared->popularity_count;
+    }
+    
+    int collaborative_count = recommendation_by_collaborative(
+        user_manager, user_id, collaborative_recs, MAX_RECOMMENDATIONS);
+    
+    // Combinar com os mesmos pesos e pela mesma ordem de recommendation_personalized_reference
+    ContentScore combined_scores[4 * MAX_RECOMMENDATIONS];
+    int combined_slots[128];    // Potência de 2 acima do dobro das entradas possíveis
+    int combined_count = 0;
+    int combined_mask = 127;
+    memset(combined_slots, 0, sizeof(combined_slots));
+    recommendation_merge_source(combined_scores, &combined_count, combined_slots, combined_mask,
+                                similarity_recs, similarity_count, 3.0f);
+    recommendation_merge_source(combined_scores, &combined_count, combined_slots, combined_mask,
+                                collaborative_recs, collaborative_count, 2.5f);
+    recommendation_merge_source(combined_scores, &combined_count, combined_slots, combined_mask,
+                                category_recs, category_count_recs, 2.0f);
+    recommendation_merge_source(combined_scores, &combined_count, combined_slots, combined_mask,
+                                shared->popularity, shared->popularity_count, 1.0f);
+    
+    TopK best;
+    if (!topk_init(&best, max_recommendations)) {
+        return 0;
+    }
+    for (int i = 0; i < combined_count; i++) {
+        topk_push(&best, combined_scores[i].content_id, combined_scores[i].score);
+    }
+    
+    int recommendation_count = topk_extract_scored(&best, recommendations, scores, max_recommendations);
+    topk_free(&best);
     return recommendation_count;
 }
 
-int recommendation_has_watched(UserManager *user_manager, int user_id, int content_id) {
-    if (user_manager == NULL || user_id <= 0 || content_id <= 0) {
+// Corpo de recommendation_personalized, com a época do catálogo já fixada pelo chamador
+static int recommendation_personalized_pinned(UserManager *user_manager, 
+                                            ContentCatalog *content_catalog,
+                                            int user_id, 
+                                            int *recommendations, 
+                                            int max_recommendations) {
+    if (user_manager == NULL || content_catalog == NULL || 
+        user_id <= 0 || recommendations == NULL || max_recommendations <= 0) {
         return 0;
     }
     
-    for (int i = 0; i < user_manager->interaction_count; i++) {
-        Interaction *interaction = &user_manager->interactions[i];
+    // Lista pré-calculada, se o utilizador estiver na tabela e o registo ainda valer
+    RecommendationTable *table = recommendation_table;
+    if (table != NULL && table->manager == user_manager && table->catalog == content_catalog) {
+        int count = recommendation_table_lookup(table, user_id, recommendations, NULL, max_recommendations);
+        if (count >= 0) {
+            return count;
+        }
+    }
+    
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    PersonalizedCatalog shared;
+    int recommendation_count = 0;
+    if (recommendation_catalog_prepare(&shared, content_catalog, scratch)) {
+        recommendation_count = recommendation_personalized_user(user_manager, &shared, user_id, 
+                                                                recommendations, NULL, max_recommendations);
+    }
+    arena_reset_to(scratch, mark);
+    return recommendation_count;
+}
+
+int recommendation_personalized(UserManager *user_manager, 
+                              ContentCatalog *content_catalog,
+                              int user_id, 
+                              int *recommendations, 
+                              int max_recommendations) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(content_catalog)) {
+        return 0;
+    }
+    int count = recommendation_personalized_pinned(user_manager, content_catalog, user_id, 
+                                                   recommendations, max_recommendations);
+    content_read_end(content_catalog);
+    return count;
+}
+
+// Cabeçalho do ficheiro binário de recommendation_batch_all (64 bytes)
+typedef struct {
+    char magic[8];              // RECOMMENDATION_BATCH_MAGIC
+    int32_t max_recommendations; // K: IDs e scores por registo
+    int32_t user_count;         // Número de registos
+    int32_t index_slots;        // Posições do índice ID -> registo (potência de 2)
+    int32_t reserved;           // 0
+    int64_t created;            // Hora da geração
+    int64_t records_offset;     // Início dos registos
+    int64_t index_offset;       // Início do índice
+    char padding[16];           // 0
+} RecommendationTableHeader;
+
+// Pedidos de uma janela de utilizadores do processamento em lote
+typedef struct {
+    UserManager *manager;
+    const PersonalizedCatalog *shared;
+    const int *user_ids;        // IDs da janela, por ordem crescente
+    int32_t *records;           // Registo de cada utilizador: ID, número, K IDs e K scores
+    int max_recommendations;
+} RecommendationBatch;
+
+// Calcula os registos dos utilizadores [begin, end) da janela
+static void recommendation_batch_range(void *context, int begin, int end) {
+    RecommendationBatch *batch = (RecommendationBatch*)context;
+    int record_size = 2 + 2 * batch->max_recommendations;
+    
+    for (int i = begin; i < end; i++) {
+        int32_t *record = batch->records + (size_t)i * record_size;
+        int *ids = (int*)(record + 2);
+        float *scores = (float*)(record + 2 + batch->max_recommendations);
         
-        if (interaction->user_id == user_id && 
-            interaction->content_id == content_id && 
-            (interaction->type == INTERACTION_COMPLETE || interaction->type == INTERACTION_PLAY)) {
-            return 1; // Utilizador já assistiu
+        memset(record, 0, record_size * sizeof(int32_t));
+        record[0] = batch->user_ids[i];
+        record[1] = recommendation_personalized_user(batch->manager, batch->shared, batch->user_ids[i],
+                                                     ids, scores, batch->max_recommendations);
+    }
+}
+
+static int recommendation_compare_ids(const void *a, const void *b) {
+    int id1 = *(const int*)a;
+    int id2 = *(const int*)b;
+    return (id1 > id2) - (id1 < id2);
+}
+
+// Posições do índice ID -> registo para user_count utilizadores (ocupação até metade)
+static int recommendation_table_slots(int user_count) {
+    int slots = 16;
+    while (slots < 2 * user_count) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+// Corpo de recommendation_batch_all, com a época do catálogo já fixada pelo chamador
+static int recommendation_batch_all_pinned(UserManager *user_manager, ContentCatalog *content_catalog, 
+                                           int max_recommendations, const char *filename, 
+                                           RecommendationBatchFormat format, ThreadPool *pool) {
+    if (user_manager == NULL || content_catalog == NULL || max_recommendations <= 0 || filename == NULL) {
+        return -1;
+    }
+    
+    int user_count = user_manager->count;
+    int record_size = 2 + 2 * max_recommendations;
+    int window = user_count < RECOMMENDATION_BATCH_WINDOW ? user_count : RECOMMENDATION_BATCH_WINDOW;
+    int *user_ids = (int*)malloc((user_count > 0 ? user_count : 1) * sizeof(int));
+    int32_t *records = (int32_t*)malloc((size_t)(window > 0 ? window : 1) * record_size * sizeof(int32_t));
+    FILE *file = fopen(filename, format == RECOMMENDATION_BATCH_BINARY ? "wb" : "w");
+    if (user_ids == NULL || records == NULL || file == NULL) {
+        free(user_ids);
+        free(records);
+        if (file != NULL) {
+            fclose(file);
+        }
+        return -1;
+    }
+    
+    for (int i = 0; i < user_count; i++) {
+        user_ids[i] = user_manager->users[i].id;
+    }
+    qsort(user_ids, user_count, sizeof(int), recommendation_compare_ids);
+    
+    // Os dados partilhados ficam abaixo das marcas das tarefas desta thread
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    PersonalizedCatalog shared;
+    int ok = recommendation_catalog_prepare(&shared, content_catalog, scratch);
+    int index_slots = recommendation_table_slots(user_count);
+    
+    if (ok && format == RECOMMENDATION_BATCH_BINARY) {
+        RecommendationTableHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, RECOMMENDATION_BATCH_MAGIC, strlen(RECOMMENDATION_BATCH_MAGIC));
+        header.max_recommendations = max_recommendations;
+        header.user_count = user_count;
+        header.index_slots = index_slots;
+        header.created = (int64_t)time(NULL);
+        header.records_offset = (int64_t)sizeof(header);
+        header.index_offset = header.records_offset + (int64_t)user_count * record_size * sizeof(int32_t);
+        ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    } else if (ok) {
+        ok = fprintf(file, "Utilizador,Posicao,Conteudo,Score\n") > 0;
+    }
+    
+    RecommendationBatch batch;
+    batch.manager = user_manager;
+    batch.shared = &shared;
+    batch.records = records;
+    batch.max_recommendations = max_recommendations;
+    
+    // Janela a janela: calcular em paralelo e gravar pela ordem dos IDs
+    for (int start = 0; ok && start < user_count; start += window) {
+        int count = user_count - start < window ? user_count - start : window;
+        batch.user_ids = user_ids + start;
+        threadpool_parallel_for(pool, 0, count, 16, recommendation_batch_range, &batch);
+        
+        if (format == RECOMMENDATION_BATCH_BINARY) {
+            ok = fwrite(records, sizeof(int32_t) * record_size, count, file) == (size_t)count;
+            continue;
+        }
+        for (int i = 0; i < count && ok; i++) {
+            const int32_t *record = records + (size_t)i * record_size;
+            const float *scores = (const float*)(record + 2 + max_recommendations);
+            for (int rank = 0; rank < record[1] && ok; rank++) {
+                ok = fprintf(file, "%d,%d,%d,%.4f\n", (int)record[0], rank + 1, 
+                             (int)record[2 + rank], scores[rank]) > 0;
+            }
+        }
+    }
+    arena_reset_to(scratch, mark);
+    
+    // Índice ID -> registo + 1 (0 = vazio), por dispersão com sondagem linear
+    if (ok && format == RECOMMENDATION_BATCH_BINARY) {
+        int32_t *index = (int32_t*)calloc(index_slots, sizeof(int32_t));
+        ok = index != NULL;
+        for (int row = 0; ok && row < user_count; row++) {
+            unsigned int slot = ((unsigned)user_ids[row] * 2654435761u) & (unsigned)(index_slots - 1);
+            while (index[slot] != 0) {
+                slot = (slot + 1) & (unsigned)(index_slots - 1);
+            }
+            index[slot] = row + 1;
         }
+        ok = ok && fwrite(index, sizeof(int32_t), index_slots, file) == (size_t)index_slots;
+        free(index);
     }
     
-    return 0; // Utilizador não assistiu
+    free(user_ids);
+    free(records);
+    if (fclose(file) != 0) {
+        ok = 0;
+    }
+    return ok ? user_count : -1;
+}
+
+int recommendation_batch_all(UserManager *user_manager, ContentCatalog *content_catalog, int max_recommendations,
+                             const char *filename, RecommendationBatchFormat format, ThreadPool *pool) {
+    // Os conteúdos lidos pertencem à versão publicada, que não pode ser libertada até ao fim
+    if (!content_read_begin(content_catalog)) {
+        return -1;
+    }
+    int count = recommendation_batch_all_pinned(user_manager, content_catalog, max_recommendations, 
+                                                filename, format, pool);
+    content_read_end(content_catalog);
+    return count;
+}
+
+// Observador do catálogo: conteúdos editados ou removidos podem estar nas listas gravadas
+static void recommendation_table_on_change(void *context, int id, ContentChange change) {
+    RecommendationTable *table = (RecommendationTable*)context;
+    (void)id;
+    if (change != CONTENT_CHANGE_ADD) {
+        __atomic_store_n(&table->catalog_stale, 1, __ATOMIC_SEQ_CST);
+    }
 }
 
-float recommendation_calculate_similarity(Content *content1, Content *content2) {
+// Registo de um utilizador no índice (-1 se não estiver na tabela)
+static int recommendation_table_row(const RecommendationTable *table, int user_id) {
+    unsigned int mask = (unsigned)table->index_slots - 1;
+    unsigned int slot = ((unsigned)user_id * 2654435761u) & mask;
+    for (int probes = 0; probes < table->index_slots && table->index[slot] != 0; probes++) {
+        int row = table->index[slot] - 1;
+        if (row >= 0 && row < table->user_count && 
+            table->records[(size_t)row * table->record_size] == user_id) {
+            return row;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+int recommendation_table_open(RecommendationTable *table, const char *filename, 
+                              UserManager *user_manager, ContentCatalog *content_catalog) {
+    if (table == NULL || filename == NULL || user_manager == NULL || content_catalog == NULL) {
+        return 0;
+    }
+    
+    memset(table, 0, sizeof(RecommendationTable));
+    size_t size = 0;
+    void *mapping = mapfile_open(filename, &size);
+    if (mapping == NULL) {
+        return 0;
+    }
+    
+    // Validar o cabeçalho e o tamanho de cada secção antes de confiar nos deslocamentos
+    const RecommendationTableHeader *header = (const RecommendationTableHeader*)mapping;
+    int valid = size >= sizeof(RecommendationTableHeader) &&
+                memcmp(header->magic, RECOMMENDATION_BATCH_MAGIC, strlen(RECOMMENDATION_BATCH_MAGIC) + 1) == 0 &&
+                header->max_recommendations > 0 && header->user_count >= 0 &&
+                header->index_slots >= 16 && (header->index_slots & (header->index_slots - 1)) == 0 &&
+                header->index_slots >= header->user_count &&
+                header->records_offset == (int64_t)sizeof(RecommendationTableHeader);
+    if (valid) {
+        int64_t record_bytes = (2 + 2 * (int64_t)header->max_recommendations) * (int64_t)sizeof(int32_t);
+        valid = header->index_offset == header->records_offset + header->user_count * record_bytes &&
+                (int64_t)size >= header->index_offset + header->index_slots * (int64_t)sizeof(int32_t);
+    }
+    
+    unsigned char *stale = valid ? (unsigned char*)calloc(header->user_count + 1, 1) : NULL;
+    if (stale == NULL || !content_add_change_listener(content_catalog, recommendation_table_on_change, table)) {
+        free(stale);
+        mapfile_close(mapping, size);
+        return 0;
+    }
+    
+    table->mapping = mapping;
+    table->mapping_size = size;
+    table->max_recommendations = header->max_recommendations;
+    table->user_count = header->user_count;
+    table->index_slots = header->index_slots;
+    table->record_size = 2 + 2 * header->max_recommendations;
+    table->created = (long long)header->created;
+    table->records = (const int32_t*)((const char*)mapping + header->records_offset);
+    table->index = (const int32_t*)((const char*)mapping + header->index_offset);
+    table->stale = stale;
+    table->manager = user_manager;
+    table->catalog = content_catalog;
+    table->revision = user_manager->revision;
+    return 1;
+}
+
+void recommendation_table_free(RecommendationTable *table) {
+    if (table == NULL || table->mapping == NULL) {
+        return;
+    }
+    
+    content_remove_change_listener(table->catalog, table);
+    mapfile_close(table->mapping, table->mapping_size);
+    free(table->stale);
+    memset(table, 0, sizeof(RecommendationTable));
+}
+
+int recommendation_table_lookup(RecommendationTable *table, int user_id, 
+                                int *recommendations, float *scores, int max_recommendations) {
+    if (table == NULL || table->mapping == NULL || recommendations == NULL || 
+        max_recommendations <= 0 || max_recommendations > table->max_recommendations ||
+        __atomic_load_n(&table->catalog_stale, __ATOMIC_SEQ_CST)) {
+        return -1;
+    }
+    
+    // Interações registadas depois da abertura dão ao utilizador uma revisão mais recente; as
+    // carregadas antes da abertura mas posteriores à geração do ficheiro têm timestamp mais recente
+    User *user = user_get_by_id(table->manager, user_id);
+    int fresh = user != NULL && user->revision <= table->revision && 
+                (long long)user->last_interaction <= table->created;
+    int row = fresh ? recommendation_table_row(table, user_id) : -1;
+    if (row < 0 || __atomic_load_n(&table->stale[row], __ATOMIC_SEQ_CST)) {
+        return -1;
+    }
+    
+    const int32_t *record = table->records + (size_t)row * table->record_size;
+    int count = record[1] < max_recommendations ? record[1] : max_recommendations;
+    if (count < 0) {
+        return -1;
+    }
+    memcpy(recommendations, record + 2, count * sizeof(int));
+    if (scores != NULL) {
+        memcpy(scores, record + 2 + table->max_recommendations, count * sizeof(float));
+    }
+    return count;
+}
+
+int recommendation_table_mark_stale(RecommendationTable *table, int user_id) {
+    if (table == NULL || table->mapping == NULL) {
+        return 0;
+    }
+    
+    int row = recommendation_table_row(table, user_id);
+    if (row < 0) {
+        return 0;
+    }
+    __atomic_store_n(&table->stale[row], 1, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+void recommendation_set_table(RecommendationTable *table) {
+    recommendation_table = table;
+    __atomic_add_fetch(&recommendation_config_generation, 1, __ATOMIC_SEQ_CST);
+}
+
+void recommendation_set_neighbors(NeighborTable *table) {
+    recommendation_neighbors = table;
+    __atomic_add_fetch(&recommendation_config_generation, 1, __ATOMIC_SEQ_CST);
+}
+
+void recommendation_set_collab(CollabModel *model) {
+    recommendation_collab = model;
+    __atomic_add_fetch(&recommendation_config_generation, 1, __ATOMIC_SEQ_CST);
+}
+
+int recommendation_has_watched(UserManager *user_manager, int user_id, int content_id) {
+    if (user_manager == NULL || user_id <= 0 || content_id <= 0) {
+        return 0;
+    }
+    
+    return user_has_watched(user_manager, user_id, content_id);
+}
+
+float recommendation_calculate_similarity(const Content *content1, const Content *content2) {
     if (content1 == NULL || content2 == NULL) {
         return 0.0f;
     }
@@ -386,4 +1357,289 @@ float recommendation_calculate_similarity(Content *content1, Content *content2)
     }
     
     return similarity; // Valor entre 0 e 1
-}
\ No newline at end of file
+}
+
+// Observador do catálogo: qualquer alteração pode mudar o resultado de qualquer utilizador
+static void recommendation_cache_on_change(void *context, int id, ContentChange change) {
+    RecommendationCache *cache = (RecommendationCache*)context;
+    (void)id;
+    (void)change;
+    __atomic_add_fetch(&cache->catalog_generation, 1, __ATOMIC_SEQ_CST);
+}
+
+// Posição da tabela de dispersão de uma chave
+static int recommendation_cache_bucket(const RecommendationCache *cache, int user_id, 
+                                       RecommendationMethod method, int requested) {
+    unsigned int hash = (unsigned)user_id * 2654435761u;
+    hash ^= ((unsigned)method << 8) ^ (unsigned)requested;
+    hash *= 2654435761u;
+    return (int)((hash >> 8) & (unsigned)cache->bucket_mask);
+}
+
+// Procura a entrada de uma chave (-1 se não existir)
+static int recommendation_cache_find(const RecommendationCache *cache, int user_id, 
+                                     RecommendationMethod method, int requested) {
+    int slot = cache->buckets[recommendation_cache_bucket(cache, user_id, method, requested)];
+    while (slot != -1) {
+        const RecommendationCacheEntry *entry = &cache->entries[slot];
+        if (entry->user_id == user_id && entry->method == method && entry->requested == requested) {
+            return slot;
+        }
+        slot = entry->chain;
+    }
+    return -1;
+}
+
+// Retira uma entrada da lista LRU
+static void recommendation_cache_unlink(RecommendationCache *cache, int slot) {
+    RecommendationCacheEntry *entry = &cache->entries[slot];
+    
+    if (entry->previous != -1) {
+        cache->entries[entry->previous].next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+    if (entry->next != -1) {
+        cache->entries[entry->next].previous = entry->previous;
+    } else {
+        cache->tail = entry->previous;
+    }
+}
+
+// Coloca uma entrada no início da lista LRU (usada mais recentemente)
+static void recommendation_cache_push_front(RecommendationCache *cache, int slot) {
+    RecommendationCacheEntry *entry = &cache->entries[slot];
+    
+    entry->previous = -1;
+    entry->next = cache->head;
+    if (cache->head != -1) {
+        cache->entries[cache->head].previous = slot;
+    } else {
+        cache->tail = slot;
+    }
+    cache->head = slot;
+}
+
+// Remove uma entrada da tabela de dispersão e da lista LRU e devolve-a às livres
+static void recommendation_cache_drop(RecommendationCache *cache, int slot) {
+    RecommendationCacheEntry *entry = &cache->entries[slot];
+    int *link = &cache->buckets[recommendation_cache_bucket(cache, entry->user_id, 
+                                                            entry->method, entry->requested)];
+    
+    while (*link != slot) {
+        link = &cache->entries[*link].chain;
+    }
+    *link = entry->chain;
+    
+    recommendation_cache_unlink(cache, slot);
+    entry->next = cache->free_head;
+    cache->free_head = slot;
+    cache->count--;
+}
+
+// Calcula as recomendações de um método sem passar pela cache
+static int recommendation_cache_compute(RecommendationCache *cache, RecommendationMethod method, int user_id, 
+                                        int *recommendations, int max_recommendations) {
+    switch (method) {
+        case RECOMMENDATION_METHOD_SIMILARITY:
+            return recommendation_by_content_similarity(cache->manager, cache->catalog, user_id, 
+                                                        recommendations, max_recommendations);
+        case RECOMMENDATION_METHOD_CATEGORY:
+            return recommendation_by_category(cache->manager, cache->catalog, user_id, 
+                                              recommendations, max_recommendations);
+        case RECOMMENDATION_METHOD_POPULARITY:
+            return recommendation_by_popularity(cache->catalog, recommendations, max_recommendations);
+        case RECOMMENDATION_METHOD_COLLABORATIVE:
+            return recommendation_by_collaborative(cache->manager, user_id, 
+                                                   recommendations, max_recommendations);
+        case RECOMMENDATION_METHOD_PERSONALIZED:
+            return recommendation_personalized(cache->manager, cache->catalog, user_id, 
+                                               recommendations, max_recommendations);
+    }
+    return 0;
+}
+
+int recommendation_cache_init(RecommendationCache *cache, UserManager *user_manager, 
+                              ContentCatalog *content_catalog, int capacity) {
+    if (cache == NULL || user_manager == NULL || content_catalog == NULL || capacity <= 0) {
+        return 0;
+    }
+    
+    memset(cache, 0, sizeof(RecommendationCache));
+    
+    int bucket_count = 16;
+    while (bucket_count < capacity) {
+        bucket_count *= 2;
+    }
+    
+    cache->entries = (RecommendationCacheEntry*)malloc(capacity * sizeof(RecommendationCacheEntry));
+    cache->buckets = (int*)malloc(bucket_count * sizeof(int));
+    if (cache->entries == NULL || cache->buckets == NULL ||
+        pthread_mutex_init(&cache->lock, NULL) != 0) {
+        free(cache->entries);
+        free(cache->buckets);
+        return 0;
+    }
+    
+    if (!content_add_change_listener(content_catalog, recommendation_cache_on_change, cache)) {
+        pthread_mutex_destroy(&cache->lock);
+        free(cache->entries);
+        free(cache->buckets);
+        return 0;
+    }
+    
+    cache->capacity = capacity;
+    cache->bucket_mask = bucket_count - 1;
+    cache->manager = user_manager;
+    cache->catalog = content_catalog;
+    cache->catalog_generation = 1;
+    recommendation_cache_clear(cache);
+    return 1;
+}
+
+void recommendation_cache_free(RecommendationCache *cache) {
+    if (cache == NULL || cache->entries == NULL) {
+        return;
+    }
+    
+    content_remove_change_listener(cache->catalog, cache);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->entries);
+    free(cache->buckets);
+    cache->entries = NULL;
+    cache->buckets = NULL;
+    cache->capacity = 0;
+    cache->count = 0;
+}
+
+int recommendation_cached(RecommendationCache *cache, RecommendationMethod method, int user_id, 
+                          int *recommendations, int max_recommendations) {
+    if (cache == NULL || cache->entries == NULL || recommendations == NULL || max_recommendations <= 0) {
+        return 0;
+    }
+    
+    // A popularidade não depende do utilizador: um único resultado partilhado por todos
+    unsigned long user_revision = 0;
+    if (method == RECOMMENDATION_METHOD_POPULARITY) {
+        user_id = 0;
+    } else {
+        User *user = user_get_by_id(cache->manager, user_id);
+        if (user == NULL) {
+            pthread_mutex_lock(&cache->lock);
+            cache->stats.misses++;
+            pthread_mutex_unlock(&cache->lock);
+            return recommendation_cache_compute(cache, method, user_id, recommendations, max_recommendations);
+        }
+        user_revision = user->revision;
+    }
+    
+    // Lidas antes do cálculo: uma alteração durante o cálculo invalida o resultado no pedido seguinte
+    unsigned long catalog_generation = __atomic_load_n(&cache->catalog_generation, __ATOMIC_SEQ_CST);
+    unsigned long config_generation = __atomic_load_n(&recommendation_config_generation, __ATOMIC_SEQ_CST);
+    unsigned long neighbors_generation = neighbors_version(recommendation_neighbors);
+    unsigned long views_generation = content_views_generation(cache->catalog);
+    
+    pthread_mutex_lock(&cache->lock);
+    if (max_recommendations > RECOMMENDATION_CACHE_MAX_RESULTS) {
+        cache->stats.misses++;
+        pthread_mutex_unlock(&cache->lock);
+        return recommendation_cache_compute(cache, method, user_id, recommendations, max_recommendations);
+    }
+    
+    int slot = recommendation_cache_find(cache, user_id, method, max_recommendations);
+    if (slot != -1) {
+        RecommendationCacheEntry *entry = &cache->entries[slot];
+        if (entry->user_revision == user_revision && entry->catalog_generation == catalog_generation &&
+            entry->config_generation == config_generation && entry->neighbors_version == neighbors_generation &&
+            entry->views_generation == views_generation) {
+            int count = entry->count;
+            memcpy(recommendations, entry->results, count * sizeof(int));
+            recommendation_cache_unlink(cache, slot);
+            recommendation_cache_push_front(cache, slot);
+            cache->stats.hits++;
+            pthread_mutex_unlock(&cache->lock);
+            return count;
+        }
+        recommendation_cache_drop(cache, slot);
+        cache->stats.invalidations++;
+    }
+    cache->stats.misses++;
+    pthread_mutex_unlock(&cache->lock);
+    
+    // O cálculo corre fora do bloqueio para não atrasar os pedidos servidos pela cache
+    int count = recommendation_cache_compute(cache, method, user_id, recommendations, max_recommendations);
+    if (count < 0) {
+        return count;
+    }
+    
+    pthread_mutex_lock(&cache->lock);
+    
+    // Outra thread pode ter guardado a mesma chave entretanto
+    slot = recommendation_cache_find(cache, user_id, method, max_recommendations);
+    if (slot != -1) {
+        recommendation_cache_drop(cache, slot);
+    }
+    if (cache->free_head == -1) {
+        recommendation_cache_drop(cache, cache->tail);
+        cache->stats.evictions++;
+    }
+    
+    slot = cache->free_head;
+    RecommendationCacheEntry *entry = &cache->entries[slot];
+    cache->free_head = entry->next;
+    
+    entry->user_id = user_id;
+    entry->method = method;
+    entry->requested = max_recommendations;
+    entry->count = count;
+    entry->user_revision = user_revision;
+    entry->catalog_generation = catalog_generation;
+    entry->config_generation = config_generation;
+    entry->neighbors_version = neighbors_generation;
+    entry->views_generation = views_generation;
+    memcpy(entry->results, recommendations, count * sizeof(int));
+    
+    int bucket = recommendation_cache_bucket(cache, user_id, method, max_recommendations);
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = slot;
+    recommendation_cache_push_front(cache, slot);
+    cache->count++;
+    
+    pthread_mutex_unlock(&cache->lock);
+    return count;
+}
+
+void recommendation_cache_clear(RecommendationCache *cache) {
+    if (cache == NULL || cache->entries == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&cache->lock);
+    for (int i = 0; i <= cache->bucket_mask; i++) {
+        cache->buckets[i] = -1;
+    }
+    for (int i = 0; i < cache->capacity; i++) {
+        cache->entries[i].next = i + 1 < cache->capacity ? i + 1 : -1;
+    }
+    cache->free_head = 0;
+    cache->head = -1;
+    cache->tail = -1;
+    cache->count = 0;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void recommendation_cache_get_stats(RecommendationCache *cache, RecommendationCacheStats *stats) {
+    if (cache == NULL || stats == NULL) {
+        return;
+    }
+    
+    if (cache->entries == NULL) {
+        memset(stats, 0, sizeof(RecommendationCacheStats));
+        return;
+    }
+    
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    stats->entries = cache->count;
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -4,6 +4,8 @@
  * 
  * Este módulo contém funções e estruturas para recomendar conteúdos
  * aos utilizadores com base em seu histórico de visualização e interações.
+ * Os recomendadores leem apenas as interações em bruto: as que a retenção
+ * já agregou (ver user_compact_interactions) deixam de contar.
  */
 
 #ifndef RECOMMENDATION_H
@@ -12,10 +14,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <stdint.h>
 #include "content.h"
 #include "user.h"
+#include "neighbors.h"
+#include "collab.h"
+#include "threadpool.h"
 
 #define MAX_RECOMMENDATIONS 10
+#define RECOMMENDATION_CACHE_MAX_RESULTS 32
+#define RECOMMENDATION_BATCH_WINDOW 4096
+#define RECOMMENDATION_BATCH_MAGIC "SFRECS2"
 
 /**
  * @brief Estrutura que representa uma recomendação com seu score
@@ -25,6 +35,117 @@ typedef struct {
     float score;           /**< Pontuação de relevância da recomendação */
 } Recommendation;
 
+/**
+ * @brief Métodos de recomendação servidos pela cache
+ */
+typedef enum {
+    RECOMMENDATION_METHOD_SIMILARITY,    /**< recommendation_by_content_similarity */
+    RECOMMENDATION_METHOD_CATEGORY,      /**< recommendation_by_category */
+    RECOMMENDATION_METHOD_POPULARITY,    /**< recommendation_by_popularity (igual para todos os utilizadores) */
+    RECOMMENDATION_METHOD_COLLABORATIVE, /**< recommendation_by_collaborative */
+    RECOMMENDATION_METHOD_PERSONALIZED   /**< recommendation_personalized */
+} RecommendationMethod;
+
+/**
+ * @brief Formatos do ficheiro gerado por recommendation_batch_all
+ */
+typedef enum {
+    RECOMMENDATION_BATCH_CSV,    /**< Linhas Utilizador,Posicao,Conteudo */
+    RECOMMENDATION_BATCH_BINARY  /**< Tabela para recommendation_table_open (ver recommendation_batch_all) */
+} RecommendationBatchFormat;
+
+/**
+ * @brief Recomendações pré-calculadas, lidas de um ficheiro mapeado em memória
+ * 
+ * O ficheiro é o gerado por recommendation_batch_all em formato binário.
+ * Um registo deixa de valer quando o utilizador regista interações depois
+ * da abertura (User.revision), quando tem interações com timestamp
+ * posterior à geração do ficheiro (User.last_interaction, por exemplo
+ * carregadas de um CSV mais recente), quando é marcado com
+ * recommendation_table_mark_stale, ou, para todos, quando um conteúdo é
+ * editado ou removido; os conteúdos adicionados só entram na próxima
+ * geração da tabela.
+ */
+typedef struct {
+    void *mapping;              /**< Ficheiro mapeado em memória (NULL se fechada) */
+    size_t mapping_size;        /**< Tamanho do mapeamento */
+    int max_recommendations;    /**< K: recomendações por registo */
+    int user_count;             /**< Número de registos */
+    int index_slots;            /**< Posições do índice (potência de 2) */
+    int record_size;            /**< Inteiros de 32 bits por registo (2 + 2 * K) */
+    long long created;          /**< Hora da geração */
+    const int32_t *records;     /**< Registos, por ordem crescente de ID do utilizador */
+    const int32_t *index;       /**< Índice ID -> registo + 1 (0 = vazio) */
+    unsigned char *stale;       /**< 1 se o registo foi marcado como desatualizado */
+    int catalog_stale;          /**< 1 depois de um conteúdo ser editado ou removido */
+    UserManager *manager;       /**< Gerenciador dos utilizadores */
+    ContentCatalog *catalog;    /**< Catálogo observado */
+    unsigned long revision;     /**< Última revisão de utilizador atribuída na abertura */
+} RecommendationTable;
+
+/**
+ * @brief Resultado guardado na cache de recomendações
+ * 
+ * A chave é (utilizador, método, número pedido); a popularidade usa o
+ * utilizador 0. O resultado é válido enquanto a revisão do histórico do
+ * utilizador e as gerações do catálogo, da configuração e das
+ * visualizações forem as registadas. Todos os métodos podem recorrer à
+ * popularidade, que conta as visualizações consolidadas e as pendentes,
+ * por isso qualquer visualização registada invalida todas as entradas.
+ */
+typedef struct {
+    int user_id;                /**< ID do utilizador (0 para a popularidade) */
+    RecommendationMethod method; /**< Método de recomendação */
+    int requested;              /**< Número de recomendações pedido */
+    int count;                  /**< Número de recomendações guardadas */
+    unsigned long user_revision; /**< Revisão do histórico do utilizador no cálculo */
+    unsigned long catalog_generation; /**< Geração do catálogo no cálculo */
+    unsigned long config_generation; /**< Geração da tabela de vizinhos e do modelo colaborativo no cálculo */
+    unsigned long neighbors_version; /**< Versão das listas de vizinhos no cálculo (muda com neighbors_repair) */
+    unsigned long views_generation; /**< Geração das visualizações no cálculo */
+    int previous;               /**< Entrada usada mais recentemente antes desta (-1 se nenhuma) */
+    int next;                   /**< Entrada usada menos recentemente depois desta (-1 se nenhuma; próxima livre se não usada) */
+    int chain;                  /**< Próxima entrada na mesma posição da tabela de dispersão (-1 se nenhuma) */
+    int results[RECOMMENDATION_CACHE_MAX_RESULTS]; /**< IDs recomendados */
+} RecommendationCacheEntry;
+
+/**
+ * @brief Contadores da cache de recomendações
+ */
+typedef struct {
+    long hits;                  /**< Pedidos servidos pela cache */
+    long misses;                /**< Pedidos calculados (incluindo os que não podem ser guardados) */
+    long evictions;             /**< Entradas válidas descartadas por falta de espaço */
+    long invalidations;         /**< Entradas descartadas por o histórico, o catálogo ou a configuração terem mudado */
+    int entries;                /**< Entradas guardadas */
+} RecommendationCacheStats;
+
+/**
+ * @brief Cache LRU de resultados de recomendação
+ * 
+ * Observa o catálogo: cada content_add, content_edit e content_remove
+ * avança a geração do catálogo e invalida todas as entradas. As novas
+ * interações de um utilizador (que mudam User.revision) invalidam só as
+ * entradas desse utilizador, e recommendation_set_neighbors,
+ * recommendation_set_collab, as listas recalculadas por neighbors_repair
+ * e as visualizações registadas (content_views_generation) invalidam todas.
+ */
+typedef struct {
+    RecommendationCacheEntry *entries; /**< Entradas (capacity posições) */
+    int capacity;               /**< Número máximo de entradas */
+    int count;                  /**< Entradas em uso */
+    int *buckets;               /**< Primeira entrada de cada posição da tabela de dispersão (-1 se vazia) */
+    int bucket_mask;            /**< Número de posições da tabela menos 1 (potência de 2) */
+    int head;                   /**< Entrada usada mais recentemente (-1 se vazia) */
+    int tail;                   /**< Entrada usada menos recentemente (-1 se vazia) */
+    int free_head;              /**< Primeira entrada livre (-1 se nenhuma) */
+    UserManager *manager;       /**< Gerenciador dos utilizadores */
+    ContentCatalog *catalog;    /**< Catálogo observado */
+    unsigned long catalog_generation; /**< Avançada a cada alteração do catálogo */
+    RecommendationCacheStats stats; /**< Contadores */
+    pthread_mutex_t lock;       /**< Protege as entradas e os contadores */
+} RecommendationCache;
+
 /**
  * @brief Gera recomendações com base em conteúdos similares aos assistidos pelo utilizador
  * 
@@ -69,9 +190,32 @@ int recommendation_by_popularity(ContentCatalog *content_catalog,
                                 int *recommendations, 
                                 int max_recommendations);
 
+/**
+ * @brief Gera recomendações por filtragem colaborativa (conteúdos vistos pelos mesmos utilizadores)
+ * 
+ * @param user_manager Ponteiro para o gerenciador de utilizadores
+ * @param user_id ID do utilizador
+ * @param recommendations Array para armazenar os IDs dos conteúdos recomendados
+ * @param max_recommendations Tamanho máximo do array de recomendações
+ * @return int Número de recomendações geradas (0 sem modelo definido para o gerenciador)
+ */
+int recommendation_by_collaborative(UserManager *user_manager, 
+                                    int user_id, 
+                                    int *recommendations, 
+                                    int max_recommendations);
+
 /**
  * @brief Gera recomendações personalizadas combinando vários métodos
  * 
+ * Combina, por ordem de peso, similaridade de conteúdos, filtragem
+ * colaborativa (quando há modelo definido), categoria e popularidade: os
+ * 10 primeiros de cada fonte recebem um score pela posição, multiplicado
+ * pelo peso da fonte. As fontes de similaridade, categoria e popularidade
+ * são calculadas juntas, com uma passagem pelo histórico do utilizador e
+ * uma pelo catálogo, e a similaridade é sempre a exata (a tabela de
+ * vizinhos não é usada). Com uma tabela pré-calculada definida
+ * (recommendation_set_table), a lista é lida da tabela quando possível.
+ * 
  * @param user_manager Ponteiro para o gerenciador de utilizadores
  * @param content_catalog Ponteiro para o catálogo de conteúdos
  * @param user_id ID do utilizador
@@ -85,6 +229,111 @@ int recommendation_personalized(UserManager *user_manager,
                               int *recommendations, 
                               int max_recommendations);
 
+/**
+ * @brief Gera recomendações personalizadas chamando cada método em separado
+ * 
+ * Versão de referência de recommendation_personalized (para testes e
+ * benchmarks): sem tabela de vizinhos nem tabela pré-calculada definidas,
+ * produz a mesma lista.
+ * 
+ * @param user_manager Ponteiro para o gerenciador de utilizadores
+ * @param content_catalog Ponteiro para o catálogo de conteúdos
+ * @param user_id ID do utilizador
+ * @param recommendations Array para armazenar os IDs dos conteúdos recomendados
+ * @param max_recommendations Tamanho máximo do array de recomendações
+ * @return int Número de recomendações geradas
+ */
+int recommendation_personalized_reference(UserManager *user_manager, 
+                                        ContentCatalog *content_catalog,
+                                        int user_id, 
+                                        int *recommendations, 
+                                        int max_recommendations);
+
+/**
+ * @brief Gera as recomendações personalizadas de todos os utilizadores e grava-as num ficheiro
+ * 
+ * Os dados do catálogo (colunas de similaridade, categorias internas e
+ * lista de popularidade) são preparados uma vez e partilhados só para
+ * leitura; os utilizadores são repartidos pelas threads do conjunto, cada
+ * uma com os seus buffers temporários, em janelas de
+ * RECOMMENDATION_BATCH_WINDOW utilizadores gravadas à medida que ficam
+ * prontas. Cada utilizador recebe a mesma lista que
+ * recommendation_personalized e os utilizadores ficam por ordem crescente
+ * de ID.
+ * 
+ * O formato binário, na ordem de bytes da máquina, tem um cabeçalho de 64
+ * bytes (RECOMMENDATION_BATCH_MAGIC, K = max_recommendations, número de
+ * utilizadores, posições do índice, hora da geração e início dos registos
+ * e do índice), um registo de largura fixa por utilizador (ID, número de
+ * recomendações, K IDs em int32 e K scores em float, a zero depois das
+ * recomendações) e um índice por dispersão do ID do utilizador para o
+ * registo + 1 (0 = vazio), com ocupação até metade.
+ * 
+ * @param user_manager Ponteiro para o gerenciador de utilizadores
+ * @param content_catalog Ponteiro para o catálogo de conteúdos
+ * @param max_recommendations Número de recomendações por utilizador
+ * @param filename Nome do ficheiro
+ * @param format Formato do ficheiro
+ * @param pool Conjunto de threads (NULL para executar em série)
+ * @return int Número de utilizadores gravados, ou -1 em caso de erro
+ */
+int recommendation_batch_all(UserManager *user_manager, ContentCatalog *content_catalog, int max_recommendations,
+                             const char *filename, RecommendationBatchFormat format, ThreadPool *pool);
+
+/**
+ * @brief Abre um ficheiro de recomendações pré-calculadas, mapeando-o em memória
+ * 
+ * @param table Ponteiro para a tabela
+ * @param filename Ficheiro binário gerado por recommendation_batch_all
+ * @param user_manager Gerenciador dos utilizadores da tabela
+ * @param content_catalog Catálogo a observar
+ * @return int 1 se a abertura foi bem-sucedida, 0 caso contrário
+ */
+int recommendation_table_open(RecommendationTable *table, const char *filename, 
+                              UserManager *user_manager, ContentCatalog *content_catalog);
+
+/**
+ * @brief Desfaz o mapeamento da tabela e deixa de observar o catálogo
+ * 
+ * @param table Ponteiro para a tabela
+ */
+void recommendation_table_free(RecommendationTable *table);
+
+/**
+ * @brief Obtém as recomendações pré-calculadas de um utilizador, em tempo constante
+ * 
+ * @param table Ponteiro para a tabela
+ * @param user_id ID do utilizador
+ * @param recommendations Array para armazenar os IDs dos conteúdos recomendados
+ * @param scores Array para o score de cada recomendação (pode ser NULL)
+ * @param max_recommendations Tamanho máximo do array (até ao K da tabela)
+ * @return int Número de recomendações, ou -1 se o utilizador não estiver na tabela,
+ *             o registo estiver desatualizado ou o pedido exceder K
+ */
+int recommendation_table_lookup(RecommendationTable *table, int user_id, 
+                                int *recommendations, float *scores, int max_recommendations);
+
+/**
+ * @brief Marca o registo de um utilizador como desatualizado
+ * 
+ * @param table Ponteiro para a tabela
+ * @param user_id ID do utilizador
+ * @return int 1 se o utilizador estava na tabela, 0 caso contrário
+ */
+int recommendation_table_mark_stale(RecommendationTable *table, int user_id);
+
+/**
+ * @brief Define a tabela consultada por recommendation_personalized antes de calcular
+ * 
+ * Com uma tabela aberta sobre o gerenciador e o catálogo do pedido, os
+ * utilizadores com registo válido recebem a lista gravada; os restantes
+ * (ausentes, desatualizados ou pedidos acima de K) são calculados. Invalida
+ * as caches de recomendações.
+ * 
+ * @param table Ponteiro para a tabela (NULL para calcular sempre)
+ */
+void recommendation_set_table(RecommendationTable *table);
+
 /**
  * @brief Verifica se um utilizador já assistiu a um conteúdo
  * 
@@ -102,6 +351,82 @@ int recommendation_has_watched(UserManager *user_manager, int user_id, int conte
  * @param content2 Ponteiro para o segundo conteúdo
  * @return float Valor de similaridade entre 0 (nada similar) e 1 (idêntico)
  */
-float recommendation_calculate_similarity(Content *content1, Content *content2);
+float recommendation_calculate_similarity(const Content *content1, const Content *content2);
+
+/**
+ * @brief Define a tabela de vizinhos usada pelas recomendações por similaridade
+ * 
+ * Com uma tabela construída sobre o catálogo do pedido, as recomendações
+ * juntam as listas de vizinhos dos conteúdos assistidos; se as listas não
+ * chegarem para preencher o pedido, o catálogo todo é pontuado com a versão
+ * vetorizada (neighbors_score). Sem tabela, comparam o catálogo todo par a par.
+ * 
+ * Invalida as caches de recomendações.
+ * 
+ * @param table Ponteiro para a tabela (NULL para comparar sempre o catálogo todo)
+ */
+void recommendation_set_neighbors(NeighborTable *table);
+
+/**
+ * @brief Define o modelo de filtragem colaborativa usado pelas recomendações
+ * 
+ * Invalida as caches de recomendações; deve ser chamada de novo depois de
+ * reconstruir o modelo.
+ * 
+ * @param model Ponteiro para o modelo construído (NULL para não usar filtragem colaborativa)
+ */
+void recommendation_set_collab(CollabModel *model);
+
+/**
+ * @brief Inicializa uma cache vazia e passa a observar o catálogo
+ * 
+ * @param cache Ponteiro para a cache
+ * @param user_manager Ponteiro para o gerenciador de utilizadores
+ * @param content_catalog Ponteiro para o catálogo de conteúdos
+ * @param capacity Número máximo de resultados guardados (> 0)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int recommendation_cache_init(RecommendationCache *cache, UserManager *user_manager, 
+                              ContentCatalog *content_catalog, int capacity);
+
+/**
+ * @brief Liberta a memória da cache e deixa de observar o catálogo
+ * 
+ * @param cache Ponteiro para a cache
+ */
+void recommendation_cache_free(RecommendationCache *cache);
+
+/**
+ * @brief Gera recomendações por um método, reutilizando o resultado guardado quando ainda é válido
+ * 
+ * Devolve a mesma lista que a chamada direta ao método. Pedidos de mais de
+ * RECOMMENDATION_CACHE_MAX_RESULTS recomendações ou de utilizadores
+ * inexistentes são calculados sem passar pela cache. Pode ser chamada por
+ * várias threads em simultâneo.
+ * 
+ * @param cache Ponteiro para a cache
+ * @param method Método de recomendação
+ * @param user_id ID do utilizador (ignorado pela popularidade)
+ * @param recommendations Array para armazenar os IDs dos conteúdos recomendados
+ * @param max_recommendations Tamanho máximo do array de recomendações
+ * @return int Número de recomendações geradas
+ */
+int recommendation_cached(RecommendationCache *cache, RecommendationMethod method, int user_id, 
+                          int *recommendations, int max_recommendations);
+
+/**
+ * @brief Descarta todos os resultados guardados (os contadores mantêm-se)
+ * 
+ * @param cache Ponteiro para a cache
+ */
+void recommendation_cache_clear(RecommendationCache *cache);
+
+/**
+ * @brief Obtém os contadores da cache
+ * 
+ * @param cache Ponteiro para a cache
+ * @param stats Recebe os contadores
+ */
+void recommendation_cache_get_stats(RecommendationCache *cache, RecommendationCacheStats *stats);
 
 #endif /* RECOMMENDATION_H */
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include "report.h"
 #include "csvutil.h"
+#include "usershard.h"
 
 // Função de comparação para ordenação de conteúdos por visualizações (ordem decrescente)
 static int compare_content_views(const void *a, const void *b) {
@@ -37,17 +38,23 @@ int report_most_viewed_contents(ContentCatalog *content_catalog,
         return 0;
     }
     
-    // Copiar os dados para o array de resultados
-    int count = content_catalog->count < max_results ? content_catalog->count : max_results;
+    // Copiar os dados para o array de resultados (a versão lida fica fixada até ao fim da cópia)
+    if (!content_read_begin(content_catalog)) {
+        return 0;
+    }
+    int content_count;
+    const Content *items = content_snapshot(content_catalog, &content_count);
+    int count = content_count < max_results ? content_count : max_results;
     
     for (int i = 0; i < count; i++) {
-        Content *content = &content_catalog->items[i];
+        const Content *content = &items[i];
         
         results[i].content_id = content->id;
         strncpy(results[i].title, content->title, MAX_TITLE_LENGTH - 1);
         results[i].title[MAX_TITLE_LENGTH - 1] = '\0';
-        results[i].count = content->views;
+        results[i].count = content_get_views(content_catalog, content);
     }
+    content_read_end(content_catalog);
     
     // Ordenar por número de visualizações
     qsort(results, count, sizeof(ContentReportItem), compare_content_views);
@@ -66,8 +73,14 @@ int report_most_popular_categories(ContentCatalog *content_catalog,
     CategoryReportItem categories[100]; // Assumindo no máximo 100 categorias
     int category_count = 0;
     
-    for (int i = 0; i < content_catalog->count; i++) {
-        Content *content = &content_catalog->items[i];
+    if (!content_read_begin(content_catalog)) {
+        return 0;
+    }
+    int content_count;
+    const Content *items = content_snapshot(content_catalog, &content_count);
+    
+    for (int i = 0; i < content_count; i++) {
+        const Content *content = &items[i];
         
         // Verificar se a categoria já está na lista
         int category_index = -1;
@@ -79,14 +92,15 @@ int report_most_popular_categories(ContentCatalog *content_catalog,
         }
         
         if (category_index >= 0) {
-            categories[category_index].count += content->views;
+            categories[category_index].count += content_get_views(content_catalog, content);
         } else if (category_count < 100) {
             strncpy(categories[category_count].category, content->category, MAX_CATEGORY_LENGTH - 1);
             categories[category_count].category[MAX_CATEGORY_LENGTH - 1] = '\0';
-            categories[category_count].count = content->views;
+            categories[category_count].count = content_get_views(content_catalog, content);
             category_count++;
         }
     }
+    content_read_end(content_catalog);
     
     // Ordenar por popularidade
     qsort(categories, category_count, sizeof(CategoryReportItem), compare_category_popularity);
@@ -101,6 +115,59 @@ int report_most_popular_categories(ContentCatalog *content_catalog,
     return result_count;
 }
 
+// Ranking parcial dos utilizadores mais ativos de cada partição
+typedef struct {
+    UserReportItem *partials;   // max_results itens por partição
+    int *partial_counts;        // Itens preenchidos por partição
+    int max_results;
+} ActiveUsersScatter;
+
+// Calcula o ranking de uma partição (executado com a partição bloqueada)
+static void report_active_users_shard(UserManager *manager, int shard, void *context) {
+    ActiveUsersScatter *scatter = (ActiveUsersScatter*)context;
+    
+    scatter->partial_counts[shard] = report_most_active_users(manager, 
+                                     &scatter->partials[shard * scatter->max_results], 
+                                     scatter->max_results);
+}
+
+// Scatter-gather: cada partição ordena os seus utilizadores numa thread e os rankings são fundidos
+static int report_most_active_users_sharded(ShardedUserManager *sharded, 
+                                            UserReportItem *results, 
+                                            int max_results) {
+    ActiveUsersScatter scatter;
+    scatter.max_results = max_results;
+    scatter.partials = (UserReportItem*)malloc(sharded->shard_count * max_results * sizeof(UserReportItem));
+    scatter.partial_counts = (int*)calloc(sharded->shard_count, sizeof(int));
+    
+    if (scatter.partials == NULL || scatter.partial_counts == NULL) {
+        free(scatter.partials);
+        free(scatter.partial_counts);
+        return 0;
+    }
+    
+    usershard_scatter(sharded, report_active_users_shard, &scatter);
+    
+    // Juntar os rankings parciais e reordenar
+    int user_count = 0;
+    for (int shard = 0; shard < sharded->shard_count; shard++) {
+        for (int i = 0; i < scatter.partial_counts[shard]; i++) {
+            scatter.partials[user_count++] = scatter.partials[shard * max_results + i];
+        }
+    }
+    
+    qsort(scatter.partials, user_count, sizeof(UserReportItem), compare_user_activity);
+    
+    int result_count = user_count < max_results ? user_count : max_results;
+    for (int i = 0; i < result_count; i++) {
+        results[i] = scatter.partials[i];
+    }
+    
+    free(scatter.partials);
+    free(scatter.partial_counts);
+    return result_count;
+}
+
 int report_most_active_users(UserManager *user_manager, 
                             UserReportItem *results, 
                             int max_results) {
@@ -108,6 +175,10 @@ int report_most_active_users(UserManager *user_manager,
         return 0;
     }
     
+    if (user_manager->sharded != NULL) {
+        return report_most_active_users_sharded(user_manager->sharded, results, max_results);
+    }
+    
     // Contar interações por utilizadores
     UserReportItem users[1000]; // Assumindo no máximo 1000 utilizadores
     int user_count = 0;
@@ -155,6 +226,10 @@ int report_user_interactions(UserManager *user_manager,
     ContentReportItem interactions[1000]; // Assumindo no máximo 1000 conteúdos
     int interaction_count = 0;
     
+    // Os títulos são copiados da versão publicada, fixada enquanto se lê
+    if (!content_read_begin(content_catalog)) {
+        return 0;
+    }
     for (int i = 0; i < user_manager->interaction_count; i++) {
         Interaction *interaction = &user_manager->interactions[i];
         
@@ -171,7 +246,7 @@ int report_user_interactions(UserManager *user_manager,
             if (content_index >= 0) {
                 interactions[content_index].count++;
             } else if (interaction_count < 1000) {
-                Content *content = content_get_by_id(content_catalog, interaction->content_id);
+                const Content *content = content_get_by_id(content_catalog, interaction->content_id);
                 if (content != NULL) {
                     interactions[interaction_count].content_id = content->id;
                     strncpy(interactions[interaction_count].title, content->title, MAX_TITLE_LENGTH - 1);
@@ -183,6 +258,40 @@ int report_user_interactions(UserManager *user_manager,
         }
     }
     
+    // Somar as interações antigas já agregadas pela política de retenção
+    for (int i = 0; i < user_manager->retention.count; i++) {
+        InteractionAggregate *aggregate = &user_manager->retention.aggregates[i];
+        
+        if (aggregate->user_id == user_id) {
+            int total = 0;
+            for (int j = 0; j < 4; j++) {
+                total += aggregate->counts[j];
+            }
+            
+            int content_index = -1;
+            for (int j = 0; j < interaction_count; j++) {
+                if (interactions[j].content_id == aggregate->content_id) {
+                    content_index = j;
+                    break;
+                }
+            }
+            
+            if (content_index >= 0) {
+                interactions[content_index].count += total;
+            } else if (interaction_count < 1000) {
+                const Content *content = content_get_by_id(content_catalog, aggregate->content_id);
+                if (content != NULL) {
+                    interactions[interaction_count].content_id = content->id;
+                    strncpy(interactions[interaction_count].title, content->title, MAX_TITLE_LENGTH - 1);
+                    interactions[interaction_count].title[MAX_TITLE_LENGTH - 1] = '\0';
+                    interactions[interaction_count].count = total;
+                    interaction_count++;
+                }
+            }
+        }
+    }
+    content_read_end(content_catalog);
+    
     // Ordenar por número de interações
     qsort(interactions, interaction_count, sizeof(ContentReportItem), compare_content_views);
     
@@ -68,6 +68,10 @@ int report_most_popular_categories(ContentCatalog *content_catalog,
 /**
  * @brief Gera um relatório dos utilizadores mais ativos
  * 
+ * Num gerenciador particionado (user_enable_shards), cada partição calcula o
+ * seu ranking numa thread (scatter) e os rankings parciais são fundidos no
+ * resultado final (gather).
+ * 
  * @param user_manager Ponteiro para o gerenciador de utilizadores
  * @param results Array para armazenar os itens do relatório
  * @param max_results Tamanho máximo do array de resultados
@@ -0,0 +1,409 @@
+/**
+ * @file session.c
+ * @brief Implementação do módulo de sessões de visualização
+ */
+
+#include "session.h"
+#include "user.h"
+
+// Estados de uma sessão
+#define SESSION_CLOSED 0
+#define SESSION_PLAYING 1
+#define SESSION_PAUSED 2
+
+// Função de dispersão multiplicativa para IDs inteiros
+static unsigned int session_hash_id(int id) {
+    return (unsigned int)id * 2654435761u;
+}
+
+// Procura a posição de um ID numa tabela de dispersão (posição vazia se não existir)
+static SessionSlot* session_slot_find(SessionSlot *slots, int capacity, int key) {
+    unsigned int mask = (unsigned int)capacity - 1;
+    unsigned int slot = session_hash_id(key) & mask;
+    
+    while (slots[slot].key != 0 && slots[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    
+    return &slots[slot];
+}
+
+// Duplica uma tabela de dispersão, reinserindo as entradas existentes
+static int session_slots_grow(SessionSlot **slots, int *capacity) {
+    int new_capacity = *capacity * 2;
+    SessionSlot *new_slots = (SessionSlot*)calloc(new_capacity, sizeof(SessionSlot));
+    if (new_slots == NULL) {
+        return 0;
+    }
+    
+    for (int i = 0; i < *capacity; i++) {
+        if ((*slots)[i].key != 0) {
+            *session_slot_find(new_slots, new_capacity, (*slots)[i].key) = (*slots)[i];
+        }
+    }
+    
+    free(*slots);
+    *slots = new_slots;
+    *capacity = new_capacity;
+    return 1;
+}
+
+// Obtém (criando se necessário) a entrada de um ID numa tabela de dispersão
+static SessionSlot* session_slot_get(SessionSlot **slots, int *count, int *capacity, int key) {
+    SessionSlot *entry = session_slot_find(*slots, *capacity, key);
+    if (entry->key != 0) {
+        return entry;
+    }
+    
+    // Manter a ocupação abaixo de metade
+    if ((*count + 1) * 2 > *capacity) {
+        if (!session_slots_grow(slots, capacity)) {
+            return NULL;
+        }
+        entry = session_slot_find(*slots, *capacity, key);
+    }
+    
+    entry->key = key;
+    entry->head = -1;
+    entry->open = -1;
+    (*count)++;
+    return entry;
+}
+
+// Fecha uma sessão, acumulando o tempo em reprodução até ao timestamp indicado
+static void session_close(Session *session, time_t timestamp) {
+    if (session->state == SESSION_PLAYING && timestamp > session->end) {
+        session->watch_seconds += (int)(timestamp - session->end);
+    }
+    if (timestamp > session->end) {
+        session->end = timestamp;
+    }
+    session->state = SESSION_CLOSED;
+}
+
+// Abre uma nova sessão e liga-a às listas do utilizador e do conteúdo
+static Session* session_open(SessionTable *table, SessionSlot *user_slot, 
+                             int user_id, int content_id, time_t timestamp) {
+    SessionSlot *content_slot = session_slot_get(&table->by_content, &table->content_slot_count, 
+                                                 &table->content_slot_capacity, content_id);
+    if (content_slot == NULL) {
+        return NULL;
+    }
+    
+    if (table->count >= table->capacity) {
+        int new_capacity = table->capacity * 2;
+        Session *new_sessions = (Session*)realloc(table->sessions, new_capacity * sizeof(Session));
+        
+        if (new_sessions == NULL) {
+            return NULL;
+        }
+        
+        table->sessions = new_sessions;
+        table->capacity = new_capacity;
+    }
+    
+    int index = table->count++;
+    Session *session = &table->sessions[index];
+    
+    session->user_id = user_id;
+    session->content_id = content_id;
+    session->start = timestamp;
+    session->end = timestamp;
+    session->watch_seconds = 0;
+    session->pauses = 0;
+    session->completed = 0;
+    session->state = SESSION_PLAYING;
+    session->next_by_user = user_slot->head;
+    session->next_by_content = content_slot->head;
+    
+    user_slot->head = index;
+    user_slot->open = index;
+    content_slot->head = index;
+    return session;
+}
+
+int session_table_init(SessionTable *table) {
+    if (table == NULL) {
+        return 0;
+    }
+    
+    table->capacity = 64;
+    table->count = 0;
+    table->user_slot_capacity = 64;
+    table->user_slot_count = 0;
+    table->content_slot_capacity = 64;
+    table->content_slot_count = 0;
+    
+    table->sessions = (Session*)malloc(table->capacity * sizeof(Session));
+    table->by_user = (SessionSlot*)calloc(table->user_slot_capacity, sizeof(SessionSlot));
+    table->by_content = (SessionSlot*)calloc(table->content_slot_capacity, sizeof(SessionSlot));
+    
+    if (table->sessions == NULL || table->by_user == NULL || table->by_content == NULL) {
+        session_table_free(table);
+        return 0;
+    }
+    
+    return 1;
+}
+
+void session_table_free(SessionTable *table) {
+    if (table == NULL) {
+        return;
+    }
+    
+    free(table->sessions);
+    free(table->by_user);
+    free(table->by_content);
+    table->sessions = NULL;
+    table->by_user = NULL;
+    table->by_content = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->user_slot_count = 0;
+    table->user_slot_capacity = 0;
+    table->content_slot_count = 0;
+    table->content_slot_capacity = 0;
+}
+
+int session_table_apply(SessionTable *table, int user_id, int content_id, 
+                        int type, time_t timestamp) {
+    if (table == NULL || table->sessions == NULL || user_id <= 0 || content_id <= 0) {
+        return 0;
+    }
+    
+    if (type == INTERACTION_FAVORITE) {
+        return 1;
+    }
+    
+    SessionSlot *user_slot = session_slot_get(&table->by_user, &table->user_slot_count, 
+                                              &table->user_slot_capacity, user_id);
+    if (user_slot == NULL) {
+        return 0;
+    }
+    
+    Session *session = user_slot->open >= 0 ? &table->sessions[user_slot->open] : NULL;
+    
+    // Fechar a sessão aberta se o evento for de outro conteúdo ou chegar após inatividade
+    if (session != NULL && 
+        (session->content_id != content_id || 
+         timestamp - session->end > SESSION_IDLE_TIMEOUT)) {
+        // Não contar o período de inatividade como tempo assistido
+        time_t close_time = timestamp - session->end > SESSION_IDLE_TIMEOUT ? session->end : timestamp;
+        session_close(session, close_time);
+        user_slot->open = -1;
+        session = NULL;
+    }
+    
+    switch (type) {
+        case INTERACTION_PLAY:
+            if (session == NULL) {
+                return session_open(table, user_slot, user_id, content_id, timestamp) != NULL;
+            }
+            if (session->state == SESSION_PLAYING && timestamp > session->end) {
+                session->watch_seconds += (int)(timestamp - session->end);
+            }
+            session->state = SESSION_PLAYING;
+            break;
+        case INTERACTION_PAUSE:
+            if (session == NULL) {
+                return 1; // Pausa sem reprodução em curso
+            }
+            if (session->state == SESSION_PLAYING) {
+                if (timestamp > session->end) {
+                    session->watch_seconds += (int)(timestamp - session->end);
+                }
+                session->pauses++;
+            }
+            session->state = SESSION_PAUSED;
+            break;
+        case INTERACTION_COMPLETE:
+            if (session == NULL) {
+                // Conclusão sem PLAY registado: sessão instantânea
+                session = session_open(table, user_slot, user_id, content_id, timestamp);
+                if (session == NULL) {
+                    return 0;
+                }
+            }
+            session_close(session, timestamp);
+            session->completed = 1;
+            user_slot->open = -1;
+            return 1;
+        default:
+            return 1;
+    }
+    
+    if (timestamp > session->end) {
+        session->end = timestamp;
+    }
+    
+    return 1;
+}
+
+int session_table_remove_users(SessionTable *table, const int *user_ids, int n) {
+    if (table == NULL || table->sessions == NULL || user_ids == NULL || n <= 0) {
+        return 0;
+    }
+    
+    // Marcar os utilizadores a remover na própria tabela de utilizadores
+    int marked = 0;
+    for (int i = 0; i < n; i++) {
+        if (user_ids[i] <= 0) {
+            continue;
+        }
+        SessionSlot *entry = session_slot_find(table->by_user, table->user_slot_capacity, user_ids[i]);
+        if (entry->key != 0) {
+            entry->head = -2;
+            marked++;
+        }
+    }
+    
+    if (marked == 0) {
+        return 0;
+    }
+    
+    // Compactar as sessões, preservando a ordem
+    int kept = 0;
+    for (int i = 0; i < table->count; i++) {
+        SessionSlot *entry = session_slot_find(table->by_user, table->user_slot_capacity, 
+                                               table->sessions[i].user_id);
+        if (entry->head != -2) {
+            table->sessions[kept++] = table->sessions[i];
+        }
+    }
+    
+    int removed = table->count - kept;
+    table->count = kept;
+    
+    // Reconstruir as listas ligadas e as sessões abertas
+    memset(table->by_user, 0, table->user_slot_capacity * sizeof(SessionSlot));
+    memset(table->by_content, 0, table->content_slot_capacity * sizeof(SessionSlot));
+    table->user_slot_count = 0;
+    table->content_slot_count = 0;
+    
+    for (int i = 0; i < table->count; i++) {
+        Session *session = &table->sessions[i];
+        SessionSlot *user_slot = session_slot_get(&table->by_user, &table->user_slot_count, 
+                                                  &table->user_slot_capacity, session->user_id);
+        SessionSlot *content_slot = session_slot_get(&table->by_content, &table->content_slot_count, 
+                                                     &table->content_slot_capacity, session->content_id);
+        
+        // As tabelas já tinham capacidade para estas chaves, por isso não há realocação
+        session->next_by_user = user_slot->head;
+        session->next_by_content = content_slot->head;
+        user_slot->head = i;
+        content_slot->head = i;
+        if (session->state != SESSION_CLOSED) {
+            user_slot->open = i;
+        }
+    }
+    
+    return removed;
+}
+
+int session_get_by_user(SessionTable *table, int user_id, 
+                        Session *results, int max_results) {
+    if (table == NULL || table->by_user == NULL || user_id <= 0 || 
+        results == NULL || max_results <= 0) {
+        return 0;
+    }
+    
+    SessionSlot *entry = session_slot_find(table->by_user, table->user_slot_capacity, user_id);
+    if (entry->key == 0) {
+        return 0;
+    }
+    
+    int found_count = 0;
+    for (int i = entry->head; i >= 0 && found_count < max_results; 
+         i = table->sessions[i].next_by_user) {
+        results[found_count++] = table->sessions[i];
+    }
+    
+    return found_count;
+}
+
+int session_get_by_content(SessionTable *table, int content_id, 
+                           Session *results, int max_results) {
+    if (table == NULL || table->by_content == NULL || content_id <= 0 || 
+        results == NULL || max_results <= 0) {
+        return 0;
+    }
+    
+    SessionSlot *entry = session_slot_find(table->by_content, table->content_slot_capacity, content_id);
+    if (entry->key == 0) {
+        return 0;
+    }
+    
+    int found_count = 0;
+    for (int i = entry->head; i >= 0 && found_count < max_results; 
+         i = table->sessions[i].next_by_content) {
+        results[found_count++] = table->sessions[i];
+    }
+    
+    return found_count;
+}
+
+int session_watch_seconds(const Session *session, ContentCatalog *catalog) {
+    if (session == NULL) {
+        return 0;
+    }
+    
+    int seconds = session->watch_seconds;
+    
+    // Sem secção de leitura não se lê o catálogo (a duração fica sem limite)
+    if (catalog != NULL && content_read_begin(catalog)) {
+        const Content *content = content_get_by_id(catalog, session->content_id);
+        if (content != NULL && seconds > content->duration * 60) {
+            seconds = content->duration * 60;
+        }
+        content_read_end(catalog);
+    }
+    
+    return seconds;
+}
+
+long session_total_watch_by_user(SessionTable *table, ContentCatalog *catalog, int user_id) {
+    if (table == NULL || table->by_user == NULL || user_id <= 0) {
+        return 0;
+    }
+    
+    SessionSlot *entry = session_slot_find(table->by_user, table->user_slot_capacity, user_id);
+    if (entry->key == 0) {
+        return 0;
+    }
+    
+    long total = 0;
+    for (int i = entry->head; i >= 0; i = table->sessions[i].next_by_user) {
+        total += session_watch_seconds(&table->sessions[i], catalog);
+    }
+    
+    return total;
+}
+
+long session_total_watch_by_content(SessionTable *table, ContentCatalog *catalog, int content_id) {
+    if (table == NULL || table->by_content == NULL || content_id <= 0) {
+        return 0;
+    }
+    
+    SessionSlot *entry = session_slot_find(table->by_content, table->content_slot_capacity, content_id);
+    if (entry->key == 0) {
+        return 0;
+    }
+    
+    // O limite é o mesmo para todas as sessões do conteúdo
+    int limit = -1;
+    if (catalog != NULL && content_read_begin(catalog)) {
+        const Content *content = content_get_by_id(catalog, content_id);
+        if (content != NULL) {
+            limit = content->duration * 60;
+        }
+        content_read_end(catalog);
+    }
+    
+    long total = 0;
+    for (int i = entry->head; i >= 0; i = table->sessions[i].next_by_content) {
+        int seconds = table->sessions[i].watch_seconds;
+        total += (limit >= 0 && seconds > limit) ? limit : seconds;
+    }
+    
+    return total;
+}
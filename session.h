@@ -0,0 +1,157 @@
+/**
+ * @file session.h
+ * @brief Módulo de sessões de visualização
+ * 
+ * Este módulo agrupa as interações PLAY/PAUSE/COMPLETE de cada utilizador em
+ * sessões de visualização (início, fim, pausas, conclusão e segundos
+ * assistidos), atualizadas incrementalmente à medida que os eventos chegam.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "content.h"
+
+#define SESSION_IDLE_TIMEOUT 1800
+
+/**
+ * @brief Estrutura que representa uma sessão de visualização
+ */
+typedef struct {
+    int user_id;            /**< ID do utilizador */
+    int content_id;         /**< ID do conteúdo */
+    time_t start;           /**< Timestamp do primeiro evento da sessão */
+    time_t end;             /**< Timestamp do último evento da sessão */
+    int watch_seconds;      /**< Segundos em reprodução (sem limite pela duração) */
+    int next_by_user;       /**< Sessão anterior do mesmo utilizador (-1 se nenhuma) */
+    int next_by_content;    /**< Sessão anterior do mesmo conteúdo (-1 se nenhuma) */
+    unsigned short pauses;  /**< Número de pausas */
+    unsigned char completed; /**< 1 se a visualização foi completada */
+    unsigned char state;    /**< Estado interno (fechada, em reprodução, em pausa) */
+} Session;
+
+/**
+ * @brief Entrada das tabelas de dispersão ID -> sessões
+ */
+typedef struct {
+    int key;                /**< ID do utilizador ou do conteúdo (0 = vazio) */
+    int head;               /**< Sessão mais recente (-1 se nenhuma) */
+    int open;               /**< Sessão aberta do utilizador (-1 se nenhuma) */
+} SessionSlot;
+
+/**
+ * @brief Estrutura que gerencia a tabela de sessões
+ */
+typedef struct {
+    Session *sessions;      /**< Array dinâmico de sessões */
+    int count;              /**< Número atual de sessões */
+    int capacity;           /**< Capacidade máxima do array */
+    SessionSlot *by_user;   /**< Tabela de dispersão utilizador -> sessões */
+    int user_slot_count;    /**< Número de posições ocupadas em by_user */
+    int user_slot_capacity; /**< Número de posições de by_user (potência de 2) */
+    SessionSlot *by_content; /**< Tabela de dispersão conteúdo -> sessões */
+    int content_slot_count; /**< Número de posições ocupadas em by_content */
+    int content_slot_capacity; /**< Número de posições de by_content (potência de 2) */
+} SessionTable;
+
+/**
+ * @brief Inicializa a tabela de sessões
+ * 
+ * @param table Ponteiro para a tabela a ser inicializada
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int session_table_init(SessionTable *table);
+
+/**
+ * @brief Liberta a memória alocada para a tabela de sessões
+ * 
+ * @param table Ponteiro para a tabela a ser libertada
+ */
+void session_table_free(SessionTable *table);
+
+/**
+ * @brief Incorpora um evento na sessão aberta do utilizador (O(1))
+ * 
+ * PLAY abre ou retoma uma sessão, PAUSE acumula o tempo em reprodução e
+ * conta a pausa, COMPLETE fecha a sessão como concluída. Um PLAY noutro
+ * conteúdo ou após SESSION_IDLE_TIMEOUT segundos fecha a sessão anterior.
+ * FAVORITE é ignorado.
+ * 
+ * @param table Ponteiro para a tabela de sessões
+ * @param user_id ID do utilizador
+ * @param content_id ID do conteúdo
+ * @param type Tipo de interação (valor de InteractionType)
+ * @param timestamp Timestamp do evento
+ * @return int 1 se o evento foi processado, 0 em caso de erro
+ */
+int session_table_apply(SessionTable *table, int user_id, int content_id, 
+                        int type, time_t timestamp);
+
+/**
+ * @brief Remove todas as sessões de um conjunto de utilizadores
+ * 
+ * @param table Ponteiro para a tabela de sessões
+ * @param user_ids Array com os IDs dos utilizadores
+ * @param n Número de IDs
+ * @return int Número de sessões removidas
+ */
+int session_table_remove_users(SessionTable *table, const int *user_ids, int n);
+
+/**
+ * @brief Obtém as sessões de um utilizador, da mais recente para a mais antiga
+ * 
+ * @param table Ponteiro para a tabela de sessões
+ * @param user_id ID do utilizador
+ * @param results Array para armazenar as sessões encontradas
+ * @param max_results Tamanho máximo do array de resultados
+ * @return int Número de sessões encontradas
+ */
+int session_get_by_user(SessionTable *table, int user_id, 
+                        Session *results, int max_results);
+
+/**
+ * @brief Obtém as sessões de um conteúdo, da mais recente para a mais antiga
+ * 
+ * @param table Ponteiro para a tabela de sessões
+ * @param content_id ID do conteúdo
+ * @param results Array para armazenar as sessões encontradas
+ * @param max_results Tamanho máximo do array de resultados
+ * @return int Número de sessões encontradas
+ */
+int session_get_by_content(SessionTable *table, int content_id, 
+                           Session *results, int max_results);
+
+/**
+ * @brief Calcula os segundos assistidos numa sessão, limitados pela duração do conteúdo
+ * 
+ * @param session Ponteiro para a sessão
+ * @param catalog Ponteiro para o catálogo (NULL para não limitar)
+ * @return int Segundos assistidos
+ */
+int session_watch_seconds(const Session *session, ContentCatalog *catalog);
+
+/**
+ * @brief Soma os segundos assistidos de todas as sessões de um utilizador
+ * 
+ * @param table Ponteiro para a tabela de sessões
+ * @param catalog Ponteiro para o catálogo (NULL para não limitar)
+ * @param user_id ID do utilizador
+ * @return long Total de segundos assistidos
+ */
+long session_total_watch_by_user(SessionTable *table, ContentCatalog *catalog, int user_id);
+
+/**
+ * @brief Soma os segundos assistidos de todas as sessões de um conteúdo
+ * 
+ * @param table Ponteiro para a tabela de sessões
+ * @param catalog Ponteiro para o catálogo (NULL para não limitar)
+ * @param content_id ID do conteúdo
+ * @return long Total de segundos assistidos
+ */
+long session_total_watch_by_content(SessionTable *table, ContentCatalog *catalog, int content_id);
+
+#endif /* SESSION_H */
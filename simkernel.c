@@ -0,0 +1,284 @@
+/**
+ * @file simkernel.c
+ * @brief Implementação do módulo de cálculo vetorizado da similaridade
+ */
+
+#include <stdlib.h>
+
+#include "simkernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMKERNEL_X86 1
+#include <immintrin.h>
+#else
+#define SIMKERNEL_X86 0
+#endif
+
+// Versão em uso (-1 até à primeira chamada)
+static int simkernel_current = -1;
+
+float simkernel_similarity(int category1, int age_rating1, int duration1,
+                           int category2, int age_rating2, int duration2) {
+    float similarity = 0.0f;
+    
+    // Similaridade por categoria (0.6 se for a mesma categoria)
+    if (category1 == category2) {
+        similarity += 0.6f;
+    }
+    
+    // Similaridade por classificação etária (até 0.2)
+    float age_diff = abs(age_rating1 - age_rating2);
+    similarity += 0.2f * (1.0f - (age_diff / 18.0f));
+    
+    // Similaridade por duração (até 0.2)
+    float duration_diff = abs(duration1 - duration2);
+    float max_duration = duration1 > duration2 ? duration1 : duration2;
+    if (max_duration > 0) {
+        similarity += 0.2f * (1.0f - (duration_diff / max_duration));
+    }
+    
+    return similarity;
+}
+
+// Versão de referência: um candidato de cada vez
+static void simkernel_accumulate_scalar(int category, int age_rating, int duration,
+                                        const int *categories, const int *age_ratings,
+                                        const int *durations, int count, float *scores) {
+    for (int i = 0; i < count; i++) {
+        scores[i] += simkernel_similarity(category, age_rating, duration,
+                                          categories[i], age_ratings[i], durations[i]);
+    }
+}
+
+// Produto interno de referência
+static float simkernel_dot_scalar(const float *a, const float *b, int length) {
+    float sum = 0.0f;
+    for (int k = 0; k < length; k++) {
+        sum += a[k] * b[k];
+    }
+    return sum;
+}
+
+#if SIMKERNEL_X86
+
+// Similaridade de 4 candidatos, com as mesmas operações (e a mesma ordem) da versão escalar
+__attribute__((target("sse2")))
+static __m128 simkernel_sse2_lanes(__m128i category, __m128 age_rating, __m128 duration,
+                                   const int *categories, const int *age_ratings, const int *durations) {
+    __m128i other_category = _mm_loadu_si128((const __m128i*)categories);
+    __m128 other_age = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)age_ratings));
+    __m128 other_duration = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)durations));
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 weight = _mm_set1_ps(0.2f);
+    
+    __m128 same = _mm_castsi128_ps(_mm_cmpeq_epi32(category, other_category));
+    __m128 similarity = _mm_and_ps(same, _mm_set1_ps(0.6f));
+    
+    // Os atributos são inteiros pequenos, pelo que a diferença em float é exata
+    __m128 age_diff = _mm_andnot_ps(sign, _mm_sub_ps(age_rating, other_age));
+    similarity = _mm_add_ps(similarity, _mm_mul_ps(weight,
+                 _mm_sub_ps(one, _mm_div_ps(age_diff, _mm_set1_ps(18.0f)))));
+    
+    __m128 duration_diff = _mm_andnot_ps(sign, _mm_sub_ps(duration, other_duration));
+    __m128 max_duration = _mm_max_ps(duration, other_duration);
+    __m128 duration_similarity = _mm_mul_ps(weight,
+                                 _mm_sub_ps(one, _mm_div_ps(duration_diff, max_duration)));
+    __m128 positive = _mm_cmpgt_ps(max_duration, _mm_setzero_ps());
+    return _mm_add_ps(similarity, _mm_and_ps(positive, duration_similarity));
+}
+
+__attribute__((target("sse2")))
+static void simkernel_accumulate_sse2(int category, int age_rating, int duration,
+                                      const int *categories, const int *age_ratings,
+                                      const int *durations, int count, float *scores) {
+    __m128i query_category = _mm_set1_epi32(category);
+    __m128 query_age = _mm_set1_ps((float)age_rating);
+    __m128 query_duration = _mm_set1_ps((float)duration);
+    int i = 0;
+    
+    for (; i + 8 <= count; i += 8) {
+        __m128 first = simkernel_sse2_lanes(query_category, query_age, query_duration,
+                                            categories + i, age_ratings + i, durations + i);
+        __m128 second = simkernel_sse2_lanes(query_category, query_age, query_duration,
+                                             categories + i + 4, age_ratings + i + 4, durations + i + 4);
+        _mm_storeu_ps(scores + i, _mm_add_ps(_mm_loadu_ps(scores + i), first));
+        _mm_storeu_ps(scores + i + 4, _mm_add_ps(_mm_loadu_ps(scores + i + 4), second));
+    }
+    
+    simkernel_accumulate_scalar(category, age_rating, duration, categories + i, age_ratings + i,
+                                durations + i, count - i, scores + i);
+}
+
+// Similaridade de 8 candidatos, com as mesmas operações (e a mesma ordem) da versão escalar
+__attribute__((target("avx2")))
+static __m256 simkernel_avx2_lanes(__m256i category, __m256 age_rating, __m256 duration,
+                                   const int *categories, const int *age_ratings, const int *durations) {
+    __m256i other_category = _mm256_loadu_si256((const __m256i*)categories);
+    __m256 other_age = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)age_ratings));
+    __m256 other_duration = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)durations));
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 weight = _mm256_set1_ps(0.2f);
+    
+    __m256 same = _mm256_castsi256_ps(_mm256_cmpeq_epi32(category, other_category));
+    __m256 similarity = _mm256_and_ps(same, _mm256_set1_ps(0.6f));
+    
+    __m256 age_diff = _mm256_andnot_ps(sign, _mm256_sub_ps(age_rating, other_age));
+    similarity = _mm256_add_ps(similarity, _mm256_mul_ps(weight,
+                 _mm256_sub_ps(one, _mm256_div_ps(age_diff, _mm256_set1_ps(18.0f)))));
+    
+    __m256 duration_diff = _mm256_andnot_ps(sign, _mm256_sub_ps(duration, other_duration));
+    __m256 max_duration = _mm256_max_ps(duration, other_duration);
+    __m256 duration_similarity = _mm256_mul_ps(weight,
+                                 _mm256_sub_ps(one, _mm256_div_ps(duration_diff, max_duration)));
+    __m256 positive = _mm256_cmp_ps(max_duration, _mm256_setzero_ps(), _CMP_GT_OQ);
+    return _mm256_add_ps(similarity, _mm256_and_ps(positive, duration_similarity));
+}
+
+__attribute__((target("avx2")))
+static void simkernel_accumulate_avx2(int category, int age_rating, int duration,
+                                      const int *categories, const int *age_ratings,
+                                      const int *durations, int count, float *scores) {
+    __m256i query_category = _mm256_set1_epi32(category);
+    __m256 query_age = _mm256_set1_ps((float)age_rating);
+    __m256 query_duration = _mm256_set1_ps((float)duration);
+    int i = 0;
+    
+    for (; i + 16 <= count; i += 16) {
+        __m256 first = simkernel_avx2_lanes(query_category, query_age, query_duration,
+                                            categories + i, age_ratings + i, durations + i);
+        __m256 second = simkernel_avx2_lanes(query_category, query_age, query_duration,
+                                             categories + i + 8, age_ratings + i + 8, durations + i + 8);
+        _mm256_storeu_ps(scores + i, _mm256_add_ps(_mm256_loadu_ps(scores + i), first));
+        _mm256_storeu_ps(scores + i + 8, _mm256_add_ps(_mm256_loadu_ps(scores + i + 8), second));
+    }
+    
+    // O resto (menos de 16 candidatos) segue pela versão SSE2 e depois escalar
+    simkernel_accumulate_sse2(category, age_rating, duration, categories + i, age_ratings + i,
+                              durations + i, count - i, scores + i);
+}
+
+// Produto interno com 4 somas parciais em paralelo
+__attribute__((target("sse2")))
+static float simkernel_dot_sse2(const float *a, const float *b, int length) {
+    __m128 sum = _mm_setzero_ps();
+    int k = 0;
+    
+    for (; k + 4 <= length; k += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + k), _mm_loadu_ps(b + k)));
+    }
+    
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum) + simkernel_dot_scalar(a + k, b + k, length - k);
+}
+
+// Produto interno com 8 somas parciais em paralelo
+__attribute__((target("avx2")))
+static float simkernel_dot_avx2(const float *a, const float *b, int length) {
+    __m256 sum = _mm256_setzero_ps();
+    int k = 0;
+    
+    for (; k + 8 <= length; k += 8) {
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(a + k), _mm256_loadu_ps(b + k)));
+    }
+    
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half) + simkernel_dot_scalar(a + k, b + k, length - k);
+}
+
+#endif /* SIMKERNEL_X86 */
+
+SimKernelLevel simkernel_supported(void) {
+#if SIMKERNEL_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMKERNEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMKERNEL_SSE2;
+    }
+#endif
+    return SIMKERNEL_SCALAR;
+}
+
+SimKernelLevel simkernel_level(void) {
+    int level = __atomic_load_n(&simkernel_current, __ATOMIC_RELAXED);
+    if (level < 0) {
+        level = (int)simkernel_supported();
+        __atomic_store_n(&simkernel_current, level, __ATOMIC_RELAXED);
+    }
+    return (SimKernelLevel)level;
+}
+
+SimKernelLevel simkernel_set_level(SimKernelLevel level) {
+    SimKernelLevel supported = simkernel_supported();
+    if (level > supported) {
+        level = supported;
+    }
+    __atomic_store_n(&simkernel_current, (int)level, __ATOMIC_RELAXED);
+    return level;
+}
+
+const char* simkernel_level_name(SimKernelLevel level) {
+    switch (level) {
+        case SIMKERNEL_AVX2: return "AVX2";
+        case SIMKERNEL_SSE2: return "SSE2";
+        default: return "escalar";
+    }
+}
+
+void simkernel_accumulate(int category, int age_rating, int duration,
+                          const int *categories, const int *age_ratings, const int *durations,
+                          int count, float *scores) {
+    if (categories == NULL || age_ratings == NULL || durations == NULL ||
+        scores == NULL || count <= 0) {
+        return;
+    }
+    
+    switch (simkernel_level()) {
+#if SIMKERNEL_X86
+        case SIMKERNEL_AVX2:
+            simkernel_accumulate_avx2(category, age_rating, duration, categories,
+                                      age_ratings, durations, count, scores);
+            break;
+        case SIMKERNEL_SSE2:
+            simkernel_accumulate_sse2(category, age_rating, duration, categories,
+                                      age_ratings, durations, count, scores);
+            break;
+#endif
+        default:
+            simkernel_accumulate_scalar(category, age_rating, duration, categories,
+                                        age_ratings, durations, count, scores);
+            break;
+    }
+}
+
+void simkernel_dot_rows(const float *query, const float *rows, int length, int stride,
+                        int count, float *scores) {
+    if (query == NULL || rows == NULL || scores == NULL || length <= 0 || count <= 0) {
+        return;
+    }
+    
+    switch (simkernel_level()) {
+#if SIMKERNEL_X86
+        case SIMKERNEL_AVX2:
+            for (int i = 0; i < count; i++) {
+                scores[i] = simkernel_dot_avx2(query, rows + (size_t)i * stride, length);
+            }
+            break;
+        case SIMKERNEL_SSE2:
+            for (int i = 0; i < count; i++) {
+                scores[i] = simkernel_dot_sse2(query, rows + (size_t)i * stride, length);
+            }
+            break;
+#endif
+        default:
+            for (int i = 0; i < count; i++) {
+                scores[i] = simkernel_dot_scalar(query, rows + (size_t)i * stride, length);
+            }
+            break;
+    }
+}
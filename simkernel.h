@@ -0,0 +1,108 @@
+/**
+ * @file simkernel.h
+ * @brief Módulo de cálculo vetorizado da similaridade entre conteúdos
+ * 
+ * Calcula a similaridade de recommendation_calculate_similarity de um
+ * conteúdo contra um bloco contíguo de candidatos guardados em arrays
+ * separados (categoria interna, classificação etária e duração). A versão
+ * usada é escolhida em tempo de execução conforme o processador: AVX2
+ * (16 candidatos por iteração), SSE2 (8 por iteração) ou escalar, e todas
+ * produzem os mesmos valores que a versão escalar de referência. O mesmo
+ * despacho serve o produto interno usado para pontuar fatores latentes.
+ */
+
+#ifndef SIMKERNEL_H
+#define SIMKERNEL_H
+
+/**
+ * @brief Versões disponíveis do cálculo
+ */
+typedef enum {
+    SIMKERNEL_SCALAR,      /**< Um candidato de cada vez (referência) */
+    SIMKERNEL_SSE2,        /**< 4 candidatos por instrução */
+    SIMKERNEL_AVX2         /**< 8 candidatos por instrução */
+} SimKernelLevel;
+
+/**
+ * @brief Similaridade entre dois conteúdos, com a categoria já convertida num inteiro
+ * 
+ * @param category1 Categoria interna do primeiro conteúdo
+ * @param age_rating1 Classificação etária do primeiro conteúdo
+ * @param duration1 Duração do primeiro conteúdo
+ * @param category2 Categoria interna do segundo conteúdo
+ * @param age_rating2 Classificação etária do segundo conteúdo
+ * @param duration2 Duração do segundo conteúdo
+ * @return float Similaridade entre 0 e 1
+ */
+float simkernel_similarity(int category1, int age_rating1, int duration1,
+                           int category2, int age_rating2, int duration2);
+
+/**
+ * @brief Soma a scores a similaridade de um conteúdo com cada candidato do bloco
+ * 
+ * scores[i] += similaridade(conteúdo, candidato i), para i em [0, count).
+ * Chamadas sucessivas para vários conteúdos acumulam pela mesma ordem que
+ * um ciclo escalar sobre esses conteúdos.
+ * 
+ * @param category Categoria interna do conteúdo
+ * @param age_rating Classificação etária do conteúdo
+ * @param duration Duração do conteúdo
+ * @param categories Categoria interna de cada candidato
+ * @param age_ratings Classificação etária de cada candidato
+ * @param durations Duração de cada candidato
+ * @param count Número de candidatos
+ * @param scores Scores acumulados de cada candidato
+ */
+void simkernel_accumulate(int category, int age_rating, int duration,
+                          const int *categories, const int *age_ratings, const int *durations,
+                          int count, float *scores);
+
+/**
+ * @brief Produto interno de um vetor com cada linha de uma matriz densa
+ * 
+ * scores[i] = soma de query[k] * rows[i * stride + k] para k em [0, length).
+ * Usa a mesma versão (AVX2, SSE2 ou escalar) de simkernel_accumulate; a
+ * ordem das somas difere entre versões, pelo que os resultados coincidem
+ * apenas a menos do arredondamento.
+ * 
+ * @param query Vetor de length floats
+ * @param rows Primeira linha da matriz (linhas de stride floats)
+ * @param length Número de colunas usadas de cada linha
+ * @param stride Distância, em floats, entre linhas consecutivas
+ * @param count Número de linhas
+ * @param scores Produto interno de cada linha
+ */
+void simkernel_dot_rows(const float *query, const float *rows, int length, int stride,
+                        int count, float *scores);
+
+/**
+ * @brief Obtém a versão mais rápida suportada pelo processador
+ * 
+ * @return SimKernelLevel Versão suportada
+ */
+SimKernelLevel simkernel_supported(void);
+
+/**
+ * @brief Obtém a versão usada por simkernel_accumulate
+ * 
+ * @return SimKernelLevel Versão em uso
+ */
+SimKernelLevel simkernel_level(void);
+
+/**
+ * @brief Escolhe a versão usada por simkernel_accumulate (para testes e benchmarks)
+ * 
+ * @param level Versão pretendida; é limitada à suportada pelo processador
+ * @return SimKernelLevel Versão efetivamente em uso
+ */
+SimKernelLevel simkernel_set_level(SimKernelLevel level);
+
+/**
+ * @brief Obtém o nome de uma versão
+ * 
+ * @param level Versão
+ * @return const char* Nome da versão
+ */
+const char* simkernel_level_name(SimKernelLevel level);
+
+#endif /* SIMKERNEL_H */
@@ -7,18 +7,42 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
+#include <stdint.h>
 
 #include "csvutil.h"
+#include "bitmap.h"
+#include "session.h"
 #include "content.h"
 #include "user.h"
+#include "usershard.h"
 #include "list.h"
 #include "recommendation.h"
 #include "report.h"
+#include "threadpool.h"
+#include "arena.h"
+#include "topk.h"
+#include "neighbors.h"
+#include "simkernel.h"
+#include "collab.h"
+#include "als.h"
+#include "hnsw.h"
 
 // Protótipos das funções de teste
 void test_csvutil();
+void test_bitmap();
 void test_content();
 void test_user();
+void test_session();
+void test_usershard();
+void test_threadpool();
+void test_arena();
+void test_topk();
+void test_neighbors();
+void test_simkernel();
+void test_collab();
+void test_als();
+void test_hnsw();
 void test_list();
 void test_recommendation();
 void test_report();
@@ -33,8 +57,19 @@ void test_integration();
     printf("Iniciando testes unitários...\n\n");
     
     test_csvutil();
+    test_bitmap();
     test_content();
     test_user();
+    test_session();
+    test_usershard();
+    test_threadpool();
+    test_arena();
+    test_topk();
+    test_neighbors();
+    test_simkernel();
+    test_collab();
+    test_als();
+    test_hnsw();
     test_list();
     test_recommendation();
     test_report();
@@ -91,6 +126,98 @@ void test_csvutil() {
     printf("Módulo csvutil testado com sucesso!\n");
 }
 
+/**
+ * @brief Testes para o módulo de conjuntos comprimidos
+ */
+void test_bitmap() {
+    printf("Testando módulo bitmap...\n");
+    
+    Bitmap bitmap;
+    bitmap_init(&bitmap);
+    assert(bitmap_contains(&bitmap, 1) == 0);
+    
+    // Valores em contentores diferentes e repetidos
+    assert(bitmap_add(&bitmap, 5) == 1);
+    assert(bitmap_add(&bitmap, 5) == 1);
+    assert(bitmap_add(&bitmap, 70000) == 1);
+    assert(bitmap_add(&bitmap, 3) == 1);
+    assert(bitmap_cardinality(&bitmap) == 3);
+    assert(bitmap.count == 2);
+    assert(bitmap_contains(&bitmap, 3) == 1);
+    assert(bitmap_contains(&bitmap, 4) == 0);
+    assert(bitmap_contains(&bitmap, 70000) == 1);
+    assert(bitmap_contains(&bitmap, 4464) == 0);
+    
+    // Forçar a conversão do primeiro contentor para mapa de bits
+    for (uint32_t i = 0; i < 10000; i += 2) {
+        assert(bitmap_add(&bitmap, i) == 1);
+    }
+    assert(bitmap.containers[0].is_bitset == 1);
+    assert(bitmap_contains(&bitmap, 9998) == 1);
+    assert(bitmap_contains(&bitmap, 9999) == 0);
+    assert(bitmap_contains(&bitmap, 3) == 1);
+    assert(bitmap_cardinality(&bitmap) == 5000 + 3);
+    
+    bitmap_free(&bitmap);
+    assert(bitmap_contains(&bitmap, 3) == 0);
+    
+    printf("Módulo bitmap testado com sucesso!\n");
+}
+
+// Argumentos de uma thread leitora do teste de conteúdos
+typedef struct {
+    ContentCatalog *catalog;
+    int *stop;
+    int reads;
+} ContentReaderArgs;
+
+// Lê repetidamente o catálogo enquanto outra thread o altera
+static void *content_reader_run(void *arg) {
+    ContentReaderArgs *args = (ContentReaderArgs*)arg;
+    int reader = content_reader_register(args->catalog);
+    assert(reader >= 0);
+    
+    do {
+        content_read_lock(args->catalog, reader);
+        int count = 0;
+        const Content *items = content_snapshot(args->catalog, &count);
+        for (int i = 0; i < count; i++) {
+            assert(items[i].id > 0 && items[i].title[0] != '\0');
+        }
+        int results[4];
+        content_search_by_category(args->catalog, "Drama", results, 4);
+        content_read_unlock(args->catalog, reader);
+        args->reads++;
+    } while (!__atomic_load_n(args->stop, __ATOMIC_ACQUIRE));
+    
+    content_reader_unregister(args->catalog, reader);
+    return NULL;
+}
+
+// Abre e fecha uma secção de leitura e termina, devolvendo a posição de leitor
+static void *content_section_run(void *arg) {
+    ContentCatalog *catalog = (ContentCatalog*)arg;
+    int ok = content_read_begin(catalog);
+    assert(ok == 1);
+    content_read_end(catalog);
+    return NULL;
+}
+
+// Argumentos de uma thread que incrementa visualizações
+typedef struct {
+    ContentCatalog *catalog;
+    int id;
+} ViewWriterArgs;
+
+// Incrementa 1000 visualizações de um conteúdo
+static void *view_writer_run(void *arg) {
+    ViewWriterArgs *args = (ViewWriterArgs*)arg;
+    for (int i = 0; i < 1000; i++) {
+        content_increment_views(args->catalog, args->id);
+    }
+    return NULL;
+}
+
 /**
  * @brief Testes para o módulo de conteúdos
  */
@@ -110,8 +237,151 @@ void test_content() {
     assert(id3 > 0);
     assert(catalog.count == 3);
     
+    // Testar leitores concorrentes com reclamação por épocas
+    ContentCatalog shared;
+    assert(content_init_catalog(&shared, 2) == 1);
+    int shared_id = content_add(&shared, "Original", "Ação", 100, 12);
+    int reader = content_reader_register(&shared);
+    assert(reader >= 0);
+    content_read_lock(&shared, reader);
+    int snapshot_count = 0;
+    const Content *snapshot = content_snapshot(&shared, &snapshot_count);
+    assert(content_edit(&shared, shared_id, "Editado", NULL, 0, -1) == 1);
+    assert(shared.retired_count == 1);          // O leitor ainda fixa a versão antiga
+    assert(snapshot_count == 1 && strcmp(snapshot[0].title, "Original") == 0);
+    assert(strcmp(content_get_by_id(&shared, shared_id)->title, "Editado") == 0);
+    content_read_unlock(&shared, reader);
+    content_reader_unregister(&shared, reader);
+    assert(content_reclaim(&shared) == 1);
+    assert(shared.retired_count == 0);
+    
+    // Threads que terminam devolvem a posição: mais threads do que posições continuam a ler
+    for (int i = 0; i < 2 * CONTENT_MAX_READERS; i++) {
+        pthread_t section_thread;
+        assert(pthread_create(&section_thread, NULL, content_section_run, &shared) == 0);
+        pthread_join(section_thread, NULL);
+    }
+    assert(shared.reader_count <= 2);
+    
+    // Sem posições livres, a secção usa a fixação partilhada e impede a reclamação
+    int held[CONTENT_MAX_READERS];
+    for (int i = 0; i < CONTENT_MAX_READERS; i++) {
+        held[i] = content_reader_register(&shared);
+        assert(held[i] >= 0);
+    }
+    assert(content_reader_register(&shared) == -1);
+    assert(content_read_begin(&shared) == 1);
+    assert(shared.shared_readers == 1);
+    const Content *fallback = content_get_by_id(&shared, shared_id);
+    assert(content_edit(&shared, shared_id, "Partilhado", NULL, 0, -1) == 1);
+    assert(content_reclaim(&shared) == 0 && shared.retired_count == 1);
+    assert(strcmp(fallback->title, "Editado") == 0);
+    content_read_end(&shared);
+    assert(shared.shared_readers == 0);
+    assert(content_reclaim(&shared) == 1 && shared.retired_count == 0);
+    for (int i = 0; i < CONTENT_MAX_READERS; i++) {
+        content_reader_unregister(&shared, held[i]);
+    }
+    assert(content_edit(&shared, shared_id, "Editado", NULL, 0, -1) == 1);
+    assert(shared.retired_count == 0);          // Sem leitores, a publicação liberta logo
+    
+    // Secções de leitura da thread, aninhadas: só a mais externa liberta a versão lida
+    assert(content_read_begin(&shared) == 1);
+    assert(content_read_begin(&shared) == 1);
+    const Content *pinned = content_get_by_id(&shared, shared_id);
+    assert(content_edit(&shared, shared_id, "Fixado", NULL, 0, -1) == 1);
+    content_read_end(&shared);
+    assert(content_reclaim(&shared) == 0 && shared.retired_count == 1);
+    assert(strcmp(pinned->title, "Editado") == 0);
+    content_read_end(&shared);
+    assert(content_reclaim(&shared) == 1 && shared.retired_count == 0);
+    content_read_end(&shared);                  // Sem secção aberta: não faz nada
+    
+    pthread_t reader_threads[4];
+    ContentReaderArgs reader_args[4];
+    int stop_readers = 0;
+    for (int i = 0; i < 4; i++) {
+        reader_args[i].catalog = &shared;
+        reader_args[i].stop = &stop_readers;
+        reader_args[i].reads = 0;
+        assert(pthread_create(&reader_threads[i], NULL, content_reader_run, &reader_args[i]) == 0);
+    }
+    char shared_title[32];
+    for (int i = 0; i < 2000; i++) {
+        sprintf(shared_title, "Titulo %d", i);
+        assert(content_add(&shared, shared_title, "Drama", 50, 0) > 0);
+        if (i % 10 == 0) {
+            assert(content_edit(&shared, shared_id, shared_title, NULL, 0, -1) == 1);
+        }
+        if (i % 100 == 0) {
+            assert(content_remove(&shared, shared.items[shared.count - 1].id) == 1);
+        }
+    }
+    __atomic_store_n(&stop_readers, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < 4; i++) {
+        pthread_join(reader_threads[i], NULL);
+        assert(reader_args[i].reads > 0);
+    }
+    assert(shared.count == 1 + 2000 - 20);
+    assert(content_reclaim(&shared) >= 0 && shared.retired_count == 0);
+    content_free_catalog(&shared);
+    
+    // Testar contadores de visualizações por thread e consolidação
+    ContentCatalog counted;
+    assert(content_init_catalog(&counted, 4) == 1);
+    int hot = content_add(&counted, "Popular", "Ação", 100, 12);
+    int cold = content_add(&counted, "Raro", "Drama", 100, 12);
+    pthread_t view_threads[4];
+    ViewWriterArgs view_args[4];
+    for (int i = 0; i < 4; i++) {
+        view_args[i].catalog = &counted;
+        view_args[i].id = hot;
+        assert(pthread_create(&view_threads[i], NULL, view_writer_run, &view_args[i]) == 0);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(view_threads[i], NULL);
+    }
+    assert(content_increment_views(&counted, cold) == 1);
+    assert(content_increment_views(&counted, 999) == 0);
+    const Content *hot_content = content_get_by_id(&counted, hot);
+    assert(hot_content->views == 0);
+    assert(content_get_views(&counted, hot_content) == 4000);
+    assert(content_fold_views(&counted) == 4001);
+    assert(hot_content->views == 4000);
+    assert(content_get_views(&counted, hot_content) == 4000);
+    assert(content_fold_views(&counted) == 0);
+    assert(content_remove(&counted, cold) == 1);
+    assert(content_increment_views(&counted, hot) == 1);
+    cold = content_add(&counted, "Novo", "Drama", 100, 12);  // Reutiliza o ID removido
+    assert(content_get_views(&counted, content_get_by_id(&counted, cold)) == 0);
+    assert(content_get_views(&counted, content_get_by_id(&counted, hot)) == 4001);
+    content_free_catalog(&counted);
+    
+    // IDs sem fatia ficam pendentes até à consolidação, sem tocar na versão publicada
+    FILE *far_file = fopen("test_far_views.csv", "w");
+    assert(far_file != NULL);
+    fprintf(far_file, "id,titulo,categoria,duracao,classificacao,visualizacoes\n");
+    fprintf(far_file, "5000000,Distante,Ação,100,12,7\n");
+    fclose(far_file);
+    ContentCatalog far;
+    assert(content_init_catalog(&far, 4) == 1);
+    assert(content_load_from_csv(&far, "test_far_views.csv") == 1);
+    const Content *far_content = content_get_by_id(&far, 5000000);
+    assert(far_content != NULL);
+    unsigned long far_generation = content_views_generation(&far);
+    assert(content_increment_views(&far, 5000000) == 1);
+    assert(content_increment_views(&far, 5000000) == 1);
+    assert(content_views_generation(&far) != far_generation);
+    assert(far_content->views == 7);
+    assert(content_get_views(&far, far_content) == 9);
+    assert(content_fold_views(&far) == 2);
+    assert(content_get_by_id(&far, 5000000)->views == 9);
+    assert(content_fold_views(&far) == 0);
+    content_free_catalog(&far);
+    remove("test_far_views.csv");
+    
     // Testar busca por ID
-    Content *content = content_get_by_id(&catalog, id1);
+    const Content *content = content_get_by_id(&catalog, id1);
     assert(content != NULL);
     assert(strcmp(content->title, "Filme 1") == 0);
     assert(strcmp(content->category, "Ação") == 0);
@@ -144,7 +414,7 @@ void test_content() {
     // Testar incremento de visualizações
     assert(content_increment_views(&catalog, id1) == 1);
     content = content_get_by_id(&catalog, id1);
-    assert(content->views == 1);
+    assert(content_get_views(&catalog, content) == 1);
     
     // Testar remoção de conteúdo
     assert(content_remove(&catalog, id2) == 1);
@@ -210,7 +480,7 @@ void test_user() {
     // Testar favoritos
     user = user_get_by_id(&manager, id1);
     assert(user->favorite_count == 1); // Devido à interação FAVORITE
-    assert(user->favorite_contents[0] == 102);
+    assert(user_get_favorites(user, NULL)[0] == 102);
     
     // Testar remoção de favoritos
     assert(user_remove_favorite(&manager, id1, 102) == 1);
@@ -221,7 +491,7 @@ void test_user() {
     assert(user_add_favorite(&manager, id1, 103) == 1);
     user = user_get_by_id(&manager, id1);
     assert(user->favorite_count == 1);
-    assert(user->favorite_contents[0] == 103);
+    assert(user_get_favorites(user, NULL)[0] == 103);
     
     // Testar salvamento e carregamento
     assert(user_save_to_csv(&manager, "test_user.csv") == 1);
@@ -242,6 +512,254 @@ void test_user() {
     assert(loaded_manager.count == 1);
     assert(user_get_by_id(&loaded_manager, id2) == NULL);
     
+    // Testar registro de interações em lote
+    Interaction events[4] = {
+        {id1, 104, INTERACTION_PLAY, 0},
+        {id2, 104, INTERACTION_FAVORITE, 1000},
+        {999, 104, INTERACTION_PLAY, 0},       // Utilizador inexistente
+        {id1, 105, INTERACTION_FAVORITE, 0}
+    };
+    assert(user_register_interactions_batch(&manager, NULL, events, 4) == 3);
+    assert(manager.interaction_count == 6);
+    assert(manager.interactions[4].timestamp == 1000);
+    assert(manager.interactions[3].timestamp != 0);
+    assert(user_get_by_id(&manager, id1)->favorite_count == 2);
+    assert(user_get_by_id(&manager, id2)->favorite_count == 1);
+    
+    // Testar favoritos ordenados e sem limite fixo
+    for (int i = 300; i > 100; i--) {
+        assert(user_add_favorite(&manager, id2, i) == 1);
+    }
+    int favorite_count;
+    const int *favorites = user_get_favorites(user_get_by_id(&manager, id2), &favorite_count);
+    assert(favorite_count == 200);
+    for (int i = 1; i < favorite_count; i++) {
+        assert(favorites[i - 1] < favorites[i]);
+    }
+    assert(user_has_favorite(&manager, id2, 150) == 1);
+    assert(user_has_favorite(&manager, id2, 301) == 0);
+    for (int i = 101; i <= 299; i++) {
+        assert(user_remove_favorite(&manager, id2, i) == 1);
+    }
+    assert(user_get_by_id(&manager, id2)->favorite_count == 1);
+    assert(user_get_favorites(user_get_by_id(&manager, id2), NULL)[0] == 300);
+    
+    // Testar relógio simulado e timestamps explícitos
+    user_set_mock_clock(&manager, 5000, 10);
+    assert(user_register_interaction(&manager, id1, 101, INTERACTION_PAUSE) == 1);
+    assert(user_register_interaction(&manager, id1, 101, INTERACTION_PLAY) == 1);
+    assert(manager.interactions[6].timestamp == 5000);
+    assert(manager.interactions[7].timestamp == 5010);
+    assert(user_register_interaction_at(&manager, id2, 101, INTERACTION_PLAY, 42) == 1);
+    assert(manager.interactions[8].timestamp == 42);
+    assert(user_register_interaction(&manager, 999, 101, INTERACTION_PLAY) == 0);
+    assert(user_clock_now(&manager) == 5020);       // O utilizador inválido não leu o relógio
+    
+    // Um lote lê o relógio uma única vez, mesmo que a leitura seja 0
+    user_set_mock_clock(&manager, 0, 5);
+    Interaction untimed[2] = {
+        {id1, 102, INTERACTION_PLAY, 0},
+        {id2, 102, INTERACTION_PLAY, 0}
+    };
+    assert(user_register_interactions_batch(&manager, NULL, untimed, 2) == 2);
+    assert(manager.interactions[9].timestamp == 0 && manager.interactions[10].timestamp == 0);
+    assert(user_clock_now(&manager) == 5);
+    
+    // Testar conversão de tipos de interação (texto e coluna numérica)
+    assert(user_interaction_type_from_string("PLAY") == INTERACTION_PLAY);
+    assert(user_interaction_type_from_string("pause") == INTERACTION_PAUSE);
+    assert(user_interaction_type_from_string("Complete") == INTERACTION_COMPLETE);
+    assert(user_interaction_type_from_string("fAvOrItE") == INTERACTION_FAVORITE);
+    assert(user_interaction_type_from_string("3") == INTERACTION_FAVORITE);
+    assert(user_interaction_type_from_string("1") == INTERACTION_PAUSE);
+    assert(user_interaction_type_from_string("PLAYS") == INTERACTION_PLAY);
+    assert(user_interaction_type_from_string("COMPLETED") == INTERACTION_PLAY);
+    assert(user_interaction_type_from_string("CAVORITE") == INTERACTION_PLAY);
+    
+    // Testar eliminação de eventos repetidos na ingestão
+    ContentCatalog dedup_catalog;
+    assert(content_init_catalog(&dedup_catalog, 4) == 1);
+    int dedup_content = content_add(&dedup_catalog, "Filme", "Ação", 100, 12);
+    assert(user_set_dedup_window(&manager, 5) == 1);
+    user_set_mock_clock(&manager, 10000, 1);
+    int before_dedup = manager.interaction_count;
+    assert(user_ingest_interaction(&manager, &dedup_catalog, id1, dedup_content, INTERACTION_PLAY) == 1);
+    assert(user_ingest_interaction(&manager, &dedup_catalog, id1, dedup_content, INTERACTION_PLAY) == 2);
+    assert(user_ingest_interaction(&manager, &dedup_catalog, id1, dedup_content, INTERACTION_PAUSE) == 1);
+    Interaction retries[3] = {
+        {id1, dedup_content, INTERACTION_PLAY, 10003},
+        {id1, dedup_content, INTERACTION_PLAY, 10005},  // Fora da janela
+        {id2, dedup_content, INTERACTION_PLAY, 10005}
+    };
+    assert(user_register_interactions_batch(&manager, &dedup_catalog, retries, 3) == 2);
+    // O registo direto também descarta o repetido
+    assert(user_register_interaction_at(&manager, id2, dedup_content, INTERACTION_PLAY, 10006) == 2);
+    assert(manager.interaction_count == before_dedup + 4);
+    assert(content_get_views(&dedup_catalog, content_get_by_id(&dedup_catalog, dedup_content)) == 3);
+    assert(manager.dedup.dropped == 3);
+    assert(user_set_dedup_window(&manager, 0) == 1);
+    content_free_catalog(&dedup_catalog);
+    
+    // Uma posição expirada antes da chave não esconde o repetido (1 e 4097 colidem na tabela)
+    UserManager probed;
+    assert(user_init_manager(&probed, 4, 4) == 1);
+    int probed_id = user_add(&probed, "Sondas");
+    assert(user_set_dedup_window(&probed, 10) == 1);
+    assert(user_register_interaction_at(&probed, probed_id, 1, INTERACTION_PLAY, 100) == 1);
+    assert(user_register_interaction_at(&probed, probed_id, 4097, INTERACTION_PLAY, 105) == 1);
+    assert(user_register_interaction_at(&probed, probed_id, 4097, INTERACTION_PLAY, 111) == 2);
+    assert(probed.interaction_count == 2);
+    user_free_manager(&probed);
+    
+    // Testar retenção e compactação incremental das interações antigas
+    UserManager retained;
+    assert(user_init_manager(&retained, 10, 4) == 1);
+    int old_id = user_add(&retained, "Antigo");
+    for (int i = 0; i < 6; i++) {
+        assert(user_register_interaction_at(&retained, old_id, 201 + (i % 2), INTERACTION_PLAY, 100 + i) == 1);
+    }
+    assert(user_register_interaction_at(&retained, old_id, 201, INTERACTION_COMPLETE, 10 * 86400) == 1);
+    user_set_retention(&retained, 1);
+    assert(user_compact_interactions(&retained, 10 * 86400, 4) == 4);
+    assert(retained.interaction_count == 3);
+    assert(user_compact_interactions(&retained, 10 * 86400, 4) == 2);
+    assert(user_compact_interactions(&retained, 10 * 86400, 4) == 0);
+    assert(retained.interaction_count == 1);
+    assert(retained.interactions[0].type == INTERACTION_COMPLETE);
+    assert(retained.retention.count == 2);
+    assert(user_get_interaction_count(&retained, old_id) == 7);
+    for (int i = 0; i < 10; i++) {
+        assert(user_register_interaction_at(&retained, old_id, 203, INTERACTION_PAUSE, 11 * 86400) == 1);
+    }
+    assert(retained.interaction_count == 11);
+    assert(retained.interactions[0].type == INTERACTION_COMPLETE);
+    assert(user_save_aggregates_to_csv(&retained, "test_aggregates.csv") == 1);
+    
+    UserManager reloaded;
+    assert(user_init_manager(&reloaded, 10, 4) == 1);
+    assert(user_add(&reloaded, "Antigo") == old_id);
+    assert(user_load_aggregates_from_csv(&reloaded, "test_aggregates.csv") == 2);
+    assert(user_get_by_id(&reloaded, old_id)->interaction_count == 6);
+    assert(user_get_interaction_count(&reloaded, old_id) == 6);
+    user_free_manager(&retained);
+    user_free_manager(&reloaded);
+    remove("test_aggregates.csv");
+    
+    // Testar a compactação de um histórico fora da ordem cronológica (ordenado por utilizador)
+    UserManager unordered;
+    assert(user_init_manager(&unordered, 10, 4) == 1);
+    int unordered_a = user_add(&unordered, "A");
+    int unordered_b = user_add(&unordered, "B");
+    assert(user_register_interaction_at(&unordered, unordered_a, 401, INTERACTION_PLAY, 10 * 86400) == 1);
+    assert(user_register_interaction_at(&unordered, unordered_b, 402, INTERACTION_PLAY, 100) == 1);
+    assert(user_register_interaction_at(&unordered, unordered_a, 403, INTERACTION_PLAY, 200) == 1);
+    assert(user_register_interaction_at(&unordered, unordered_b, 404, INTERACTION_PLAY, 10 * 86400 + 1) == 1);
+    assert(user_register_interaction_at(&unordered, unordered_a, 405, INTERACTION_PLAY, 300) == 1);
+    assert(user_sort_interactions(&unordered, 1) == 1);
+    user_set_retention(&unordered, 1);
+    assert(user_compact_interactions(&unordered, 10 * 86400, 10) == 3);
+    assert(unordered.interaction_count == 2 && unordered.order.count == 2);
+    int unordered_count = 0;
+    assert(user_get_interactions(&unordered, unordered_a, &unordered_count) != NULL && unordered_count == 1);
+    assert(user_get_interactions(&unordered, unordered_b, &unordered_count)->content_id == 404);
+    // Reposição de um evento antigo no fim do histórico: a varredura limitada chega lá em passos
+    assert(user_register_interaction_at(&unordered, unordered_b, 406, INTERACTION_PLAY, 50) == 1);
+    assert(user_compact_interactions(&unordered, 10 * 86400, 1) == 0);
+    assert(user_compact_interactions(&unordered, 10 * 86400, 1) == 0);
+    assert(user_compact_interactions(&unordered, 10 * 86400, 1) == 1);
+    assert(unordered.interaction_count == 2 && unordered.retention.count == 4);
+    assert(user_save_interactions_to_csv(&unordered, "test_unordered.csv") == 1);
+    user_free_manager(&unordered);
+    assert(user_init_manager(&unordered, 10, 4) == 1);
+    assert(user_load_interactions_from_csv(&unordered, "test_unordered.csv") == 2);
+    assert(unordered.interactions[0].content_id == 401 && unordered.interactions[1].content_id == 404);
+    user_free_manager(&unordered);
+    remove("test_unordered.csv");
+    
+    // As linhas antigas no meio do histórico só saem no fim da varredura, numa passagem
+    UserManager swept;
+    assert(user_init_manager(&swept, 10, 8) == 1);
+    int swept_id = user_add(&swept, "Varrido");
+    for (int i = 0; i < 5; i++) {
+        time_t timestamp = i % 2 == 0 ? 10 * 86400 : 100 * i;
+        assert(user_register_interaction_at(&swept, swept_id, 501 + i, INTERACTION_PLAY, timestamp) == 1);
+    }
+    user_set_retention(&swept, 1);
+    assert(user_compact_interactions(&swept, 10 * 86400, 2) == 0);
+    assert(swept.interaction_count == 5 && swept.retention.pending == 1);
+    assert(user_compact_interactions(&swept, 10 * 86400, 2) == 0);
+    assert(swept.interaction_count == 5 && swept.retention.pending == 2);
+    assert(user_compact_interactions(&swept, 10 * 86400, 2) == 2);
+    assert(swept.interaction_count == 3 && swept.retention.cursor == 0 && swept.retention.pending == 0);
+    assert(swept.interactions[0].content_id == 501 && swept.interactions[1].content_id == 503 && 
+           swept.interactions[2].content_id == 505);
+    assert(user_get_interaction_count(&swept, swept_id) == 5);
+    user_free_manager(&swept);
+    
+    // Testar ordenação das interações por (utilizador, timestamp) e exportação na ordem original
+    UserManager sorted;
+    assert(user_init_manager(&sorted, 10, 4) == 1);
+    int sorted_a = user_add(&sorted, "A");
+    int sorted_b = user_add(&sorted, "B");
+    int sorted_c = user_add(&sorted, "C");
+    int sorted_users[3] = {sorted_c, sorted_a, sorted_b};
+    for (int i = 0; i < 300; i++) {
+        assert(user_register_interaction_at(&sorted, sorted_users[i % 3], 300 + i, 
+                                            INTERACTION_PLAY, 1000 - (i % 50) * 10) == 1);
+    }
+    assert(user_sort_interactions(&sorted, 3) == 1);
+    for (int i = 1; i < sorted.interaction_count; i++) {
+        Interaction *previous = &sorted.interactions[i - 1];
+        Interaction *current = &sorted.interactions[i];
+        assert(previous->user_id < current->user_id || 
+               (previous->user_id == current->user_id && previous->timestamp <= current->timestamp));
+        // Estabilidade: com chaves iguais mantém-se a ordem de chegada
+        if (previous->user_id == current->user_id && previous->timestamp == current->timestamp) {
+            assert(previous->content_id < current->content_id);
+        }
+    }
+    int range_count = 0;
+    const Interaction *range = user_get_interaction_range(&sorted, sorted_a, 600, 700, &range_count);
+    assert(range != NULL && range_count == 22);
+    assert(range[0].user_id == sorted_a && range[0].timestamp == 600);
+    assert(range[range_count - 1].timestamp == 700);
+    assert(user_get_interaction_range(&sorted, sorted_b, 2000, 3000, &range_count) == NULL);
+    assert(range_count == 0);
+    assert(user_register_interaction_at(&sorted, sorted_a, 999, INTERACTION_PAUSE, 5) == 1);
+    assert(user_remove(&sorted, sorted_b) == 1);
+    assert(user_save_interactions_to_csv(&sorted, "test_sorted.csv") == 1);
+    
+    UserManager unsorted;
+    assert(user_init_manager(&unsorted, 10, 4) == 1);
+    assert(user_load_interactions_from_csv(&unsorted, "test_sorted.csv") == 201);
+    for (int i = 0, j = 0; i < 300; i++) {
+        if (sorted_users[i % 3] != sorted_b) {
+            assert(unsorted.interactions[j++].content_id == 300 + i);
+        }
+    }
+    assert(unsorted.interactions[200].content_id == 999);
+    user_free_manager(&sorted);
+    user_free_manager(&unsorted);
+    remove("test_sorted.csv");
+    
+    // Testar remoção em lote, preservando a ordem das interações
+    int id3 = user_add(&manager, "Utilizador3");
+    assert(user_register_interaction_at(&manager, id3, 101, INTERACTION_PLAY, 1) == 1);
+    assert(user_register_interaction_at(&manager, id1, 102, INTERACTION_PLAY, 2) == 1);
+    assert(user_register_interaction_at(&manager, id3, 103, INTERACTION_PLAY, 3) == 1);
+    int remove_ids[3] = {id2, 999, id3};
+    int before = manager.interaction_count;
+    int id2_interactions = user_get_interaction_count(&manager, id2);
+    assert(user_remove_batch(&manager, remove_ids, 3) == 2);
+    assert(manager.count == 1);
+    assert(user_get_by_id(&manager, id1) != NULL);
+    assert(user_get_by_id(&manager, id3) == NULL);
+    assert(manager.interaction_count == before - id2_interactions - 2);
+    for (int i = 0; i < manager.interaction_count; i++) {
+        assert(manager.interactions[i].user_id == id1);
+    }
+    assert(manager.interactions[manager.interaction_count - 1].timestamp == 2);
+    
     // Limpar recursos
     user_free_manager(&manager);
     user_free_manager(&loaded_manager);
@@ -251,6 +769,1026 @@ void test_user() {
     printf("Módulo user testado com sucesso!\n");
 }
 
+/**
+ * @brief Testes para o módulo de sessões
+ */
+void test_session() {
+    printf("Testando módulo session...\n");
+    
+    ContentCatalog catalog;
+    assert(content_init_catalog(&catalog, 10) == 1);
+    int film = content_add(&catalog, "Filme", "Ação", 2, 12);   // 120 segundos
+    int series = content_add(&catalog, "Série", "Drama", 60, 12);
+    
+    UserManager manager;
+    assert(user_init_manager(&manager, 10, 100) == 1);
+    int user_id = user_add(&manager, "Utilizador1");
+    int other_id = user_add(&manager, "Utilizador2");
+    
+    // PLAY, PAUSE, PLAY, COMPLETE no mesmo conteúdo formam uma sessão
+    assert(user_register_interaction_at(&manager, user_id, series, INTERACTION_PLAY, 1000) == 1);
+    assert(user_register_interaction_at(&manager, user_id, series, INTERACTION_PAUSE, 1100) == 1);
+    assert(user_register_interaction_at(&manager, user_id, series, INTERACTION_PLAY, 1200) == 1);
+    assert(user_register_interaction_at(&manager, user_id, series, INTERACTION_COMPLETE, 1500) == 1);
+    
+    // PLAY longo no filme, interrompido por um PLAY noutro conteúdo
+    assert(user_register_interaction_at(&manager, user_id, film, INTERACTION_PLAY, 2000) == 1);
+    assert(user_register_interaction_at(&manager, user_id, series, INTERACTION_PLAY, 2500) == 1);
+    assert(user_register_interaction_at(&manager, other_id, film, INTERACTION_PLAY, 2000) == 1);
+    
+    Session sessions[10];
+    int count = session_get_by_user(&manager.sessions, user_id, sessions, 10);
+    assert(count == 3);
+    assert(sessions[2].content_id == series);
+    assert(sessions[2].start == 1000 && sessions[2].end == 1500);
+    assert(sessions[2].pauses == 1);
+    assert(sessions[2].completed == 1);
+    assert(sessions[2].watch_seconds == 400);
+    assert(sessions[1].content_id == film);
+    assert(sessions[1].watch_seconds == 500);
+    assert(session_watch_seconds(&sessions[1], &catalog) == 120); // Limitado pela duração
+    assert(sessions[1].completed == 0);
+    
+    assert(session_get_by_content(&manager.sessions, film, sessions, 10) == 2);
+    assert(session_total_watch_by_user(&manager.sessions, &catalog, user_id) == 520);
+    assert(session_total_watch_by_content(&manager.sessions, &catalog, film) == 120);
+    
+    // Inatividade longa abre uma nova sessão sem contar o intervalo
+    assert(user_register_interaction_at(&manager, user_id, series, INTERACTION_PAUSE, 2600) == 1);
+    assert(user_register_interaction_at(&manager, user_id, series, INTERACTION_PLAY, 2600 + SESSION_IDLE_TIMEOUT + 1) == 1);
+    assert(session_get_by_user(&manager.sessions, user_id, sessions, 10) == 4);
+    assert(sessions[1].watch_seconds == 100);
+    
+    // Remover um utilizador remove as suas sessões
+    assert(user_remove(&manager, user_id) == 1);
+    assert(session_get_by_user(&manager.sessions, user_id, sessions, 10) == 0);
+    assert(session_get_by_content(&manager.sessions, film, sessions, 10) == 1);
+    assert(sessions[0].user_id == other_id);
+    
+    content_free_catalog(&catalog);
+    user_free_manager(&manager);
+    
+    printf("Módulo session testado com sucesso!\n");
+}
+
+// Argumentos de uma thread de escrita do teste de partições
+typedef struct {
+    UserManager *manager;
+    int user_id;
+} ShardWriter;
+
+// Registra 1000 interações de um utilizador numa thread
+static void *shard_writer_run(void *arg) {
+    ShardWriter *writer = (ShardWriter*)arg;
+    for (int i = 0; i < 1000; i++) {
+        user_register_interaction_at(writer->manager, writer->user_id, 1 + i % 10, 
+                                     INTERACTION_PLAY, 1000 + i);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Testes para o módulo de utilizadores particionados
+ */
+void test_usershard() {
+    printf("Testando módulo usershard...\n");
+    
+    // Gerenciador carregado normalmente e depois particionado
+    UserManager manager;
+    assert(user_init_manager(&manager, 4, 4) == 1);
+    int a = user_add(&manager, "A");
+    int b = user_add(&manager, "B");
+    assert(user_add_favorite(&manager, b, 9) == 1);
+    assert(user_register_interaction_at(&manager, a, 9, INTERACTION_COMPLETE, 10) == 1);
+    assert(user_register_interaction_at(&manager, b, 8, INTERACTION_PLAY, 11) == 1);
+    assert(user_set_dedup_window(&manager, 5) == 1);
+    
+    assert(user_enable_shards(&manager, 4) == 1);
+    assert(manager.sharded != NULL && manager.count == 0 && manager.interaction_count == 0);
+    assert(usershard_count(manager.sharded) == 2);
+    assert(user_has_favorite(&manager, b, 9) == 1);
+    assert(user_has_watched(&manager, a, 9) == 1);
+    assert(user_get_interaction_count(&manager, b) == 1);
+    assert(user_get_by_id(&manager, a) != NULL);
+    assert(user_get_by_username(&manager, "B")->id == b);
+    assert(user_enable_shards(&manager, 2) == 0);           // Já particionado
+    assert(user_load_from_csv(&manager, "usershard.csv") == -1);
+    
+    // Criação com IDs globais e nomes únicos entre partições
+    int ids[8];
+    char username[20];
+    for (int i = 0; i < 8; i++) {
+        sprintf(username, "Utilizador%d", i);
+        ids[i] = user_add(&manager, username);
+        assert(ids[i] == b + 1 + i);
+    }
+    assert(user_add(&manager, "Utilizador3") == -1);
+    assert(user_add(&manager, "A") == -1);
+    assert(user_add_with_id(&manager, ids[2], "Outro") == -1);
+    assert(usershard_count(manager.sharded) == 10);
+    
+    // Cada utilizador vive apenas na sua partição
+    UserManager *shard = usershard_lock(manager.sharded, ids[5]);
+    assert(shard->sharded == NULL && user_get_by_id(shard, ids[5]) != NULL);
+    usershard_unlock(manager.sharded, ids[5]);
+    
+    // Escritas concorrentes de vários utilizadores pela API user_*
+    pthread_t threads[8];
+    ShardWriter writers[8];
+    for (int i = 0; i < 8; i++) {
+        writers[i].manager = &manager;
+        writers[i].user_id = ids[i];
+        assert(pthread_create(&threads[i], NULL, shard_writer_run, &writers[i]) == 0);
+    }
+    for (int i = 0; i < 8; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < 8; i++) {
+        assert(user_get_interaction_count(&manager, ids[i]) == 1000);
+    }
+    assert(user_has_watched(&manager, ids[2], 7) == 1);
+    assert(user_has_watched(&manager, ids[2], 11) == 0);
+    
+    // A janela de duplicados passou para as partições
+    assert(user_register_interaction_at(&manager, ids[3], 1, INTERACTION_PLAY, 1992) == 2);
+    
+    // Favoritos e remoção encaminhados para a partição certa
+    assert(user_add_favorite(&manager, ids[1], 42) == 1);
+    assert(user_has_favorite(&manager, ids[1], 42) == 1);
+    assert(user_remove_favorite(&manager, ids[1], 42) == 1);
+    assert(user_has_favorite(&manager, ids[1], 42) == 0);
+    assert(user_register_interaction_at(&manager, ids[6], 3, INTERACTION_PAUSE, 5000) == 1);
+    assert(user_remove(&manager, ids[0]) == 1);
+    assert(usershard_count(manager.sharded) == 9);
+    assert(user_register_interaction(&manager, ids[0], 1, INTERACTION_PLAY) == 0);
+    int gone[2] = {ids[7], ids[7]};
+    assert(user_remove_batch(&manager, gone, 2) == 1);
+    assert(user_get_by_id(&manager, ids[7]) == NULL);
+    
+    // Lote repartido pelas partições (eventos de utilizadores removidos são ignorados)
+    Interaction events[3] = {
+        {a, 5, INTERACTION_PLAY, 20}, {b, 5, INTERACTION_PLAY, 21}, {ids[0], 5, INTERACTION_PLAY, 22}
+    };
+    assert(user_register_interactions_batch(&manager, NULL, events, 3) == 2);
+    assert(user_has_watched(&manager, a, 5) == 1 && user_has_watched(&manager, b, 5) == 1);
+    
+    // Relógio simulado copiado para todas as partições
+    user_set_mock_clock(&manager, 7000, 1);
+    assert(user_register_interaction(&manager, ids[2], 4, INTERACTION_COMPLETE) == 1);
+    assert(user_get_by_id(&manager, ids[2])->last_interaction == 7000);
+    
+    // Relatório por scatter-gather sobre todas as partições
+    UserReportItem active[3];
+    assert(report_most_active_users(&manager, active, 3) == 3);
+    assert(active[0].count == 1001 && active[1].count == 1001 && active[2].count == 1000);
+    assert((active[0].user_id == ids[2] || active[0].user_id == ids[6]) && 
+           (active[1].user_id == ids[2] || active[1].user_id == ids[6]));
+    
+    // Histórico ordenado em cada partição
+    int history_count = 0;
+    assert(user_sort_interactions(&manager, 2) == 1);
+    const Interaction *history = user_get_interactions(&manager, ids[1], &history_count);
+    assert(history != NULL && history_count == 1000 && history[0].user_id == ids[1]);
+    
+    // Compactação com um limite de linhas partilhado pelas partições
+    user_set_retention(&manager, 1);
+    time_t now = 7000 + 2 * 24 * 60 * 60;
+    assert(user_compact_interactions(&manager, now, 10) == 10);
+    assert(user_compact_interactions(&manager, now, 100000) == 2 + 2 + 6 * 1000 + 1 + 1 - 10);
+    
+    user_free_manager(&manager);
+    assert(manager.sharded == NULL);
+    
+    printf("Módulo usershard testado com sucesso!\n");
+}
+
+// Marca cada posição do intervalo (deteta posições visitadas duas vezes)
+static void pool_mark_range(void *context, int begin, int end) {
+    int *marks = (int*)context;
+    for (int i = begin; i < end; i++) {
+        __atomic_add_fetch(&marks[i], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Soma os índices do intervalo num parcial long long
+static void pool_sum_range(void *context, int begin, int end, void *partial) {
+    (void)context;
+    for (int i = begin; i < end; i++) {
+        *(long long*)partial += i;
+    }
+}
+
+static void pool_sum_combine(void *context, void *into, const void *from) {
+    (void)context;
+    *(long long*)into += *(const long long*)from;
+}
+
+// Tarefa externa que lança o seu próprio ciclo paralelo (paralelismo aninhado)
+typedef struct {
+    ThreadPool *pool;
+    int *marks;
+    int offset;
+} PoolNestedTask;
+
+static void pool_nested_run(void *arg) {
+    PoolNestedTask *task = (PoolNestedTask*)arg;
+    threadpool_parallel_for(task->pool, task->offset, task->offset + 1000, 16, 
+                            pool_mark_range, task->marks);
+}
+
+/**
+ * @brief Testes para o módulo de conjunto de threads
+ */
+void test_threadpool() {
+    printf("Testando módulo threadpool...\n");
+    
+    ThreadPool pool;
+    assert(threadpool_init(&pool, 0) == 0);
+    assert(threadpool_init(&pool, THREADPOOL_MAX_WORKERS + 1) == 0);
+    assert(threadpool_init(&pool, 2) == 1);
+    assert(pool.worker_count == 2);
+    
+    // Ciclo paralelo cobre cada posição exatamente uma vez
+    int *marks = (int*)calloc(10000, sizeof(int));
+    assert(marks != NULL);
+    threadpool_parallel_for(&pool, 0, 10000, 7, pool_mark_range, marks);
+    for (int i = 0; i < 10000; i++) {
+        assert(marks[i] == 1);
+    }
+    
+    // Sem conjunto, o mesmo ciclo corre em série
+    threadpool_parallel_for(NULL, 0, 10000, 7, pool_mark_range, marks);
+    assert(marks[0] == 2 && marks[9999] == 2);
+    
+    // Redução paralela igual à soma em série
+    long long identity = 0, sum = -1;
+    assert(threadpool_parallel_reduce(&pool, 0, 100000, 333, pool_sum_range, pool_sum_combine, 
+                                      NULL, &sum, &identity, sizeof(long long)) == 1);
+    assert(sum == 100000LL * 99999LL / 2);
+    assert(threadpool_parallel_reduce(&pool, 5, 5, 10, pool_sum_range, pool_sum_combine, 
+                                      NULL, &sum, &identity, sizeof(long long)) == 1);
+    assert(sum == 0);
+    
+    // Grupo de tarefas em que cada tarefa faz um ciclo paralelo aninhado
+    memset(marks, 0, 10000 * sizeof(int));
+    PoolNestedTask tasks[10];
+    ThreadPoolGroup group;
+    threadpool_group_init(&group, &pool);
+    for (int i = 0; i < 10; i++) {
+        tasks[i].pool = &pool;
+        tasks[i].marks = marks;
+        tasks[i].offset = i * 1000;
+        threadpool_group_spawn(&group, pool_nested_run, &tasks[i]);
+    }
+    threadpool_group_wait(&group);
+    assert(group.pending == 0);
+    for (int i = 0; i < 10000; i++) {
+        assert(marks[i] == 1);
+    }
+    
+    // Conjunto partilhado pelo programa
+    assert(threadpool_get_default() == NULL);
+    threadpool_set_default(&pool);
+    assert(threadpool_get_default() == &pool);
+    
+    // A ordenação das interações usa o conjunto partilhado quando definido
+    UserManager manager;
+    assert(user_init_manager(&manager, 4, 4) == 1);
+    int a = user_add(&manager, "A");
+    int b = user_add(&manager, "B");
+    for (int i = 0; i < 1000; i++) {
+        assert(user_register_interaction_at(&manager, i % 2 ? a : b, 1 + i % 20, 
+                                            INTERACTION_PLAY, 5000 - i) == 1);
+    }
+    assert(user_sort_interactions(&manager, 4) == 1);
+    for (int i = 1; i < manager.interaction_count; i++) {
+        assert(manager.interactions[i - 1].user_id < manager.interactions[i].user_id || 
+               manager.interactions[i - 1].timestamp <= manager.interactions[i].timestamp);
+    }
+    user_free_manager(&manager);
+    
+    free(marks);
+    threadpool_free(&pool);
+    assert(threadpool_get_default() == NULL);
+    
+    printf("Módulo threadpool testado com sucesso!\n");
+}
+
+/**
+ * @brief Testes para o módulo de arenas
+ */
+void test_arena() {
+    printf("Testando módulo arena...\n");
+    
+    Arena arena;
+    assert(arena_init(&arena, 256) == 1);
+    assert(arena.block_allocations == 0);
+    
+    // Pedidos alinhados servidos do mesmo bloco
+    char *a = (char*)arena_alloc(&arena, 3);
+    double *b = (double*)arena_alloc(&arena, 4 * sizeof(double));
+    assert(a != NULL && b != NULL);
+    assert(((size_t)b % ARENA_ALIGNMENT) == 0);
+    assert(arena.block_allocations == 1 && arena.allocations == 2);
+    
+    char *copy = arena_strdup(&arena, "Streamflix");
+    char *formatted = arena_printf(&arena, "%d-%s", 42, "x");
+    assert(strcmp(copy, "Streamflix") == 0);
+    assert(strcmp(formatted, "42-x") == 0);
+    
+    // Reposição até uma marca reutiliza a mesma memória
+    ArenaMark mark = arena_mark(&arena);
+    char *first = (char*)arena_alloc(&arena, 100);
+    arena_reset_to(&arena, mark);
+    char *second = (char*)arena_alloc(&arena, 100);
+    assert(first == second);
+    assert(strcmp(copy, "Streamflix") == 0);
+    
+    // Pedidos maiores que um bloco e blocos mantidos depois de arena_reset
+    assert(arena_alloc(&arena, 1000) != NULL);
+    assert(arena_alloc(&arena, 200) != NULL);
+    size_t blocks = arena.block_allocations;
+    assert(blocks >= 2);
+    arena_reset(&arena);
+    for (int round = 0; round < 10; round++) {
+        assert(arena_alloc(&arena, 100) != NULL);
+        assert(arena_alloc(&arena, 1000) != NULL);
+        assert(arena_alloc(&arena, 200) != NULL);
+        arena_reset(&arena);
+    }
+    assert(arena.block_allocations <= blocks + 1);
+    arena_free(&arena);
+    
+    // Arena de rascunho da thread, partilhada por chamadas aninhadas
+    Arena *scratch = arena_scratch();
+    assert(scratch == arena_scratch());
+    ArenaMark outer = arena_mark(scratch);
+    int *values = (int*)arena_alloc(scratch, 10 * sizeof(int));
+    assert(values != NULL);
+    values[9] = 7;
+    ArenaMark inner = arena_mark(scratch);
+    assert(arena_alloc(scratch, 100000) != NULL);
+    arena_reset_to(scratch, inner);
+    assert(values[9] == 7);
+    arena_reset_to(scratch, outer);
+    arena_scratch_free();
+    
+    printf("Módulo arena testado com sucesso!\n");
+}
+
+/**
+ * @brief Testes para o módulo de seleção dos K melhores
+ */
+void test_topk() {
+    printf("Testando módulo topk...\n");
+    
+    TopK best;
+    int ids[10];
+    assert(topk_init(&best, 0) == 0);
+    assert(topk_init(&best, 5) == 1);
+    
+    // Os 5 melhores de 1000 scores pseudo-aleatórios, por ordem decrescente
+    float scores[1000];
+    srand(3);
+    for (int i = 0; i < 1000; i++) {
+        scores[i] = (float)(rand() % 100);
+        topk_push(&best, i, scores[i]);
+    }
+    assert(topk_extract(&best, ids, 10) == 5);
+    for (int i = 0; i < 5; i++) {
+        // Nenhum candidato fora da seleção é melhor que o selecionado
+        int better = 0;
+        for (int j = 0; j < 1000; j++) {
+            if (scores[j] > scores[ids[i]] || (scores[j] == scores[ids[i]] && j < ids[i])) {
+                better++;
+            }
+        }
+        assert(better == i);
+    }
+    
+    // Empates resolvidos pela ordem de chegada; a seleção fica vazia depois de extraída
+    assert(best.count == 0);
+    topk_push(&best, 10, 1.0f);
+    topk_push(&best, 11, 2.0f);
+    topk_push(&best, 12, 1.0f);
+    topk_push(&best, 13, 2.0f);
+    assert(topk_extract(&best, ids, 3) == 3);
+    assert(ids[0] == 11 && ids[1] == 13 && ids[2] == 10);
+    topk_free(&best);
+    
+    // Recomendações consideram todo o catálogo, mesmo para além de 1000 títulos
+    ContentCatalog catalog;
+    assert(content_init_catalog(&catalog, 1500) == 1);
+    for (int i = 0; i < 1500; i++) {
+        content_add(&catalog, "Titulo", "Drama", 90, 12);
+    }
+    assert(content_add_views(&catalog, 1400, 50) == 1);
+    assert(content_add_views(&catalog, 7, 20) == 1);
+    content_fold_views(&catalog);
+    int recommendations[3];
+    assert(recommendation_by_popularity(&catalog, recommendations, 3) == 3);
+    assert(recommendations[0] == 1400 && recommendations[1] == 7 && recommendations[2] == 1);
+    content_free_catalog(&catalog);
+    
+    printf("Módulo topk testado com sucesso!\n");
+}
+
+// Compara as listas da tabela com o cálculo exaustivo por recommendation_calculate_similarity
+static int neighbors_match_brute_force(NeighborTable *table, ContentCatalog *catalog) {
+    int content_count;
+    const Content *items = content_snapshot(catalog, &content_count);
+    
+    for (int i = 0; i < content_count; i++) {
+        NeighborEntry expected[8];
+        int expected_count = 0;
+        
+        for (int j = 0; j < content_count; j++) {
+            if (j == i) {
+                continue;
+            }
+            float score = recommendation_calculate_similarity(&items[i], &items[j]);
+            int position = expected_count;
+            while (position > 0 && (score > expected[position - 1].score || 
+                   (score == expected[position - 1].score && items[j].id < expected[position - 1].id))) {
+                position--;
+            }
+            if (position >= table->neighbor_count) {
+                continue;
+            }
+            int last = expected_count < table->neighbor_count ? expected_count : table->neighbor_count - 1;
+            for (int k = last; k > position; k--) {
+                expected[k] = expected[k - 1];
+            }
+            expected[position].id = items[j].id;
+            expected[position].score = score;
+            if (expected_count < table->neighbor_count) {
+                expected_count++;
+            }
+        }
+        
+        int count;
+        const NeighborEntry *list = neighbors_get(table, items[i].id, &count);
+        if (list == NULL || count != expected_count) {
+            return 0;
+        }
+        for (int k = 0; k < count; k++) {
+            if (list[k].id != expected[k].id || list[k].score != expected[k].score) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Testes para o módulo de listas de conteúdos semelhantes
+ */
+void test_neighbors() {
+    printf("Testando módulo neighbors...\n");
+    
+    static const char *categories[] = {"Drama", "Comédia", "Ação", "Terror"};
+    ContentCatalog catalog;
+    assert(content_init_catalog(&catalog, 16) == 1);
+    srand(5);
+    for (int i = 0; i < 300; i++) {
+        content_add(&catalog, "Titulo", categories[rand() % 4], 30 + rand() % 150, (rand() % 4) * 6);
+    }
+    
+    // Construção paralela em blocos igual ao cálculo exaustivo (e à construção em série)
+    ThreadPool pool;
+    assert(threadpool_init(&pool, 2) == 1);
+    NeighborTable table;
+    assert(neighbors_init(&table, 0) == 0);
+    assert(neighbors_init(&table, 8) == 1);
+    assert(neighbors_build(&table, &catalog, &pool) == 1);
+    assert(neighbors_match_brute_force(&table, &catalog) == 1);
+    assert(neighbors_build(&table, &catalog, NULL) == 1);
+    assert(neighbors_match_brute_force(&table, &catalog) == 1);
+    threadpool_free(&pool);
+    
+    // Atualização incremental através do catálogo observado
+    assert(content_edit(&catalog, 10, NULL, "Documentário", 200, 18) == 1);
+    assert(content_edit(&catalog, 11, NULL, "Drama", 95, 12) == 1);
+    int added = content_add(&catalog, "Novo", "Ação", 100, 12);
+    assert(added == 301);
+    assert(content_remove(&catalog, 20) == 1);
+    // As listas cheias de onde um conteúdo saiu ficam marcadas em vez de recalculadas no observador
+    assert(table.recomputed == 0);
+    int dirty = table.dirty_count;
+    assert(dirty > 0);
+    unsigned long version = neighbors_version(&table);
+    assert(neighbors_repair(&table, NULL, 0) == dirty);
+    assert(table.dirty_count == 0 && table.recomputed == dirty);
+    assert(neighbors_version(&table) != version);
+    assert(neighbors_repair(&table, NULL, 0) == 0);
+    assert(neighbors_match_brute_force(&table, &catalog) == 1);
+    
+    int count;
+    assert(neighbors_get(&table, 20, &count) == NULL && count == 0);
+    assert(neighbors_get(&table, added, &count) != NULL && count == 8);
+    
+    // Recomendação pela junção das listas: exclui os assistidos e respeita o limite
+    int watched[2] = {1, 2};
+    int recommendations[5];
+    assert(neighbors_recommend(&table, watched, 2, recommendations, 5) == 5);
+    for (int i = 0; i < 5; i++) {
+        assert(recommendations[i] != 1 && recommendations[i] != 2 && recommendations[i] != 20);
+    }
+    
+    // O recomendador por similaridade usa a tabela quando está definida
+    UserManager manager;
+    assert(user_init_manager(&manager, 4, 4) == 1);
+    int user = user_add(&manager, "Vizinho");
+    assert(user_register_interaction(&manager, user, 1, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, user, 2, INTERACTION_COMPLETE) == 1);
+    int from_table[5];
+    recommendation_set_neighbors(&table);
+    assert(recommendation_by_content_similarity(&manager, &catalog, user, from_table, 5) == 5);
+    recommendation_set_neighbors(NULL);
+    assert(memcmp(from_table, recommendations, sizeof(from_table)) == 0);
+    
+    user_free_manager(&manager);
+    neighbors_free(&table);
+    assert(catalog.listener_count == 0);
+    content_free_catalog(&catalog);
+    
+    printf("Módulo neighbors testado com sucesso!\n");
+}
+
+/**
+ * @brief Testes para o módulo de cálculo vetorizado da similaridade
+ */
+void test_simkernel() {
+    printf("Testando módulo simkernel...\n");
+    
+    enum { CANDIDATES = 1037 };
+    static int categories[CANDIDATES], age_ratings[CANDIDATES], durations[CANDIDATES];
+    static float expected[CANDIDATES], scores[CANDIDATES];
+    srand(9);
+    for (int i = 0; i < CANDIDATES; i++) {
+        categories[i] = rand() % 5;
+        age_ratings[i] = (rand() % 4) * 6;
+        durations[i] = rand() % 8 == 0 ? 0 : rand() % 240;
+    }
+    
+    // A função de pares é a de recommendation_calculate_similarity
+    Content first, second;
+    strcpy(first.category, "C1");
+    strcpy(second.category, "C1");
+    first.age_rating = 12;
+    second.age_rating = 0;
+    first.duration = 90;
+    second.duration = 45;
+    assert(simkernel_similarity(1, 12, 90, 1, 0, 45) == recommendation_calculate_similarity(&first, &second));
+    second.duration = 0;
+    first.duration = 0;
+    strcpy(second.category, "C2");
+    assert(simkernel_similarity(1, 12, 0, 2, 0, 0) == recommendation_calculate_similarity(&first, &second));
+    
+    // Todas as versões suportadas dão os valores da referência, incluindo os restos de cada bloco
+    static const int lengths[] = {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, CANDIDATES};
+    for (int level = SIMKERNEL_SCALAR; level <= (int)simkernel_supported(); level++) {
+        assert(simkernel_set_level((SimKernelLevel)level) == (SimKernelLevel)level);
+        
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            int count = lengths[l];
+            for (int i = 0; i < count; i++) {
+                expected[i] = 0.0f;
+                expected[i] += simkernel_similarity(2, 12, 90, categories[i], age_ratings[i], durations[i]);
+                expected[i] += simkernel_similarity(4, 0, 0, categories[i], age_ratings[i], durations[i]);
+                scores[i] = 0.0f;
+            }
+            simkernel_accumulate(2, 12, 90, categories, age_ratings, durations, count, scores);
+            simkernel_accumulate(4, 0, 0, categories, age_ratings, durations, count, scores);
+            for (int i = 0; i < count; i++) {
+                assert(fabsf(scores[i] - expected[i]) <= 1e-6f);
+            }
+        }
+    }
+    assert(simkernel_set_level(SIMKERNEL_AVX2) == simkernel_supported());
+    assert(simkernel_level() == simkernel_supported());
+    
+    // Quando as listas de vizinhos não chegam, o score exato vetorizado dá o resultado da comparação par a par
+    ContentCatalog catalog;
+    UserManager manager;
+    NeighborTable table;
+    static const char *names[] = {"Drama", "Comédia", "Ação"};
+    assert(content_init_catalog(&catalog, 16) == 1);
+    assert(user_init_manager(&manager, 4, 8) == 1);
+    for (int i = 0; i < 200; i++) {
+        content_add(&catalog, "Titulo", names[rand() % 3], 20 + rand() % 160, (rand() % 4) * 6);
+    }
+    int user = user_add(&manager, "Escalar");
+    assert(user_register_interaction(&manager, user, 3, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, user, 50, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, user, 120, INTERACTION_COMPLETE) == 1);
+    
+    int exact[MAX_RECOMMENDATIONS], vectorized[MAX_RECOMMENDATIONS];
+    assert(recommendation_by_content_similarity(&manager, &catalog, user, exact, MAX_RECOMMENDATIONS) == MAX_RECOMMENDATIONS);
+    assert(neighbors_init(&table, 1) == 1);
+    assert(neighbors_build(&table, &catalog, NULL) == 1);
+    recommendation_set_neighbors(&table);
+    assert(recommendation_by_content_similarity(&manager, &catalog, user, vectorized, MAX_RECOMMENDATIONS) == MAX_RECOMMENDATIONS);
+    recommendation_set_neighbors(NULL);
+    assert(memcmp(exact, vectorized, sizeof(exact)) == 0);
+    
+    neighbors_free(&table);
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+    
+    printf("Módulo simkernel testado com sucesso!\n");
+}
+
+/**
+ * @brief Testes para o módulo de filtragem colaborativa
+ */
+void test_collab() {
+    printf("Testando módulo collab...\n");
+    
+    ContentCatalog catalog;
+    UserManager manager;
+    CollabModel model;
+    assert(content_init_catalog(&catalog, 8) == 1);
+    assert(user_init_manager(&manager, 8, 32) == 1);
+    for (int i = 0; i < 6; i++) {
+        content_add(&catalog, "Titulo", "Drama", 90, 12);
+    }
+    char username[MAX_USERNAME_LENGTH];
+    for (int i = 0; i < 5; i++) {
+        snprintf(username, sizeof(username), "colab%d", i);
+        assert(user_add(&manager, username) == i + 1);
+    }
+    
+    // 1 e 2 são vistos juntos por dois utilizadores, 3 por um, 4 e 5 por outro grupo
+    assert(user_register_interaction(&manager, 1, 1, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, 1, 2, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, 2, 1, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, 2, 2, INTERACTION_PLAY) == 1);
+    assert(user_register_interaction(&manager, 2, 2, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, 2, 3, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, 3, 4, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, 3, 5, INTERACTION_COMPLETE) == 1);
+    assert(user_register_interaction(&manager, 4, 1, INTERACTION_COMPLETE) == 1);
+    
+    assert(collab_init(&model, 0) == 0);
+    assert(collab_init(&model, 3) == 1);
+    assert(collab_build(&model, &manager, &catalog, NULL) == 1);
+    
+    // CSR com o par repetido fundido (fica o maior peso) e CSC com as mesmas entradas
+    assert(model.matrix.row_count == 4);
+    assert(model.matrix.entry_count == 8);
+    assert(model.matrix.row_offsets[1] - model.matrix.row_offsets[0] == 2);
+    assert(model.matrix.values[model.matrix.row_offsets[1] + 1] == COLLAB_WEIGHT_COMPLETE);
+    assert(model.matrix.column_offsets[2] - model.matrix.column_offsets[1] == 3);
+    assert(model.matrix.column_offsets[model.matrix.item_slots] == model.matrix.entry_count);
+    
+    // cos(1, 2) = (2*2 + 2*2) / (sqrt(12) * sqrt(8))
+    int count;
+    const NeighborEntry *list = collab_get_neighbors(&model, 1, &count);
+    assert(list != NULL && count == 2);
+    assert(list[0].id == 2 && fabsf(list[0].score - 8.0f / sqrtf(96.0f)) < 1e-6f);
+    assert(list[1].id == 3);
+    assert(collab_get_neighbors(&model, 6, &count) == NULL && count == 0);
+    
+    int recommendations[MAX_RECOMMENDATIONS];
+    assert(collab_recommend(&model, 4, recommendations, MAX_RECOMMENDATIONS) == 2);
+    assert(recommendations[0] == 2 && recommendations[1] == 3);
+    assert(collab_recommend(&model, 5, recommendations, MAX_RECOMMENDATIONS) == 0);
+    
+    // Fonte das recomendações personalizadas apenas para o gerenciador do modelo
+    UserManager other;
+    assert(user_init_manager(&other, 4, 4) == 1);
+    recommendation_set_collab(&model);
+    assert(recommendation_by_collaborative(&other, 4, recommendations, MAX_RECOMMENDATIONS) == 0);
+    assert(recommendation_by_collaborative(&manager, 4, recommendations, MAX_RECOMMENDATIONS) == 2);
+    int personalized = recommendation_personalized(&manager, &catalog, 4, recommendations, MAX_RECOMMENDATIONS);
+    int found = 0;
+    for (int i = 0; i < personalized; i++) {
+        found |= recommendations[i] == 2;
+    }
+    assert(found);
+    recommendation_set_collab(NULL);
+    user_free_manager(&other);
+    
+    // Conteúdos removidos do catálogo saem da matriz na reconstrução
+    assert(content_remove(&catalog, 3) == 1);
+    assert(collab_build(&model, &manager, &catalog, NULL) == 1);
+    assert(collab_get_neighbors(&model, 1, &count) != NULL && count == 1);
+    assert(collab_get_neighbors(&model, 3, &count) == NULL);
+    
+    // Produto esparso em paralelo igual ao cálculo em série e ao cosseno denso
+    enum { USERS = 60, ITEMS = 40 };
+    static float dense[USERS + 1][ITEMS + 1];
+    UserManager random_manager;
+    ContentCatalog random_catalog;
+    CollabModel serial;
+    ThreadPool pool;
+    assert(user_init_manager(&random_manager, USERS, 16) == 1);
+    assert(content_init_catalog(&random_catalog, ITEMS) == 1);
+    for (int i = 0; i < ITEMS; i++) {
+        content_add(&random_catalog, "Titulo", "Drama", 90, 12);
+    }
+    static const float weights[] = {COLLAB_WEIGHT_PLAY, COLLAB_WEIGHT_PAUSE, 
+                                    COLLAB_WEIGHT_COMPLETE, COLLAB_WEIGHT_FAVORITE};
+    srand(21);
+    for (int u = 1; u <= USERS; u++) {
+        snprintf(username, sizeof(username), "aleatorio%d", u);
+        assert(user_add(&random_manager, username) == u);
+        for (int k = 0; k < 6; k++) {
+            int item = 1 + rand() % ITEMS;
+            InteractionType type = (InteractionType)(rand() % 4);
+            user_register_interaction(&random_manager, u, item, type);
+            if (weights[type] > dense[u][item]) {
+                dense[u][item] = weights[type];
+            }
+        }
+    }
+    
+    assert(collab_init(&serial, 5) == 1);
+    assert(collab_build(&serial, &random_manager, &random_catalog, NULL) == 1);
+    assert(threadpool_init(&pool, 3) == 1);
+    collab_free(&model);
+    assert(collab_init(&model, 5) == 1);
+    assert(collab_build(&model, &random_manager, &random_catalog, &pool) == 1);
+    threadpool_free(&pool);
+    
+    for (int item = 1; item <= ITEMS; item++) {
+        int serial_count;
+        const NeighborEntry *parallel_list = collab_get_neighbors(&model, item, &count);
+        const NeighborEntry *serial_list = collab_get_neighbors(&serial, item, &serial_count);
+        assert(count == serial_count);
+        if (count > 0) {
+            assert(memcmp(parallel_list, serial_list, count * sizeof(NeighborEntry)) == 0);
+        }
+        
+        for (int other = 1; other <= ITEMS; other++) {
+            float dot = 0.0f, norm_item = 0.0f, norm_other = 0.0f;
+            for (int u = 1; u <= USERS; u++) {
+                dot += dense[u][item] * dense[u][other];
+                norm_item += dense[u][item] * dense[u][item];
+                norm_other += dense[u][other] * dense[u][other];
+            }
+            if (other == item || dot == 0.0f) {
+                continue;
+            }
+            float cosine = dot / (sqrtf(norm_item) * sqrtf(norm_other));
+            
+            // Cada vizinho tem o cosseno denso; quem ficou de fora não bate o último
+            int listed = 0;
+            for (int k = 0; k < count; k++) {
+                if (parallel_list[k].id == other) {
+                    listed = 1;
+                    assert(fabsf(parallel_list[k].score - cosine) < 1e-5f);
+                }
+            }
+            assert(listed || (count == 5 && cosine <= parallel_list[count - 1].score + 1e-5f));
+        }
+    }
+    
+    collab_free(&serial);
+    collab_free(&model);
+    user_free_manager(&random_manager);
+    content_free_catalog(&random_catalog);
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+    
+    printf("Módulo collab testado com sucesso!\n");
+}
+
+/**
+ * @brief Testes para o módulo als
+ */
+void test_als() {
+    printf("Testando módulo als...\n");
+    
+    ContentCatalog catalog;
+    UserManager manager;
+    AlsModel model;
+    assert(content_init_catalog(&catalog, 16) == 1);
+    assert(user_init_manager(&manager, 16, 64) == 1);
+    for (int i = 0; i < 10; i++) {
+        content_add(&catalog, "Titulo", "Drama", 90, 12);
+    }
+    
+    // Dois grupos: utilizadores 1-6 veem os conteúdos 1-5, 7-12 veem 6-10; o 1 não viu o 5
+    char username[MAX_USERNAME_LENGTH];
+    for (int u = 1; u <= 12; u++) {
+        snprintf(username, sizeof(username), "als%d", u);
+        assert(user_add(&manager, username) == u);
+        int first = u <= 6 ? 1 : 6;
+        for (int item = first; item < first + 5; item++) {
+            if (u == 1 && item == 5) {
+                continue;
+            }
+            assert(user_register_interaction(&manager, u, item, 
+                                             item % 2 ? INTERACTION_COMPLETE : INTERACTION_PLAY) == 1);
+        }
+    }
+    assert(user_register_interaction(&manager, 13, 1, INTERACTION_PAUSE) == 0);
+    
+    assert(als_init(&model, 0, 0.1f, 10.0f) == 0);
+    assert(als_init(&model, ALS_MAX_FACTORS + 1, 0.1f, 10.0f) == 0);
+    assert(als_init(&model, 4, 0.0f, 10.0f) == 0);
+    assert(als_init(&model, 4, 0.1f, 10.0f) == 1);
+    assert(als_train(&model, &manager, &catalog, 0, NULL) == 0);
+    assert(als_train(&model, &manager, &catalog, 10, NULL) == 1);
+    assert(model.stride == 8);
+    assert(((uintptr_t)model.user_factors % ALS_ALIGNMENT) == 0);
+    assert(((uintptr_t)model.item_factors % ALS_ALIGNMENT) == 0);
+    
+    // O conteúdo em falta do grupo vem primeiro e o histórico não é recomendado
+    int recs[10];
+    int count = als_recommend(&model, 1, recs, 10);
+    assert(count == 6);
+    assert(recs[0] == 5);
+    for (int i = 0; i < count; i++) {
+        assert(recs[i] == 5 || recs[i] > 5);
+    }
+    assert(als_predict(&model, 1, 5) > als_predict(&model, 1, 8));
+    assert(als_predict(&model, 7, 8) > als_predict(&model, 7, 2));
+    assert(als_predict(&model, 99, 1) == 0.0f);
+    assert(als_recommend(&model, 99, recs, 10) == 0);
+    assert(als_recommend(&model, 1, recs, 0) == -1);
+    
+    // O produto interno de cada versão coincide com o escalar a menos do arredondamento
+    float query[8], rows[5 * 8], expected[5], scores[5];
+    for (int k = 0; k < 8; k++) {
+        query[k] = 0.25f * k - 0.5f;
+    }
+    for (int i = 0; i < 5 * 8; i++) {
+        rows[i] = (float)((i * 7) % 11) / 11.0f;
+    }
+    SimKernelLevel level_in_use = simkernel_level();
+    simkernel_set_level(SIMKERNEL_SCALAR);
+    simkernel_dot_rows(query, rows, 7, 8, 5, expected);
+    for (int level = SIMKERNEL_SCALAR; level <= (int)simkernel_supported(); level++) {
+        simkernel_set_level((SimKernelLevel)level);
+        simkernel_dot_rows(query, rows, 7, 8, 5, scores);
+        for (int i = 0; i < 5; i++) {
+            assert(fabsf(scores[i] - expected[i]) < 1e-5f);
+        }
+    }
+    simkernel_set_level(level_in_use);
+    
+    // O treino em paralelo produz os mesmos fatores que o treino em série
+    AlsModel parallel;
+    ThreadPool pool;
+    assert(threadpool_init(&pool, 3) == 1);
+    assert(als_init(&parallel, 4, 0.1f, 10.0f) == 1);
+    assert(als_train(&parallel, &manager, &catalog, 10, &pool) == 1);
+    threadpool_free(&pool);
+    assert(memcmp(parallel.user_factors, model.user_factors, 
+                  model.matrix.row_count * model.stride * sizeof(float)) == 0);
+    assert(memcmp(parallel.item_factors, model.item_factors, 
+                  model.matrix.item_slots * model.stride * sizeof(float)) == 0);
+    
+    als_free(&parallel);
+    als_free(&model);
+    user_free_manager(&manager);
+    content_free_catalog(&catalog);
+    
+    printf("Módulo als testado com sucesso!\n");
+}
+
+/**
+ * @brief Testes para o módulo hnsw
+ */
+void test_hnsw() {
+    printf("Testando módulo hnsw...\n");
+    
+    enum { DIMENSION = 8, COUNT = 600, K = 10 };
+    static float vectors[COUNT][DIMENSION];
+    int ids[COUNT];
+    srand(31);
+    for (int i = 0; i < COUNT; i++) {
+        ids[i] = i + 1;
+        for (int k = 0; k < DIMENSION; k++) {
+            vectors[i][k] = (float)rand() / RAND_MAX - 0.5f;
+        }
+    }
+    
+    HnswIndex index;
+    assert(hnsw_init(&index, 0, 16, 100) == 0);
+    assert(hnsw_init(&index, DIMENSION, 1, 100) == 0);
+    assert(hnsw_init(&index, DIMENSION, 16, 8) == 0);
+    assert(hnsw_init(&index, DIMENSION, 8, 64) == 1);
+    
+    int found[K];
+    float scores[K];
+    assert(hnsw_search(&index, vectors[0], K, 32, found, scores) == 0);
+    assert(hnsw_build(&index, &vectors[0][0], DIMENSION, ids, COUNT) == 1);
+    assert(index.count == COUNT);
+    
+    // Cada vetor encontra-se a si próprio, e os 10 primeiros coincidem quase sempre com os exatos
+    int hits = 0;
+    for (int q = 0; q < 50; q++) {
+        assert(hnsw_search(&index, vectors[q], K, 64, found, scores) == K);
+        assert(found[0] == q + 1);
+        assert(fabsf(scores[0] - 1.0f) < 1e-4f);
+        for (int i = 1; i < K; i++) {
+            assert(scores[i] <= scores[i - 1]);
+        }
+        
+        float exact[COUNT];
+        for (int i = 0; i < COUNT; i++) {
+            float dot = 0.0f, norm_q = 0.0f, norm_i = 0.0f;
+            for (int k = 0; k < DIMENSION; k++) {
+                dot += vectors[q][k] * vectors[i][k];
+                norm_q += vectors[q][k] * vectors[q][k];
+                norm_i += vectors[i][k] * vectors[i][k];
+            }
+            exact[i] = dot / sqrtf(norm_q * norm_i);
+        }
+        for (int i = 0; i < K; i++) {
+            int better = 0;
+            for (int j = 0; j < COUNT; j++) {
+                better += exact[j] > exact[found[i] - 1] + 1e-6f;
+            }
+            hits += better < K;
+        }
+    }
+    assert(hits >= 50 * K * 9 / 10);
+    
+    // Removido deixa de aparecer; reinserido com outro vetor aparece no novo lugar
+    assert(hnsw_remove(&index, 1) == 1);
+    assert(hnsw_remove(&index, 1) == 0);
+    assert(hnsw_search(&index, vectors[0], K, 64, found, NULL) == K);
+    for (int i = 0; i < K; i++) {
+        assert(found[i] != 1);
+    }
+    assert(hnsw_insert(&index, 2, vectors[0]) == 1);
+    assert(index.deleted_count == 2);
+    assert(hnsw_search(&index, vectors[0], 1, 64, found, scores) == 1);
+    assert(found[0] == 2);
+    
+    // Gravado e reaberto com mapeamento, dá os mesmos resultados; a primeira escrita copia-o
+    int before[K], after[K];
+    assert(hnsw_search(&index, vectors[7], K, 64, before, NULL) == K);
+    assert(hnsw_save(&index, "test_hnsw.bin") == 1);
+    HnswIndex mapped;
+    assert(hnsw_init(&mapped, DIMENSION, 8, 64) == 1);
+    assert(hnsw_open_mapped(&mapped, "test_missing.bin") == 0);
+    assert(hnsw_open_mapped(&mapped, "test_hnsw.bin") == 1);
+    assert(mapped.mapping != NULL);
+    assert(mapped.count == index.count && mapped.deleted_count == 2);
+    assert(hnsw_search(&mapped, vectors[7], K, 64, after, NULL) == K);
+    assert(memcmp(before, after, sizeof(before)) == 0);
+    assert(hnsw_insert(&mapped, COUNT + 1, vectors[7]) == 1);
+    assert(mapped.mapping == NULL);
+    assert(hnsw_search(&mapped, vectors[7], 2, 64, after, NULL) == 2);
+    assert((after[0] == 8 && after[1] == COUNT + 1) || (after[0] == COUNT + 1 && after[1] == 8));
+    hnsw_free(&mapped);
+    
+    // Um ficheiro truncado é recusado
+    FILE *file = fopen("test_hnsw.bin", "r+b");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    file = fopen("test_hnsw.bin", "rb");
+    char *bytes = (char*)malloc(size);
+    assert(fread(bytes, 1, size, file) == (size_t)size);
+    fclose(file);
+    file = fopen("test_hnsw.bin", "wb");
+    fwrite(bytes, 1, size - 4, file);
+    fclose(file);
+    free(bytes);
+    assert(hnsw_init(&mapped, DIMENSION, 8, 64) == 1);
+    assert(hnsw_open_mapped(&mapped, "test_hnsw.bin") == 0);
+    hnsw_free(&mapped);
+    remove("test_hnsw.bin");
+    hnsw_free(&index);
+    
+    // Ligado ao catálogo, acompanha content_add e content_remove ao lado da tabela de vizinhos
+    ContentCatalog catalog;
+    NeighborTable table;
+    assert(content_init_catalog(&catalog, 8) == 1);
+    content_add(&catalog, "Comedia", "Comedia", 90, 12);
+    content_add(&catalog, "Drama", "Drama", 120, 16);
+    assert(neighbors_init(&table, 4) == 1);
+    assert(neighbors_build(&table, &catalog, NULL) == 1);
+    assert(hnsw_init(&index, HNSW_METADATA_DIMENSION, HNSW_DEFAULT_M, HNSW_DEFAULT_EF_CONSTRUCTION) == 1);
+    assert(hnsw_attach(&index, &catalog, hnsw_embed_metadata, NULL) == 1);
+    assert(catalog.listener_count == 2);
+    
+    int terror = content_add(&catalog, "Terror", "Terror", 100, 18);
+    float query[HNSW_METADATA_DIMENSION];
+    hnsw_embed_metadata(NULL, content_get_by_id(&catalog, terror), query);
+    assert(hnsw_search(&index, query, 1, HNSW_DEFAULT_EF_SEARCH, found, scores) == 1);
+    assert(found[0] == terror);
+    int count;
+    assert(neighbors_get(&table, terror, &count) != NULL && count == 2);
+    assert(content_remove(&catalog, terror) == 1);
+    assert(hnsw_search(&index, query, 1, HNSW_DEFAULT_EF_SEARCH, found, scores) == 0);
+    
+    hnsw_free(&index);
+    assert(catalog.listener_count == 1);
+    neighbors_free(&table);
+    content_free_catalog(&catalog);
+    
+    printf("Módulo hnsw testado com sucesso!\n");
+}
+
 /**
  * @brief Testes para o módulo de listas
  */
@@ -382,10 +1920,240 @@ void test_recommendation() {
     count = recommendation_personalized(&user_manager, &catalog, user_id1, recommendations, 5);
     assert(count > 0);
     
+    // A versão numa só passagem dá a mesma lista que a combinação das fontes em separado,
+    // com histórico ordenado, interações registadas depois da ordenação e IDs fora do catálogo
+    ContentCatalog random_catalog;
+    UserManager random_manager;
+    CollabModel model;
+    static const char *category_names[] = {"Ação", "Comédia", "Drama", "Terror", "Anime", "Documentário", "Romance"};
+    char username[MAX_USERNAME_LENGTH];
+    assert(content_init_catalog(&random_catalog, 256) == 1);
+    assert(user_init_manager(&random_manager, 64, 4096) == 1);
+    srand(41);
+    for (int i = 0; i < 200; i++) {
+        int id = content_add(&random_catalog, "Titulo", category_names[rand() % 7], 
+                             30 + 10 * (rand() % 12), 6 * (rand() % 4));
+        content_add_views(&random_catalog, id, rand() % 50);
+    }
+    for (int u = 1; u <= 60; u++) {
+        snprintf(username, sizeof(username), "fundido%d", u);
+        assert(user_add(&random_manager, username) == u);
+        int history = u == 1 ? 0 : rand() % 40;
+        for (int k = 0; k < history; k++) {
+            int content_id = rand() % 20 == 0 ? 900 + rand() % 5 : 1 + rand() % 200;
+            user_register_interaction(&random_manager, u, content_id, (InteractionType)(rand() % 4));
+        }
+    }
+    assert(user_sort_interactions(&random_manager, 1) == 1);
+    int block_count;
+    const Interaction *block = user_get_interactions(&random_manager, 2, &block_count);
+    assert(block != NULL && block_count == user_get_interaction_count(&random_manager, 2));
+    assert(block[0].user_id == 2 && block[block_count - 1].user_id == 2);
+    assert(user_get_interactions(&random_manager, 1, &block_count) == NULL && block_count == 0);
+    for (int k = 0; k < 200; k++) {
+        user_register_interaction(&random_manager, 1 + rand() % 60, 1 + rand() % 200, 
+                                  (InteractionType)(rand() % 4));
+    }
+    
+    assert(collab_init(&model, COLLAB_DEFAULT_NEIGHBORS) == 1);
+    assert(collab_build(&model, &random_manager, &random_catalog, NULL) == 1);
+    for (int pass = 0; pass < 2; pass++) {
+        recommendation_set_collab(pass == 0 ? NULL : &model);
+        for (int u = 1; u <= 61; u++) {
+            int fused[10], reference[10];
+            int fused_count = recommendation_personalized(&random_manager, &random_catalog, u, fused, 10);
+            int reference_count = recommendation_personalized_reference(&random_manager, &random_catalog, u, 
+                                                                        reference, 10);
+            assert(fused_count == reference_count);
+            assert(memcmp(fused, reference, fused_count * sizeof(int)) == 0);
+            assert(recommendation_personalized(&random_manager, &random_catalog, u, fused, 4) == 
+                   (reference_count < 4 ? reference_count : 4));
+            assert(memcmp(fused, reference, (reference_count < 4 ? reference_count : 4) * sizeof(int)) == 0);
+        }
+    }
+    
+    // Lote: cada utilizador, por ordem de ID, com a lista de recommendation_personalized
+    ThreadPool batch_pool;
+    assert(threadpool_init(&batch_pool, 3) == 1);
+    assert(recommendation_batch_all(&random_manager, &random_catalog, 0, "test_batch.bin", 
+                                    RECOMMENDATION_BATCH_BINARY, NULL) == -1);
+    assert(recommendation_batch_all(&random_manager, &random_catalog, 6, "test_batch.bin", 
+                                    RECOMMENDATION_BATCH_BINARY, &batch_pool) == 60);
+    assert(recommendation_batch_all(&random_manager, &random_catalog, 6, "test_batch.csv", 
+                                    RECOMMENDATION_BATCH_CSV, NULL) == 60);
+    threadpool_free(&batch_pool);
+    
+    FILE *batch_file = fopen("test_batch.bin", "rb");
+    char batch_magic[8];
+    int32_t batch_header[4];
+    int64_t batch_offsets[3];
+    char batch_padding[16];
+    assert(batch_file != NULL);
+    assert(fread(batch_magic, 1, 8, batch_file) == 8 && strcmp(batch_magic, RECOMMENDATION_BATCH_MAGIC) == 0);
+    assert(fread(batch_header, sizeof(int32_t), 4, batch_file) == 4);
+    assert(batch_header[0] == 6 && batch_header[1] == 60 && batch_header[2] == 128);
+    assert(fread(batch_offsets, sizeof(int64_t), 3, batch_file) == 3);
+    assert(batch_offsets[1] == 64 && batch_offsets[2] == 64 + 60 * 14 * 4);
+    assert(fread(batch_padding, 1, 16, batch_file) == 16);
+    int csv_rows = 0;
+    for (int u = 1; u <= 60; u++) {
+        int32_t record[14];
+        float record_scores[6];
+        int expected[6];
+        int expected_count = recommendation_personalized(&random_manager, &random_catalog, u, expected, 6);
+        assert(fread(record, sizeof(int32_t), 14, batch_file) == 14);
+        assert(record[0] == u && record[1] == expected_count);
+        memcpy(record_scores, record + 8, sizeof(record_scores));
+        for (int r = 0; r < 6; r++) {
+            assert(record[2 + r] == (r < expected_count ? expected[r] : 0));
+            assert(r == 0 || r >= expected_count || record_scores[r] <= record_scores[r - 1]);
+        }
+        csv_rows += expected_count;
+    }
+    fclose(batch_file);
+    
+    // Tabela pré-calculada: os registos válidos são lidos do ficheiro, os restantes calculados
+    RecommendationTable table;
+    int table_ids[8], live_ids[8];
+    float table_scores[6];
+    assert(recommendation_table_open(&table, "test_batch.csv", &random_manager, &random_catalog) == 0);
+    // Uma interação posterior à geração do ficheiro, já presente na abertura (como num CSV mais recente)
+    assert(user_register_interaction_at(&random_manager, 8, 9, INTERACTION_COMPLETE, time(NULL) + 3600) == 1);
+    assert(recommendation_table_open(&table, "test_batch.bin", &random_manager, &random_catalog) == 1);
+    assert(table.user_count == 60 && table.max_recommendations == 6);
+    assert(recommendation_table_lookup(&table, 8, table_ids, NULL, 6) == -1);
+    int live_count = recommendation_personalized(&random_manager, &random_catalog, 3, live_ids, 6);
+    assert(recommendation_table_lookup(&table, 3, table_ids, table_scores, 6) == live_count);
+    assert(memcmp(table_ids, live_ids, live_count * sizeof(int)) == 0);
+    assert(recommendation_table_lookup(&table, 3, table_ids, NULL, 7) == -1);
+    assert(recommendation_table_lookup(&table, 99, table_ids, NULL, 6) == -1);
+    
+    recommendation_set_table(&table);
+    for (int u = 1; u <= 60; u++) {
+        assert(u == 8 || recommendation_table_lookup(&table, u, table_ids, NULL, 4) >= 0);
+        int served = recommendation_personalized(&random_manager, &random_catalog, u, table_ids, 4);
+        assert(recommendation_personalized_reference(&random_manager, &random_catalog, u, live_ids, 4) == served);
+        assert(memcmp(table_ids, live_ids, served * sizeof(int)) == 0);
+    }
+    
+    // Novas interações, marcação explícita e edições do catálogo levam ao cálculo
+    user_register_interaction(&random_manager, 5, 7, INTERACTION_COMPLETE);
+    assert(recommendation_table_lookup(&table, 5, table_ids, NULL, 6) == -1);
+    live_count = recommendation_personalized(&random_manager, &random_catalog, 5, table_ids, 6);
+    assert(recommendation_personalized_reference(&random_manager, &random_catalog, 5, live_ids, 6) == live_count);
+    assert(memcmp(table_ids, live_ids, live_count * sizeof(int)) == 0);
+    assert(recommendation_table_mark_stale(&table, 6) == 1);
+    assert(recommendation_table_mark_stale(&table, 99) == 0);
+    assert(recommendation_table_lookup(&table, 6, table_ids, NULL, 6) == -1);
+    assert(recommendation_table_lookup(&table, 7, table_ids, NULL, 6) >= 0);
+    content_add(&random_catalog, "Novo", "Anime", 60, 0);
+    assert(recommendation_table_lookup(&table, 7, table_ids, NULL, 6) >= 0);
+    assert(content_edit(&random_catalog, 1, "Editado", "Drama", 90, 12) == 1);
+    assert(recommendation_table_lookup(&table, 7, table_ids, NULL, 6) == -1);
+    recommendation_set_table(NULL);
+    recommendation_table_free(&table);
+    assert(random_catalog.listener_count == 0);
+    remove("test_batch.bin");
+    
+    // O CSV tem uma linha por recomendação, com a posição a começar em 1
+    char batch_line[64];
+    int batch_user, batch_rank, batch_content, batch_rows = 0;
+    batch_file = fopen("test_batch.csv", "r");
+    assert(batch_file != NULL);
+    assert(fgets(batch_line, sizeof(batch_line), batch_file) != NULL);
+    while (fgets(batch_line, sizeof(batch_line), batch_file) != NULL) {
+        assert(sscanf(batch_line, "%d,%d,%d", &batch_user, &batch_rank, &batch_content) == 3);
+        assert(batch_rank >= 1 && batch_rank <= 6);
+        batch_rows++;
+    }
+    assert(batch_rows == csv_rows);
+    fclose(batch_file);
+    remove("test_batch.csv");
+    
+    recommendation_set_collab(NULL);
+    collab_free(&model);
+    user_free_manager(&random_manager);
+    content_free_catalog(&random_catalog);
+    
+    // Cache: o segundo pedido igual é servido pela cache, com a mesma lista
+    RecommendationCache cache;
+    RecommendationCacheStats stats;
+    int direct[MAX_RECOMMENDATIONS], cached[MAX_RECOMMENDATIONS];
+    assert(recommendation_cache_init(&cache, &user_manager, &catalog, 0) == 0);
+    assert(recommendation_cache_init(&cache, &user_manager, &catalog, 2) == 1);
+    int direct_count = recommendation_personalized(&user_manager, &catalog, user_id1, direct, 3);
+    for (int pass = 0; pass < 2; pass++) {
+        assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_PERSONALIZED, user_id1, cached, 3) == direct_count);
+        assert(memcmp(cached, direct, direct_count * sizeof(int)) == 0);
+    }
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.hits == 1 && stats.misses == 1 && stats.entries == 1);
+    
+    // A popularidade é partilhada por todos os utilizadores
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, user_id1, cached, 3) == 3);
+    assert(cached[0] == id2);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, user_id2, cached, 3) == 3);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.hits == 2 && stats.misses == 2 && stats.entries == 2);
+    
+    // Só as interações do próprio utilizador invalidam as suas entradas
+    user_register_interaction(&user_manager, user_id2, id3, INTERACTION_COMPLETE);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_PERSONALIZED, user_id1, cached, 3) == direct_count);
+    user_register_interaction(&user_manager, user_id1, id5, INTERACTION_COMPLETE);
+    direct_count = recommendation_personalized(&user_manager, &catalog, user_id1, direct, 3);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_PERSONALIZED, user_id1, cached, 3) == direct_count);
+    assert(memcmp(cached, direct, direct_count * sizeof(int)) == 0);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.hits == 3 && stats.misses == 3 && stats.invalidations == 1);
+    
+    // Uma alteração do catálogo invalida tudo, incluindo a popularidade
+    int id6 = content_add(&catalog, "Animação 1", "Animação", 95, 6);
+    for (int i = 0; i < 50; i++) content_increment_views(&catalog, id6);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, 0, cached, 3) == 3);
+    assert(cached[0] == id6);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.invalidations == 2 && stats.entries == 2);
+    
+    // Sem espaço, sai a entrada usada há mais tempo (a personalizada do utilizador 1)
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_CATEGORY, user_id2, cached, 3) >= 0);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, 0, cached, 3) == 3);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.evictions == 1 && stats.entries == 2 && stats.hits == 4);
+    
+    // As visualizações pendentes invalidam a popularidade em cache, como numa chamada direta
+    for (int i = 0; i < 100; i++) content_increment_views(&catalog, id3);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, 0, cached, 3) == 3);
+    assert(recommendation_by_popularity(&catalog, direct, 3) == 3);
+    assert(memcmp(cached, direct, 3 * sizeof(int)) == 0);
+    assert(cached[0] == id3);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.invalidations == 3 && stats.hits == 4);
+    assert(content_fold_views(&catalog) >= 100);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, 0, cached, 3) == 3);
+    assert(cached[0] == id3);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, 0, cached, 3) == 3);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.invalidations == 4 && stats.hits == 5);
+    
+    // Pedidos grandes não são guardados, e mudar o modelo colaborativo invalida tudo
+    int many[RECOMMENDATION_CACHE_MAX_RESULTS + 1];
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, 0, many, 
+                                 RECOMMENDATION_CACHE_MAX_RESULTS + 1) == 6);
+    recommendation_set_collab(NULL);
+    assert(recommendation_cached(&cache, RECOMMENDATION_METHOD_POPULARITY, 0, cached, 3) == 3);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.entries == 2 && stats.invalidations == 5);
+    
+    recommendation_cache_clear(&cache);
+    recommendation_cache_get_stats(&cache, &stats);
+    assert(stats.entries == 0);
+    recommendation_cache_free(&cache);
+    assert(catalog.listener_count == 0);
+    
     // Testar similaridade
-    Content *c1 = content_get_by_id(&catalog, id1);
-    Content *c2 = content_get_by_id(&catalog, id2);
-    Content *c3 = content_get_by_id(&catalog, id3);
+    const Content *c1 = content_get_by_id(&catalog, id1);
+    const Content *c2 = content_get_by_id(&catalog, id2);
+    const Content *c3 = content_get_by_id(&catalog, id3);
     
     float sim1 = recommendation_calculate_similarity(c1, c2);
     float sim2 = recommendation_calculate_similarity(c1, c3);
@@ -577,7 +2345,7 @@ void test_integration() {
     assert(list_load_from_csv(&new_list_manager, "integration_list.csv") == 1);
     
     // 8. Verificar se os dados foram carregados corretamente
-    Content *content = content_get_by_id(&new_catalog, film_id);
+    const Content *content = content_get_by_id(&new_catalog, film_id);
     assert(content != NULL);
     assert(strcmp(content->title, "Matrix") == 0);
     assert(content->views == 1);
@@ -0,0 +1,391 @@
+/**
+ * @file threadpool.c
+ * @brief Implementação do módulo de conjunto de threads com roubo de trabalho
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <sched.h>
+
+#include "threadpool.h"
+
+// Conjunto partilhado pelo programa
+static ThreadPool *threadpool_default_pool = NULL;
+
+// Conjunto e fila da thread atual (-1 se não for uma thread trabalhadora)
+static __thread ThreadPool *threadpool_current_pool = NULL;
+static __thread int threadpool_current_worker = -1;
+
+// Bloco de um ciclo paralelo, dividido ao meio enquanto for maior que grain
+typedef struct {
+    ThreadPoolGroup *group;
+    int begin;
+    int end;
+    int grain;
+    ThreadPoolRangeFunc func;
+    void *context;
+} ThreadPoolRange;
+
+// Dados de uma redução paralela
+typedef struct {
+    int begin;
+    int grain;
+    int end;
+    ThreadPoolMapFunc map;
+    void *context;
+    unsigned char *partials;
+    size_t size;
+} ThreadPoolReduce;
+
+// Coloca uma tarefa no fim da fila (lado do dono)
+static int threadpool_deque_push(ThreadPoolDeque *deque, ThreadPoolTask task) {
+    pthread_mutex_lock(&deque->lock);
+    
+    if (deque->count == deque->capacity) {
+        int new_capacity = deque->capacity * 2;
+        ThreadPoolTask *tasks = (ThreadPoolTask*)malloc(new_capacity * sizeof(ThreadPoolTask));
+        if (tasks == NULL) {
+            pthread_mutex_unlock(&deque->lock);
+            return 0;
+        }
+        for (int i = 0; i < deque->count; i++) {
+            tasks[i] = deque->tasks[(deque->head + i) & (deque->capacity - 1)];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->head = 0;
+        deque->capacity = new_capacity;
+    }
+    
+    deque->tasks[(deque->head + deque->count) & (deque->capacity - 1)] = task;
+    deque->count++;
+    
+    pthread_mutex_unlock(&deque->lock);
+    return 1;
+}
+
+// Retira uma tarefa: o dono tira a mais recente, os ladrões a mais antiga
+static int threadpool_deque_pop(ThreadPoolDeque *deque, int steal, ThreadPoolTask *task) {
+    pthread_mutex_lock(&deque->lock);
+    
+    if (deque->count == 0) {
+        pthread_mutex_unlock(&deque->lock);
+        return 0;
+    }
+    
+    if (steal) {
+        *task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) & (deque->capacity - 1);
+    } else {
+        *task = deque->tasks[(deque->head + deque->count - 1) & (deque->capacity - 1)];
+    }
+    deque->count--;
+    
+    pthread_mutex_unlock(&deque->lock);
+    return 1;
+}
+
+// Executa uma tarefa pendente (da própria fila ou roubada); retorna 0 se não havia nenhuma
+static int threadpool_run_one(ThreadPool *pool) {
+    if (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) {
+        return 0;
+    }
+    
+    ThreadPoolTask task;
+    int self = threadpool_current_pool == pool ? threadpool_current_worker : -1;
+    int found = self >= 0 && threadpool_deque_pop(&pool->deques[self], 0, &task);
+    
+    // Roubar a partir da fila seguinte para espalhar os ladrões
+    for (int i = 1; !found && i <= pool->worker_count; i++) {
+        int victim = ((self >= 0 ? self : 0) + i) % pool->worker_count;
+        found = threadpool_deque_pop(&pool->deques[victim], 1, &task);
+    }
+    
+    if (!found) {
+        return 0;
+    }
+    
+    __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    task.func(task.arg);
+    __atomic_sub_fetch(task.pending, 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Ciclo de uma thread trabalhadora
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} ThreadPoolWorker;
+
+static void *threadpool_worker_run(void *arg) {
+    ThreadPoolWorker worker = *(ThreadPoolWorker*)arg;
+    ThreadPool *pool = worker.pool;
+    free(arg);
+    
+    threadpool_current_pool = pool;
+    threadpool_current_worker = worker.index;
+    
+    while (!__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE)) {
+        if (threadpool_run_one(pool)) {
+            continue;
+        }
+        
+        pthread_mutex_lock(&pool->idle_lock);
+        while (!pool->stop && __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) == 0) {
+            pthread_cond_wait(&pool->idle_cond, &pool->idle_lock);
+        }
+        pthread_mutex_unlock(&pool->idle_lock);
+    }
+    
+    return NULL;
+}
+
+// Para as threads já criadas e liberta as filas e a memória do conjunto
+static void threadpool_release(ThreadPool *pool, int started) {
+    pthread_mutex_lock(&pool->idle_lock);
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+    
+    for (int i = 0; i < started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    
+    for (int i = 0; i < pool->worker_count; i++) {
+        free(pool->deques[i].tasks);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    
+    pthread_mutex_destroy(&pool->idle_lock);
+    pthread_cond_destroy(&pool->idle_cond);
+    free(pool->threads);
+    free(pool->deques);
+    
+    if (threadpool_default_pool == pool) {
+        threadpool_default_pool = NULL;
+    }
+    memset(pool, 0, sizeof(ThreadPool));
+}
+
+int threadpool_init(ThreadPool *pool, int workers) {
+    if (pool == NULL || workers < 1 || workers > THREADPOOL_MAX_WORKERS) {
+        return 0;
+    }
+    
+    memset(pool, 0, sizeof(ThreadPool));
+    pool->threads = (pthread_t*)malloc(workers * sizeof(pthread_t));
+    pool->deques = (ThreadPoolDeque*)calloc(workers, sizeof(ThreadPoolDeque));
+    if (pool->threads == NULL || pool->deques == NULL) {
+        free(pool->threads);
+        free(pool->deques);
+        return 0;
+    }
+    
+    pthread_mutex_init(&pool->idle_lock, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+    
+    // As filas existem antes de qualquer thread começar a roubar
+    pool->worker_count = workers;
+    for (int i = 0; i < workers; i++) {
+        ThreadPoolDeque *deque = &pool->deques[i];
+        pthread_mutex_init(&deque->lock, NULL);
+        deque->capacity = 64;
+        deque->tasks = (ThreadPoolTask*)malloc(deque->capacity * sizeof(ThreadPoolTask));
+        if (deque->tasks == NULL) {
+            threadpool_release(pool, 0);
+            return 0;
+        }
+    }
+    
+    for (int i = 0; i < workers; i++) {
+        ThreadPoolWorker *worker = (ThreadPoolWorker*)malloc(sizeof(ThreadPoolWorker));
+        if (worker != NULL) {
+            worker->pool = pool;
+            worker->index = i;
+        }
+        if (worker == NULL || pthread_create(&pool->threads[i], NULL, threadpool_worker_run, worker) != 0) {
+            free(worker);
+            threadpool_release(pool, i);
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+void threadpool_free(ThreadPool *pool) {
+    if (pool == NULL || pool->deques == NULL) {
+        return;
+    }
+    
+    threadpool_release(pool, pool->worker_count);
+}
+
+void threadpool_set_default(ThreadPool *pool) {
+    threadpool_default_pool = pool;
+}
+
+ThreadPool* threadpool_get_default(void) {
+    return threadpool_default_pool;
+}
+
+void threadpool_group_init(ThreadPoolGroup *group, ThreadPool *pool) {
+    group->pool = pool;
+    group->pending = 0;
+}
+
+void threadpool_group_spawn(ThreadPoolGroup *group, ThreadPoolTaskFunc func, void *arg) {
+    ThreadPool *pool = group->pool;
+    
+    if (pool == NULL) {
+        func(arg);
+        return;
+    }
+    
+    ThreadPoolTask task;
+    task.func = func;
+    task.arg = arg;
+    task.pending = &group->pending;
+    
+    // Dentro de uma thread trabalhadora, a tarefa vai para a própria fila
+    int target;
+    if (threadpool_current_pool == pool) {
+        target = threadpool_current_worker;
+    } else {
+        target = (int)((unsigned int)__atomic_fetch_add(&pool->next_deque, 1, __ATOMIC_RELAXED) 
+                       % (unsigned int)pool->worker_count);
+    }
+    
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_RELEASE);
+    
+    if (!threadpool_deque_push(&pool->deques[target], task)) {
+        // Sem memória para a fila: executar já
+        __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_RELEASE);
+        func(arg);
+        __atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE);
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->idle_lock);
+    pthread_cond_signal(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+void threadpool_group_wait(ThreadPoolGroup *group) {
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0) {
+        // Ajudar em vez de bloquear: evita impasses com paralelismo aninhado
+        if (group->pool == NULL || !threadpool_run_one(group->pool)) {
+            sched_yield();
+        }
+    }
+}
+
+// Executa um bloco do ciclo paralelo, lançando a metade direita enquanto for grande
+static void threadpool_range_run(void *arg) {
+    ThreadPoolRange *range = (ThreadPoolRange*)arg;
+    
+    while (range->end - range->begin > range->grain) {
+        int middle = range->begin + (range->end - range->begin) / 2;
+        ThreadPoolRange *right = (ThreadPoolRange*)malloc(sizeof(ThreadPoolRange));
+        if (right == NULL) {
+            break; // Sem memória: tratar o resto nesta thread
+        }
+        *right = *range;
+        right->begin = middle;
+        range->end = middle;
+        threadpool_group_spawn(range->group, threadpool_range_run, right);
+    }
+    
+    range->func(range->context, range->begin, range->end);
+    free(range);
+}
+
+void threadpool_parallel_for(ThreadPool *pool, int begin, int end, int grain, 
+                             ThreadPoolRangeFunc func, void *context) {
+    if (func == NULL || begin >= end) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    
+    if (pool == NULL || end - begin <= grain) {
+        func(context, begin, end);
+        return;
+    }
+    
+    ThreadPoolGroup group;
+    threadpool_group_init(&group, pool);
+    
+    ThreadPoolRange *range = (ThreadPoolRange*)malloc(sizeof(ThreadPoolRange));
+    if (range == NULL) {
+        func(context, begin, end);
+        return;
+    }
+    
+    range->group = &group;
+    range->begin = begin;
+    range->end = end;
+    range->grain = grain;
+    range->func = func;
+    range->context = context;
+    
+    threadpool_range_run(range);
+    threadpool_group_wait(&group);
+}
+
+// Acumula os blocos [first, last) da redução, cada um no seu parcial
+static void threadpool_reduce_chunks(void *context, int first, int last) {
+    ThreadPoolReduce *reduce = (ThreadPoolReduce*)context;
+    
+    for (int chunk = first; chunk < last; chunk++) {
+        int begin = reduce->begin + chunk * reduce->grain;
+        int end = begin + reduce->grain < reduce->end ? begin + reduce->grain : reduce->end;
+        reduce->map(reduce->context, begin, end, reduce->partials + chunk * reduce->size);
+    }
+}
+
+int threadpool_parallel_reduce(ThreadPool *pool, int begin, int end, int grain, 
+                               ThreadPoolMapFunc map, ThreadPoolCombineFunc combine, 
+                               void *context, void *result, const void *identity, size_t size) {
+    if (map == NULL || combine == NULL || result == NULL || identity == NULL || size == 0) {
+        return 0;
+    }
+    
+    memcpy(result, identity, size);
+    if (begin >= end) {
+        return 1;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    
+    int chunks = (int)(((long long)end - begin + grain - 1) / grain);
+    ThreadPoolReduce reduce;
+    reduce.begin = begin;
+    reduce.grain = grain;
+    reduce.end = end;
+    reduce.map = map;
+    reduce.context = context;
+    reduce.size = size;
+    reduce.partials = (unsigned char*)malloc((size_t)chunks * size);
+    if (reduce.partials == NULL) {
+        return 0;
+    }
+    
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        memcpy(reduce.partials + chunk * size, identity, size);
+    }
+    
+    threadpool_parallel_for(pool, 0, chunks, 1, threadpool_reduce_chunks, &reduce);
+    
+    // Juntar pela ordem dos blocos para um resultado determinístico
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        combine(context, result, reduce.partials + chunk * size);
+    }
+    
+    free(reduce.partials);
+    return 1;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file threadpool.h
+ * @brief Módulo de conjunto de threads com roubo de trabalho
+ * 
+ * Este módulo fornece um conjunto de threads partilhado pelo programa, com
+ * uma fila dupla (deque) por thread: cada thread retira o trabalho mais
+ * recente da sua fila e, sem trabalho, rouba o mais antigo das outras.
+ * Sobre ele existem as primitivas de grupo de tarefas, ciclo paralelo
+ * (parallel-for) e redução paralela. Quem espera por um grupo executa
+ * tarefas pendentes enquanto espera, o que permite paralelismo aninhado.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#define THREADPOOL_MAX_WORKERS 64
+#define THREADPOOL_DEFAULT_WORKERS 4
+
+/**
+ * @brief Função executada por uma tarefa
+ * 
+ * @param arg Argumento da tarefa
+ */
+typedef void (*ThreadPoolTaskFunc)(void *arg);
+
+/**
+ * @brief Função aplicada a um intervalo [begin, end) por threadpool_parallel_for
+ * 
+ * @param context Dados do chamador
+ * @param begin Início do intervalo
+ * @param end Fim do intervalo (exclusivo)
+ */
+typedef void (*ThreadPoolRangeFunc)(void *context, int begin, int end);
+
+/**
+ * @brief Função que acumula um intervalo [begin, end) num resultado parcial
+ * 
+ * @param context Dados do chamador
+ * @param begin Início do intervalo
+ * @param end Fim do intervalo (exclusivo)
+ * @param partial Resultado parcial (iniciado com o valor neutro)
+ */
+typedef void (*ThreadPoolMapFunc)(void *context, int begin, int end, void *partial);
+
+/**
+ * @brief Função que junta um resultado parcial noutro
+ * 
+ * @param context Dados do chamador
+ * @param into Resultado acumulado
+ * @param from Resultado parcial a juntar
+ */
+typedef void (*ThreadPoolCombineFunc)(void *context, void *into, const void *from);
+
+/**
+ * @brief Estrutura que representa uma tarefa numa fila
+ */
+typedef struct {
+    ThreadPoolTaskFunc func;    /**< Função da tarefa */
+    void *arg;                  /**< Argumento da tarefa */
+    int *pending;               /**< Contador de tarefas pendentes do grupo */
+} ThreadPoolTask;
+
+/**
+ * @brief Fila dupla de tarefas de uma thread
+ */
+typedef struct {
+    pthread_mutex_t lock;       /**< Protege a fila */
+    ThreadPoolTask *tasks;      /**< Buffer circular de tarefas */
+    int head;                   /**< Posição da tarefa mais antiga (roubada por outras threads) */
+    int count;                  /**< Número de tarefas na fila */
+    int capacity;               /**< Capacidade do buffer (potência de 2) */
+} ThreadPoolDeque;
+
+/**
+ * @brief Estrutura que representa o conjunto de threads
+ */
+typedef struct {
+    pthread_t *threads;         /**< Threads trabalhadoras */
+    ThreadPoolDeque *deques;    /**< Uma fila por thread trabalhadora */
+    int worker_count;           /**< Número de threads trabalhadoras */
+    int queued;                 /**< Tarefas em fila em todas as threads */
+    int next_deque;             /**< Fila que recebe a próxima tarefa externa */
+    int stop;                   /**< Pedido de paragem das threads */
+    pthread_mutex_t idle_lock;  /**< Protege a espera das threads sem trabalho */
+    pthread_cond_t idle_cond;   /**< Acorda as threads quando chega trabalho */
+} ThreadPool;
+
+/**
+ * @brief Grupo de tarefas cujo fim pode ser esperado em conjunto
+ */
+typedef struct {
+    ThreadPool *pool;           /**< Conjunto de threads (NULL = execução em série) */
+    int pending;                /**< Tarefas do grupo ainda não terminadas */
+} ThreadPoolGroup;
+
+/**
+ * @brief Inicializa o conjunto de threads
+ * 
+ * @param pool Ponteiro para o conjunto a ser inicializado
+ * @param workers Número de threads trabalhadoras (1 a THREADPOOL_MAX_WORKERS)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int threadpool_init(ThreadPool *pool, int workers);
+
+/**
+ * @brief Para as threads e liberta a memória do conjunto
+ * 
+ * @param pool Ponteiro para o conjunto
+ */
+void threadpool_free(ThreadPool *pool);
+
+/**
+ * @brief Define o conjunto de threads partilhado pelo programa
+ * 
+ * Os módulos que aceitam paralelismo (carregamento, relatórios e
+ * recomendações) usam este conjunto; sem conjunto definido, trabalham em série.
+ * 
+ * @param pool Ponteiro para o conjunto (NULL para voltar à execução em série)
+ */
+void threadpool_set_default(ThreadPool *pool);
+
+/**
+ * @brief Obtém o conjunto de threads partilhado pelo programa
+ * 
+ * @return ThreadPool* Conjunto definido com threadpool_set_default, ou NULL
+ */
+ThreadPool* threadpool_get_default(void);
+
+/**
+ * @brief Inicializa um grupo de tarefas
+ * 
+ * @param group Ponteiro para o grupo
+ * @param pool Conjunto de threads (NULL para executar as tarefas em série)
+ */
+void threadpool_group_init(ThreadPoolGroup *group, ThreadPool *pool);
+
+/**
+ * @brief Lança uma tarefa no grupo
+ * 
+ * @param group Ponteiro para o grupo
+ * @param func Função da tarefa
+ * @param arg Argumento da tarefa
+ */
+void threadpool_group_spawn(ThreadPoolGroup *group, ThreadPoolTaskFunc func, void *arg);
+
+/**
+ * @brief Espera pelo fim de todas as tarefas do grupo, executando trabalho pendente
+ * 
+ * @param group Ponteiro para o grupo
+ */
+void threadpool_group_wait(ThreadPoolGroup *group);
+
+/**
+ * @brief Aplica uma função a [begin, end) em blocos de até grain elementos, em paralelo
+ * 
+ * @param pool Conjunto de threads (NULL para executar em série)
+ * @param begin Início do intervalo
+ * @param end Fim do intervalo (exclusivo)
+ * @param grain Tamanho máximo de cada bloco (>= 1)
+ * @param func Função aplicada a cada bloco
+ * @param context Dados passados à função
+ */
+void threadpool_parallel_for(ThreadPool *pool, int begin, int end, int grain, 
+                             ThreadPoolRangeFunc func, void *context);
+
+/**
+ * @brief Reduz [begin, end) em paralelo para um único resultado
+ * 
+ * Cada bloco acumula num resultado parcial iniciado com identity; os parciais
+ * são juntados por ordem dos blocos, pelo que o resultado é determinístico.
+ * 
+ * @param pool Conjunto de threads (NULL para executar em série)
+ * @param begin Início do intervalo
+ * @param end Fim do intervalo (exclusivo)
+ * @param grain Tamanho máximo de cada bloco (>= 1)
+ * @param map Função que acumula um bloco
+ * @param combine Função que junta dois resultados
+ * @param context Dados passados às funções
+ * @param result Resultado (recebe identity mais todos os parciais)
+ * @param identity Valor neutro da redução
+ * @param size Tamanho em bytes de um resultado
+ * @return int 1 se a redução foi bem-sucedida, 0 em caso de erro de memória
+ */
+int threadpool_parallel_reduce(ThreadPool *pool, int begin, int end, int grain, 
+                               ThreadPoolMapFunc map, ThreadPoolCombineFunc combine, 
+                               void *context, void *result, const void *identity, size_t size);
+
+#endif /* THREADPOOL_H */
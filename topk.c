@@ -0,0 +1,130 @@
+/**
+ * @file topk.c
+ * @brief Implementação do módulo de seleção dos K melhores elementos
+ */
+
+#include "topk.h"
+
+// Verifica se a é melhor que b (maior score; em empate, chegou primeiro)
+static int topk_better(const TopKItem *a, const TopKItem *b) {
+    if (a->score != b->score) {
+        return a->score > b->score;
+    }
+    return a->order < b->order;
+}
+
+// Desce a raiz até repor a propriedade de heap mínimo
+static void topk_sift_down(TopK *topk, int index) {
+    TopKItem *items = topk->items;
+    TopKItem item = items[index];
+    
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= topk->count) {
+            break;
+        }
+        // Escolher o pior dos dois filhos
+        if (child + 1 < topk->count && topk_better(&items[child], &items[child + 1])) {
+            child++;
+        }
+        if (!topk_better(&item, &items[child])) {
+            break;
+        }
+        items[index] = items[child];
+        index = child;
+    }
+    
+    items[index] = item;
+}
+
+// Sobe um elemento enquanto for pior que o pai
+static void topk_sift_up(TopK *topk, int index) {
+    TopKItem *items = topk->items;
+    TopKItem item = items[index];
+    
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!topk_better(&items[parent], &item)) {
+            break;
+        }
+        items[index] = items[parent];
+        index = parent;
+    }
+    
+    items[index] = item;
+}
+
+int topk_init(TopK *topk, int k) {
+    if (topk == NULL || k <= 0) {
+        return 0;
+    }
+    
+    topk->items = (TopKItem*)malloc(k * sizeof(TopKItem));
+    if (topk->items == NULL) {
+        return 0;
+    }
+    
+    topk->count = 0;
+    topk->capacity = k;
+    topk->pushed = 0;
+    return 1;
+}
+
+void topk_free(TopK *topk) {
+    if (topk == NULL) {
+        return;
+    }
+    
+    free(topk->items);
+    topk->items = NULL;
+    topk->count = 0;
+    topk->capacity = 0;
+}
+
+void topk_push(TopK *topk, int id, float score) {
+    TopKItem item;
+    item.id = id;
+    item.score = score;
+    item.order = topk->pushed++;
+    
+    if (topk->count < topk->capacity) {
+        topk->items[topk->count++] = item;
+        topk_sift_up(topk, topk->count - 1);
+    } else if (topk_better(&item, &topk->items[0])) {
+        // Substituir o pior dos K melhores
+        topk->items[0] = item;
+        topk_sift_down(topk, 0);
+    }
+}
+
+int topk_extract_scored(TopK *topk, int *ids, float *scores, int max_ids) {
+    if (topk == NULL || ids == NULL || max_ids < 0) {
+        return 0;
+    }
+    
+    // Descartar os piores que não cabem no resultado
+    while (topk->count > max_ids) {
+        topk->items[0] = topk->items[--topk->count];
+        topk_sift_down(topk, 0);
+    }
+    
+    // Retirar do pior para o melhor, preenchendo o resultado de trás para a frente
+    int written = topk->count;
+    while (topk->count > 0) {
+        ids[topk->count - 1] = topk->items[0].id;
+        if (scores != NULL) {
+            scores[topk->count - 1] = topk->items[0].score;
+        }
+        topk->items[0] = topk->items[--topk->count];
+        if (topk->count > 0) {
+            topk_sift_down(topk, 0);
+        }
+    }
+    
+    topk->pushed = 0;
+    return written;
+}
+
+int topk_extract(TopK *topk, int *ids, int max_ids) {
+    return topk_extract_scored(topk, ids, NULL, max_ids);
+}
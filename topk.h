@@ -0,0 +1,87 @@
+/**
+ * @file topk.h
+ * @brief Módulo de seleção dos K melhores elementos por score
+ * 
+ * Mantém um heap mínimo limitado a K elementos: a raiz é o pior dos K
+ * melhores vistos até ao momento, pelo que cada novo elemento custa no
+ * máximo O(log K) e a seleção sobre n elementos custa O(n log K), sem
+ * ordenar nem guardar todos os candidatos. Em caso de empate no score,
+ * ganha o elemento inserido primeiro (o mesmo resultado de uma ordenação
+ * estável pela ordem de chegada).
+ */
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <stdlib.h>
+
+/**
+ * @brief Elemento candidato da seleção
+ */
+typedef struct {
+    int id;                     /**< Identificador do elemento (ex.: ID do conteúdo) */
+    float score;                /**< Score do elemento (maior = melhor) */
+    int order;                  /**< Ordem de chegada (desempate) */
+} TopKItem;
+
+/**
+ * @brief Estrutura que representa a seleção dos K melhores
+ */
+typedef struct {
+    TopKItem *items;            /**< Heap mínimo (raiz = pior dos K melhores) */
+    int count;                  /**< Número de elementos no heap */
+    int capacity;               /**< K */
+    int pushed;                 /**< Elementos oferecidos desde a inicialização */
+} TopK;
+
+/**
+ * @brief Inicializa uma seleção de até k elementos
+ * 
+ * @param topk Ponteiro para a seleção
+ * @param k Número de elementos a manter (> 0)
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int topk_init(TopK *topk, int k);
+
+/**
+ * @brief Liberta a memória da seleção
+ * 
+ * @param topk Ponteiro para a seleção
+ */
+void topk_free(TopK *topk);
+
+/**
+ * @brief Oferece um elemento à seleção
+ * 
+ * @param topk Ponteiro para a seleção
+ * @param id Identificador do elemento
+ * @param score Score do elemento
+ */
+void topk_push(TopK *topk, int id, float score);
+
+/**
+ * @brief Retira os elementos selecionados, do melhor para o pior
+ * 
+ * A seleção fica vazia e pode ser reutilizada.
+ * 
+ * @param topk Ponteiro para a seleção
+ * @param ids Array para os identificadores
+ * @param max_ids Tamanho do array
+ * @return int Número de identificadores escritos
+ */
+int topk_extract(TopK *topk, int *ids, int max_ids);
+
+/**
+ * @brief Retira os elementos selecionados com os seus scores, do melhor para o pior
+ * 
+ * Igual a topk_extract, escrevendo também o score de cada identificador.
+ * 
+ * @param topk Ponteiro para a seleção
+ * @param ids Array para os identificadores
+ * @param scores Array para os scores (pode ser NULL)
+ * @param max_ids Tamanho dos arrays
+ * @return int Número de identificadores escritos
+ */
+int topk_extract_scored(TopK *topk, int *ids, float *scores, int max_ids);
+
+#endif /* TOPK_H */
@@ -3,9 +3,460 @@
  * @brief Implementação do módulo para gerenciamento de utilizadores e suas interações
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+
 #include "user.h"
+#include "usershard.h"
 #include "csvutil.h"
-#include <ctype.h>
+#include "threadpool.h"
+#include "arena.h"
+
+// Função de dispersão multiplicativa para IDs inteiros
+static unsigned int user_hash_id(int id) {
+    return (unsigned int)id * 2654435761u;
+}
+
+// Insere a posição de um utilizador na tabela de dispersão (mantém a primeira ocorrência do ID)
+static void user_index_insert(UserManager *manager, int position) {
+    unsigned int mask = (unsigned int)manager->user_index_capacity - 1;
+    unsigned int slot = user_hash_id(manager->users[position].id) & mask;
+    
+    while (manager->user_index[slot] != 0) {
+        if (manager->users[manager->user_index[slot] - 1].id == manager->users[position].id) {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    manager->user_index[slot] = position + 1;
+}
+
+// Reconstrói a tabela de dispersão a partir do array de utilizadores
+static int user_index_rebuild(UserManager *manager) {
+    int capacity = 16;
+    while (capacity < manager->count * 2) {
+        capacity *= 2;
+    }
+    
+    if (capacity != manager->user_index_capacity) {
+        int *new_index = (int*)realloc(manager->user_index, capacity * sizeof(int));
+        
+        if (new_index == NULL) {
+            // Sem tabela, as buscas voltam a ser lineares
+            free(manager->user_index);
+            manager->user_index = NULL;
+            manager->user_index_capacity = 0;
+            return 0;
+        }
+        
+        manager->user_index = new_index;
+        manager->user_index_capacity = capacity;
+    }
+    
+    memset(manager->user_index, 0, capacity * sizeof(int));
+    for (int i = 0; i < manager->count; i++) {
+        user_index_insert(manager, i);
+    }
+    
+    return 1;
+}
+
+// Obtém a posição de um utilizador no array a partir do ID (-1 se não existir)
+static int user_index_find(UserManager *manager, int user_id) {
+    if (manager->user_index == NULL) {
+        for (int i = 0; i < manager->count; i++) {
+            if (manager->users[i].id == user_id) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    
+    unsigned int mask = (unsigned int)manager->user_index_capacity - 1;
+    unsigned int slot = user_hash_id(user_id) & mask;
+    
+    while (manager->user_index[slot] != 0) {
+        int position = manager->user_index[slot] - 1;
+        if (manager->users[position].id == user_id) {
+            return position;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    return -1;
+}
+
+// Garante espaço para pelo menos 'required' interações com uma única realocação
+static int user_reserve_interactions(UserManager *manager, int required) {
+    if (required <= manager->interaction_capacity) {
+        return 1;
+    }
+    
+    Interaction *block = manager->interactions - manager->interaction_offset;
+    
+    // Reaproveitar o espaço libertado pela compactação antes de realocar
+    if (manager->interaction_offset > 0) {
+        memmove(block, manager->interactions, manager->interaction_count * sizeof(Interaction));
+        manager->interactions = block;
+        manager->interaction_capacity += manager->interaction_offset;
+        manager->interaction_offset = 0;
+        
+        if (required <= manager->interaction_capacity) {
+            return 1;
+        }
+    }
+    
+    int new_capacity = manager->interaction_capacity > 0 ? manager->interaction_capacity : 1;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+    
+    Interaction *new_interactions = (Interaction*)realloc(block, 
+                                    new_capacity * sizeof(Interaction));
+    if (new_interactions == NULL) {
+        return 0;
+    }
+    
+    manager->interactions = new_interactions;
+    manager->interaction_capacity = new_capacity;
+    return 1;
+}
+
+// Função de dispersão para o par (utilizador, conteúdo)
+static unsigned int user_hash_pair(int user_id, int content_id) {
+    return user_hash_id(user_id) ^ ((unsigned int)content_id * 0x9E3779B1u + 0x7F4A7C15u);
+}
+
+// Reconstrói a tabela de dispersão dos agregados
+static int user_aggregate_index_rebuild(InteractionRetention *retention) {
+    int capacity = 16;
+    while (capacity < retention->count * 2) {
+        capacity *= 2;
+    }
+    
+    int *index = (int*)calloc(capacity, sizeof(int));
+    if (index == NULL) {
+        // Sem tabela, as buscas voltam a ser lineares
+        free(retention->index);
+        retention->index = NULL;
+        retention->index_capacity = 0;
+        return 0;
+    }
+    
+    unsigned int mask = (unsigned int)capacity - 1;
+    for (int i = 0; i < retention->count; i++) {
+        InteractionAggregate *aggregate = &retention->aggregates[i];
+        unsigned int slot = user_hash_pair(aggregate->user_id, aggregate->content_id) & mask;
+        while (index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = i + 1;
+    }
+    
+    free(retention->index);
+    retention->index = index;
+    retention->index_capacity = capacity;
+    return 1;
+}
+
+// Procura o agregado de um par (utilizador, conteúdo) (NULL se não existir)
+static InteractionAggregate* user_aggregate_find(InteractionRetention *retention, 
+                                                 int user_id, int content_id) {
+    if (retention->index == NULL) {
+        for (int i = 0; i < retention->count; i++) {
+            if (retention->aggregates[i].user_id == user_id && 
+                retention->aggregates[i].content_id == content_id) {
+                return &retention->aggregates[i];
+            }
+        }
+        return NULL;
+    }
+    
+    unsigned int mask = (unsigned int)retention->index_capacity - 1;
+    unsigned int slot = user_hash_pair(user_id, content_id) & mask;
+    
+    while (retention->index[slot] != 0) {
+        InteractionAggregate *aggregate = &retention->aggregates[retention->index[slot] - 1];
+        if (aggregate->user_id == user_id && aggregate->content_id == content_id) {
+            return aggregate;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    return NULL;
+}
+
+// Obtém (criando se necessário) o agregado de um par (utilizador, conteúdo)
+static InteractionAggregate* user_aggregate_get(InteractionRetention *retention, 
+                                                int user_id, int content_id) {
+    InteractionAggregate *aggregate = user_aggregate_find(retention, user_id, content_id);
+    if (aggregate != NULL) {
+        return aggregate;
+    }
+    
+    if (retention->count >= retention->capacity) {
+        int new_capacity = retention->capacity > 0 ? retention->capacity * 2 : 16;
+        InteractionAggregate *new_aggregates = (InteractionAggregate*)realloc(
+            retention->aggregates, new_capacity * sizeof(InteractionAggregate));
+        
+        if (new_aggregates == NULL) {
+            return NULL;
+        }
+        
+        retention->aggregates = new_aggregates;
+        retention->capacity = new_capacity;
+    }
+    
+    aggregate = &retention->aggregates[retention->count++];
+    memset(aggregate, 0, sizeof(InteractionAggregate));
+    aggregate->user_id = user_id;
+    aggregate->content_id = content_id;
+    
+    // Manter a ocupação da tabela abaixo de metade
+    if (retention->index == NULL || retention->count * 2 > retention->index_capacity) {
+        user_aggregate_index_rebuild(retention);
+    } else {
+        unsigned int mask = (unsigned int)retention->index_capacity - 1;
+        unsigned int slot = user_hash_pair(user_id, content_id) & mask;
+        while (retention->index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        retention->index[slot] = retention->count;
+    }
+    
+    return aggregate;
+}
+
+// Verifica se um evento repete um evento aceite dentro da janela (e regista-o se não repetir)
+static int user_dedup_is_duplicate(InteractionDedup *dedup, int user_id, int content_id, 
+                                   InteractionType type, time_t timestamp) {
+    if (dedup->window <= 0 || dedup->entries == NULL) {
+        return 0;
+    }
+    
+    unsigned int mask = DEDUP_TABLE_SIZE - 1;
+    unsigned int slot = (user_hash_id(user_id) ^ 
+                         ((unsigned int)content_id * 0x9E3779B1u) ^ 
+                         ((unsigned int)type * 0x85EBCA6Bu)) & mask;
+    DedupEntry *victim = NULL;
+    DedupEntry *oldest = &dedup->entries[slot];
+    
+    // Procurar a chave em todas as posições antes de escolher onde a guardar:
+    // uma posição vazia ou expirada antes da chave não prova que ela não existe
+    for (int probe = 0; probe < DEDUP_MAX_PROBES; probe++) {
+        DedupEntry *entry = &dedup->entries[(slot + probe) & mask];
+        
+        if (entry->user_id == user_id && entry->content_id == content_id && entry->type == type) {
+            if (timestamp >= entry->timestamp && timestamp - entry->timestamp < dedup->window) {
+                dedup->dropped++;
+                return 1;
+            }
+            victim = entry;
+            break;
+        }
+        
+        // Preferir a primeira posição vazia ou expirada; senão substituir a mais antiga
+        if (victim == NULL && (entry->user_id == 0 || timestamp - entry->timestamp >= dedup->window)) {
+            victim = entry;
+        }
+        if (entry->timestamp < oldest->timestamp) {
+            oldest = entry;
+        }
+    }
+    if (victim == NULL) {
+        victim = oldest;
+    }
+    
+    victim->user_id = user_id;
+    victim->content_id = content_id;
+    victim->type = type;
+    victim->timestamp = timestamp;
+    dedup->accepted++;
+    return 0;
+}
+
+// Entrada da tabela de dispersão perfeita dos nomes dos tipos de interação
+typedef struct {
+    const char *name;       // Nome em minúsculas
+    size_t length;          // Comprimento do nome
+    InteractionType type;   // Tipo correspondente
+} UserTypeName;
+
+// Indexada por ((c0 | 0x20) + (c1 | 0x20)) & 7, sem colisões entre os quatro nomes
+static const UserTypeName user_type_names[8] = {
+    {NULL, 0, INTERACTION_PLAY},
+    {"pause", 5, INTERACTION_PAUSE},
+    {"complete", 8, INTERACTION_COMPLETE},
+    {NULL, 0, INTERACTION_PLAY},
+    {"play", 4, INTERACTION_PLAY},
+    {NULL, 0, INTERACTION_PLAY},
+    {NULL, 0, INTERACTION_PLAY},
+    {"favorite", 8, INTERACTION_FAVORITE}
+};
+
+// Obtém o array de favoritos de um utilizador (interno ou no heap)
+static int* user_favorite_items(User *user) {
+    return user->favorite_count <= USER_INLINE_FAVORITES ? 
+           user->favorites.inline_items : user->favorites.heap_items;
+}
+
+// Capacidade do array de favoritos no heap para um dado número de favoritos
+static int user_favorite_heap_capacity(int count) {
+    int capacity = 2 * USER_INLINE_FAVORITES;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Busca binária: primeira posição com valor >= content_id
+static int user_favorite_lower_bound(const int *items, int count, int content_id) {
+    int low = 0;
+    int high = count;
+    
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (items[mid] < content_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
+
+// Liberta o array de favoritos no heap, se existir
+static void user_favorite_free(User *user) {
+    if (user->favorite_count > USER_INLINE_FAVORITES) {
+        free(user->favorites.heap_items);
+    }
+    user->favorite_count = 0;
+}
+
+// Dá ao histórico do utilizador uma revisão nova, diferente de todas as anteriores do gerenciador
+static void user_touch(UserManager *manager, User *user) {
+    user->revision = ++manager->revision;
+}
+
+// Regista um conteúdo como assistido (interações PLAY e COMPLETE)
+static void user_mark_watched(User *user, int content_id, InteractionType type) {
+    if (type != INTERACTION_PLAY && type != INTERACTION_COMPLETE) {
+        return;
+    }
+    
+    if (user->watched == NULL) {
+        user->watched = (Bitmap*)malloc(sizeof(Bitmap));
+        if (user->watched == NULL) {
+            return;
+        }
+        bitmap_init(user->watched);
+    }
+    
+    bitmap_add(user->watched, (uint32_t)content_id);
+}
+
+// Guarda o timestamp da interação mais recente de um utilizador
+static void user_note_interaction(User *user, time_t timestamp) {
+    if (timestamp > user->last_interaction) {
+        user->last_interaction = timestamp;
+    }
+}
+
+// Liberta o conjunto de conteúdos assistidos de um utilizador
+static void user_watched_free(User *user) {
+    if (user->watched != NULL) {
+        bitmap_free(user->watched);
+        free(user->watched);
+        user->watched = NULL;
+    }
+}
+
+// Adiciona um conteúdo aos favoritos de um utilizador já resolvido
+static int user_favorite_insert(User *user, int content_id) {
+    int *items = user_favorite_items(user);
+    int count = user->favorite_count;
+    int position = user_favorite_lower_bound(items, count, content_id);
+    
+    // Verificar se o conteúdo já está nos favoritos
+    if (position < count && items[position] == content_id) {
+        return 1; // Já está nos favoritos
+    }
+    
+    if (count < USER_INLINE_FAVORITES) {
+        // Ainda há espaço no próprio registo
+        memmove(&items[position + 1], &items[position], (count - position) * sizeof(int));
+        items[position] = content_id;
+    } else if (count == USER_INLINE_FAVORITES) {
+        // Transbordar para o heap
+        int *heap = (int*)malloc(user_favorite_heap_capacity(count + 1) * sizeof(int));
+        if (heap == NULL) {
+            return 0;
+        }
+        
+        memcpy(heap, items, position * sizeof(int));
+        heap[position] = content_id;
+        memcpy(&heap[position + 1], &items[position], (count - position) * sizeof(int));
+        user->favorites.heap_items = heap;
+    } else {
+        // Duplicar o array no heap quando estiver cheio
+        if (count == user_favorite_heap_capacity(count)) {
+            int *heap = (int*)realloc(items, 2 * count * sizeof(int));
+            if (heap == NULL) {
+                return 0;
+            }
+            
+            user->favorites.heap_items = heap;
+            items = heap;
+        }
+        
+        memmove(&items[position + 1], &items[position], (count - position) * sizeof(int));
+        items[position] = content_id;
+    }
+    
+    user->favorite_count++;
+    return 1;
+}
+
+// Remove um conteúdo dos favoritos de um utilizador já resolvido
+static int user_favorite_erase(User *user, int content_id) {
+    int *items = user_favorite_items(user);
+    int count = user->favorite_count;
+    int position = user_favorite_lower_bound(items, count, content_id);
+    
+    if (position >= count || items[position] != content_id) {
+        return 0; // Conteúdo não está nos favoritos
+    }
+    
+    if (count - 1 == USER_INLINE_FAVORITES) {
+        // Voltar a guardar os favoritos no próprio registo
+        int *heap = items;
+        int next = 0;
+        
+        for (int i = 0; i < count; i++) {
+            if (i != position) {
+                user->favorites.inline_items[next++] = heap[i];
+            }
+        }
+        free(heap);
+    } else {
+        memmove(&items[position], &items[position + 1], (count - position - 1) * sizeof(int));
+        
+        // Reduzir o array no heap quando ficar com metade da capacidade
+        if (count - 1 > USER_INLINE_FAVORITES && 
+            user_favorite_heap_capacity(count - 1) < user_favorite_heap_capacity(count)) {
+            int *heap = (int*)realloc(items, user_favorite_heap_capacity(count - 1) * sizeof(int));
+            if (heap != NULL) {
+                user->favorites.heap_items = heap;
+            }
+        }
+    }
+    
+    user->favorite_count--;
+    return 1;
+}
 
 int user_init_manager(UserManager *manager, int initial_user_capacity, 
                      int initial_interaction_capacity) {
@@ -24,10 +475,26 @@ int user_init_manager(UserManager *manager, int initial_user_capacity,
         return 0;
     }
     
+    if (!session_table_init(&manager->sessions)) {
+        free(manager->users);
+        free(manager->interactions);
+        return 0;
+    }
+    
     manager->count = 0;
     manager->capacity = initial_user_capacity;
     manager->interaction_count = 0;
     manager->interaction_capacity = initial_interaction_capacity;
+    manager->interaction_offset = 0;
+    memset(&manager->retention, 0, sizeof(InteractionRetention));
+    memset(&manager->dedup, 0, sizeof(InteractionDedup));
+    memset(&manager->order, 0, sizeof(InteractionOrder));
+    manager->revision = 0;
+    manager->user_index = NULL;
+    manager->user_index_capacity = 0;
+    manager->sharded = NULL;
+    user_index_rebuild(manager);
+    user_set_clock(manager, USER_CLOCK_COARSE);
     
     return 1;
 }
@@ -37,18 +504,116 @@ void user_free_manager(UserManager *manager) {
         return;
     }
     
+    // As partições guardam todos os dados de um gerenciador particionado
+    if (manager->sharded != NULL) {
+        usershard_free_manager(manager->sharded);
+        free(manager->sharded);
+        manager->sharded = NULL;
+    }
+    
+    for (int i = 0; i < manager->count; i++) {
+        user_favorite_free(&manager->users[i]);
+        user_watched_free(&manager->users[i]);
+    }
+    
     free(manager->users);
-    free(manager->interactions);
+    if (manager->interactions != NULL) {
+        free(manager->interactions - manager->interaction_offset);
+    }
+    free(manager->user_index);
+    free(manager->retention.aggregates);
+    free(manager->retention.index);
+    memset(&manager->retention, 0, sizeof(InteractionRetention));
+    free(manager->dedup.entries);
+    memset(&manager->dedup, 0, sizeof(InteractionDedup));
+    free(manager->order.positions);
+    memset(&manager->order, 0, sizeof(InteractionOrder));
+    session_table_free(&manager->sessions);
     manager->users = NULL;
     manager->interactions = NULL;
+    manager->user_index = NULL;
+    manager->user_index_capacity = 0;
     manager->count = 0;
     manager->capacity = 0;
     manager->interaction_count = 0;
     manager->interaction_capacity = 0;
+    manager->interaction_offset = 0;
+}
+
+// Argumentos e resultado de uma operação aplicada a todas as partições
+typedef struct {
+    int value;              // Dias, segundos, threads ou linhas ainda por compactar
+    time_t now;             // Instante atual da compactação
+    int result;             // Resultado acumulado das partições
+} UserShardCall;
+
+// Copia o relógio do gerenciador particionado para uma partição
+static void user_shard_copy_clock(UserManager *shard, int index, void *context) {
+    (void)index;
+    shard->clock = *(const UserClock*)context;
+}
+
+int user_enable_shards(UserManager *manager, int shard_count) {
+    if (manager == NULL || manager->sharded != NULL || 
+        shard_count < 1 || shard_count > MAX_USER_SHARDS) {
+        return 0;
+    }
+    
+    // Capacidade inicial de cada partição: a sua parte do gerenciador atual
+    int user_capacity = manager->count / shard_count + 1;
+    int interaction_capacity = manager->interaction_count / shard_count + 1;
+    
+    ShardedUserManager *sharded = (ShardedUserManager*)malloc(sizeof(ShardedUserManager));
+    if (sharded == NULL) {
+        return 0;
+    }
+    if (!usershard_init_manager(sharded, shard_count, user_capacity, interaction_capacity)) {
+        free(sharded);
+        return 0;
+    }
+    
+    // O gerenciador passa a ficar vazio; prepará-lo antes de mexer nos dados atuais
+    UserManager router;
+    if (!user_init_manager(&router, 1, 1)) {
+        usershard_free_manager(sharded);
+        free(sharded);
+        return 0;
+    }
+    
+    // Revisões continuam a partir das já atribuídas (as recomendações em cache não voltam a valer)
+    for (int i = 0; i < shard_count; i++) {
+        sharded->shards[i].manager.revision = manager->revision;
+    }
+    
+    // Repartir sem filtro de duplicados: o histórico já foi filtrado na ingestão
+    if (!usershard_load_from_manager(sharded, manager)) {
+        user_free_manager(&router);
+        usershard_free_manager(sharded);
+        free(sharded);
+        return 0;
+    }
+    
+    router.clock = manager->clock;
+    router.retention.days = manager->retention.days;
+    router.revision = manager->revision;
+    int dedup_window = manager->dedup.window;
+    
+    user_free_manager(manager);
+    *manager = router;
+    manager->sharded = sharded;
+    
+    // As partições herdam a configuração do gerenciador
+    user_set_retention(manager, manager->retention.days);
+    usershard_for_each(sharded, user_shard_copy_clock, &manager->clock);
+    if (!user_set_dedup_window(manager, dedup_window)) {
+        // Sem memória para os filtros, desativá-los em todas as partições por igual
+        user_set_dedup_window(manager, 0);
+    }
+    return 1;
 }
 
 int user_load_from_csv(UserManager *manager, const char *filename) {
-    if (manager == NULL || filename == NULL) {
+    if (manager == NULL || filename == NULL || manager->sharded != NULL) {
         return -1;
     }
     
@@ -57,16 +622,25 @@ int user_load_from_csv(UserManager *manager, const char *filename) {
         return -1;
     }
     
-    char buffer[1024];
-    char *fields[MAX_FIELD_COUNT];
+    // Linhas de utilizadores podem ter muitos favoritos: buffers na arena de rascunho
+    Arena *scratch = arena_scratch();
+    ArenaMark mark = arena_mark(scratch);
+    char *buffer = (char*)arena_alloc(scratch, MAX_USER_LINE_LENGTH);
+    char **fields = (char**)arena_alloc(scratch, MAX_USER_FIELD_COUNT * sizeof(char*));
     int loaded_count = 0;
     
+    if (buffer == NULL || fields == NULL) {
+        arena_reset_to(scratch, mark);
+        fclose(file);
+        return -1;
+    }
+    
     // Pular a linha de cabeçalho
-    csv_read_line(file, buffer, sizeof(buffer));
+    csv_read_line(file, buffer, MAX_USER_LINE_LENGTH);
     
     // Ler os dados
-    while (csv_read_line(file, buffer, sizeof(buffer))) {
-        int field_count = csv_parse_line(buffer, fields, MAX_FIELD_COUNT);
+    while (csv_read_line(file, buffer, MAX_USER_LINE_LENGTH)) {
+        int field_count = csv_parse_line(buffer, fields, MAX_USER_FIELD_COUNT);
         
         if (field_count >= 2) {  // ID, nome de utilizador
             // Verificar se precisamos aumentar a capacidade do gerenciador
@@ -75,7 +649,9 @@ int user_load_from_csv(UserManager *manager, const char *filename) {
                 User *new_users = (User*)realloc(manager->users, new_capacity * sizeof(User));
                 
                 if (new_users == NULL) {
+                    arena_reset_to(scratch, mark);
                     fclose(file);
+                    user_index_rebuild(manager);
                     return -1;
                 }
                 
@@ -91,10 +667,13 @@ int user_load_from_csv(UserManager *manager, const char *filename) {
             
             user->favorite_count = 0;
             user->interaction_count = 0;
+            user->watched = NULL;
+            user->last_interaction = 0;
+            user_touch(manager, user);
             
             // Carregar favoritos se houver (campo 2 em diante)
-            for (int i = 2; i < field_count && user->favorite_count < 100; i++) {
-                user->favorite_contents[user->favorite_count++] = atoi(fields[i]);
+            for (int i = 2; i < field_count; i++) {
+                user_favorite_insert(user, atoi(fields[i]));
             }
             
             manager->count++;
@@ -102,12 +681,14 @@ int user_load_from_csv(UserManager *manager, const char *filename) {
         }
     }
     
+    arena_reset_to(scratch, mark);
     fclose(file);
+    user_index_rebuild(manager);
     return loaded_count;
 }
 
 int user_save_to_csv(UserManager *manager, const char *filename) {
-    if (manager == NULL || filename == NULL) {
+    if (manager == NULL || filename == NULL || manager->sharded != NULL) {
         return 0;
     }
     
@@ -119,13 +700,18 @@ int user_save_to_csv(UserManager *manager, const char *filename) {
     // Escrever cabeçalho
     fprintf(file, "ID,Nome de Utilizador,Favoritos\n");
     
+    Arena *scratch = arena_scratch();
+    
     // Escrever dados
     for (int i = 0; i < manager->count; i++) {
         User *user = &manager->users[i];
         
         // Calcular o número de campos total (ID + username + favoritos)
         int field_count = 2 + user->favorite_count;
-        char **fields = (char**)malloc(field_count * sizeof(char*));
+        
+        // Campos da linha na arena de rascunho, descartados no fim da linha
+        ArenaMark mark = arena_mark(scratch);
+        char **fields = (char**)arena_alloc(scratch, field_count * sizeof(char*));
         
         if (fields == NULL) {
             fclose(file);
@@ -139,37 +725,19 @@ int user_save_to_csv(UserManager *manager, const char *filename) {
         fields[1] = user->username;
         
         // Adicionar os favoritos
-        char **favorite_strs = (char**)malloc(user->favorite_count * sizeof(char*));
-        if (favorite_strs == NULL) {
-            free(fields);
-            fclose(file);
-            return 0;
-        }
+        const int *favorites = user_get_favorites(user, NULL);
         
         for (int j = 0; j < user->favorite_count; j++) {
-            favorite_strs[j] = (char*)malloc(20 * sizeof(char));
-            if (favorite_strs[j] == NULL) {
-                for (int k = 0; k < j; k++) {
-                    free(favorite_strs[k]);
-                }
-                free(favorite_strs);
-                free(fields);
+            fields[2 + j] = arena_printf(scratch, "%d", favorites[j]);
+            if (fields[2 + j] == NULL) {
+                arena_reset_to(scratch, mark);
                 fclose(file);
                 return 0;
             }
-            
-            sprintf(favorite_strs[j], "%d", user->favorite_contents[j]);
-            fields[2 + j] = favorite_strs[j];
         }
         
         csv_write_line(file, fields, field_count);
-        
-        // Libertar memória
-        for (int j = 0; j < user->favorite_count; j++) {
-            free(favorite_strs[j]);
-        }
-        free(favorite_strs);
-        free(fields);
+        arena_reset_to(scratch, mark);
     }
     
     fclose(file);
@@ -177,7 +745,7 @@ int user_save_to_csv(UserManager *manager, const char *filename) {
 }
 
 int user_load_interactions_from_csv(UserManager *manager, const char *filename) {
-    if (manager == NULL || filename == NULL) {
+    if (manager == NULL || filename == NULL || manager->sharded != NULL) {
         return -1;
     }
     
@@ -199,18 +767,9 @@ int user_load_interactions_from_csv(UserManager *manager, const char *filename)
         
         if (field_count >= 4) {  // user_id, content_id, type, timestamp
             // Verificar se precisamos aumentar a capacidade do gerenciador
-            if (manager->interaction_count >= manager->interaction_capacity) {
-                int new_capacity = manager->interaction_capacity * 2;
-                Interaction *new_interactions = (Interaction*)realloc(manager->interactions, 
-                                                new_capacity * sizeof(Interaction));
-                
-                if (new_interactions == NULL) {
-                    fclose(file);
-                    return -1;
-                }
-                
-                manager->interactions = new_interactions;
-                manager->interaction_capacity = new_capacity;
+            if (!user_reserve_interactions(manager, manager->interaction_count + 1)) {
+                fclose(file);
+                return -1;
             }
             
             Interaction *interaction = &manager->interactions[manager->interaction_count];
@@ -224,6 +783,12 @@ int user_load_interactions_from_csv(UserManager *manager, const char *filename)
             User *user = user_get_by_id(manager, interaction->user_id);
             if (user != NULL) {
                 user->interaction_count++;
+                user_mark_watched(user, interaction->content_id, interaction->type);
+                user_note_interaction(user, interaction->timestamp);
+                user_touch(manager, user);
+                session_table_apply(&manager->sessions, interaction->user_id, 
+                                    interaction->content_id, interaction->type, 
+                                    interaction->timestamp);
             }
             
             manager->interaction_count++;
@@ -235,8 +800,29 @@ int user_load_interactions_from_csv(UserManager *manager, const char *filename)
     return loaded_count;
 }
 
+// Escreve uma interação como linha CSV
+static void user_write_interaction(FILE *file, const Interaction *interaction) {
+    char user_id_str[20], content_id_str[20], timestamp_str[30];
+    char type_str[MAX_INTERACTION_TYPE_LENGTH];
+    
+    sprintf(user_id_str, "%d", interaction->user_id);
+    sprintf(content_id_str, "%d", interaction->content_id);
+    sprintf(timestamp_str, "%ld", (long)interaction->timestamp);
+    
+    user_interaction_type_to_string(interaction->type, type_str, MAX_INTERACTION_TYPE_LENGTH);
+    
+    char *fields[4] = {
+        user_id_str,
+        content_id_str,
+        type_str,
+        timestamp_str
+    };
+    
+    csv_write_line(file, fields, 4);
+}
+
 int user_save_interactions_to_csv(UserManager *manager, const char *filename) {
-    if (manager == NULL || filename == NULL) {
+    if (manager == NULL || filename == NULL || manager->sharded != NULL) {
         return 0;
     }
     
@@ -248,38 +834,637 @@ int user_save_interactions_to_csv(UserManager *manager, const char *filename) {
     // Escrever cabeçalho
     fprintf(file, "ID_Utilizador,ID_Conteudo,Tipo,Timestamp\n");
     
-    // Escrever dados
-    for (int i = 0; i < manager->interaction_count; i++) {
-        Interaction *interaction = &manager->interactions[i];
-        
-        char user_id_str[20], content_id_str[20], timestamp_str[30];
-        char type_str[MAX_INTERACTION_TYPE_LENGTH];
-        
-        sprintf(user_id_str, "%d", interaction->user_id);
-        sprintf(content_id_str, "%d", interaction->content_id);
-        sprintf(timestamp_str, "%ld", (long)interaction->timestamp);
-        
-        user_interaction_type_to_string(interaction->type, type_str, MAX_INTERACTION_TYPE_LENGTH);
-        
-        char *fields[4] = {
-            user_id_str,
-            content_id_str,
-            type_str,
-            timestamp_str
-        };
-        
-        csv_write_line(file, fields, 4);
+    // Escrever dados (o prefixo ordenado volta à ordem original do ficheiro)
+    const int *positions = manager->order.positions + manager->order.offset;
+    int sorted_count = manager->order.count;
+    int *by_position = NULL;
+    
+    if (sorted_count > 0) {
+        by_position = (int*)malloc(manager->order.total * sizeof(int));
+    }
+    
+    if (by_position != NULL) {
+        for (int i = 0; i < manager->order.total; i++) {
+            by_position[i] = -1;
+        }
+        for (int i = 0; i < sorted_count; i++) {
+            by_position[positions[i]] = i;
+        }
+        for (int i = 0; i < manager->order.total; i++) {
+            if (by_position[i] >= 0) {
+                user_write_interaction(file, &manager->interactions[by_position[i]]);
+            }
+        }
+        free(by_position);
+    } else {
+        // Sem memória para a permutação inversa: exportar pela ordem atual
+        sorted_count = 0;
+    }
+    
+    for (int i = sorted_count; i < manager->interaction_count; i++) {
+        user_write_interaction(file, &manager->interactions[i]);
     }
     
     fclose(file);
     return 1;
 }
 
-int user_add(UserManager *manager, const char *username) {
-    if (manager == NULL || username == NULL || strlen(username) == 0) {
+int user_load_aggregates_from_csv(UserManager *manager, const char *filename) {
+    if (manager == NULL || filename == NULL || manager->sharded != NULL) {
         return -1;
     }
     
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    
+    char buffer[1024];
+    char *fields[MAX_FIELD_COUNT];
+    int loaded_count = 0;
+    
+    // Pular a linha de cabeçalho
+    csv_read_line(file, buffer, sizeof(buffer));
+    
+    // Ler os dados
+    while (csv_read_line(file, buffer, sizeof(buffer))) {
+        int field_count = csv_parse_line(buffer, fields, MAX_FIELD_COUNT);
+        
+        if (field_count >= 7) {  // user_id, content_id, PLAY, PAUSE, COMPLETE, FAVORITE, último timestamp
+            InteractionAggregate *aggregate = user_aggregate_get(&manager->retention, 
+                                                                 atoi(fields[0]), atoi(fields[1]));
+            if (aggregate == NULL) {
+                fclose(file);
+                return -1;
+            }
+            
+            int total = 0;
+            for (int i = 0; i < 4; i++) {
+                int value = atoi(fields[2 + i]);
+                aggregate->counts[i] += value;
+                total += value;
+            }
+            
+            time_t last_timestamp = (time_t)atoll(fields[6]);
+            if (last_timestamp > aggregate->last_timestamp) {
+                aggregate->last_timestamp = last_timestamp;
+            }
+            
+            // O histórico agregado conta para a atividade do utilizador
+            User *user = user_get_by_id(manager, aggregate->user_id);
+            if (user != NULL) {
+                user->interaction_count += total;
+            }
+            
+            loaded_count++;
+        }
+    }
+    
+    fclose(file);
+    return loaded_count;
+}
+
+int user_save_aggregates_to_csv(UserManager *manager, const char *filename) {
+    if (manager == NULL || filename == NULL || manager->sharded != NULL) {
+        return 0;
+    }
+    
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        return 0;
+    }
+    
+    // Escrever cabeçalho
+    fprintf(file, "ID_Utilizador,ID_Conteudo,Play,Pause,Complete,Favorite,Ultimo_Timestamp\n");
+    
+    // Escrever dados
+    for (int i = 0; i < manager->retention.count; i++) {
+        InteractionAggregate *aggregate = &manager->retention.aggregates[i];
+        
+        char value_strs[6][20];
+        char timestamp_str[30];
+        
+        sprintf(value_strs[0], "%d", aggregate->user_id);
+        sprintf(value_strs[1], "%d", aggregate->content_id);
+        for (int j = 0; j < 4; j++) {
+            sprintf(value_strs[2 + j], "%d", aggregate->counts[j]);
+        }
+        sprintf(timestamp_str, "%ld", (long)aggregate->last_timestamp);
+        
+        char *fields[7] = {
+            value_strs[0], value_strs[1], value_strs[2], 
+            value_strs[3], value_strs[4], value_strs[5], 
+            timestamp_str
+        };
+        
+        csv_write_line(file, fields, 7);
+    }
+    
+    fclose(file);
+    return 1;
+}
+
+static void user_shard_set_retention(UserManager *shard, int index, void *context) {
+    (void)index;
+    user_set_retention(shard, ((UserShardCall*)context)->value);
+}
+
+void user_set_retention(UserManager *manager, int days) {
+    if (manager == NULL || days < 0) {
+        return;
+    }
+    
+    manager->retention.days = days;
+    
+    UserShardCall call = {days, 0, 0};
+    usershard_for_each(manager->sharded, user_shard_set_retention, &call);
+}
+
+// Agrega uma interação antiga no contador do par (utilizador, conteúdo)
+static int user_compact_one(UserManager *manager, const Interaction *interaction) {
+    InteractionAggregate *aggregate = user_aggregate_get(&manager->retention, 
+                                                         interaction->user_id, 
+                                                         interaction->content_id);
+    if (aggregate == NULL) {
+        return 0;
+    }
+    
+    aggregate->counts[interaction->type]++;
+    if (interaction->timestamp > aggregate->last_timestamp) {
+        aggregate->last_timestamp = interaction->timestamp;
+    }
+    
+    // O histórico visível do dono mudou (as recomendações em cache deixam de valer)
+    User *owner = user_get_by_id(manager, interaction->user_id);
+    if (owner != NULL) {
+        user_touch(manager, owner);
+    }
+    return 1;
+}
+
+// Compacta uma partição com o que resta do limite de linhas
+static void user_shard_compact(UserManager *shard, int index, void *context) {
+    UserShardCall *call = (UserShardCall*)context;
+    (void)index;
+    
+    if (call->result < 0) {
+        return;
+    }
+    
+    int compacted = user_compact_interactions(shard, call->now, call->value);
+    if (compacted < 0) {
+        call->result = -1;
+        return;
+    }
+    call->value -= compacted;
+    call->result += compacted;
+}
+
+int user_compact_interactions(UserManager *manager, time_t now, int max_rows) {
+    if (manager == NULL || max_rows <= 0 || manager->retention.days <= 0) {
+        return 0;
+    }
+    
+    // O limite de linhas é partilhado pelas partições
+    if (manager->sharded != NULL) {
+        UserShardCall call = {max_rows, now, 0};
+        usershard_for_each(manager->sharded, user_shard_compact, &call);
+        return call.result;
+    }
+    
+    time_t cutoff = now - (time_t)manager->retention.days * 24 * 60 * 60;
+    int *positions = manager->order.positions != NULL ? 
+                     manager->order.positions + manager->order.offset : NULL;
+    int compacted = 0;
+    int failed = 0;
+    
+    // Início do histórico antigo (registo cronológico): descartar sem mover o resto
+    if (manager->retention.cursor == 0) {
+        while (compacted < max_rows && compacted < manager->interaction_count && 
+               manager->interactions[compacted].timestamp < cutoff) {
+            if (!user_compact_one(manager, &manager->interactions[compacted])) {
+                failed = 1;
+                break;
+            }
+            compacted++;
+        }
+        
+        int sorted_compacted = compacted < manager->order.count ? compacted : manager->order.count;
+        manager->order.offset += sorted_compacted;
+        manager->order.count -= sorted_compacted;
+        if (positions != NULL) {
+            positions += sorted_compacted;
+        }
+        
+        manager->interactions += compacted;
+        manager->interaction_offset += compacted;
+        manager->interaction_count -= compacted;
+        manager->interaction_capacity -= compacted;
+    }
+    
+    // Resto da janela: o histórico pode não estar por ordem cronológica (ordenação,
+    // reposição com timestamps antigos, CSV desordenado), por isso examina-se cada
+    // linha; as antigas só são contadas, para não deslocar a cauda a cada passo
+    InteractionRetention *retention = &manager->retention;
+    int end = retention->cursor + (max_rows - compacted);
+    if (end > manager->interaction_count) {
+        end = manager->interaction_count;
+    }
+    
+    for (int read = retention->cursor; read < end; read++) {
+        if (manager->interactions[read].timestamp < cutoff) {
+            if (retention->pending == 0) {
+                retention->first_pending = read;
+            }
+            retention->pending++;
+        }
+    }
+    retention->cursor = end;
+    
+    // Fim da varredura: remover todas as linhas antigas numa só passagem até ao fim
+    if (retention->cursor >= manager->interaction_count) {
+        if (retention->pending > 0 && !failed) {
+            int sorted_end = manager->order.count;
+            int write = retention->first_pending < manager->interaction_count ? 
+                        retention->first_pending : manager->interaction_count;
+            int removed = 0;
+            int sorted_removed = 0;
+            
+            for (int read = write; read < manager->interaction_count; read++) {
+                Interaction *interaction = &manager->interactions[read];
+                
+                if (!failed && interaction->timestamp < cutoff) {
+                    if (user_compact_one(manager, interaction)) {
+                        removed++;
+                        if (read < sorted_end) {
+                            sorted_removed++;
+                        }
+                        continue;
+                    }
+                    failed = 1;
+                }
+                
+                if (write != read) {
+                    manager->interactions[write] = *interaction;
+                    if (positions != NULL && read < sorted_end) {
+                        positions[write] = positions[read];
+                    }
+                }
+                write++;
+            }
+            
+            manager->interaction_count -= removed;
+            manager->order.count -= sorted_removed;
+            compacted += removed;
+        }
+        retention->cursor = 0;
+        retention->pending = 0;
+    }
+    
+    if (failed && compacted == 0) {
+        return -1; // Falha de memória ao criar um agregado
+    }
+    
+    return compacted;
+}
+
+// Tarefa de uma thread da ordenação radix: histograma ou distribuição de um bloco
+typedef struct {
+    const Interaction *src;     // Interações de origem
+    Interaction *dst;           // Interações de destino
+    const int *src_positions;   // Posições originais de origem
+    int *dst_positions;         // Posições originais de destino
+    int begin;                  // Início do bloco desta thread
+    int end;                    // Fim do bloco (exclusivo)
+    int digit;                  // Byte da chave (0-7 timestamp, 8-11 utilizador)
+    size_t counts[256];         // Histograma do bloco / posições de escrita
+} UserSortTask;
+
+// Extrai um byte da chave (utilizador, timestamp), com o bit de sinal invertido
+static unsigned int user_sort_digit(const Interaction *interaction, int digit) {
+    if (digit < 8) {
+        uint64_t key = (uint64_t)(int64_t)interaction->timestamp ^ ((uint64_t)1 << 63);
+        return (unsigned int)(key >> (digit * 8)) & 0xFF;
+    }
+    uint32_t key = (uint32_t)interaction->user_id ^ 0x80000000u;
+    return (key >> ((digit - 8) * 8)) & 0xFF;
+}
+
+// Conta os bytes de um dígito no bloco da thread
+static void *user_sort_histogram(void *arg) {
+    UserSortTask *task = (UserSortTask*)arg;
+    
+    memset(task->counts, 0, sizeof(task->counts));
+    for (int i = task->begin; i < task->end; i++) {
+        task->counts[user_sort_digit(&task->src[i], task->digit)]++;
+    }
+    return NULL;
+}
+
+// Distribui o bloco da thread pelas posições de escrita calculadas (estável)
+static void *user_sort_scatter(void *arg) {
+    UserSortTask *task = (UserSortTask*)arg;
+    
+    for (int i = task->begin; i < task->end; i++) {
+        size_t target = task->counts[user_sort_digit(&task->src[i], task->digit)]++;
+        task->dst[target] = task->src[i];
+        task->dst_positions[target] = task->src_positions[i];
+    }
+    return NULL;
+}
+
+// Fase da ordenação executada no conjunto de threads do programa
+typedef struct {
+    UserSortTask *tasks;
+    void *(*phase)(void*);
+} UserSortPhase;
+
+static void user_sort_phase_range(void *context, int begin, int end) {
+    UserSortPhase *phase = (UserSortPhase*)context;
+    for (int t = begin; t < end; t++) {
+        phase->phase(&phase->tasks[t]);
+    }
+}
+
+// Executa uma fase em todas as threads (a thread atual trata da primeira tarefa)
+static void user_sort_run(UserSortTask *tasks, int threads, void *(*phase)(void*)) {
+    pthread_t handles[USER_SORT_MAX_THREADS];
+    int started[USER_SORT_MAX_THREADS];
+    
+    // Com um conjunto de threads definido, reutilizá-lo em vez de criar threads por fase
+    ThreadPool *pool = threadpool_get_default();
+    if (pool != NULL) {
+        UserSortPhase context;
+        context.tasks = tasks;
+        context.phase = phase;
+        threadpool_parallel_for(pool, 0, threads, 1, user_sort_phase_range, &context);
+        return;
+    }
+    
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&handles[t], NULL, phase, &tasks[t]) == 0;
+        if (!started[t]) {
+            phase(&tasks[t]);
+        }
+    }
+    
+    phase(&tasks[0]);
+    
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(handles[t], NULL);
+        }
+    }
+}
+
+static void user_shard_sort(UserManager *shard, int index, void *context) {
+    UserShardCall *call = (UserShardCall*)context;
+    (void)index;
+    if (!user_sort_interactions(shard, call->value)) {
+        call->result = 0;
+    }
+}
+
+int user_sort_interactions(UserManager *manager, int threads) {
+    if (manager == NULL || threads < 1 || threads > USER_SORT_MAX_THREADS) {
+        return 0;
+    }
+    
+    // Cada partição ordena o seu histórico (os utilizadores nunca atravessam partições)
+    if (manager->sharded != NULL) {
+        UserShardCall call = {threads, 0, 1};
+        usershard_for_each(manager->sharded, user_shard_sort, &call);
+        return call.result;
+    }
+    
+    int n = manager->interaction_count;
+    if (n == 0) {
+        return 1;
+    }
+    
+    Interaction *buffer = (Interaction*)malloc(n * sizeof(Interaction));
+    int *positions = (int*)malloc(n * sizeof(int));
+    int *position_buffer = (int*)malloc(n * sizeof(int));
+    UserSortTask *tasks = (UserSortTask*)malloc(threads * sizeof(UserSortTask));
+    
+    if (buffer == NULL || positions == NULL || position_buffer == NULL || tasks == NULL) {
+        free(buffer);
+        free(positions);
+        free(position_buffer);
+        free(tasks);
+        return 0;
+    }
+    
+    // Posições originais: o prefixo já ordenado mantém as suas, o resto segue a chegada
+    InteractionOrder *order = &manager->order;
+    for (int i = 0; i < n; i++) {
+        positions[i] = i < order->count ? order->positions[order->offset + i] 
+                                        : order->total + (i - order->count);
+    }
+    int total = order->total + (n - order->count);
+    
+    if (threads > n) {
+        threads = n;
+    }
+    
+    Interaction *src = manager->interactions, *dst = buffer;
+    int *src_positions = positions, *dst_positions = position_buffer;
+    
+    for (int digit = 0; digit < 12; digit++) {
+        for (int t = 0; t < threads; t++) {
+            tasks[t].src = src;
+            tasks[t].dst = dst;
+            tasks[t].src_positions = src_positions;
+            tasks[t].dst_positions = dst_positions;
+            tasks[t].begin = (int)((long long)n * t / threads);
+            tasks[t].end = (int)((long long)n * (t + 1) / threads);
+            tasks[t].digit = digit;
+        }
+        
+        user_sort_run(tasks, threads, user_sort_histogram);
+        
+        // Saltar dígitos em que todas as chaves coincidem (p. ex. bytes altos)
+        int trivial = 0;
+        for (int b = 0; b < 256 && !trivial; b++) {
+            size_t bucket = 0;
+            for (int t = 0; t < threads; t++) {
+                bucket += tasks[t].counts[b];
+            }
+            trivial = bucket == (size_t)n;
+        }
+        if (trivial) {
+            continue;
+        }
+        
+        // Posições de escrita: por byte e, dentro de cada byte, pela ordem dos blocos
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            for (int t = 0; t < threads; t++) {
+                size_t bucket = tasks[t].counts[b];
+                tasks[t].counts[b] = offset;
+                offset += bucket;
+            }
+        }
+        
+        user_sort_run(tasks, threads, user_sort_scatter);
+        
+        Interaction *swap = src;
+        src = dst;
+        dst = swap;
+        int *swap_positions = src_positions;
+        src_positions = dst_positions;
+        dst_positions = swap_positions;
+    }
+    
+    // Garantir que o resultado fica no bloco do gerenciador
+    if (src != manager->interactions) {
+        memcpy(manager->interactions, src, n * sizeof(Interaction));
+    }
+    if (src_positions != positions) {
+        memcpy(positions, src_positions, n * sizeof(int));
+    }
+    
+    free(buffer);
+    free(position_buffer);
+    free(tasks);
+    
+    free(order->positions);
+    order->positions = positions;
+    order->offset = 0;
+    order->count = n;
+    order->total = total;
+    return 1;
+}
+
+// Verifica se uma interação precede a chave (utilizador, timestamp); com inclusive,
+// as interações com timestamp igual também contam como anteriores
+static int user_interaction_before(const Interaction *interaction, int user_id, 
+                                   time_t timestamp, int inclusive) {
+    if (interaction->user_id != user_id) {
+        return interaction->user_id < user_id;
+    }
+    return inclusive ? interaction->timestamp <= timestamp : interaction->timestamp < timestamp;
+}
+
+// Primeira posição do prefixo ordenado que não precede a chave
+static int user_interaction_bound(UserManager *manager, int user_id, time_t timestamp, int inclusive) {
+    int low = 0, high = manager->order.count;
+    
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (user_interaction_before(&manager->interactions[mid], user_id, timestamp, inclusive)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+const Interaction* user_get_interaction_range(UserManager *manager, int user_id, 
+                                              time_t from, time_t to, int *count) {
+    if (count != NULL) {
+        *count = 0;
+    }
+    
+    if (manager != NULL && manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        const Interaction *result = user_get_interaction_range(shard, user_id, from, to, count);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
+    if (manager == NULL || manager->order.count == 0 || from > to) {
+        return NULL;
+    }
+    
+    int first = user_interaction_bound(manager, user_id, from, 0);
+    int last = user_interaction_bound(manager, user_id, to, 1);
+    
+    if (last <= first) {
+        return NULL;
+    }
+    
+    if (count != NULL) {
+        *count = last - first;
+    }
+    return &manager->interactions[first];
+}
+
+// Primeira posição do prefixo ordenado com utilizador maior ou igual a user_id
+static int user_block_bound(UserManager *manager, int user_id) {
+    int low = 0, high = manager->order.count;
+    
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (manager->interactions[mid].user_id < user_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+const Interaction* user_get_interactions(UserManager *manager, int user_id, int *count) {
+    if (count != NULL) {
+        *count = 0;
+    }
+    
+    if (manager != NULL && manager->sharded != NULL && user_id > 0) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        const Interaction *result = user_get_interactions(shard, user_id, count);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
+    if (manager == NULL || manager->order.count == 0 || user_id <= 0) {
+        return NULL;
+    }
+    
+    int first = user_block_bound(manager, user_id);
+    int last = user_block_bound(manager, user_id + 1);
+    
+    if (last <= first) {
+        return NULL;
+    }
+    
+    if (count != NULL) {
+        *count = last - first;
+    }
+    return &manager->interactions[first];
+}
+
+int user_add(UserManager *manager, const char *username) {
+    if (manager == NULL) {
+        return -1;
+    }
+    
+    // IDs e nomes únicos entre partições são atribuídos pelo registo do gerenciador particionado
+    if (manager->sharded != NULL) {
+        return usershard_add(manager->sharded, username);
+    }
+    
+    // Encontrar o próximo ID disponível
+    int next_id = 1;
+    for (int i = 0; i < manager->count; i++) {
+        if (manager->users[i].id >= next_id) {
+            next_id = manager->users[i].id + 1;
+        }
+    }
+    
+    return user_add_with_id(manager, next_id, username);
+}
+
+int user_add_with_id(UserManager *manager, int user_id, const char *username) {
+    if (manager == NULL || user_id <= 0 || username == NULL || strlen(username) == 0) {
+        return -1;
+    }
+    
+    if (manager->sharded != NULL) {
+        return usershard_add_with_id(manager->sharded, user_id, username);
+    }
+    
     // Verificar se o nome de utilizador já existe
     for (int i = 0; i < manager->count; i++) {
         if (strcmp(manager->users[i].username, username) == 0) {
@@ -287,6 +1472,11 @@ int user_add(UserManager *manager, const char *username) {
         }
     }
     
+    // Verificar se o ID já está em uso
+    if (user_index_find(manager, user_id) != -1) {
+        return -1;
+    }
+    
     // Verificar se precisamos aumentar a capacidade do gerenciador
     if (manager->count >= manager->capacity) {
         int new_capacity = manager->capacity * 2;
@@ -300,25 +1490,28 @@ int user_add(UserManager *manager, const char *username) {
         manager->capacity = new_capacity;
     }
     
-    // Encontrar o próximo ID disponível
-    int next_id = 1;
-    for (int i = 0; i < manager->count; i++) {
-        if (manager->users[i].id >= next_id) {
-            next_id = manager->users[i].id + 1;
-        }
-    }
-    
     // Adicionar o novo utilizador
     User *user = &manager->users[manager->count];
     
-    user->id = next_id;
+    user->id = user_id;
     strncpy(user->username, username, MAX_USERNAME_LENGTH - 1);
     user->username[MAX_USERNAME_LENGTH - 1] = '\0';
     user->favorite_count = 0;
     user->interaction_count = 0;
+    user->watched = NULL;
+    user->last_interaction = 0;
+    user_touch(manager, user);
     
     manager->count++;
-    return next_id;
+    
+    // Atualizar a tabela de dispersão (reconstruir ao ultrapassar metade da ocupação)
+    if (manager->user_index != NULL && manager->count * 2 <= manager->user_index_capacity) {
+        user_index_insert(manager, manager->count - 1);
+    } else {
+        user_index_rebuild(manager);
+    }
+    
+    return user_id;
 }
 
 int user_remove(UserManager *manager, int user_id) {
@@ -326,38 +1519,151 @@ int user_remove(UserManager *manager, int user_id) {
         return 0;
     }
     
-    // Buscar o utilizador com o ID especificado
-    int index = -1;
-    for (int i = 0; i < manager->count; i++) {
-        if (manager->users[i].id == user_id) {
-            index = i;
-            break;
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_remove(shard, user_id);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
+    return user_remove_batch(manager, &user_id, 1) == 1;
+}
+
+int user_remove_batch(UserManager *manager, const int *user_ids, int n) {
+    if (manager == NULL || user_ids == NULL || n < 0) {
+        return -1;
+    }
+    
+    if (n == 0) {
+        return 0;
+    }
+    
+    // Cada utilizador é removido na sua partição (IDs repetidos só contam uma vez)
+    if (manager->sharded != NULL) {
+        int removed = 0;
+        for (int i = 0; i < n; i++) {
+            removed += user_remove(manager, user_ids[i]);
         }
+        return removed;
     }
     
-    if (index == -1) {
-        return 0; // ID não encontrado
+    // Conjunto de IDs a remover: cada posição guarda o ID e se o utilizador existia
+    unsigned int slot_count = 16;
+    while (slot_count < (unsigned int)n * 2) {
+        slot_count *= 2;
     }
     
-    // Remover as interações do utilizador
-    int i = 0;
-    while (i < manager->interaction_count) {
-        if (manager->interactions[i].user_id == user_id) {
-            // Mover a última interação para a posição atual
-            manager->interactions[i] = manager->interactions[manager->interaction_count - 1];
-            manager->interaction_count--;
+    int *slot_ids = (int*)calloc(slot_count, sizeof(int));
+    char *slot_found = (char*)calloc(slot_count, sizeof(char));
+    if (slot_ids == NULL || slot_found == NULL) {
+        free(slot_ids);
+        free(slot_found);
+        return -1;
+    }
+    
+    unsigned int mask = slot_count - 1;
+    for (int i = 0; i < n; i++) {
+        if (user_ids[i] <= 0) {
+            continue;
+        }
+        
+        unsigned int slot = user_hash_id(user_ids[i]) & mask;
+        while (slot_ids[slot] != 0 && slot_ids[slot] != user_ids[i]) {
+            slot = (slot + 1) & mask;
+        }
+        slot_ids[slot] = user_ids[i];
+    }
+    
+    // Compactar os utilizadores numa única passagem, preservando a ordem
+    int removed = 0;
+    int kept_users = 0;
+    
+    for (int i = 0; i < manager->count; i++) {
+        User *user = &manager->users[i];
+        unsigned int slot = user_hash_id(user->id) & mask;
+        
+        while (slot_ids[slot] != 0 && slot_ids[slot] != user->id) {
+            slot = (slot + 1) & mask;
+        }
+        
+        if (slot_ids[slot] == user->id && !slot_found[slot]) {
+            slot_found[slot] = 1;
+            user_favorite_free(user);
+            user_watched_free(user);
+            removed++;
         } else {
-            i++;
+            manager->users[kept_users++] = *user;
         }
     }
     
-    // Mover os utilizadores seguintes uma posição para trás
-    for (int i = index; i < manager->count - 1; i++) {
-        manager->users[i] = manager->users[i + 1];
+    manager->count = kept_users;
+    
+    // Remover as interações dos utilizadores removidos, preservando a ordem cronológica
+    if (removed > 0) {
+        int kept_interactions = 0;
+        int kept_sorted = 0;
+        int *positions = manager->order.positions + manager->order.offset;
+        
+        for (int i = 0; i < manager->interaction_count; i++) {
+            int interaction_user = manager->interactions[i].user_id;
+            unsigned int slot = user_hash_id(interaction_user) & mask;
+            
+            while (slot_ids[slot] != 0 && slot_ids[slot] != interaction_user) {
+                slot = (slot + 1) & mask;
+            }
+            
+            if (slot_ids[slot] != interaction_user || !slot_found[slot]) {
+                // Manter a posição original das interações do prefixo ordenado
+                if (i < manager->order.count) {
+                    positions[kept_sorted++] = positions[i];
+                }
+                manager->interactions[kept_interactions++] = manager->interactions[i];
+            }
+        }
+        
+        manager->interaction_count = kept_interactions;
+        manager->order.count = kept_sorted;
+        
+        // Remover os agregados dos utilizadores removidos
+        InteractionRetention *retention = &manager->retention;
+        if (retention->count > 0) {
+            int kept_aggregates = 0;
+            
+            for (int i = 0; i < retention->count; i++) {
+                int aggregate_user = retention->aggregates[i].user_id;
+                unsigned int slot = user_hash_id(aggregate_user) & mask;
+                
+                while (slot_ids[slot] != 0 && slot_ids[slot] != aggregate_user) {
+                    slot = (slot + 1) & mask;
+                }
+                
+                if (slot_ids[slot] != aggregate_user || !slot_found[slot]) {
+                    retention->aggregates[kept_aggregates++] = retention->aggregates[i];
+                }
+            }
+            
+            if (kept_aggregates != retention->count) {
+                retention->count = kept_aggregates;
+                user_aggregate_index_rebuild(retention);
+            }
+        }
+        
+        // Remover as sessões dos utilizadores removidos
+        int removed_ids_count = 0;
+        for (unsigned int slot = 0; slot < slot_count; slot++) {
+            if (slot_found[slot]) {
+                slot_ids[removed_ids_count++] = slot_ids[slot];
+            }
+        }
+        session_table_remove_users(&manager->sessions, slot_ids, removed_ids_count);
     }
     
-    manager->count--;
-    return 1;
+    free(slot_ids);
+    free(slot_found);
+    
+    // Reconstruir os índices uma única vez no fim
+    user_index_rebuild(manager);
+    return removed;
 }
 
 int user_register_interaction(UserManager *manager, int user_id, int content_id, 
@@ -366,6 +1672,35 @@ int user_register_interaction(UserManager *manager, int user_id, int content_id,
         return 0;
     }
     
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_register_interaction(shard, user_id, content_id, type);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
+    // Validar o utilizador antes de ler o relógio, que o relógio simulado avança a cada leitura
+    if (user_index_find(manager, user_id) == -1) {
+        return 0;
+    }
+    
+    return user_register_interaction_at(manager, user_id, content_id, type, 
+                                        user_clock_now(manager));
+}
+
+int user_register_interaction_at(UserManager *manager, int user_id, int content_id, 
+                                 InteractionType type, time_t timestamp) {
+    if (manager == NULL || user_id <= 0 || content_id <= 0) {
+        return 0;
+    }
+    
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_register_interaction_at(shard, user_id, content_id, type, timestamp);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
     // Verificar se o utilizador existe
     User *user = user_get_by_id(manager, user_id);
     if (user == NULL) {
@@ -373,17 +1708,13 @@ int user_register_interaction(UserManager *manager, int user_id, int content_id,
     }
     
     // Verificar se precisamos aumentar a capacidade do gerenciador de interações
-    if (manager->interaction_count >= manager->interaction_capacity) {
-        int new_capacity = manager->interaction_capacity * 2;
-        Interaction *new_interactions = (Interaction*)realloc(manager->interactions, 
-                                        new_capacity * sizeof(Interaction));
-        
-        if (new_interactions == NULL) {
-            return 0;
-        }
-        
-        manager->interactions = new_interactions;
-        manager->interaction_capacity = new_capacity;
+    if (!user_reserve_interactions(manager, manager->interaction_count + 1)) {
+        return 0;
+    }
+    
+    // Descartar repetições antes do histórico (todas as entradas passam por aqui)
+    if (user_dedup_is_duplicate(&manager->dedup, user_id, content_id, type, timestamp)) {
+        return 2;
     }
     
     // Adicionar a nova interação
@@ -392,76 +1723,399 @@ int user_register_interaction(UserManager *manager, int user_id, int content_id,
     interaction->user_id = user_id;
     interaction->content_id = content_id;
     interaction->type = type;
-    interaction->timestamp = time(NULL);
+    interaction->timestamp = timestamp;
     
     manager->interaction_count++;
     user->interaction_count++;
+    user_mark_watched(user, content_id, type);
+    user_note_interaction(user, timestamp);
+    user_touch(manager, user);
+    session_table_apply(&manager->sessions, user_id, content_id, type, timestamp);
     
     // Se a interação for do tipo FAVORITE, adicionar o conteúdo aos favoritos
     if (type == INTERACTION_FAVORITE) {
-        user_add_favorite(manager, user_id, content_id);
+        user_favorite_insert(user, content_id);
     }
     
     return 1;
 }
 
+static void user_shard_set_dedup_window(UserManager *shard, int index, void *context) {
+    UserShardCall *call = (UserShardCall*)context;
+    (void)index;
+    if (!user_set_dedup_window(shard, call->value)) {
+        call->result = 0;
+    }
+}
+
+int user_set_dedup_window(UserManager *manager, int seconds) {
+    if (manager == NULL || seconds < 0) {
+        return 0;
+    }
+    
+    // Os eventos são filtrados na partição de cada utilizador
+    if (manager->sharded != NULL) {
+        UserShardCall call = {seconds, 0, 1};
+        usershard_for_each(manager->sharded, user_shard_set_dedup_window, &call);
+        manager->dedup.window = seconds;
+        return call.result;
+    }
+    
+    if (seconds > 0 && manager->dedup.entries == NULL) {
+        manager->dedup.entries = (DedupEntry*)calloc(DEDUP_TABLE_SIZE, sizeof(DedupEntry));
+        if (manager->dedup.entries == NULL) {
+            return 0;
+        }
+    }
+    
+    manager->dedup.window = seconds;
+    return 1;
+}
+
+int user_ingest_interaction(UserManager *manager, ContentCatalog *catalog, 
+                            int user_id, int content_id, InteractionType type) {
+    if (manager == NULL || user_id <= 0 || content_id <= 0) {
+        return 0;
+    }
+    
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_ingest_interaction(shard, catalog, user_id, content_id, type);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
+    if (user_get_by_id(manager, user_id) == NULL) {
+        return 0;
+    }
+    
+    // Um evento repetido (2) ou recusado (0) não conta visualizações
+    int result = user_register_interaction_at(manager, user_id, content_id, type, 
+                                              user_clock_now(manager));
+    if (result != 1) {
+        return result;
+    }
+    
+    // Incrementar visualizações se for do tipo PLAY ou COMPLETE
+    if (catalog != NULL && (type == INTERACTION_PLAY || type == INTERACTION_COMPLETE)) {
+        content_increment_views(catalog, content_id);
+    }
+    
+    return 1;
+}
+
+// Reparte o lote pelas partições e regista cada parte com um único bloqueio da partição
+static int user_register_batch_sharded(ShardedUserManager *sharded, ContentCatalog *catalog, 
+                                       const Interaction *events, int n) {
+    Interaction *grouped = (Interaction*)malloc(n * sizeof(Interaction));
+    if (grouped == NULL) {
+        return -1;
+    }
+    
+    // Ordenação por contagem da partição de cada evento, mantendo a ordem de chegada
+    int starts[MAX_USER_SHARDS + 1] = {0};
+    for (int i = 0; i < n; i++) {
+        starts[usershard_index(sharded, events[i].user_id) + 1]++;
+    }
+    for (int shard = 0; shard < sharded->shard_count; shard++) {
+        starts[shard + 1] += starts[shard];
+    }
+    
+    int fill[MAX_USER_SHARDS];
+    memcpy(fill, starts, sharded->shard_count * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        grouped[fill[usershard_index(sharded, events[i].user_id)]++] = events[i];
+    }
+    
+    int registered = 0;
+    for (int shard = 0; shard < sharded->shard_count; shard++) {
+        int count = starts[shard + 1] - starts[shard];
+        if (count == 0) {
+            continue;
+        }
+        
+        UserShard *part = &sharded->shards[shard];
+        pthread_mutex_lock(&part->lock);
+        int result = user_register_interactions_batch(&part->manager, catalog, 
+                                                      grouped + starts[shard], count);
+        pthread_mutex_unlock(&part->lock);
+        
+        if (result < 0) {
+            registered = -1;
+            break;
+        }
+        registered += result;
+    }
+    
+    free(grouped);
+    return registered;
+}
+
+int user_register_interactions_batch(UserManager *manager, ContentCatalog *catalog,
+                                     const Interaction *events, int n) {
+    if (manager == NULL || events == NULL || n < 0) {
+        return -1;
+    }
+    
+    if (n == 0) {
+        return 0;
+    }
+    
+    if (manager->sharded != NULL) {
+        return user_register_batch_sharded(manager->sharded, catalog, events, n);
+    }
+    
+    // Reservar a capacidade para o lote inteiro de uma só vez
+    if (!user_reserve_interactions(manager, manager->interaction_count + n)) {
+        return -1;
+    }
+    
+    // Tabela temporária ID -> posição no catálogo para as visualizações
+    int *content_slots = NULL;
+    unsigned int content_mask = 0;
+    
+    if (catalog != NULL && catalog->count > 0) {
+        unsigned int slot_count = 16;
+        while (slot_count < (unsigned int)catalog->count * 2) {
+            slot_count *= 2;
+        }
+        
+        content_slots = (int*)calloc(slot_count, sizeof(int));
+        if (content_slots != NULL) {
+            content_mask = slot_count - 1;
+            
+            for (int i = 0; i < catalog->count; i++) {
+                unsigned int slot = user_hash_id(catalog->items[i].id) & content_mask;
+                while (content_slots[slot] != 0 && 
+                       catalog->items[content_slots[slot] - 1].id != catalog->items[i].id) {
+                    slot = (slot + 1) & content_mask;
+                }
+                if (content_slots[slot] == 0) {
+                    content_slots[slot] = i + 1;
+                }
+            }
+        }
+    }
+    
+    time_t now = 0;
+    int clock_read = 0;
+    int registered = 0;
+    
+    for (int i = 0; i < n; i++) {
+        const Interaction *event = &events[i];
+        
+        if (event->user_id <= 0 || event->content_id <= 0) {
+            continue;
+        }
+        
+        int position = user_index_find(manager, event->user_id);
+        if (position == -1) {
+            continue;
+        }
+        
+        time_t timestamp = event->timestamp;
+        if (timestamp == 0) {
+            // Ler o relógio uma única vez por lote (0 é uma leitura válida do relógio simulado)
+            if (!clock_read) {
+                now = user_clock_now(manager);
+                clock_read = 1;
+            }
+            timestamp = now;
+        }
+        
+        // Descartar repetições antes do histórico e das visualizações
+        if (user_dedup_is_duplicate(&manager->dedup, event->user_id, event->content_id, 
+                                    event->type, timestamp)) {
+            continue;
+        }
+        
+        User *user = &manager->users[position];
+        Interaction *interaction = &manager->interactions[manager->interaction_count];
+        
+        *interaction = *event;
+        interaction->timestamp = timestamp;
+        
+        manager->interaction_count++;
+        user->interaction_count++;
+        user_mark_watched(user, event->content_id, event->type);
+        user_note_interaction(user, timestamp);
+        user_touch(manager, user);
+        session_table_apply(&manager->sessions, event->user_id, event->content_id, 
+                            event->type, interaction->timestamp);
+        registered++;
+        
+        if (event->type == INTERACTION_FAVORITE) {
+            user_favorite_insert(user, event->content_id);
+        }
+        
+        // Incrementar visualizações se for do tipo PLAY ou COMPLETE
+        if (catalog != NULL && 
+            (event->type == INTERACTION_PLAY || event->type == INTERACTION_COMPLETE)) {
+            if (content_slots != NULL) {
+                unsigned int slot = user_hash_id(event->content_id) & content_mask;
+                while (content_slots[slot] != 0) {
+                    Content *content = &catalog->items[content_slots[slot] - 1];
+                    if (content->id == event->content_id) {
+                        content_add_views(catalog, content->id, 1);
+                        break;
+                    }
+                    slot = (slot + 1) & content_mask;
+                }
+            } else {
+                content_increment_views(catalog, event->content_id);
+            }
+        }
+    }
+    
+    free(content_slots);
+    return registered;
+}
+
+void user_set_clock(UserManager *manager, UserClockType type) {
+    if (manager == NULL) {
+        return;
+    }
+    
+    manager->clock.type = type;
+    manager->clock.mock_time = 0;
+    manager->clock.mock_step = 0;
+    usershard_for_each(manager->sharded, user_shard_copy_clock, &manager->clock);
+}
+
+void user_set_mock_clock(UserManager *manager, time_t start, time_t step) {
+    if (manager == NULL) {
+        return;
+    }
+    
+    manager->clock.type = USER_CLOCK_MOCK;
+    manager->clock.mock_time = start;
+    manager->clock.mock_step = step;
+    usershard_for_each(manager->sharded, user_shard_copy_clock, &manager->clock);
+}
+
+time_t user_clock_now(UserManager *manager) {
+    if (manager == NULL) {
+        return time(NULL);
+    }
+    
+    switch (manager->clock.type) {
+        case USER_CLOCK_MOCK: {
+            time_t now = manager->clock.mock_time;
+            manager->clock.mock_time += manager->clock.mock_step;
+            return now;
+        }
+        case USER_CLOCK_COARSE: {
+#ifdef CLOCK_REALTIME_COARSE
+            // Leitura pelo vDSO, sem chamada de sistema e com resolução de alguns milissegundos
+            struct timespec now;
+            if (clock_gettime(CLOCK_REALTIME_COARSE, &now) == 0) {
+                return now.tv_sec;
+            }
+#endif
+            return time(NULL);
+        }
+        case USER_CLOCK_SYSTEM:
+        default:
+            return time(NULL);
+    }
+}
+
 int user_add_favorite(UserManager *manager, int user_id, int content_id) {
     if (manager == NULL || user_id <= 0 || content_id <= 0) {
         return 0;
     }
     
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_add_favorite(shard, user_id, content_id);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
     User *user = user_get_by_id(manager, user_id);
     if (user == NULL) {
         return 0;
     }
     
-    // Verificar se o conteúdo já está nos favoritos
-    for (int i = 0; i < user->favorite_count; i++) {
-        if (user->favorite_contents[i] == content_id) {
-            return 1; // Já está nos favoritos
-        }
+    return user_favorite_insert(user, content_id);
+}
+
+int user_remove_favorite(UserManager *manager, int user_id, int content_id) {
+    if (manager == NULL || user_id <= 0 || content_id <= 0) {
+        return 0;
     }
     
-    // Verificar se ainda há espaço nos favoritos
-    if (user->favorite_count >= 100) {
-        return 0; // Lista de favoritos cheia
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_remove_favorite(shard, user_id, content_id);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
     }
     
-    // Adicionar aos favoritos
-    user->favorite_contents[user->favorite_count++] = content_id;
-    return 1;
+    User *user = user_get_by_id(manager, user_id);
+    if (user == NULL) {
+        return 0;
+    }
+    
+    return user_favorite_erase(user, content_id);
 }
 
-int user_remove_favorite(UserManager *manager, int user_id, int content_id) {
+int user_has_favorite(UserManager *manager, int user_id, int content_id) {
     if (manager == NULL || user_id <= 0 || content_id <= 0) {
         return 0;
     }
     
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_has_favorite(shard, user_id, content_id);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
     User *user = user_get_by_id(manager, user_id);
     if (user == NULL) {
         return 0;
     }
     
-    // Buscar o conteúdo na lista de favoritos
-    int index = -1;
-    for (int i = 0; i < user->favorite_count; i++) {
-        if (user->favorite_contents[i] == content_id) {
-            index = i;
-            break;
-        }
+    const int *items = user_get_favorites(user, NULL);
+    int position = user_favorite_lower_bound(items, user->favorite_count, content_id);
+    return position < user->favorite_count && items[position] == content_id;
+}
+
+int user_has_watched(UserManager *manager, int user_id, int content_id) {
+    if (manager == NULL || user_id <= 0 || content_id <= 0) {
+        return 0;
     }
     
-    if (index == -1) {
-        return 0; // Conteúdo não está nos favoritos
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_has_watched(shard, user_id, content_id);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
     }
     
-    // Mover os itens seguintes uma posição para trás
-    for (int i = index; i < user->favorite_count - 1; i++) {
-        user->favorite_contents[i] = user->favorite_contents[i + 1];
+    User *user = user_get_by_id(manager, user_id);
+    if (user == NULL) {
+        return 0;
     }
     
-    user->favorite_count--;
-    return 1;
+    return bitmap_contains(user->watched, (uint32_t)content_id);
+}
+
+const int* user_get_favorites(const User *user, int *count) {
+    if (user == NULL) {
+        if (count != NULL) {
+            *count = 0;
+        }
+        return NULL;
+    }
+    
+    if (count != NULL) {
+        *count = user->favorite_count;
+    }
+    
+    return user->favorite_count <= USER_INLINE_FAVORITES ? 
+           user->favorites.inline_items : user->favorites.heap_items;
 }
 
 User* user_get_by_id(UserManager *manager, int user_id) {
@@ -469,13 +2123,15 @@ User* user_get_by_id(UserManager *manager, int user_id) {
         return NULL;
     }
     
-    for (int i = 0; i < manager->count; i++) {
-        if (manager->users[i].id == user_id) {
-            return &manager->users[i];
-        }
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        User* result = user_get_by_id(shard, user_id);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
     }
     
-    return NULL;
+    int position = user_index_find(manager, user_id);
+    return position >= 0 ? &manager->users[position] : NULL;
 }
 
 User* user_get_by_username(UserManager *manager, const char *username) {
@@ -483,6 +2139,10 @@ User* user_get_by_username(UserManager *manager, const char *username) {
         return NULL;
     }
     
+    if (manager->sharded != NULL) {
+        return usershard_get_by_username(manager->sharded, username);
+    }
+    
     for (int i = 0; i < manager->count; i++) {
         if (strcmp(manager->users[i].username, username) == 0) {
             return &manager->users[i];
@@ -497,6 +2157,13 @@ int user_get_interaction_count(UserManager *manager, int user_id) {
         return 0;
     }
     
+    if (manager->sharded != NULL) {
+        UserManager *shard = usershard_lock(manager->sharded, user_id);
+        int result = user_get_interaction_count(shard, user_id);
+        usershard_unlock(manager->sharded, user_id);
+        return result;
+    }
+    
     int count = 0;
     for (int i = 0; i < manager->interaction_count; i++) {
         if (manager->interactions[i].user_id == user_id) {
@@ -504,6 +2171,16 @@ int user_get_interaction_count(UserManager *manager, int user_id) {
         }
     }
     
+    // Incluir as interações já agregadas pela retenção
+    for (int i = 0; i < manager->retention.count; i++) {
+        InteractionAggregate *aggregate = &manager->retention.aggregates[i];
+        if (aggregate->user_id == user_id) {
+            for (int j = 0; j < 4; j++) {
+                count += aggregate->counts[j];
+            }
+        }
+    }
+    
     return count;
 }
 
@@ -530,32 +2207,36 @@ void user_interaction_type_to_string(InteractionType type, char *buffer, size_t
 }
 
 InteractionType user_interaction_type_from_string(const char *str) {
-    if (str == NULL) {
+    if (str == NULL || str[0] == '\0') {
         return INTERACTION_PLAY; // Valor padrão
     }
     
-    // Converter para maiúsculas para comparação
-    char upper_str[MAX_INTERACTION_TYPE_LENGTH];
-    size_t len = strlen(str);
+    // Coluna numérica compacta (0-3)
+    if (str[1] == '\0') {
+        if (str[0] >= '0' && str[0] <= '0' + INTERACTION_FAVORITE) {
+            return (InteractionType)(str[0] - '0');
+        }
+        return INTERACTION_PLAY; // Valor padrão
+    }
+    
+    // Dispersão perfeita pelos dois primeiros bytes, sem copiar a string;
+    // forçar o bit 0x20 torna a comparação insensível a maiúsculas
+    unsigned int key = ((unsigned char)(str[0] | 0x20) + (unsigned char)(str[1] | 0x20)) & 7;
+    const UserTypeName *candidate = &user_type_names[key];
     
-    if (len >= MAX_INTERACTION_TYPE_LENGTH) {
-        len = MAX_INTERACTION_TYPE_LENGTH - 1;
+    if (candidate->name == NULL) {
+        return INTERACTION_PLAY; // Valor padrão
     }
     
-    for (size_t i = 0; i < len; i++) {
-        upper_str[i] = toupper(str[i]);
+    for (size_t i = 0; i < candidate->length; i++) {
+        if ((str[i] | 0x20) != candidate->name[i]) {
+            return INTERACTION_PLAY; // Valor padrão
+        }
     }
-    upper_str[len] = '\0';
     
-    if (strcmp(upper_str, "PLAY") == 0) {
-        return INTERACTION_PLAY;
-    } else if (strcmp(upper_str, "PAUSE") == 0) {
-        return INTERACTION_PAUSE;
-    } else if (strcmp(upper_str, "COMPLETE") == 0) {
-        return INTERACTION_COMPLETE;
-    } else if (strcmp(upper_str, "FAVORITE") == 0) {
-        return INTERACTION_FAVORITE;
+    if (str[candidate->length] != '\0') {
+        return INTERACTION_PLAY; // Valor padrão
     }
     
-    return INTERACTION_PLAY; // Valor padrão
+    return candidate->type;
 }
\ No newline at end of file
@@ -14,10 +14,18 @@
 #include <string.h>
 #include <time.h>
 #include "content.h"
+#include "bitmap.h"
+#include "session.h"
 
 #define MAX_USERNAME_LENGTH 50
 #define MAX_INTERACTIONS 1000
 #define MAX_INTERACTION_TYPE_LENGTH 20
+#define USER_INLINE_FAVORITES 2
+#define MAX_USER_LINE_LENGTH 65536
+#define MAX_USER_FIELD_COUNT 8192
+#define DEDUP_TABLE_SIZE 4096
+#define DEDUP_MAX_PROBES 8
+#define USER_SORT_MAX_THREADS 64
 
 /**
  * @brief Tipos de interação do utilizador com conteúdos
@@ -29,6 +37,24 @@ typedef enum {
     INTERACTION_FAVORITE    /**< Marcar como favorito */
 } InteractionType;
 
+/**
+ * @brief Fontes de relógio para os timestamps das interações
+ */
+typedef enum {
+    USER_CLOCK_SYSTEM,      /**< time(NULL) a cada leitura */
+    USER_CLOCK_COARSE,      /**< Relógio grosseiro (CLOCK_REALTIME_COARSE quando disponível) */
+    USER_CLOCK_MOCK         /**< Relógio determinístico para testes e benchmarks */
+} UserClockType;
+
+/**
+ * @brief Estrutura que representa a fonte de relógio do gerenciador
+ */
+typedef struct {
+    UserClockType type;     /**< Tipo de relógio */
+    time_t mock_time;       /**< Próximo valor devolvido pelo relógio simulado */
+    time_t mock_step;       /**< Avanço do relógio simulado a cada leitura */
+} UserClock;
+
 /**
  * @brief Estrutura que representa uma interação do utilizador com um conteúdo
  */
@@ -39,17 +65,84 @@ typedef struct {
     time_t timestamp;       /**< Timestamp da interação */
 } Interaction;
 
+/**
+ * @brief Contadores agregados das interações antigas de um utilizador com um conteúdo
+ */
+typedef struct {
+    int user_id;            /**< ID do utilizador */
+    int content_id;         /**< ID do conteúdo */
+    int counts[4];          /**< Número de interações por tipo (índice = InteractionType) */
+    time_t last_timestamp;  /**< Timestamp da interação agregada mais recente */
+} InteractionAggregate;
+
+/**
+ * @brief Estrutura que representa a política de retenção das interações
+ */
+typedef struct {
+    int days;               /**< Idade máxima das interações em bruto (0 = sem limite) */
+    InteractionAggregate *aggregates; /**< Array dinâmico de agregados */
+    int count;              /**< Número atual de agregados */
+    int capacity;           /**< Capacidade máxima do array de agregados */
+    int *index;             /**< Tabela de dispersão (utilizador, conteúdo) -> agregado + 1 */
+    int index_capacity;     /**< Número de posições da tabela (potência de 2) */
+    int cursor;             /**< Posição onde o próximo passo da compactação retoma a varredura */
+    int pending;            /**< Linhas antigas encontradas na varredura atual, removidas quando ela termina */
+    int first_pending;      /**< Posição da primeira dessas linhas */
+} InteractionRetention;
+
+/**
+ * @brief Entrada da tabela de eventos recentes usada na eliminação de duplicados
+ */
+typedef struct {
+    int user_id;            /**< ID do utilizador (0 = vazio) */
+    int content_id;         /**< ID do conteúdo */
+    InteractionType type;   /**< Tipo de interação */
+    time_t timestamp;       /**< Timestamp do último evento aceite com esta chave */
+} DedupEntry;
+
+/**
+ * @brief Estrutura que representa o filtro de eventos repetidos na ingestão
+ */
+typedef struct {
+    int window;             /**< Janela em segundos (0 = desativado) */
+    DedupEntry *entries;    /**< Tabela de eventos recentes (DEDUP_TABLE_SIZE posições) */
+    long accepted;          /**< Número de eventos aceites */
+    long dropped;           /**< Número de eventos descartados por serem repetidos */
+} InteractionDedup;
+
+/**
+ * @brief Estrutura que guarda a ordem original das interações ordenadas
+ * 
+ * Após user_sort_interactions, o prefixo [0, count) do histórico fica
+ * ordenado por (utilizador, timestamp); as interações registadas depois
+ * são acrescentadas no fim, pela ordem de chegada.
+ */
+typedef struct {
+    int *positions;         /**< Posição original de cada interação do prefixo ordenado */
+    int offset;             /**< Entradas descartadas pela compactação no início do bloco */
+    int count;              /**< Número de interações no prefixo ordenado (0 = não ordenado) */
+    int total;              /**< Limite superior das posições originais */
+} InteractionOrder;
+
 /**
  * @brief Estrutura que representa um utilizador
  */
 typedef struct {
     int id;                            /**< ID do utilizador */
     char username[MAX_USERNAME_LENGTH]; /**< Nome de utilizador */
-    int favorite_contents[100];        /**< IDs dos conteúdos favoritos */
+    union {
+        int inline_items[USER_INLINE_FAVORITES]; /**< Favoritos no próprio registo (até USER_INLINE_FAVORITES) */
+        int *heap_items;               /**< Favoritos no heap quando excedem o espaço interno */
+    } favorites;                       /**< IDs dos conteúdos favoritos, ordenados (usar user_get_favorites) */
     int favorite_count;                /**< Número de conteúdos favoritos */
     int interaction_count;             /**< Número de interações do utilizador */
+    Bitmap *watched;                   /**< Conteúdos com PLAY ou COMPLETE (NULL se nenhum) */
+    unsigned long revision;            /**< Revisão do histórico (muda a cada interação registada ou compactada) */
+    time_t last_interaction;           /**< Timestamp da interação mais recente (0 se nenhuma) */
 } User;
 
+struct ShardedUserManager;
+
 /**
  * @brief Estrutura que gerencia a coleção de utilizadores
  */
@@ -60,6 +153,16 @@ typedef struct {
     Interaction *interactions; /**< Array dinâmico de interações */
     int interaction_count;  /**< Número atual de interações */
     int interaction_capacity; /**< Capacidade máxima do array de interações */
+    int interaction_offset; /**< Interações compactadas no início do bloco alocado */
+    int *user_index;        /**< Tabela de dispersão ID -> posição em users (posição + 1, 0 = vazio) */
+    int user_index_capacity; /**< Número de posições da tabela de dispersão (potência de 2) */
+    UserClock clock;        /**< Fonte de relógio para os timestamps das interações */
+    SessionTable sessions;  /**< Sessões de visualização construídas a partir das interações */
+    InteractionRetention retention; /**< Retenção e agregados das interações antigas */
+    InteractionDedup dedup; /**< Filtro de eventos repetidos na ingestão */
+    InteractionOrder order; /**< Ordem original das interações ordenadas por utilizador */
+    unsigned long revision; /**< Última revisão atribuída a um utilizador (nunca se repete) */
+    struct ShardedUserManager *sharded; /**< Partições para onde as funções user_* encaminham (NULL = não particionado) */
 } UserManager;
 
 /**
@@ -80,6 +183,27 @@ int user_init_manager(UserManager *manager, int initial_user_capacity,
  */
 void user_free_manager(UserManager *manager);
 
+/**
+ * @brief Reparte os utilizadores do gerenciador por partições com mutex próprio
+ * 
+ * Utilizadores, favoritos e interações passam para shard_count partições
+ * (ver usershard.h), escolhidas pela dispersão do ID do utilizador. A partir
+ * daí as funções user_* que recebem um utilizador encaminham para a partição
+ * dele com o seu mutex, pelo que podem ser chamadas de várias threads; as de
+ * configuração (relógio, retenção, janela de duplicados, compactação e
+ * ordenação) aplicam-se a todas as partições. Os campos users e interactions
+ * do gerenciador ficam vazios: código que os percorre diretamente, assim como
+ * a leitura e escrita de CSV, só funciona em gerenciadores não particionados.
+ * Os agregados de retenção não são copiados, e os ponteiros devolvidos
+ * (utilizadores, históricos) só são válidos até à próxima escrita na
+ * partição do utilizador.
+ * 
+ * @param manager Ponteiro para o gerenciador (já carregado)
+ * @param shard_count Número de partições (1 a MAX_USER_SHARDS)
+ * @return int 1 se a partição foi bem-sucedida, 0 caso contrário (o gerenciador fica inalterado)
+ */
+int user_enable_shards(UserManager *manager, int shard_count);
+
 /**
  * @brief Carrega utilizadores de um arquivo CSV
  * 
@@ -116,6 +240,106 @@ int user_load_interactions_from_csv(UserManager *manager, const char *filename);
  */
 int user_save_interactions_to_csv(UserManager *manager, const char *filename);
 
+/**
+ * @brief Carrega os agregados de interações antigas de um arquivo CSV
+ * 
+ * Deve ser chamado depois de user_load_from_csv, para que os contadores de
+ * interações dos utilizadores incluam o histórico agregado.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param filename Nome do arquivo CSV
+ * @return int Número de agregados carregados ou -1 em caso de erro
+ */
+int user_load_aggregates_from_csv(UserManager *manager, const char *filename);
+
+/**
+ * @brief Salva os agregados de interações antigas em um arquivo CSV
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param filename Nome do arquivo CSV
+ * @return int 1 se o salvamento foi bem-sucedido, 0 caso contrário
+ */
+int user_save_aggregates_to_csv(UserManager *manager, const char *filename);
+
+/**
+ * @brief Define a idade máxima das interações guardadas em bruto
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param days Número de dias (0 para desativar a retenção)
+ */
+void user_set_retention(UserManager *manager, int days);
+
+/**
+ * @brief Executa um passo da compactação incremental das interações antigas
+ * 
+ * Examina no máximo 'max_rows' interações a partir do ponto onde o passo
+ * anterior parou e agrega em contadores por (utilizador, conteúdo) as mais
+ * antigas que o limite de retenção, removendo-as e mantendo a ordem das
+ * restantes. Um prefixo antigo é agregado e descartado no próprio passo,
+ * sem mover as interações. As linhas antigas no meio do histórico (depois
+ * de user_sort_interactions ou de reposições fora de ordem) são só
+ * contadas durante a varredura; o passo que chega ao fim do histórico
+ * remove-as todas numa passagem a partir da primeira, e a varredura
+ * seguinte recomeça do início. Cada varredura custa assim O(n) no total,
+ * em vez de uma deslocação da cauda por passo. Linhas que uma ordenação
+ * leve para antes da primeira encontrada ficam para a varredura seguinte.
+ * 
+ * Os agregados são lidos pelos relatórios (report.c); os recomendadores
+ * usam apenas as interações em bruto que ficam no histórico.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param now Timestamp atual
+ * @param max_rows Número máximo de interações processadas neste passo
+ * @return int Número de interações compactadas ou -1 em caso de erro de memória
+ */
+int user_compact_interactions(UserManager *manager, time_t now, int max_rows);
+
+/**
+ * @brief Ordena o histórico de interações por (utilizador, timestamp)
+ * 
+ * Usa uma ordenação radix LSD estável, repartida por várias threads, e
+ * guarda a posição original de cada interação para que a exportação
+ * mantenha a ordem do ficheiro. Depois da ordenação, as interações de
+ * cada utilizador ficam contíguas (ver user_get_interaction_range).
+ * A compactação por retenção mantém o prefixo ordenado e as posições
+ * originais ao remover interações antigas.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param threads Número de threads (1 a USER_SORT_MAX_THREADS)
+ * @return int 1 se a ordenação foi bem-sucedida, 0 caso contrário
+ */
+int user_sort_interactions(UserManager *manager, int threads);
+
+/**
+ * @brief Obtém as interações de um utilizador num intervalo de tempo
+ * 
+ * Pesquisa binária no prefixo ordenado por user_sort_interactions; as
+ * interações registadas após a ordenação não são incluídas.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param user_id ID do utilizador
+ * @param from Timestamp inicial (inclusive)
+ * @param to Timestamp final (inclusive)
+ * @param count Ponteiro para armazenar o número de interações encontradas
+ * @return const Interaction* Primeira interação do intervalo, ou NULL se nenhuma ou se o histórico não estiver ordenado
+ */
+const Interaction* user_get_interaction_range(UserManager *manager, int user_id, 
+                                              time_t from, time_t to, int *count);
+
+/**
+ * @brief Obtém todas as interações de um utilizador no histórico ordenado
+ * 
+ * Pesquisa binária no prefixo ordenado por user_sort_interactions. As
+ * interações registadas após a ordenação ficam nas posições
+ * [order.count, interaction_count) e não são incluídas.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param user_id ID do utilizador
+ * @param count Ponteiro para armazenar o número de interações encontradas
+ * @return const Interaction* Primeira interação do utilizador, ou NULL se nenhuma ou se o histórico não estiver ordenado
+ */
+const Interaction* user_get_interactions(UserManager *manager, int user_id, int *count);
+
 /**
  * @brief Adiciona um novo utilizador
  * 
@@ -125,6 +349,16 @@ int user_save_interactions_to_csv(UserManager *manager, const char *filename);
  */
 int user_add(UserManager *manager, const char *username);
 
+/**
+ * @brief Adiciona um novo utilizador com um ID escolhido pelo chamador
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param user_id ID do novo utilizador (positivo e ainda não usado)
+ * @param username Nome do utilizador
+ * @return int ID do utilizador adicionado, ou -1 em caso de erro
+ */
+int user_add_with_id(UserManager *manager, int user_id, const char *username);
+
 /**
  * @brief Remove um utilizador pelo ID
  * 
@@ -134,18 +368,124 @@ int user_add(UserManager *manager, const char *username);
  */
 int user_remove(UserManager *manager, int user_id);
 
+/**
+ * @brief Remove um conjunto de utilizadores e as suas interações
+ * 
+ * Faz uma única compactação estável dos utilizadores e uma única passagem
+ * pelas interações, preservando a ordem cronológica do histórico. Os
+ * índices são reconstruídos apenas no fim.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param user_ids Array com os IDs dos utilizadores a remover
+ * @param n Número de IDs
+ * @return int Número de utilizadores removidos ou -1 em caso de erro
+ */
+int user_remove_batch(UserManager *manager, const int *user_ids, int n);
+
 /**
  * @brief Registra uma interação de um utilizador com um conteúdo
  * 
+ * Os eventos que repetem outro dentro da janela de user_set_dedup_window
+ * são descartados. Não conta visualizações: para isso usar
+ * user_ingest_interaction, que só as conta quando o evento é registado.
+ * 
  * @param manager Ponteiro para o gerenciador de utilizadores
  * @param user_id ID do utilizador
  * @param content_id ID do conteúdo
  * @param type Tipo de interação
- * @return int 1 se o registro foi bem-sucedido, 0 caso contrário
+ * @return int 1 se o registro foi bem-sucedido, 2 se foi descartado por ser repetido, 0 caso contrário
  */
 int user_register_interaction(UserManager *manager, int user_id, int content_id, 
                               InteractionType type);
 
+/**
+ * @brief Registra uma interação com um timestamp explícito
+ * 
+ * Igual a user_register_interaction, mas sem consultar o relógio; útil para
+ * reprocessar eventos históricos e para testes.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param user_id ID do utilizador
+ * @param content_id ID do conteúdo
+ * @param type Tipo de interação
+ * @param timestamp Timestamp da interação
+ * @return int 1 se o registro foi bem-sucedido, 2 se foi descartado por ser repetido, 0 caso contrário
+ */
+int user_register_interaction_at(UserManager *manager, int user_id, int content_id, 
+                                 InteractionType type, time_t timestamp);
+
+/**
+ * @brief Define a fonte de relógio usada nos timestamps das interações
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param type Tipo de relógio (USER_CLOCK_SYSTEM ou USER_CLOCK_COARSE)
+ */
+void user_set_clock(UserManager *manager, UserClockType type);
+
+/**
+ * @brief Ativa o relógio simulado determinístico
+ * 
+ * Cada leitura devolve o valor atual e avança 'step' segundos.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param start Primeiro timestamp devolvido
+ * @param step Avanço a cada leitura (0 para um relógio parado)
+ */
+void user_set_mock_clock(UserManager *manager, time_t start, time_t step);
+
+/**
+ * @brief Lê o relógio configurado no gerenciador
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @return time_t Timestamp atual segundo a fonte configurada
+ */
+time_t user_clock_now(UserManager *manager);
+
+/**
+ * @brief Define a janela de eliminação de eventos repetidos na ingestão
+ * 
+ * Eventos com o mesmo (utilizador, conteúdo, tipo) recebidos dentro da
+ * janela após um evento aceite são descartados antes de chegarem ao
+ * histórico e ao contador de visualizações.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param seconds Janela em segundos (0 para desativar)
+ * @return int 1 se a configuração foi bem-sucedida, 0 caso contrário
+ */
+int user_set_dedup_window(UserManager *manager, int seconds);
+
+/**
+ * @brief Recebe um evento de interação: elimina repetidos, registra e conta a visualização
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param catalog Ponteiro para o catálogo de conteúdos (NULL para não contar visualizações)
+ * @param user_id ID do utilizador
+ * @param content_id ID do conteúdo
+ * @param type Tipo de interação
+ * @return int 1 se o evento foi registado, 2 se foi descartado por ser repetido, 0 em caso de erro
+ */
+int user_ingest_interaction(UserManager *manager, ContentCatalog *catalog, 
+                            int user_id, int content_id, InteractionType type);
+
+/**
+ * @brief Registra um lote de interações de uma só vez
+ * 
+ * Equivalente a chamar user_register_interaction para cada evento, mas reserva
+ * a capacidade uma única vez, resolve os utilizadores pela tabela de dispersão,
+ * lê o relógio uma única vez e incrementa as visualizações dos conteúdos
+ * (PLAY e COMPLETE) na mesma passagem. Eventos com timestamp 0 recebem o
+ * instante atual; eventos com utilizador inexistente ou repetidos dentro da
+ * janela de user_set_dedup_window são ignorados.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param catalog Ponteiro para o catálogo de conteúdos (NULL para não contar visualizações)
+ * @param events Array de eventos a registrar
+ * @param n Número de eventos
+ * @return int Número de interações registradas ou -1 em caso de erro de memória
+ */
+int user_register_interactions_batch(UserManager *manager, ContentCatalog *catalog,
+                                     const Interaction *events, int n);
+
 /**
  * @brief Adiciona um conteúdo aos favoritos de um utilizador
  * 
@@ -166,6 +506,41 @@ int user_add_favorite(UserManager *manager, int user_id, int content_id);
  */
 int user_remove_favorite(UserManager *manager, int user_id, int content_id);
 
+/**
+ * @brief Verifica se um conteúdo está nos favoritos de um utilizador (busca binária)
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param user_id ID do utilizador
+ * @param content_id ID do conteúdo
+ * @return int 1 se o conteúdo é favorito, 0 caso contrário
+ */
+int user_has_favorite(UserManager *manager, int user_id, int content_id);
+
+/**
+ * @brief Obtém os favoritos de um utilizador sem cópia
+ * 
+ * O array devolvido está ordenado por ID de conteúdo e só é válido até
+ * à próxima alteração dos favoritos ou dos utilizadores.
+ * 
+ * @param user Ponteiro para o utilizador
+ * @param count Ponteiro para armazenar o número de favoritos (pode ser NULL)
+ * @return const int* Array ordenado com os IDs dos conteúdos favoritos
+ */
+const int* user_get_favorites(const User *user, int *count);
+
+/**
+ * @brief Verifica se um utilizador já reproduziu ou completou um conteúdo
+ * 
+ * Consulta o conjunto de conteúdos assistidos mantido a cada interação
+ * PLAY ou COMPLETE, sem percorrer o histórico.
+ * 
+ * @param manager Ponteiro para o gerenciador de utilizadores
+ * @param user_id ID do utilizador
+ * @param content_id ID do conteúdo
+ * @return int 1 se o utilizador já assistiu, 0 caso contrário
+ */
+int user_has_watched(UserManager *manager, int user_id, int content_id);
+
 /**
  * @brief Obtém um utilizador pelo ID
  * 
@@ -185,7 +560,7 @@ User* user_get_by_id(UserManager *manager, int user_id);
 User* user_get_by_username(UserManager *manager, const char *username);
 
 /**
- * @brief Obtém o número de interações de um utilizador
+ * @brief Obtém o número de interações de um utilizador (incluindo as agregadas)
  * 
  * @param manager Ponteiro para o gerenciador de utilizadores
  * @param user_id ID do utilizador
@@ -205,6 +580,9 @@ void user_interaction_type_to_string(InteractionType type, char *buffer, size_t
 /**
  * @brief Converte uma string em tipo de interação
  * 
+ * Aceita PLAY, PAUSE, COMPLETE e FAVORITE sem distinguir maiúsculas de
+ * minúsculas, ou o valor numérico do tipo (0-3) em ficheiros compactos.
+ * 
  * @param str String representando o tipo de interação
  * @return InteractionType Tipo de interação correspondente
  */
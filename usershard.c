@@ -0,0 +1,276 @@
+/**
+ * @file usershard.c
+ * @brief Implementação do módulo de utilizadores particionados
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "usershard.h"
+#include "threadpool.h"
+
+// Argumentos de uma thread de usershard_scatter
+typedef struct {
+    ShardedUserManager *sharded;
+    int shard;
+    UserShardTask task;
+    void *context;
+} UserShardJob;
+
+// Executa a tarefa de uma partição com o respetivo mutex
+static void *usershard_run_job(void *arg) {
+    UserShardJob *job = (UserShardJob*)arg;
+    UserShard *shard = &job->sharded->shards[job->shard];
+    
+    pthread_mutex_lock(&shard->lock);
+    job->task(&shard->manager, job->shard, job->context);
+    pthread_mutex_unlock(&shard->lock);
+    return NULL;
+}
+
+// Executa as tarefas das partições [begin, end) no conjunto de threads do programa
+static void usershard_run_jobs(void *context, int begin, int end) {
+    UserShardJob *jobs = (UserShardJob*)context;
+    for (int i = begin; i < end; i++) {
+        usershard_run_job(&jobs[i]);
+    }
+}
+
+int usershard_init_manager(ShardedUserManager *sharded, int shard_count, 
+                           int initial_user_capacity, int initial_interaction_capacity) {
+    if (sharded == NULL || shard_count < 1 || shard_count > MAX_USER_SHARDS) {
+        return 0;
+    }
+    
+    sharded->shards = (UserShard*)malloc(shard_count * sizeof(UserShard));
+    if (sharded->shards == NULL) {
+        return 0;
+    }
+    
+    for (int i = 0; i < shard_count; i++) {
+        if (!user_init_manager(&sharded->shards[i].manager, initial_user_capacity, 
+                               initial_interaction_capacity)) {
+            for (int j = 0; j < i; j++) {
+                user_free_manager(&sharded->shards[j].manager);
+                pthread_mutex_destroy(&sharded->shards[j].lock);
+            }
+            free(sharded->shards);
+            sharded->shards = NULL;
+            return 0;
+        }
+        pthread_mutex_init(&sharded->shards[i].lock, NULL);
+    }
+    
+    sharded->shard_count = shard_count;
+    sharded->next_id = 1;
+    pthread_mutex_init(&sharded->registry_lock, NULL);
+    return 1;
+}
+
+void usershard_free_manager(ShardedUserManager *sharded) {
+    if (sharded == NULL || sharded->shards == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < sharded->shard_count; i++) {
+        user_free_manager(&sharded->shards[i].manager);
+        pthread_mutex_destroy(&sharded->shards[i].lock);
+    }
+    
+    free(sharded->shards);
+    pthread_mutex_destroy(&sharded->registry_lock);
+    sharded->shards = NULL;
+    sharded->shard_count = 0;
+    sharded->next_id = 1;
+}
+
+int usershard_index(const ShardedUserManager *sharded, int user_id) {
+    // Mesma dispersão multiplicativa usada nos índices do módulo user
+    unsigned int hash = (unsigned int)user_id * 2654435761u;
+    return (int)((hash >> 16) % (unsigned int)sharded->shard_count);
+}
+
+UserManager* usershard_lock(ShardedUserManager *sharded, int user_id) {
+    UserShard *shard = &sharded->shards[usershard_index(sharded, user_id)];
+    pthread_mutex_lock(&shard->lock);
+    return &shard->manager;
+}
+
+void usershard_unlock(ShardedUserManager *sharded, int user_id) {
+    pthread_mutex_unlock(&sharded->shards[usershard_index(sharded, user_id)].lock);
+}
+
+void usershard_scatter(ShardedUserManager *sharded, UserShardTask task, void *context) {
+    if (sharded == NULL || task == NULL) {
+        return;
+    }
+    
+    UserShardJob jobs[MAX_USER_SHARDS];
+    pthread_t threads[MAX_USER_SHARDS];
+    int started[MAX_USER_SHARDS];
+    
+    for (int i = 0; i < sharded->shard_count; i++) {
+        jobs[i].sharded = sharded;
+        jobs[i].shard = i;
+        jobs[i].task = task;
+        jobs[i].context = context;
+    }
+    
+    // Com um conjunto de threads definido, reutilizá-lo em vez de criar threads
+    ThreadPool *pool = threadpool_get_default();
+    if (pool != NULL) {
+        threadpool_parallel_for(pool, 0, sharded->shard_count, 1, usershard_run_jobs, jobs);
+        return;
+    }
+    
+    // A thread atual trata da partição 0; sem threads disponíveis, corre em série
+    for (int i = 1; i < sharded->shard_count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, usershard_run_job, &jobs[i]) == 0;
+        if (!started[i]) {
+            usershard_run_job(&jobs[i]);
+        }
+    }
+    
+    usershard_run_job(&jobs[0]);
+    
+    for (int i = 1; i < sharded->shard_count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+void usershard_for_each(ShardedUserManager *sharded, UserShardTask task, void *context) {
+    if (sharded == NULL || task == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < sharded->shard_count; i++) {
+        UserShard *shard = &sharded->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        task(&shard->manager, i, context);
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+// Adiciona o utilizador na sua partição (chamado com registry_lock)
+static int usershard_add_locked(ShardedUserManager *sharded, int user_id, const char *username) {
+    // Nomes únicos entre todas as partições
+    if (usershard_get_by_username(sharded, username) != NULL) {
+        return -1;
+    }
+    
+    UserManager *manager = usershard_lock(sharded, user_id);
+    int result = user_add_with_id(manager, user_id, username);
+    usershard_unlock(sharded, user_id);
+    
+    if (result != -1 && user_id >= sharded->next_id) {
+        sharded->next_id = user_id + 1;
+    }
+    return result;
+}
+
+int usershard_add(ShardedUserManager *sharded, const char *username) {
+    if (sharded == NULL || username == NULL || strlen(username) == 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&sharded->registry_lock);
+    int result = usershard_add_locked(sharded, sharded->next_id, username);
+    pthread_mutex_unlock(&sharded->registry_lock);
+    return result;
+}
+
+int usershard_add_with_id(ShardedUserManager *sharded, int user_id, const char *username) {
+    if (sharded == NULL || user_id <= 0 || username == NULL || strlen(username) == 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&sharded->registry_lock);
+    int result = usershard_add_locked(sharded, user_id, username);
+    pthread_mutex_unlock(&sharded->registry_lock);
+    return result;
+}
+
+User* usershard_get_by_username(ShardedUserManager *sharded, const char *username) {
+    if (sharded == NULL || username == NULL) {
+        return NULL;
+    }
+    
+    for (int i = 0; i < sharded->shard_count; i++) {
+        UserShard *shard = &sharded->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        User *user = user_get_by_username(&shard->manager, username);
+        pthread_mutex_unlock(&shard->lock);
+        
+        if (user != NULL) {
+            return user;
+        }
+    }
+    return NULL;
+}
+
+int usershard_load_from_manager(ShardedUserManager *sharded, UserManager *source) {
+    if (sharded == NULL || source == NULL) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&sharded->registry_lock);
+    
+    for (int i = 0; i < source->count; i++) {
+        User *user = &source->users[i];
+        UserManager *manager = usershard_lock(sharded, user->id);
+        int ok = user_add_with_id(manager, user->id, user->username) != -1;
+        
+        int favorite_count = 0;
+        const int *favorites = user_get_favorites(user, &favorite_count);
+        for (int j = 0; ok && j < favorite_count; j++) {
+            ok = user_add_favorite(manager, user->id, favorites[j]);
+        }
+        usershard_unlock(sharded, user->id);
+        
+        if (!ok) {
+            pthread_mutex_unlock(&sharded->registry_lock);
+            return 0;
+        }
+        
+        if (user->id >= sharded->next_id) {
+            sharded->next_id = user->id + 1;
+        }
+    }
+    
+    pthread_mutex_unlock(&sharded->registry_lock);
+    
+    for (int i = 0; i < source->interaction_count; i++) {
+        Interaction *interaction = &source->interactions[i];
+        
+        // Interações de utilizadores inexistentes são ignoradas, como no gerenciador de origem
+        if (user_get_by_id(source, interaction->user_id) == NULL) {
+            continue;
+        }
+        
+        UserManager *manager = usershard_lock(sharded, interaction->user_id);
+        int result = user_register_interaction_at(manager, interaction->user_id, interaction->content_id, 
+                                                  interaction->type, interaction->timestamp);
+        usershard_unlock(sharded, interaction->user_id);
+        
+        if (result == 0) {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+int usershard_count(ShardedUserManager *sharded) {
+    if (sharded == NULL) {
+        return 0;
+    }
+    
+    int count = 0;
+    for (int i = 0; i < sharded->shard_count; i++) {
+        pthread_mutex_lock(&sharded->shards[i].lock);
+        count += sharded->shards[i].manager.count;
+        pthread_mutex_unlock(&sharded->shards[i].lock);
+    }
+    return count;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file usershard.h
+ * @brief Módulo de utilizadores particionados para escrita concorrente
+ * 
+ * Este módulo reparte utilizadores, favoritos e interações por N partições
+ * (shards) segundo a dispersão do ID do utilizador. Cada partição é um
+ * UserManager com o seu próprio mutex, pelo que escritas de utilizadores
+ * em partições diferentes avançam em paralelo.
+ * 
+ * Normalmente não é usado diretamente: um UserManager convertido com
+ * user_enable_shards encaminha as funções user_* para a partição certa.
+ */
+
+#ifndef USERSHARD_H
+#define USERSHARD_H
+
+#include <pthread.h>
+#include "user.h"
+
+#define MAX_USER_SHARDS 64
+
+/**
+ * @brief Estrutura que representa uma partição de utilizadores
+ */
+typedef struct {
+    UserManager manager;    /**< Utilizadores e interações desta partição */
+    pthread_mutex_t lock;   /**< Protege o gerenciador da partição */
+} UserShard;
+
+/**
+ * @brief Estrutura que gerencia os utilizadores particionados
+ */
+typedef struct ShardedUserManager {
+    UserShard *shards;      /**< Array de partições */
+    int shard_count;        /**< Número de partições */
+    int next_id;            /**< Próximo ID de utilizador a atribuir */
+    pthread_mutex_t registry_lock; /**< Serializa a criação de utilizadores (IDs e nomes únicos) */
+} ShardedUserManager;
+
+/**
+ * @brief Tarefa executada sobre cada partição por usershard_scatter
+ * 
+ * @param manager Gerenciador da partição (já bloqueado)
+ * @param shard Índice da partição
+ * @param context Dados do chamador
+ */
+typedef void (*UserShardTask)(UserManager *manager, int shard, void *context);
+
+/**
+ * @brief Inicializa o gerenciador particionado
+ * 
+ * @param sharded Ponteiro para o gerenciador a ser inicializado
+ * @param shard_count Número de partições (1 a MAX_USER_SHARDS)
+ * @param initial_user_capacity Capacidade inicial de utilizadores por partição
+ * @param initial_interaction_capacity Capacidade inicial de interações por partição
+ * @return int 1 se a inicialização foi bem-sucedida, 0 caso contrário
+ */
+int usershard_init_manager(ShardedUserManager *sharded, int shard_count, 
+                           int initial_user_capacity, int initial_interaction_capacity);
+
+/**
+ * @brief Liberta a memória alocada pelo gerenciador particionado
+ * 
+ * @param sharded Ponteiro para o gerenciador
+ */
+void usershard_free_manager(ShardedUserManager *sharded);
+
+/**
+ * @brief Reparte pelas partições os utilizadores, favoritos e interações de um gerenciador
+ * 
+ * Os agregados de retenção do gerenciador de origem não são copiados.
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado (vazio)
+ * @param source Gerenciador de origem (por exemplo, carregado dos ficheiros CSV)
+ * @return int 1 se a partição foi bem-sucedida, 0 caso contrário
+ */
+int usershard_load_from_manager(ShardedUserManager *sharded, UserManager *source);
+
+/**
+ * @brief Obtém o índice da partição de um utilizador
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @param user_id ID do utilizador
+ * @return int Índice da partição
+ */
+int usershard_index(const ShardedUserManager *sharded, int user_id);
+
+/**
+ * @brief Bloqueia a partição de um utilizador e devolve o seu gerenciador
+ * 
+ * Permite usar qualquer função user_* sobre o utilizador; deve ser seguido
+ * de usershard_unlock com o mesmo ID.
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @param user_id ID do utilizador
+ * @return UserManager* Gerenciador da partição bloqueada
+ */
+UserManager* usershard_lock(ShardedUserManager *sharded, int user_id);
+
+/**
+ * @brief Desbloqueia a partição de um utilizador
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @param user_id ID do utilizador
+ */
+void usershard_unlock(ShardedUserManager *sharded, int user_id);
+
+/**
+ * @brief Executa uma tarefa sobre todas as partições em paralelo (uma thread por partição)
+ * 
+ * Cada tarefa corre com a sua partição bloqueada.
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @param task Tarefa a executar
+ * @param context Dados passados a cada tarefa
+ */
+void usershard_scatter(ShardedUserManager *sharded, UserShardTask task, void *context);
+
+/**
+ * @brief Executa uma tarefa sobre cada partição, uma de cada vez, na thread atual
+ * 
+ * Usado para configurações que se aplicam a todas as partições. Cada tarefa
+ * corre com a sua partição bloqueada; sem gerenciador não faz nada.
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado (pode ser NULL)
+ * @param task Tarefa a executar
+ * @param context Dados passados a cada tarefa
+ */
+void usershard_for_each(ShardedUserManager *sharded, UserShardTask task, void *context);
+
+/**
+ * @brief Adiciona um novo utilizador na partição correspondente ao seu ID
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @param username Nome do utilizador (único entre todas as partições)
+ * @return int ID do utilizador adicionado, ou -1 em caso de erro
+ */
+int usershard_add(ShardedUserManager *sharded, const char *username);
+
+/**
+ * @brief Adiciona um utilizador com um ID escolhido pelo chamador
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @param user_id ID do utilizador (único entre todas as partições)
+ * @param username Nome do utilizador (único entre todas as partições)
+ * @return int ID do utilizador adicionado, ou -1 em caso de erro
+ */
+int usershard_add_with_id(ShardedUserManager *sharded, int user_id, const char *username);
+
+/**
+ * @brief Procura um utilizador pelo nome em todas as partições
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @param username Nome do utilizador
+ * @return User* Utilizador encontrado, ou NULL (válido até à próxima escrita na sua partição)
+ */
+User* usershard_get_by_username(ShardedUserManager *sharded, const char *username);
+
+/**
+ * @brief Obtém o número total de utilizadores em todas as partições
+ * 
+ * @param sharded Ponteiro para o gerenciador particionado
+ * @return int Número de utilizadores
+ */
+int usershard_count(ShardedUserManager *sharded);
+
+#endif /* USERSHARD_H */